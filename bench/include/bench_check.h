@@ -0,0 +1,31 @@
+// DNF (Doomed and Forgotten): a DOOM-style first-person shooter.
+// Copyright (C) 2025-2026  Alexandr Gorbatenko
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+#pragma once
+
+#include "defines.h"
+
+/**
+ * @brief Checks the pixel primitives against per-pixel references with every
+ * instruction set the CPU supports.
+ *
+ * Fills and blits go to random (partly off-screen) rectangles of row-major
+ * and column-major, RGBA and indexed framebuffers of odd sizes, so the SIMD
+ * kernels hit their edges as well.
+ *
+ * @param iterations Random operations per instruction set.
+ * @return True if every operation matched its reference.
+ */
+bool8_t bench_check_pixels(uint32_t iterations);
@@ -0,0 +1,105 @@
+// DNF (Doomed and Forgotten): a DOOM-style first-person shooter.
+// Copyright (C) 2025-2026  Alexandr Gorbatenko
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+#pragma once
+
+#include "dnf_gametypes.h"
+#include "renderer.h"
+
+/**
+ * @brief Scripted benchmark scenes.
+ */
+typedef enum dnf_bench_scene
+{
+    DNF_BENCH_SCENE_CLEAR,       //!< Full-screen clear
+    DNF_BENCH_SCENE_FILL,        //!< Overlapping full-screen fills (fill rate)
+    DNF_BENCH_SCENE_WALLS_BSP,   //!< BSP level with many pillars and platforms
+    DNF_BENCH_SCENE_WALLS_GRID,  //!< Grid map raycaster
+    DNF_BENCH_SCENE_WALLS_TEXTURED,  //!< Grid map raycaster with mipmapped wall textures
+    DNF_BENCH_SCENE_FLATS,       //!< Textured grid map with a textured floor and ceiling
+    DNF_BENCH_SCENE_ENTITIES,    //!< Grid map raycaster with 10k entities updated every tick
+    DNF_BENCH_SCENE_SPRITES,     //!< Textured grid map with 2048 depth-sorted sprites
+    DNF_BENCH_SCENE_TEXT,        //!< BSP level with a text overlay
+
+    DNF_BENCH_SCENE_COUNT        //!< Total number of scenes
+} dnf_bench_scene;
+
+/**
+ * @brief Builds scene data (levels). Must be called once before drawing.
+ *
+ * @return True if all scenes are ready.
+ */
+bool8_t bench_scenes_init(void);
+
+/**
+ * @brief Frees scene data.
+ */
+void bench_scenes_shutdown(void);
+
+/**
+ * @brief Converts the scene textures for the palette of a rendering context
+ * (see texture_cache_set_palette()). Call it for every new context.
+ *
+ * @param target_palette Palette of the indexed target (nullptr - RGBA target).
+ * @return True on success.
+ */
+bool8_t bench_scenes_set_palette(const dnf_palette *target_palette);
+
+/**
+ * @brief Gets the name of a scene (as used in the results and thresholds).
+ *
+ * @param scene Scene.
+ * @return Scene name.
+ */
+const char *bench_scene_name(dnf_bench_scene scene);
+
+/**
+ * @brief Finds a scene by name.
+ *
+ * @param name Scene name.
+ * @return Scene or DNF_BENCH_SCENE_COUNT if there is no such scene.
+ */
+dnf_bench_scene bench_scene_find(const char *name);
+
+/**
+ * @brief Runs a simulation tick of a scene.
+ *
+ * @param scene Scene to update.
+ * @param frame Frame index within the scene.
+ * @param dt Tick duration in seconds.
+ */
+void bench_scene_update(dnf_bench_scene scene, uint32_t frame, float32_t dt);
+
+/**
+ * @brief Queues drawing of a scene frame into the back buffer.
+ *
+ * @param ctx Rendering context.
+ * @param scene Scene to draw.
+ * @param frame Frame index within the scene (drives the animation).
+ * @param frame_arena Scratch memory of the frame.
+ */
+void bench_scene_draw(const renderer_context *ctx, dnf_bench_scene scene, uint32_t frame, dnf_arena *frame_arena);
+
+/**
+ * @brief Draws the scene's overlay. Must be called between
+ * renderer_begin_frame() and renderer_end_frame().
+ *
+ * @param ctx Rendering context.
+ * @param api Rendering API.
+ * @param scene Scene to draw.
+ * @param frame Frame index within the scene.
+ */
+void bench_scene_overlay(
+    const renderer_context *ctx, const dnf_renderer_api *api, dnf_bench_scene scene, uint32_t frame);
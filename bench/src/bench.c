@@ -0,0 +1,712 @@
+// DNF (Doomed and Forgotten): a DOOM-style first-person shooter.
+// Copyright (C) 2025-2026  Alexandr Gorbatenko
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+#include "bench_check.h"
+#include "bench_scenes.h"
+
+#include "engine.h"
+#include "job_system.h"
+#include "logger.h"
+#include "pixels.h"
+#include "renderer.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define BENCH_MAX_RESOLUTIONS 8
+#define BENCH_MAX_THRESHOLDS 128
+#define BENCH_DEFAULT_FRAMES 300
+#define BENCH_DEFAULT_WARMUP 30
+#define BENCH_CHECK_OPERATIONS 4000
+
+
+/**
+ * @brief Frame stages measured by the benchmark.
+ */
+typedef enum dnf_bench_stage
+{
+    DNF_BENCH_STAGE_UPDATE,
+    DNF_BENCH_STAGE_RENDER,
+    DNF_BENCH_STAGE_UPLOAD,
+    DNF_BENCH_STAGE_PRESENT,
+    DNF_BENCH_STAGE_FRAME,
+
+    DNF_BENCH_STAGE_COUNT
+} dnf_bench_stage;
+
+/**
+ * @brief Reported statistics of a stage.
+ */
+typedef enum dnf_bench_metric
+{
+    DNF_BENCH_METRIC_MIN,
+    DNF_BENCH_METRIC_MEDIAN,
+    DNF_BENCH_METRIC_P99,
+
+    DNF_BENCH_METRIC_COUNT
+} dnf_bench_metric;
+
+static const char *stage_names[DNF_BENCH_STAGE_COUNT] = {
+    "update", "render", "upload", "present", "frame"
+};
+static const char *metric_names[DNF_BENCH_METRIC_COUNT] = {
+    "min", "median", "p99"
+};
+
+/**
+ * @brief A benchmark resolution.
+ */
+typedef struct dnf_bench_resolution
+{
+    int32_t width;
+    int32_t height;
+} dnf_bench_resolution;
+
+/**
+ * @brief Timings of one scene at one resolution.
+ */
+typedef struct dnf_bench_result
+{
+    dnf_bench_scene scene;              //!< Measured scene
+    dnf_bench_resolution resolution;    //!< Measured resolution
+    float64_t stats[DNF_BENCH_STAGE_COUNT][DNF_BENCH_METRIC_COUNT];  //!< Milliseconds
+} dnf_bench_result;
+
+/**
+ * @brief A regression threshold: fails the run if the metric exceeds the limit.
+ */
+typedef struct dnf_bench_threshold
+{
+    dnf_bench_scene scene;           //!< Scene (DNF_BENCH_SCENE_COUNT - any)
+    dnf_bench_resolution resolution; //!< Resolution (0x0 - any)
+    dnf_bench_stage stage;           //!< Checked stage
+    dnf_bench_metric metric;         //!< Checked metric
+    float64_t limit_ms;              //!< Maximum allowed value
+} dnf_bench_threshold;
+
+/**
+ * @brief Benchmark settings.
+ */
+typedef struct dnf_bench_options
+{
+    uint32_t frames;          //!< Measured frames per scene
+    uint32_t warmup;          //!< Discarded frames per scene
+    uint32_t worker_threads;  //!< Job system workers (0 - auto)
+    uint32_t framebuffers;    //!< Framebuffer count
+    dnf_renderer_backend backend;
+    dnf_pixel_isa pixel_isa;  //!< Pixel kernel instruction set
+    bool8_t column_major;     //!< Render into a column-major target
+    dnf_pixel_format render_format;  //!< Render target format
+    const char *output_path;      //!< JSON results file ("-" - stdout)
+    const char *thresholds_path;  //!< Thresholds file (nullptr - no checks)
+    bool8_t check;            //!< Check the pixel kernels instead of benchmarking
+
+    dnf_bench_resolution resolutions[BENCH_MAX_RESOLUTIONS];
+    uint32_t resolution_count;
+    dnf_bench_scene scenes[DNF_BENCH_SCENE_COUNT];
+    uint32_t scene_count;
+} dnf_bench_options;
+
+static dnf_bench_options options;
+
+// state of the current run (one resolution)
+static float64_t *samples;        // [scene][stage][frame]
+static uint32_t run_frame = 0;    // frames rendered in this run
+static uint32_t thread_count = 1; // job system threads seen during the run
+static renderer_context *render_ctx;
+static dnf_renderer_api renderer;
+
+
+/**
+ * @brief Game init callback.
+ */
+static bool8_t bench_init(game *game_instance)
+{
+    render_ctx = game_instance->renderer_context;
+    renderer = game_instance->renderer_api;
+    run_frame = 0;
+    thread_count = job_system_thread_count();
+    return bench_scenes_set_palette(render_ctx->palette);
+}
+
+/**
+ * @brief Gets the scene of the current frame.
+ *
+ * @param out_frame Frame index within the scene.
+ * @return Scene.
+ */
+static dnf_bench_scene current_scene(uint32_t *out_frame)
+{
+    const uint32_t frames_per_scene = options.warmup + options.frames;
+
+    // the extra last frame only completes the measurements
+    uint32_t slot = run_frame / frames_per_scene;
+    if (slot >= options.scene_count)
+        slot = options.scene_count - 1;
+    *out_frame = run_frame - slot * frames_per_scene;
+    return options.scenes[slot];
+}
+
+/**
+ * @brief Game update (tick) callback (scenes are driven by the frame index).
+ */
+static bool8_t bench_update(game *game_instance, float32_t dt)
+{
+    (void)game_instance;
+
+    uint32_t scene_frame;
+    const dnf_bench_scene scene = current_scene(&scene_frame);
+    bench_scene_update(scene, scene_frame, dt);
+    return true;
+}
+
+/**
+ * @brief Game render callback: records the timings of the previous frame
+ * and draws the next scripted frame.
+ */
+static bool8_t bench_render(game *game_instance, float32_t alpha)
+{
+    // scenes are a function of the frame index, frames aren't interpolated
+    (void)alpha;
+
+    const uint32_t frames_per_scene = options.warmup + options.frames;
+
+    // timings of a frame are only complete once it has finished
+    if (run_frame > 0)
+    {
+        const uint32_t prev = run_frame - 1;
+        const uint32_t slot = prev / frames_per_scene;
+        const uint32_t index = prev % frames_per_scene;
+        if (slot < options.scene_count && index >= options.warmup)
+        {
+            const dnf_frame_timings timings = engine_get_frame_timings();
+            const float64_t values[DNF_BENCH_STAGE_COUNT] = {
+                timings.update_ms, timings.render_ms, timings.upload_ms,
+                timings.present_ms, timings.frame_ms
+            };
+            for (uint32_t stage = 0; stage < DNF_BENCH_STAGE_COUNT; stage++)
+                samples[((size_t)slot * DNF_BENCH_STAGE_COUNT + stage) * options.frames
+                    + (index - options.warmup)] = values[stage];
+        }
+    }
+
+    uint32_t scene_frame;
+    const dnf_bench_scene scene = current_scene(&scene_frame);
+
+    bench_scene_draw(render_ctx, scene, scene_frame, game_instance->frame_arena);
+
+    renderer_begin_frame(render_ctx);
+    bench_scene_overlay(render_ctx, &renderer, scene, scene_frame);
+    renderer_end_frame(render_ctx);
+    renderer_swap_buffers(render_ctx);
+
+    run_frame++;
+    return true;
+}
+
+/**
+ * @brief qsort comparator for frame times.
+ */
+static int compare_f64(const void *a, const void *b)
+{
+    const float64_t x = *(const float64_t *)a, y = *(const float64_t *)b;
+    return (x > y) - (x < y);
+}
+
+/**
+ * @brief Computes min/median/p99 of samples (sorts them in place).
+ */
+static void compute_stats(float64_t *values, const uint32_t count, float64_t out[DNF_BENCH_METRIC_COUNT])
+{
+    qsort(values, count, sizeof(float64_t), compare_f64);
+
+    // nearest-rank percentiles
+    uint32_t p99 = (uint32_t)((count * 99 + 99) / 100);
+    p99 = p99 > 0 ? p99 - 1 : 0;
+
+    out[DNF_BENCH_METRIC_MIN] = values[0];
+    out[DNF_BENCH_METRIC_MEDIAN] = values[count / 2];
+    out[DNF_BENCH_METRIC_P99] = values[p99 < count ? p99 : count - 1];
+}
+
+/**
+ * @brief Runs all scenes at one resolution through the engine.
+ *
+ * @param resolution Resolution to run at.
+ * @param out_results Results, one per scene.
+ * @return True if the engine ran successfully.
+ */
+static bool8_t run_resolution(const dnf_bench_resolution resolution, dnf_bench_result *out_results)
+{
+    dnf_engine_config engine_config = {
+        .start_width = resolution.width,
+        .start_height = resolution.height,
+        .title = "DNF BENCH",
+        .worker_threads = options.worker_threads,
+        .framebuffers = options.framebuffers,
+        .target_fps = 0,
+        .tick_rate = DNF_ENGINE_DEFAULT_TICK_RATE,
+        .max_ticks = DNF_ENGINE_DEFAULT_MAX_TICKS,
+        .asset_budget_ms = DNF_ENGINE_DEFAULT_ASSET_BUDGET_MS,
+        .frame_arena_size = DNF_ENGINE_DEFAULT_FRAME_ARENA_SIZE,
+        .backend = options.backend,
+        .pixel_isa = options.pixel_isa,
+        .column_major = options.column_major,
+        .render_format = options.render_format,
+        .render_scale = 1.0f,
+        .dynamic_resolution_ms = 0.0f,  // results are per resolution
+        // one extra frame to complete the timings of the last one
+        .frame_limit = options.scene_count * (options.warmup + options.frames) + 1,
+        .fixed_dt = 1.0f / 60.0f,
+        .dump_interval = 0,
+        .dump_dir = nullptr,
+        .async_logging = true,
+        .log_format = DNF_LOG_FORMAT_TEXT,
+        .log_levels = nullptr,
+    };
+    dnf_input_system_handler input_handler;
+    renderer_context ctx;
+    game game_instance = {
+        .engine_config = &engine_config,
+        .input_handler = &input_handler,
+        .renderer_context = &ctx,
+        .renderer_api = renderer_get_api(),
+        .init = bench_init,
+        .update = bench_update,
+        .render = bench_render,
+        .shutdown = nullptr,
+        .game_state = nullptr,
+    };
+
+    if (!engine_init(&game_instance))
+        return false;
+    if (!engine_run())
+        return false;
+
+    for (uint32_t slot = 0; slot < options.scene_count; slot++)
+    {
+        dnf_bench_result *result = &out_results[slot];
+        result->scene = options.scenes[slot];
+        result->resolution = resolution;
+        for (uint32_t stage = 0; stage < DNF_BENCH_STAGE_COUNT; stage++)
+            compute_stats(
+                samples + ((size_t)slot * DNF_BENCH_STAGE_COUNT + stage) * options.frames,
+                options.frames, result->stats[stage]);
+    }
+
+    return true;
+}
+
+/**
+ * @brief Finds a name in a list.
+ *
+ * @return Index of the name or count if it's not there.
+ */
+static uint32_t find_name(const char *const *names, const uint32_t count, const char *name)
+{
+    for (uint32_t i = 0; i < count; i++)
+        if (strcmp(names[i], name) == 0)
+            return i;
+    return count;
+}
+
+/**
+ * @brief Parses a "WIDTHxHEIGHT" resolution.
+ *
+ * @return True if the resolution is valid.
+ */
+static bool8_t parse_resolution(const char *text, dnf_bench_resolution *out_resolution)
+{
+    int32_t width, height;
+    if (sscanf(text, "%dx%d", &width, &height) != 2 || width < 16 || height < 16)
+        return false;
+    *out_resolution = (dnf_bench_resolution){ width, height };
+    return true;
+}
+
+/**
+ * @brief Loads regression thresholds.
+ *
+ * One threshold per line: "SCENE RESOLUTION STAGE METRIC MAX_MS", where
+ * SCENE and RESOLUTION (WIDTHxHEIGHT) may be "*" to match anything, e.g.
+ * "walls_bsp 1920x1080 render p99 8.0". Empty lines and lines starting
+ * with '#' are ignored.
+ *
+ * @param path Thresholds file.
+ * @param out_thresholds Loaded thresholds.
+ * @param out_count Number of loaded thresholds.
+ * @return True if the file was read and every line is valid.
+ */
+static bool8_t load_thresholds(const char *path, dnf_bench_threshold *out_thresholds, uint32_t *out_count)
+{
+    FILE *file = fopen(path, "r");
+    if (!file)
+    {
+        DNF_ERROR("Could not open thresholds file %s", path);
+        return false;
+    }
+
+    char line[256];
+    uint32_t line_number = 0, count = 0;
+    bool8_t ok = true;
+    while (ok && fgets(line, sizeof(line), file))
+    {
+        line_number++;
+        char scene[32], resolution[32], stage[32], metric[32];
+        float64_t limit_ms;
+        const int fields = sscanf(line, "%31s %31s %31s %31s %lf", scene, resolution, stage, metric, &limit_ms);
+        if (fields <= 0 || scene[0] == '#')
+            continue;
+
+        dnf_bench_threshold *threshold = &out_thresholds[count];
+        ok = fields == 5 && count < BENCH_MAX_THRESHOLDS;
+        if (ok)
+        {
+            threshold->scene = strcmp(scene, "*") == 0 ? DNF_BENCH_SCENE_COUNT : bench_scene_find(scene);
+            threshold->resolution = (dnf_bench_resolution){ 0, 0 };
+            threshold->stage = find_name(stage_names, DNF_BENCH_STAGE_COUNT, stage);
+            threshold->metric = find_name(metric_names, DNF_BENCH_METRIC_COUNT, metric);
+            threshold->limit_ms = limit_ms;
+
+            ok = (strcmp(scene, "*") == 0 || threshold->scene != DNF_BENCH_SCENE_COUNT)
+                && (strcmp(resolution, "*") == 0 || parse_resolution(resolution, &threshold->resolution))
+                && threshold->stage != DNF_BENCH_STAGE_COUNT
+                && threshold->metric != DNF_BENCH_METRIC_COUNT;
+        }
+
+        if (!ok)
+            DNF_ERROR("Invalid threshold at %s:%u", path, line_number);
+        else
+            count++;
+    }
+    fclose(file);
+
+    *out_count = count;
+    return ok;
+}
+
+/**
+ * @brief Checks whether a threshold applies to a result.
+ */
+static bool8_t threshold_matches(const dnf_bench_threshold *threshold, const dnf_bench_result *result)
+{
+    if (threshold->scene != DNF_BENCH_SCENE_COUNT && threshold->scene != result->scene)
+        return false;
+    if (threshold->resolution.width != 0
+        && (threshold->resolution.width != result->resolution.width
+            || threshold->resolution.height != result->resolution.height))
+        return false;
+    return true;
+}
+
+/**
+ * @brief Writes the results (and threshold failures) as JSON.
+ *
+ * @return True if the file was written.
+ */
+static bool8_t write_results(
+    const dnf_bench_result *results, const uint32_t result_count,
+    const dnf_bench_threshold *thresholds, const uint32_t threshold_count)
+{
+    const bool8_t to_stdout = strcmp(options.output_path, "-") == 0;
+    FILE *file = to_stdout ? stdout : fopen(options.output_path, "w");
+    if (!file)
+    {
+        DNF_ERROR("Could not open output file %s", options.output_path);
+        return false;
+    }
+
+    fprintf(file, "{\n");
+    fprintf(file, "  \"frames\": %u,\n  \"warmup\": %u,\n", options.frames, options.warmup);
+    fprintf(file, "  \"threads\": %u,\n  \"framebuffers\": %u,\n", thread_count, options.framebuffers);
+    fprintf(file, "  \"backend\": \"%s\",\n",
+        options.backend == DNF_RENDERER_BACKEND_HEADLESS ? "headless" : "window");
+    fprintf(file, "  \"pixel_isa\": \"%s\",\n", pixels_isa_name(pixels_get_isa()));
+    fprintf(file, "  \"column_major\": %s,\n", options.column_major ? "true" : "false");
+    fprintf(file, "  \"render_format\": \"%s\",\n",
+        options.render_format == DNF_PIXEL_FORMAT_INDEXED8 ? "indexed8" : "rgba8");
+
+    fprintf(file, "  \"results\": [");
+    for (uint32_t i = 0; i < result_count; i++)
+    {
+        const dnf_bench_result *result = &results[i];
+        fprintf(file, "%s\n    {\"scene\": \"%s\", \"width\": %d, \"height\": %d",
+            i > 0 ? "," : "", bench_scene_name(result->scene),
+            result->resolution.width, result->resolution.height);
+        for (uint32_t stage = 0; stage < DNF_BENCH_STAGE_COUNT; stage++)
+        {
+            fprintf(file, ", \"%s\": {", stage_names[stage]);
+            for (uint32_t metric = 0; metric < DNF_BENCH_METRIC_COUNT; metric++)
+                fprintf(file, "%s\"%s_ms\": %.4f", metric > 0 ? ", " : "",
+                    metric_names[metric], result->stats[stage][metric]);
+            fprintf(file, "}");
+        }
+        fprintf(file, "}");
+    }
+    fprintf(file, "\n  ],\n");
+
+    fprintf(file, "  \"failures\": [");
+    uint32_t failures = 0;
+    for (uint32_t i = 0; i < result_count; i++)
+    {
+        for (uint32_t t = 0; t < threshold_count; t++)
+        {
+            const dnf_bench_threshold *threshold = &thresholds[t];
+            if (!threshold_matches(threshold, &results[i]))
+                continue;
+
+            const float64_t value = results[i].stats[threshold->stage][threshold->metric];
+            if (value <= threshold->limit_ms)
+                continue;
+
+            fprintf(file, "%s\n    {\"scene\": \"%s\", \"width\": %d, \"height\": %d, "
+                "\"stage\": \"%s\", \"metric\": \"%s\", \"value_ms\": %.4f, \"limit_ms\": %.4f}",
+                failures > 0 ? "," : "", bench_scene_name(results[i].scene),
+                results[i].resolution.width, results[i].resolution.height,
+                stage_names[threshold->stage], metric_names[threshold->metric],
+                value, threshold->limit_ms);
+            failures++;
+        }
+    }
+    fprintf(file, "%s]\n}\n", failures > 0 ? "\n  " : "");
+
+    if (!to_stdout)
+        fclose(file);
+    return true;
+}
+
+/**
+ * @brief Logs a human-readable summary and the threshold failures.
+ *
+ * @return Number of threshold failures.
+ */
+static uint32_t report_results(
+    const dnf_bench_result *results, const uint32_t result_count,
+    const dnf_bench_threshold *thresholds, const uint32_t threshold_count)
+{
+    uint32_t failures = 0;
+    for (uint32_t i = 0; i < result_count; i++)
+    {
+        const dnf_bench_result *result = &results[i];
+        const float64_t (*stats)[DNF_BENCH_METRIC_COUNT] = result->stats;
+        DNF_INFO(
+            "%-14s %4dx%-4d | frame %7.3f/%7.3f/%7.3f | update %6.3f | render %7.3f | upload %6.3f | present %6.3f (ms, min/median/p99, median)",
+            bench_scene_name(result->scene), result->resolution.width, result->resolution.height,
+            stats[DNF_BENCH_STAGE_FRAME][DNF_BENCH_METRIC_MIN],
+            stats[DNF_BENCH_STAGE_FRAME][DNF_BENCH_METRIC_MEDIAN],
+            stats[DNF_BENCH_STAGE_FRAME][DNF_BENCH_METRIC_P99],
+            stats[DNF_BENCH_STAGE_UPDATE][DNF_BENCH_METRIC_MEDIAN],
+            stats[DNF_BENCH_STAGE_RENDER][DNF_BENCH_METRIC_MEDIAN],
+            stats[DNF_BENCH_STAGE_UPLOAD][DNF_BENCH_METRIC_MEDIAN],
+            stats[DNF_BENCH_STAGE_PRESENT][DNF_BENCH_METRIC_MEDIAN]);
+
+        for (uint32_t t = 0; t < threshold_count; t++)
+        {
+            const dnf_bench_threshold *threshold = &thresholds[t];
+            if (!threshold_matches(threshold, result))
+                continue;
+
+            const float64_t value = stats[threshold->stage][threshold->metric];
+            if (value > threshold->limit_ms)
+            {
+                DNF_ERROR(
+                    "Regression: %s %dx%d %s %s = %.3f ms (limit %.3f ms)",
+                    bench_scene_name(result->scene), result->resolution.width, result->resolution.height,
+                    stage_names[threshold->stage], metric_names[threshold->metric],
+                    value, threshold->limit_ms);
+                failures++;
+            }
+        }
+    }
+    return failures;
+}
+
+/**
+ * @brief Parses command line options.
+ *
+ * Supported options:
+ * --window (present frames in a window, headless by default),
+ * --column-major (render into a column-major target),
+ * --indexed (render into an 8-bit palette target),
+ * --frames N (measured frames per scene), --warmup N (discarded frames),
+ * --threads N (job workers), --framebuffers N,
+ * --isa NAME (pixel kernels: auto, scalar, sse2, avx2, neon),
+ * --resolutions WxH[,WxH...], --scenes NAME[,NAME...],
+ * --output PATH (JSON results, "-" for stdout),
+ * --thresholds PATH (regression thresholds, see load_thresholds()),
+ * --check (check the pixel kernels of every instruction set against
+ * per-pixel references instead of benchmarking).
+ *
+ * @return True if all options are valid.
+ */
+static bool8_t parse_arguments(const int argc, char **argv)
+{
+    options = (dnf_bench_options){
+        .frames = BENCH_DEFAULT_FRAMES,
+        .warmup = BENCH_DEFAULT_WARMUP,
+        .worker_threads = 0,
+        .framebuffers = 2,
+        .backend = DNF_RENDERER_BACKEND_HEADLESS,
+        .pixel_isa = DNF_PIXEL_ISA_AUTO,
+        .column_major = false,
+        .render_format = DNF_PIXEL_FORMAT_RGBA8,
+        .output_path = "./bench_results.json",
+        .thresholds_path = nullptr,
+        .check = false,
+        .resolutions = { { 640, 360 }, { 960, 540 }, { 1920, 1080 } },
+        .resolution_count = 3,
+        .scene_count = 0,
+    };
+    for (uint32_t i = 0; i < DNF_BENCH_SCENE_COUNT; i++)
+        options.scenes[options.scene_count++] = (dnf_bench_scene)i;
+
+    for (int i = 1; i < argc; i++)
+    {
+        const char *arg = argv[i];
+        char *value = i + 1 < argc ? argv[i + 1] : nullptr;
+        bool8_t ok = true;
+
+        if (strcmp(arg, "--window") == 0)
+        {
+            options.backend = DNF_RENDERER_BACKEND_WINDOW;
+            continue;
+        }
+        if (strcmp(arg, "--column-major") == 0)
+        {
+            options.column_major = true;
+            continue;
+        }
+        if (strcmp(arg, "--indexed") == 0)
+        {
+            options.render_format = DNF_PIXEL_FORMAT_INDEXED8;
+            continue;
+        }
+        if (strcmp(arg, "--check") == 0)
+        {
+            options.check = true;
+            continue;
+        }
+        if (!value)
+            ok = false;
+        else if (strcmp(arg, "--frames") == 0)
+            ok = (options.frames = (uint32_t)strtoul(value, nullptr, 10)) > 0;
+        else if (strcmp(arg, "--warmup") == 0)
+            options.warmup = (uint32_t)strtoul(value, nullptr, 10);
+        else if (strcmp(arg, "--threads") == 0)
+            options.worker_threads = (uint32_t)strtoul(value, nullptr, 10);
+        else if (strcmp(arg, "--framebuffers") == 0)
+            options.framebuffers = (uint32_t)strtoul(value, nullptr, 10);
+        else if (strcmp(arg, "--isa") == 0)
+            ok = (options.pixel_isa = pixels_isa_find(value)) != DNF_PIXEL_ISA_COUNT;
+        else if (strcmp(arg, "--output") == 0)
+            options.output_path = value;
+        else if (strcmp(arg, "--thresholds") == 0)
+            options.thresholds_path = value;
+        else if (strcmp(arg, "--resolutions") == 0)
+        {
+            options.resolution_count = 0;
+            for (char *token = strtok(value, ","); ok && token; token = strtok(nullptr, ","))
+                ok = options.resolution_count < BENCH_MAX_RESOLUTIONS
+                    && parse_resolution(token, &options.resolutions[options.resolution_count++]);
+            ok = ok && options.resolution_count > 0;
+        }
+        else if (strcmp(arg, "--scenes") == 0)
+        {
+            options.scene_count = 0;
+            for (char *token = strtok(value, ","); ok && token; token = strtok(nullptr, ","))
+            {
+                const dnf_bench_scene scene = bench_scene_find(token);
+                ok = scene != DNF_BENCH_SCENE_COUNT && options.scene_count < DNF_BENCH_SCENE_COUNT;
+                if (ok)
+                    options.scenes[options.scene_count++] = scene;
+            }
+            ok = ok && options.scene_count > 0;
+        }
+        else
+            ok = false;
+
+        if (!ok)
+        {
+            DNF_ERROR("Unknown, incomplete or invalid command line option: %s", arg);
+            return false;
+        }
+        i++;
+    }
+
+    return true;
+}
+
+/**
+ * @brief Benchmark entry point.
+ *
+ * @param argc Argument count.
+ * @param argv Arguments (see parse_arguments()).
+ * @return 0 if all thresholds (or checks) passed, 1 on a regression (or a
+ * failed check), 2 on errors.
+ */
+int main(int argc, char **argv)
+{
+    if (!parse_arguments(argc, argv))
+        return 2;
+    if (options.check)
+        return bench_check_pixels(BENCH_CHECK_OPERATIONS) ? 0 : 1;
+
+    static dnf_bench_threshold thresholds[BENCH_MAX_THRESHOLDS];
+    uint32_t threshold_count = 0;
+    if (options.thresholds_path && !load_thresholds(options.thresholds_path, thresholds, &threshold_count))
+        return 2;
+
+    if (!bench_scenes_init())
+    {
+        DNF_FATAL("Could not build benchmark scenes!");
+        return 2;
+    }
+
+    const uint32_t result_count = options.resolution_count * options.scene_count;
+    dnf_bench_result *results = calloc(result_count, sizeof(dnf_bench_result));
+    samples = malloc(sizeof(float64_t) * options.scene_count * DNF_BENCH_STAGE_COUNT * options.frames);
+    if (!results || !samples)
+    {
+        DNF_FATAL("Out of memory!");
+        return 2;
+    }
+
+    int exit_code = 0;
+    for (uint32_t i = 0; i < options.resolution_count; i++)
+    {
+        if (!run_resolution(options.resolutions[i], results + i * options.scene_count))
+        {
+            DNF_FATAL("Benchmark run at %dx%d failed!",
+                options.resolutions[i].width, options.resolutions[i].height);
+            exit_code = 2;
+            break;
+        }
+    }
+
+    if (exit_code == 0)
+    {
+        if (report_results(results, result_count, thresholds, threshold_count) > 0)
+            exit_code = 1;
+        if (!write_results(results, result_count, thresholds, threshold_count))
+            exit_code = 2;
+    }
+
+    bench_scenes_shutdown();
+    free(samples);
+    free(results);
+
+    return exit_code;
+}
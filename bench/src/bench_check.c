@@ -0,0 +1,446 @@
+// DNF (Doomed and Forgotten): a DOOM-style first-person shooter.
+// Copyright (C) 2025-2026  Alexandr Gorbatenko
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+#include "bench_check.h"
+
+#include "logger.h"
+#include "palette.h"
+#include "pixels.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+// Size of the checked framebuffers (odd, so kernels get leftover pixels).
+#define BENCH_CHECK_WIDTH 203
+#define BENCH_CHECK_HEIGHT 157
+// Size of the blit sources.
+#define BENCH_CHECK_SOURCE_WIDTH 150
+#define BENCH_CHECK_SOURCE_HEIGHT 97
+// How far rectangles may start outside a framebuffer (clipping).
+#define BENCH_CHECK_MARGIN 20
+// Palette entry made transparent for keyed blits of indexed sources.
+#define BENCH_CHECK_TRANSPARENT_INDEX 5
+// Largest side of the textures of textured spans (a power of two).
+#define BENCH_CHECK_TEXTURE_SIZE 64
+// Fraction bits of the texel coordinates the pixel kernels step.
+#define BENCH_CHECK_TEXEL_FRACTION 16
+
+/**
+ * @brief Checked pixel primitives.
+ */
+typedef enum dnf_check_op
+{
+    DNF_CHECK_OP_CLEAR,
+    DNF_CHECK_OP_FILL_RECT,
+    DNF_CHECK_OP_FILL_SPAN,
+    DNF_CHECK_OP_FILL_COLUMN,
+    DNF_CHECK_OP_FILL_RECT_INDEX,
+    DNF_CHECK_OP_FILL_SPAN_INDEX,
+    DNF_CHECK_OP_FILL_COLUMN_INDEX,
+    DNF_CHECK_OP_BLIT,
+    DNF_CHECK_OP_BLIT_KEYED,
+    DNF_CHECK_OP_SPAN_TEXTURED,
+
+    DNF_CHECK_OP_COUNT
+} dnf_check_op;
+
+static const char *op_names[DNF_CHECK_OP_COUNT] = {
+    "clear", "fill_rect", "fill_span", "fill_column",
+    "fill_rect_index", "fill_span_index", "fill_column_index",
+    "blit", "blit_keyed", "span_textured"
+};
+
+/**
+ * @brief A framebuffer and what its pixels should be.
+ */
+typedef struct dnf_check_target
+{
+    dnf_framebuffer fb;
+    uint32_t *expected;  //!< Pixel values (Color bits or palette indices), row-major
+} dnf_check_target;
+
+static uint32_t rng_state = 0x2545f491u;
+static dnf_palette palette;
+static Color texture[BENCH_CHECK_TEXTURE_SIZE * BENCH_CHECK_TEXTURE_SIZE];
+
+
+/**
+ * @brief Gets the next pseudo-random number (xorshift32).
+ */
+static uint32_t random_next(void)
+{
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 17;
+    rng_state ^= rng_state << 5;
+    return rng_state;
+}
+
+/**
+ * @brief Gets a pseudo-random number in [low; high).
+ */
+static int32_t random_range(const int32_t low, const int32_t high)
+{
+    return low + (int32_t)(random_next() % (uint32_t)(high - low));
+}
+
+/**
+ * @brief Gets a random color, fully transparent or opaque most of the time.
+ */
+static Color random_color(void)
+{
+    const uint32_t bits = random_next();
+    Color color;
+    memcpy(&color, &bits, sizeof(color));
+    const uint32_t alpha = random_next() % 4;
+    if (alpha < 2)
+        color.a = alpha == 0 ? 0 : 255;
+    return color;
+}
+
+static uint32_t color_bits(const Color color)
+{
+    uint32_t bits;
+    memcpy(&bits, &color, sizeof(bits));
+    return bits;
+}
+
+/**
+ * @brief Gets the storage offset of a pixel.
+ */
+static size_t pixel_offset(const dnf_framebuffer *fb, const int32_t x, const int32_t y)
+{
+    if (fb->layout == DNF_FRAMEBUFFER_COLUMN_MAJOR)
+        return (size_t)x * fb->height + y;
+    return (size_t)y * fb->width + x;
+}
+
+/**
+ * @brief Reads a pixel value (Color bits or a palette index).
+ */
+static uint32_t read_value(const dnf_framebuffer *fb, const int32_t x, const int32_t y)
+{
+    if (fb->format == DNF_PIXEL_FORMAT_INDEXED8)
+        return ((const uint8_t *)fb->pixels)[pixel_offset(fb, x, y)];
+    return ((const uint32_t *)fb->pixels)[pixel_offset(fb, x, y)];
+}
+
+/**
+ * @brief Writes a pixel value (Color bits or a palette index).
+ */
+static void write_value(const dnf_framebuffer *fb, const int32_t x, const int32_t y, const uint32_t value)
+{
+    if (fb->format == DNF_PIXEL_FORMAT_INDEXED8)
+        ((uint8_t *)fb->pixels)[pixel_offset(fb, x, y)] = (uint8_t)value;
+    else
+        ((uint32_t *)fb->pixels)[pixel_offset(fb, x, y)] = value;
+}
+
+/**
+ * @brief Reads a pixel as a color (indices go through the palette).
+ */
+static Color read_color(const dnf_framebuffer *fb, const int32_t x, const int32_t y)
+{
+    if (fb->format == DNF_PIXEL_FORMAT_INDEXED8)
+        return fb->palette->colors[read_value(fb, x, y)];
+
+    const uint32_t bits = read_value(fb, x, y);
+    Color color;
+    memcpy(&color, &bits, sizeof(color));
+    return color;
+}
+
+/**
+ * @brief Gives a framebuffer a random layout, format and contents.
+ */
+static void randomize(dnf_framebuffer *fb, uint32_t *expected)
+{
+    fb->layout = random_next() % 2 ? DNF_FRAMEBUFFER_COLUMN_MAJOR : DNF_FRAMEBUFFER_ROW_MAJOR;
+    fb->format = random_next() % 2 ? DNF_PIXEL_FORMAT_INDEXED8 : DNF_PIXEL_FORMAT_RGBA8;
+    fb->palette = &palette;
+    for (int32_t y = 0; y < fb->height; y++)
+    {
+        for (int32_t x = 0; x < fb->width; x++)
+        {
+            const uint32_t value = fb->format == DNF_PIXEL_FORMAT_INDEXED8
+                ? random_next() & 0xff
+                : color_bits(random_color());
+            write_value(fb, x, y, value);
+            if (expected)
+                expected[(size_t)y * fb->width + x] = value;
+        }
+    }
+}
+
+/**
+ * @brief Sets the expected value of the pixels of a rectangle, clipped to
+ * the target.
+ */
+static void expect_rect(
+    dnf_check_target *target,
+    int32_t x0, int32_t y0, int32_t x1, int32_t y1,
+    const uint32_t value)
+{
+    x0 = x0 < 0 ? 0 : x0;
+    y0 = y0 < 0 ? 0 : y0;
+    x1 = x1 > target->fb.width ? target->fb.width : x1;
+    y1 = y1 > target->fb.height ? target->fb.height : y1;
+    for (int32_t y = y0; y < y1; y++)
+        for (int32_t x = x0; x < x1; x++)
+            target->expected[(size_t)y * target->fb.width + x] = value;
+}
+
+/**
+ * @brief Sets the expected value of the pixels a blit covers.
+ */
+static void expect_blit(
+    dnf_check_target *target, const int32_t dst_x, const int32_t dst_y,
+    const dnf_framebuffer *src, const int32_t src_x, const int32_t src_y,
+    const int32_t width, const int32_t height,
+    const bool8_t keyed)
+{
+    const dnf_framebuffer *dst = &target->fb;
+    for (int32_t y = 0; y < height; y++)
+    {
+        for (int32_t x = 0; x < width; x++)
+        {
+            const int32_t dx = dst_x + x, dy = dst_y + y;
+            const int32_t sx = src_x + x, sy = src_y + y;
+            if (dx < 0 || dy < 0 || dx >= dst->width || dy >= dst->height
+                || sx < 0 || sy < 0 || sx >= src->width || sy >= src->height)
+                continue;
+
+            // indices are copied as they are, colors go to the closest index
+            uint32_t value;
+            const Color color = read_color(src, sx, sy);
+            if (keyed && color.a == 0)
+                continue;
+            if (!keyed && src->format == DNF_PIXEL_FORMAT_INDEXED8 && dst->format == DNF_PIXEL_FORMAT_INDEXED8)
+                value = read_value(src, sx, sy);
+            else if (dst->format == DNF_PIXEL_FORMAT_INDEXED8)
+                value = palette_find(dst->palette, color);
+            else
+                value = color_bits(color);
+            target->expected[(size_t)dy * dst->width + dx] = value;
+        }
+    }
+}
+
+/**
+ * @brief Draws a random textured span and sets the expected value of the
+ * pixels it covers.
+ *
+ * Coordinates are whole fixed-point steps small enough for floats to hold
+ * exactly, so the clipped start is the same in the model and in the kernels.
+ */
+static void check_span_textured(dnf_check_target *target, const int32_t y, const int32_t x0, const int32_t x1)
+{
+    const dnf_framebuffer *fb = &target->fb;
+    const int32_t width = 1 << random_range(0, 7), height = 1 << random_range(0, 7);
+    for (int32_t i = 0; i < width * height; i++)
+        texture[i] = random_color();
+
+    const float32_t unit = 1.0f / (float32_t)(1 << BENCH_CHECK_TEXEL_FRACTION);
+    const int32_t u = random_range(-(1 << 20), 1 << 20), v = random_range(-(1 << 20), 1 << 20);
+    const int32_t u_step = random_range(-(1 << 17), 1 << 17), v_step = random_range(-(1 << 17), 1 << 17);
+    const float32_t light = random_next() % 2 ? 1.0f : (float32_t)random_range(0, 257) / 256.0f;
+    pixels_draw_span_textured(
+        fb, y, x0, x1, texture, width, height,
+        (float32_t)u * unit, (float32_t)v * unit, (float32_t)u_step * unit, (float32_t)v_step * unit, light);
+
+    if (y < 0 || y >= fb->height)
+        return;
+    const uint32_t scale = light >= 1.0f ? 256 : (uint32_t)(light * 256.0f);
+    for (int32_t x = x0 < 0 ? 0 : x0; x < x1 && x < fb->width; x++)
+    {
+        const uint32_t u_position = (uint32_t)u + (uint32_t)(x - x0) * (uint32_t)u_step;
+        const uint32_t v_position = (uint32_t)v + (uint32_t)(x - x0) * (uint32_t)v_step;
+        const Color texel = texture[
+            ((v_position >> BENCH_CHECK_TEXEL_FRACTION) & (uint32_t)(height - 1)) * (uint32_t)width
+            + ((u_position >> BENCH_CHECK_TEXEL_FRACTION) & (uint32_t)(width - 1))];
+
+        uint32_t value;
+        if (fb->format == DNF_PIXEL_FORMAT_INDEXED8)
+            value = palette_light(&palette, palette_find(&palette, texel), palette_light_level(light));
+        else
+        {
+            const uint32_t bits = color_bits(texel);
+            value = (((bits & 0x00ff00ffu) * scale >> 8) & 0x00ff00ffu)
+                | (((bits & 0x0000ff00u) * scale >> 8) & 0x0000ff00u)
+                | (bits & 0xff000000u);
+        }
+        target->expected[(size_t)y * fb->width + x] = value;
+    }
+}
+
+/**
+ * @brief Runs a random operation on the target and records what it should
+ * have written.
+ *
+ * @return Operation that was run.
+ */
+static dnf_check_op run_random_op(dnf_check_target *target, dnf_framebuffer *source)
+{
+    const dnf_framebuffer *fb = &target->fb;
+    const bool8_t indexed = fb->format == DNF_PIXEL_FORMAT_INDEXED8;
+
+    dnf_check_op op = (dnf_check_op)(random_next() % DNF_CHECK_OP_COUNT);
+    if (!indexed && op >= DNF_CHECK_OP_FILL_RECT_INDEX && op <= DNF_CHECK_OP_FILL_COLUMN_INDEX)
+        op -= DNF_CHECK_OP_FILL_RECT_INDEX - DNF_CHECK_OP_FILL_RECT;
+
+    const int32_t x0 = random_range(-BENCH_CHECK_MARGIN, fb->width + BENCH_CHECK_MARGIN);
+    const int32_t y0 = random_range(-BENCH_CHECK_MARGIN, fb->height + BENCH_CHECK_MARGIN);
+    const int32_t x1 = x0 + random_range(-4, fb->width);
+    const int32_t y1 = y0 + random_range(-4, fb->height);
+    const Color color = random_color();
+    const uint8_t index = (uint8_t)random_next();
+    const uint32_t value = indexed ? palette_find(&palette, color) : color_bits(color);
+
+    switch (op)
+    {
+    case DNF_CHECK_OP_CLEAR:
+        pixels_clear(fb, color);
+        expect_rect(target, 0, 0, fb->width, fb->height, value);
+        break;
+    case DNF_CHECK_OP_FILL_RECT:
+        pixels_fill_rect(fb, x0, y0, x1, y1, color);
+        expect_rect(target, x0, y0, x1, y1, value);
+        break;
+    case DNF_CHECK_OP_FILL_SPAN:
+        pixels_fill_span(fb, y0, x0, x1, color);
+        expect_rect(target, x0, y0, x1, y0 + 1, value);
+        break;
+    case DNF_CHECK_OP_FILL_COLUMN:
+        pixels_fill_column(fb, x0, y0, y1, color);
+        expect_rect(target, x0, y0, x0 + 1, y1, value);
+        break;
+    case DNF_CHECK_OP_FILL_RECT_INDEX:
+        pixels_fill_rect_index(fb, x0, y0, x1, y1, index);
+        expect_rect(target, x0, y0, x1, y1, index);
+        break;
+    case DNF_CHECK_OP_FILL_SPAN_INDEX:
+        pixels_fill_span_index(fb, y0, x0, x1, index);
+        expect_rect(target, x0, y0, x1, y0 + 1, index);
+        break;
+    case DNF_CHECK_OP_FILL_COLUMN_INDEX:
+        pixels_fill_column_index(fb, x0, y0, y1, index);
+        expect_rect(target, x0, y0, x0 + 1, y1, index);
+        break;
+    case DNF_CHECK_OP_BLIT:
+    case DNF_CHECK_OP_BLIT_KEYED:
+    {
+        const bool8_t keyed = op == DNF_CHECK_OP_BLIT_KEYED;
+        randomize(source, nullptr);
+        const int32_t src_x = random_range(-BENCH_CHECK_MARGIN, source->width + BENCH_CHECK_MARGIN);
+        const int32_t src_y = random_range(-BENCH_CHECK_MARGIN, source->height + BENCH_CHECK_MARGIN);
+        const int32_t width = x1 - x0, height = y1 - y0;
+        if (keyed)
+            pixels_blit_keyed(fb, x0, y0, source, src_x, src_y, width, height);
+        else
+            pixels_blit(fb, x0, y0, source, src_x, src_y, width, height);
+        expect_blit(target, x0, y0, source, src_x, src_y, width, height, keyed);
+        break;
+    }
+    case DNF_CHECK_OP_SPAN_TEXTURED:
+        check_span_textured(target, y0, x0, x1);
+        break;
+    default:
+        break;
+    }
+    return op;
+}
+
+/**
+ * @brief Compares a target with its expected pixels.
+ *
+ * @return True if they match.
+ */
+static bool8_t target_matches(const dnf_check_target *target)
+{
+    const dnf_framebuffer *fb = &target->fb;
+    for (int32_t y = 0; y < fb->height; y++)
+        for (int32_t x = 0; x < fb->width; x++)
+            if (read_value(fb, x, y) != target->expected[(size_t)y * fb->width + x])
+                return false;
+    return true;
+}
+
+bool8_t bench_check_pixels(const uint32_t iterations)
+{
+    const size_t target_pixels = (size_t)BENCH_CHECK_WIDTH * BENCH_CHECK_HEIGHT;
+    const size_t source_pixels = (size_t)BENCH_CHECK_SOURCE_WIDTH * BENCH_CHECK_SOURCE_HEIGHT;
+    dnf_check_target target = {
+        .fb = {
+            .pixels = malloc(target_pixels * sizeof(uint32_t)),
+            .width = BENCH_CHECK_WIDTH,
+            .height = BENCH_CHECK_HEIGHT
+        },
+        .expected = malloc(target_pixels * sizeof(uint32_t))
+    };
+    dnf_framebuffer source = {
+        .pixels = malloc(source_pixels * sizeof(uint32_t)),
+        .width = BENCH_CHECK_SOURCE_WIDTH,
+        .height = BENCH_CHECK_SOURCE_HEIGHT
+    };
+    if (!target.fb.pixels || !target.expected || !source.pixels)
+    {
+        DNF_ERROR("Out of memory for the pixel checks");
+        free(target.fb.pixels);
+        free(target.expected);
+        free(source.pixels);
+        return false;
+    }
+
+    palette_init_default(&palette);
+    palette.colors[BENCH_CHECK_TRANSPARENT_INDEX].a = 0;
+
+    const dnf_pixel_isa selected = pixels_get_isa();
+    uint32_t failures = 0;
+    for (uint32_t isa = DNF_PIXEL_ISA_SCALAR; isa < DNF_PIXEL_ISA_COUNT; isa++)
+    {
+        if (!pixels_isa_supported((dnf_pixel_isa)isa))
+            continue;
+        pixels_init((dnf_pixel_isa)isa);
+
+        uint32_t isa_failures = 0;
+        for (uint32_t i = 0; i < iterations; i++)
+        {
+            // start over on a new framebuffer now and then
+            if (i % 16 == 0)
+                randomize(&target.fb, target.expected);
+
+            const dnf_check_op op = run_random_op(&target, &source);
+            if (!target_matches(&target))
+            {
+                if (isa_failures++ < 8)
+                    DNF_ERROR(
+                        "Pixel check failed (%s): %s into a %s %s framebuffer",
+                        pixels_isa_name((dnf_pixel_isa)isa), op_names[op],
+                        target.fb.layout == DNF_FRAMEBUFFER_COLUMN_MAJOR ? "column-major" : "row-major",
+                        target.fb.format == DNF_PIXEL_FORMAT_INDEXED8 ? "indexed" : "RGBA");
+                randomize(&target.fb, target.expected);
+            }
+        }
+        DNF_INFO(
+            "Pixel checks (%s): %u of %u operations matched",
+            pixels_isa_name((dnf_pixel_isa)isa), iterations - isa_failures, iterations);
+        failures += isa_failures;
+    }
+
+    pixels_init(selected);
+    free(target.fb.pixels);
+    free(target.expected);
+    free(source.pixels);
+    return failures == 0;
+}
@@ -0,0 +1,560 @@
+// DNF (Doomed and Forgotten): a DOOM-style first-person shooter.
+// Copyright (C) 2025-2026  Alexandr Gorbatenko
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+#include "bench_scenes.h"
+
+#include "blockmap.h"
+#include "bsp.h"
+#include "entity.h"
+#include "pixels.h"
+#include "raycaster.h"
+#include "sprites.h"
+#include "texture_cache.h"
+
+#include <math.h>
+#include <stdio.h>   // overlay text formatting
+#include <string.h>  // strcmp
+
+// BSP scene: a square room with a grid of alternating pillars and platforms
+#define BENCH_LEVEL_CELLS 8
+#define BENCH_LEVEL_SPACING 4.0f
+#define BENCH_LEVEL_SIZE ((BENCH_LEVEL_CELLS + 1) * BENCH_LEVEL_SPACING)
+#define BENCH_LEVEL_BLOCK 1.5f
+#define BENCH_LEVEL_VERTICES (4 + BENCH_LEVEL_CELLS * BENCH_LEVEL_CELLS * 4)
+#define BENCH_LEVEL_SECTORS (1 + BENCH_LEVEL_CELLS * BENCH_LEVEL_CELLS)
+
+// grid scene
+#define BENCH_GRID_SIZE 32
+#define BENCH_TEXTURE_SIZE 128
+// four wall textures, two flats and a sprite, mips take less than their size again
+#define BENCH_TEXTURE_ATLAS_TEXELS (7 * BENCH_TEXTURE_SIZE * BENCH_TEXTURE_SIZE * 2)
+
+// entity scene
+#define BENCH_ENTITY_COUNT 10000
+
+// fill scene
+#define BENCH_FILL_LAYERS 8
+
+// sprite scene (every fourth sprite is untextured)
+#define BENCH_SPRITE_COUNT 2048
+#define BENCH_SPRITE_SIZE 64
+
+// text scene
+#define BENCH_TEXT_LINES 24
+
+static const char *scene_names[DNF_BENCH_SCENE_COUNT] = {
+    [DNF_BENCH_SCENE_CLEAR] = "clear",
+    [DNF_BENCH_SCENE_FILL] = "fill",
+    [DNF_BENCH_SCENE_WALLS_BSP] = "walls_bsp",
+    [DNF_BENCH_SCENE_WALLS_GRID] = "walls_grid",
+    [DNF_BENCH_SCENE_WALLS_TEXTURED] = "walls_textured",
+    [DNF_BENCH_SCENE_FLATS] = "flats",
+    [DNF_BENCH_SCENE_ENTITIES] = "entities",
+    [DNF_BENCH_SCENE_SPRITES] = "sprites",
+    [DNF_BENCH_SCENE_TEXT] = "text",
+};
+
+static const Color palette[8] = { GRAY, MAROON, DARKBROWN, BLUE, DARKGREEN, PURPLE, ORANGE, BEIGE };
+
+static dnf_bsp_level bench_level;
+static bool8_t bench_level_built = false;
+
+static uint8_t grid_cells[BENCH_GRID_SIZE * BENCH_GRID_SIZE];
+static dnf_grid_map grid_map = {
+    .width = BENCH_GRID_SIZE,
+    .height = BENCH_GRID_SIZE,
+    .cells = grid_cells,
+    .wall_colors = { [1] = GRAY, [2] = MAROON, [3] = DARKBROWN, [4] = BLUE },
+    .ceiling_color = DARKGRAY,
+    .floor_color = BROWN,
+};
+static dnf_grid_map textured_grid_map;
+static dnf_grid_map flat_grid_map;
+static dnf_texture_cache grid_textures;
+static dnf_texture_handle sprite_texture = DNF_TEXTURE_INVALID;
+static bool8_t grid_textures_built = false;
+
+static dnf_sprite_batch bench_sprites;
+static bool8_t bench_sprites_created = false;
+
+static dnf_entity_store bench_entities;
+static dnf_blockmap bench_entity_blockmap;
+static bool8_t bench_entities_created = false;
+
+/**
+ * @brief Per-frame parameters of the 2D scenes.
+ */
+typedef struct dnf_bench_frame
+{
+    dnf_bench_scene scene;  //!< Scene being drawn
+    uint32_t frame;         //!< Frame index within the scene
+} dnf_bench_frame;
+
+
+/**
+ * @brief Cheap integer hash for deterministic pseudo-random placement.
+ */
+static uint32_t hash_u32(uint32_t x)
+{
+    x ^= x >> 16;
+    x *= 0x7feb352du;
+    x ^= x >> 15;
+    x *= 0x846ca68bu;
+    x ^= x >> 16;
+    return x;
+}
+
+/**
+ * @brief Fills a rectangle clipped to a column band.
+ */
+static void fill_rect(
+    const dnf_framebuffer *fb,
+    const int32_t x_begin, const int32_t x_end,
+    int32_t x0, int32_t y0, int32_t x1, int32_t y1,
+    const Color color)
+{
+    if (x0 < x_begin) x0 = x_begin;
+    if (x1 > x_end) x1 = x_end;
+
+    pixels_fill_rect(fb, x0, y0, x1, y1, color);
+}
+
+/**
+ * @brief Draws a band of the 2D scenes (clear, fill).
+ */
+static void draw_2d_band(const dnf_framebuffer *fb, const int32_t x_begin, const int32_t x_end, void *user_data)
+{
+    const dnf_bench_frame *params = user_data;
+
+    fill_rect(fb, x_begin, x_end, 0, 0, fb->width, fb->height, DARKGRAY);
+
+    if (params->scene == DNF_BENCH_SCENE_FILL)
+    {
+        // overlapping 3/4 screen rectangles sliding around
+        const int32_t w = fb->width * 3 / 4, h = fb->height * 3 / 4;
+        for (uint32_t i = 0; i < BENCH_FILL_LAYERS; i++)
+        {
+            const uint32_t phase = params->frame + i * 37;
+            const int32_t x = (int32_t)(phase % (uint32_t)(fb->width - w + 1));
+            const int32_t y = (int32_t)((phase * 3) % (uint32_t)(fb->height - h + 1));
+            fill_rect(fb, x_begin, x_end, x, y, x + w, y + h, palette[i % 8]);
+        }
+    }
+}
+
+/**
+ * @brief Builds the BSP scene level.
+ *
+ * @return True if the level was built.
+ */
+static bool8_t build_bench_level(void)
+{
+    static dnf_vertex vertices[BENCH_LEVEL_VERTICES];
+    static dnf_linedef linedefs[BENCH_LEVEL_VERTICES];
+    static dnf_sector sectors[BENCH_LEVEL_SECTORS];
+    uint32_t vertex_count = 0, linedef_count = 0, sector_count = 0;
+
+    sectors[sector_count++] = (dnf_sector){
+        .floor_height = 0.0f, .ceiling_height = 2.0f, .light = 224,
+        .floor_color = BROWN, .ceiling_color = DARKGRAY
+    };
+
+    // room walls (clockwise - facing inwards)
+    const float32_t room[4][2] = {
+        { 0.0f, 0.0f }, { BENCH_LEVEL_SIZE, 0.0f },
+        { BENCH_LEVEL_SIZE, BENCH_LEVEL_SIZE }, { 0.0f, BENCH_LEVEL_SIZE }
+    };
+    for (uint32_t i = 0; i < 4; i++)
+    {
+        vertices[vertex_count + i] = (dnf_vertex){ room[i][0], room[i][1] };
+        linedefs[linedef_count++] = (dnf_linedef){
+            vertex_count + i, vertex_count + (i + 1) % 4, 0, DNF_BSP_NO_SECTOR, GRAY
+        };
+    }
+    vertex_count += 4;
+
+    for (uint32_t cy = 0; cy < BENCH_LEVEL_CELLS; cy++)
+    {
+        for (uint32_t cx = 0; cx < BENCH_LEVEL_CELLS; cx++)
+        {
+            const float32_t x0 = (float32_t)(cx + 1) * BENCH_LEVEL_SPACING - BENCH_LEVEL_BLOCK * 0.5f;
+            const float32_t y0 = (float32_t)(cy + 1) * BENCH_LEVEL_SPACING - BENCH_LEVEL_BLOCK * 0.5f;
+            const float32_t x1 = x0 + BENCH_LEVEL_BLOCK, y1 = y0 + BENCH_LEVEL_BLOCK;
+            const Color color = palette[(cx + cy * 3) % 8];
+
+            if ((cx + cy) % 2 == 0)
+            {
+                // pillar (counter-clockwise - facing outwards)
+                vertices[vertex_count + 0] = (dnf_vertex){ x0, y0 };
+                vertices[vertex_count + 1] = (dnf_vertex){ x0, y1 };
+                vertices[vertex_count + 2] = (dnf_vertex){ x1, y1 };
+                vertices[vertex_count + 3] = (dnf_vertex){ x1, y0 };
+                for (uint32_t i = 0; i < 4; i++)
+                    linedefs[linedef_count++] = (dnf_linedef){
+                        vertex_count + i, vertex_count + (i + 1) % 4, 0, DNF_BSP_NO_SECTOR, color
+                    };
+            }
+            else
+            {
+                // platform of varying height (two-sided, platform in front)
+                const int32_t sector = (int32_t)sector_count;
+                sectors[sector_count++] = (dnf_sector){
+                    .floor_height = 0.1f + 0.05f * (float32_t)((cx * 7 + cy) % 6),
+                    .ceiling_height = 1.4f + 0.1f * (float32_t)((cx + cy * 5) % 5),
+                    .light = (uint8_t)(160 + (cx * 13 + cy * 29) % 96),
+                    .floor_color = DARKBROWN, .ceiling_color = GRAY
+                };
+                vertices[vertex_count + 0] = (dnf_vertex){ x0, y0 };
+                vertices[vertex_count + 1] = (dnf_vertex){ x1, y0 };
+                vertices[vertex_count + 2] = (dnf_vertex){ x1, y1 };
+                vertices[vertex_count + 3] = (dnf_vertex){ x0, y1 };
+                for (uint32_t i = 0; i < 4; i++)
+                    linedefs[linedef_count++] = (dnf_linedef){
+                        vertex_count + i, vertex_count + (i + 1) % 4, sector, 0, color
+                    };
+            }
+            vertex_count += 4;
+        }
+    }
+
+    const dnf_level_map map = {
+        .vertices = vertices,
+        .vertex_count = vertex_count,
+        .linedefs = linedefs,
+        .linedef_count = linedef_count,
+        .sectors = sectors,
+        .sector_count = sector_count,
+    };
+    return bsp_level_build(&map, &bench_level);
+}
+
+/**
+ * @brief Fills the grid scene map: border walls and scattered blocks.
+ */
+static void build_grid_map(void)
+{
+    for (int32_t y = 0; y < BENCH_GRID_SIZE; y++)
+    {
+        for (int32_t x = 0; x < BENCH_GRID_SIZE; x++)
+        {
+            uint8_t cell = 0;
+            if (x == 0 || y == 0 || x == BENCH_GRID_SIZE - 1 || y == BENCH_GRID_SIZE - 1)
+                cell = 1;
+            else if (x % 4 == 2 && y % 4 == 2)
+                cell = (uint8_t)(1 + hash_u32((uint32_t)(y * BENCH_GRID_SIZE + x)) % 4);
+            grid_cells[y * BENCH_GRID_SIZE + x] = cell;
+        }
+    }
+}
+
+/**
+ * @brief Builds the textures of the textured grid scene (checkers of every
+ * wall color), the flats scene (checkered floor and ceiling) and the sprite
+ * scene (a ring on a transparent background).
+ *
+ * @return True on success.
+ */
+static bool8_t build_grid_textures(void)
+{
+    if (!texture_cache_init(&grid_textures, BENCH_TEXTURE_ATLAS_TEXELS, DNF_GRID_MAP_WALL_TYPES + 3))
+        return false;
+
+    textured_grid_map = grid_map;
+    textured_grid_map.textures = &grid_textures;
+    for (uint32_t i = 1; i <= 4; i++)
+    {
+        char name[16];
+        snprintf(name, sizeof(name), "bench_wall%u", i);
+        const Color color = grid_map.wall_colors[i];
+        const Image image = GenImageChecked(BENCH_TEXTURE_SIZE, BENCH_TEXTURE_SIZE,
+            BENCH_TEXTURE_SIZE / (int32_t)(2 * i), BENCH_TEXTURE_SIZE / (int32_t)(2 * i), color, palette[4 + i - 1]);
+        textured_grid_map.wall_textures[i] = texture_cache_add(&grid_textures, name, image, DNF_TEXTURE_WALL);
+        UnloadImage(image);
+        if (textured_grid_map.wall_textures[i] == DNF_TEXTURE_INVALID)
+            return false;
+    }
+
+    flat_grid_map = textured_grid_map;
+    const Image floor = GenImageChecked(BENCH_TEXTURE_SIZE, BENCH_TEXTURE_SIZE,
+        BENCH_TEXTURE_SIZE / 8, BENCH_TEXTURE_SIZE / 8, BROWN, DARKBROWN);
+    flat_grid_map.floor_texture = texture_cache_add(&grid_textures, "bench_floor", floor, DNF_TEXTURE_FLAT);
+    UnloadImage(floor);
+    const Image ceiling = GenImageChecked(BENCH_TEXTURE_SIZE, BENCH_TEXTURE_SIZE,
+        BENCH_TEXTURE_SIZE / 2, BENCH_TEXTURE_SIZE / 2, DARKGRAY, GRAY);
+    flat_grid_map.ceiling_texture = texture_cache_add(&grid_textures, "bench_ceiling", ceiling, DNF_TEXTURE_FLAT);
+    UnloadImage(ceiling);
+    if (flat_grid_map.floor_texture == DNF_TEXTURE_INVALID || flat_grid_map.ceiling_texture == DNF_TEXTURE_INVALID)
+        return false;
+
+    const Image sprite = GenImageColor(BENCH_SPRITE_SIZE, BENCH_SPRITE_SIZE, BLANK);
+    Color *texels = sprite.data;
+    for (int32_t y = 0; y < BENCH_SPRITE_SIZE; y++)
+    {
+        for (int32_t x = 0; x < BENCH_SPRITE_SIZE; x++)
+        {
+            const int32_t dx = 2 * x + 1 - BENCH_SPRITE_SIZE, dy = 2 * y + 1 - BENCH_SPRITE_SIZE;
+            const int32_t distance = dx * dx + dy * dy;
+            if (distance < BENCH_SPRITE_SIZE * BENCH_SPRITE_SIZE && distance > BENCH_SPRITE_SIZE * BENCH_SPRITE_SIZE / 4)
+                texels[y * BENCH_SPRITE_SIZE + x] = palette[(x / 8 + y / 8) % 8];
+        }
+    }
+    sprite_texture = texture_cache_add(&grid_textures, "bench_sprite", sprite, DNF_TEXTURE_SPRITE);
+    UnloadImage(sprite);
+    return sprite_texture != DNF_TEXTURE_INVALID;
+}
+
+/**
+ * @brief Fills the sprite batch of the sprite scene: sprites scattered over
+ * the empty grid cells, bobbing up and down.
+ *
+ * @param frame Frame index.
+ */
+static void batch_bench_sprites(const uint32_t frame)
+{
+    sprite_batch_clear(&bench_sprites);
+    for (uint32_t i = 0; i < BENCH_SPRITE_COUNT; i++)
+    {
+        uint32_t h = hash_u32(i);
+        while (grid_cells[h % (BENCH_GRID_SIZE * BENCH_GRID_SIZE)] != 0)
+            h = hash_u32(h + 1);
+
+        const uint32_t cell = h % (BENCH_GRID_SIZE * BENCH_GRID_SIZE);
+        const float32_t phase = (float32_t)frame * 0.05f + (float32_t)(h >> 20) * 0.01f;
+        const dnf_sprite sprite = {
+            .x = (float32_t)(cell % BENCH_GRID_SIZE) + 0.2f + (float32_t)((h >> 10) & 63) / 105.0f,
+            .y = (float32_t)(cell / BENCH_GRID_SIZE) + 0.2f + (float32_t)((h >> 16) & 63) / 105.0f,
+            .z = 0.1f + 0.1f * sinf(phase),
+            .width = 0.3f,
+            .height = 0.3f,
+            .light = 1.0f,
+            .texture = i % 4 == 3 ? DNF_TEXTURE_INVALID : sprite_texture,
+            .color = palette[h >> 29],
+        };
+        sprite_batch_add(&bench_sprites, &sprite);
+    }
+}
+
+/**
+ * @brief Respawns the entities of the entity scene on empty grid cells.
+ */
+static void spawn_bench_entities(void)
+{
+    entity_store_clear(&bench_entities);
+    blockmap_clear_entities(&bench_entity_blockmap);
+    for (uint32_t i = 0; i < BENCH_ENTITY_COUNT; i++)
+    {
+        // rehash until the cell is empty, entities may share cells
+        uint32_t h = hash_u32(i);
+        while (grid_cells[h % (BENCH_GRID_SIZE * BENCH_GRID_SIZE)] != 0)
+            h = hash_u32(h + 1);
+
+        const uint32_t cell = h % (BENCH_GRID_SIZE * BENCH_GRID_SIZE);
+        const dnf_entity_desc desc = {
+            .x = (float32_t)(cell % BENCH_GRID_SIZE) + 0.5f,
+            .y = (float32_t)(cell / BENCH_GRID_SIZE) + 0.5f,
+            .radius = 0.25f,
+            .speed = 1.0f + (float32_t)(h >> 24) / 255.0f,
+            .health = 20,
+            .ai_state = DNF_ENTITY_AI_IDLE,
+        };
+        entity_spawn(&bench_entities, &desc);
+    }
+}
+
+/**
+ * @brief Makes a camera circling around the level center.
+ *
+ * @param center Level center (both axes).
+ * @param radius Circle radius.
+ * @param z Camera height.
+ * @param frame Frame index.
+ * @return Camera.
+ */
+static dnf_camera orbit_camera(const float32_t center, const float32_t radius, const float32_t z, const uint32_t frame)
+{
+    const float32_t t = (float32_t)frame * 0.01f;
+    return (dnf_camera){
+        .x = center + cosf(t) * radius,
+        .y = center + sinf(t) * radius,
+        .z = z,
+        .angle = t * 3.0f,
+    };
+}
+
+bool8_t bench_scenes_init(void)
+{
+    build_grid_map();
+
+    if (!grid_textures_built)
+    {
+        if (!build_grid_textures())
+            return false;
+        grid_textures_built = true;
+    }
+
+    if (!bench_level_built)
+    {
+        if (!build_bench_level())
+            return false;
+        bench_level_built = true;
+    }
+
+    if (!bench_entities_created)
+    {
+        if (!entity_store_init(&bench_entities, BENCH_ENTITY_COUNT))
+            return false;
+        if (!blockmap_init(
+            &bench_entity_blockmap,
+            0.0f, 0.0f, (float32_t)BENCH_GRID_SIZE, (float32_t)BENCH_GRID_SIZE,
+            2.0f, BENCH_ENTITY_COUNT))
+        {
+            entity_store_shutdown(&bench_entities);
+            return false;
+        }
+        bench_entities_created = true;
+    }
+
+    if (!bench_sprites_created)
+    {
+        if (!sprite_batch_init(&bench_sprites, BENCH_SPRITE_COUNT))
+            return false;
+        bench_sprites_created = true;
+    }
+
+    return true;
+}
+
+void bench_scenes_shutdown(void)
+{
+    if (bench_level_built)
+        bsp_level_free(&bench_level);
+    bench_level_built = false;
+
+    if (grid_textures_built)
+        texture_cache_shutdown(&grid_textures);
+    grid_textures_built = false;
+
+    if (bench_entities_created)
+    {
+        blockmap_shutdown(&bench_entity_blockmap);
+        entity_store_shutdown(&bench_entities);
+    }
+    bench_entities_created = false;
+
+    if (bench_sprites_created)
+        sprite_batch_shutdown(&bench_sprites);
+    bench_sprites_created = false;
+}
+
+bool8_t bench_scenes_set_palette(const dnf_palette *target_palette)
+{
+    return texture_cache_set_palette(&grid_textures, target_palette);
+}
+
+const char *bench_scene_name(const dnf_bench_scene scene)
+{
+    return scene < DNF_BENCH_SCENE_COUNT ? scene_names[scene] : "unknown";
+}
+
+dnf_bench_scene bench_scene_find(const char *name)
+{
+    for (uint32_t i = 0; i < DNF_BENCH_SCENE_COUNT; i++)
+        if (strcmp(scene_names[i], name) == 0)
+            return (dnf_bench_scene)i;
+    return DNF_BENCH_SCENE_COUNT;
+}
+
+void bench_scene_update(const dnf_bench_scene scene, const uint32_t frame, const float32_t dt)
+{
+    if (scene != DNF_BENCH_SCENE_ENTITIES)
+        return;
+
+    // everyone chases the camera, the whole map is in sight
+    const dnf_camera camera = orbit_camera(BENCH_GRID_SIZE * 0.5f, 5.0f, 0.5f, frame);
+    const dnf_entity_ai_params ai = {
+        .target_x = camera.x,
+        .target_y = camera.y,
+        .sight_range = (float32_t)BENCH_GRID_SIZE * 2.0f,
+        .attack_range = 1.0f,
+        .attack_cooldown = 1.0f,
+    };
+    entity_pass_link(&bench_entities, &bench_entity_blockmap);
+    entity_pass_ai(&bench_entities, &ai, dt);
+    entity_pass_move(&bench_entities, dt);
+    entity_pass_collide_grid(&bench_entities, &grid_map);
+}
+
+void bench_scene_draw(const renderer_context *ctx, const dnf_bench_scene scene, const uint32_t frame, dnf_arena *frame_arena)
+{
+    switch (scene)
+    {
+        case DNF_BENCH_SCENE_WALLS_BSP:
+        case DNF_BENCH_SCENE_TEXT:
+        {
+            // stays between the first ring of blocks and the walls
+            const dnf_camera camera = orbit_camera(
+                BENCH_LEVEL_SIZE * 0.5f, BENCH_LEVEL_SPACING * 1.5f, 0.5f, frame);
+            bsp_render(ctx, &bench_level, &camera);
+            break;
+        }
+        case DNF_BENCH_SCENE_WALLS_GRID:
+        case DNF_BENCH_SCENE_WALLS_TEXTURED:
+        case DNF_BENCH_SCENE_FLATS:
+        case DNF_BENCH_SCENE_ENTITIES:
+        case DNF_BENCH_SCENE_SPRITES:
+        {
+            // every run of the entity scene starts from the same spawn
+            if (scene == DNF_BENCH_SCENE_ENTITIES && frame == 0)
+                spawn_bench_entities();
+
+            const dnf_camera camera = orbit_camera(
+                BENCH_GRID_SIZE * 0.5f, 5.0f, 0.5f, frame);
+            const bool8_t textured = scene == DNF_BENCH_SCENE_WALLS_TEXTURED || scene == DNF_BENCH_SCENE_SPRITES;
+            const dnf_grid_map *map = scene == DNF_BENCH_SCENE_FLATS ? &flat_grid_map
+                : textured ? &textured_grid_map : &grid_map;
+            raycaster_render(ctx, map, &camera);
+
+            if (scene == DNF_BENCH_SCENE_SPRITES)
+            {
+                batch_bench_sprites(frame);
+                sprite_batch_render(ctx, &bench_sprites, &grid_textures, &camera, frame_arena);
+            }
+            break;
+        }
+        default:
+        {
+            dnf_bench_frame *params = renderer_alloc_pass_data(ctx, sizeof(dnf_bench_frame));
+            params->scene = scene;
+            params->frame = frame;
+            renderer_draw_bands(ctx, draw_2d_band, params);
+            break;
+        }
+    }
+}
+
+void bench_scene_overlay(
+    const renderer_context *ctx, const dnf_renderer_api *api, const dnf_bench_scene scene, const uint32_t frame)
+{
+    if (scene != DNF_BENCH_SCENE_TEXT)
+        return;
+
+    char line[64];
+    for (uint32_t i = 0; i < BENCH_TEXT_LINES; i++)
+    {
+        snprintf(line, sizeof(line), "BENCH LINE %02u FRAME %06u", i, frame);
+        api->draw_text(ctx, line, 10, 10 + (int32_t)i * 20, 20, palette[i % 8]);
+    }
+    api->draw_fps(ctx, 10, 10 + BENCH_TEXT_LINES * 20);
+}
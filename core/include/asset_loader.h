@@ -0,0 +1,131 @@
+// DNF (Doomed and Forgotten): a DOOM-style first-person shooter.
+// Copyright (C) 2025-2026  Alexandr Gorbatenko
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+#pragma once
+
+#include "defines.h"
+
+// Most requests queued, loading or waiting to be finished at the same time.
+#define DNF_ASSET_MAX_REQUESTS 512
+// Handle of no request.
+#define DNF_ASSET_NO_REQUEST 0
+
+
+/**
+ * @brief Load priorities, the loader always picks the most urgent request.
+ */
+typedef enum dnf_asset_priority
+{
+    DNF_ASSET_PRIORITY_VISIBLE,   //!< Needed for the current frame
+    DNF_ASSET_PRIORITY_NEARBY,    //!< Likely needed soon (adjacent areas)
+    DNF_ASSET_PRIORITY_PREFETCH,  //!< Might be needed eventually
+
+    DNF_ASSET_PRIORITY_COUNT
+} dnf_asset_priority;
+
+/**
+ * @brief Loads an asset on the I/O thread: reads and decodes it, without
+ * touching anything the main thread uses (no GPU uploads, no caches).
+ *
+ * @param user_data User data passed to the request.
+ * @return True if the asset was loaded.
+ */
+typedef bool8_t (*dnf_asset_load_fn)(void *user_data);
+
+/**
+ * @brief Finishes a loaded asset on the main thread: uploads it, registers
+ * it in caches and frees what the load function allocated.
+ *
+ * @param user_data User data passed to the request.
+ * @param loaded Result of the load function.
+ */
+typedef void (*dnf_asset_finish_fn)(void *user_data, bool8_t loaded);
+
+/**
+ * @brief Handle of a load request (DNF_ASSET_NO_REQUEST - none).
+ */
+typedef uint32_t dnf_asset_request;
+
+/**
+ * @brief Starts the I/O thread.
+ *
+ * @return True on success.
+ */
+bool8_t asset_loader_init(void);
+
+/**
+ * @brief Stops the I/O thread. Queued requests are finished as not loaded,
+ * loaded ones as loaded.
+ */
+void asset_loader_shutdown(void);
+
+/**
+ * @brief Runs the finish functions of loaded requests (main thread only),
+ * in load order, until the time budget is spent.
+ *
+ * At least one request is finished per call, so loading always progresses.
+ *
+ * @param budget_ms Time budget in milliseconds.
+ * @return Number of requests finished.
+ */
+uint32_t asset_loader_finish(float64_t budget_ms);
+
+/**
+ * @brief Queues an asset load (main thread only).
+ *
+ * @param priority Load priority.
+ * @param load Load function (runs on the I/O thread).
+ * @param finish Finish function (runs on the main thread, optional).
+ * @param user_data User data passed to both functions, must stay valid
+ * until the request is finished or canceled.
+ * @return Request handle, DNF_ASSET_NO_REQUEST if the queue is full.
+ */
+DNF_API dnf_asset_request asset_loader_request(
+    dnf_asset_priority priority,
+    dnf_asset_load_fn load,
+    dnf_asset_finish_fn finish,
+    void *user_data);
+
+/**
+ * @brief Changes the priority of a request that hasn't started loading
+ * (e.g. a prefetched area came into view).
+ *
+ * @param request Request handle.
+ * @param priority New priority.
+ * @return False if the request is already loading or done.
+ */
+DNF_API bool8_t asset_loader_set_priority(dnf_asset_request request, dnf_asset_priority priority);
+
+/**
+ * @brief Cancels a request that hasn't started loading. Its finish function
+ * is never called.
+ *
+ * @param request Request handle.
+ * @return False if the request is already loading or done.
+ */
+DNF_API bool8_t asset_loader_cancel(dnf_asset_request request);
+
+/**
+ * @brief Loads and finishes every request (main thread only), e.g. behind
+ * a loading screen.
+ */
+DNF_API void asset_loader_flush(void);
+
+/**
+ * @brief Gets the number of requests not finished yet.
+ *
+ * @return Queued, loading and loaded requests.
+ */
+DNF_API uint32_t asset_loader_pending(void);
@@ -0,0 +1,245 @@
+// DNF (Doomed and Forgotten): a DOOM-style first-person shooter.
+// Copyright (C) 2025-2026  Alexandr Gorbatenko
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+
+#pragma once
+
+#include "defines.h"
+#include "bsp.h"
+#include "entity.h"
+
+// Line index of no line.
+#define DNF_BLOCKMAP_NO_LINE UINT32_MAX
+// Most entities a nearest-k query returns.
+#define DNF_BLOCKMAP_MAX_NEAREST 64
+
+
+/**
+ * @brief Result of a blockmap trace.
+ */
+typedef struct dnf_blockmap_hit
+{
+    float32_t fraction;  //!< Position of the hit along the segment (0 - start, 1 - end, nothing hit)
+    uint32_t line;       //!< Linedef hit (DNF_BLOCKMAP_NO_LINE - none)
+    dnf_entity entity;   //!< Entity hit (DNF_ENTITY_NONE - none)
+} dnf_blockmap_hit;
+
+/**
+ * @brief A uniform grid of blocks over the level (DOOM's blockmap) that
+ * lists the linedefs crossing every block and the entities centered in it.
+ *
+ * Queries only visit the blocks around the queried area, so their cost
+ * depends on the local density, not on the level size. Entities are linked
+ * by their center; queries widen their area by the biggest entity radius.
+ * Queries use per-line marks and aren't thread-safe.
+ */
+typedef struct dnf_blockmap
+{
+    float32_t origin_x;        //!< World X of the left edge of the grid
+    float32_t origin_y;        //!< World Y of the top edge of the grid
+    float32_t block_size;      //!< Block side in world units
+    int32_t width;             //!< Grid width in blocks
+    int32_t height;            //!< Grid height in blocks
+
+    // level geometry (CSR: the lines of block b are lines[line_offsets[b]] to lines[line_offsets[b + 1] - 1])
+    const dnf_bsp_level *level;  //!< Level of the lines (nullptr - entities only)
+    uint32_t *line_offsets;    //!< First line of every block, one more for the end
+    uint32_t *lines;           //!< Linedef indices of all blocks
+    uint32_t *line_marks;      //!< Query that last visited every linedef
+    uint32_t mark;             //!< Current query
+
+    // entities, by handle slot
+    uint32_t entity_capacity;  //!< Slots (the capacity of the entity store)
+    uint32_t *block_entities;  //!< First entity slot of every block
+    uint32_t *entity_next;     //!< Next slot in the same block
+    uint32_t *entity_prev;     //!< Previous slot in the same block
+    uint32_t *entity_block;    //!< Block of every slot (UINT32_MAX - not linked)
+    uint32_t *entity_marks;    //!< Query that last visited every slot
+    dnf_entity *entity_handles;  //!< Handle linked in every slot
+    float32_t *entity_x;       //!< Center X of every slot
+    float32_t *entity_y;       //!< Center Y of every slot
+    float32_t *entity_radius;  //!< Radius of every slot
+    float32_t max_radius;      //!< Biggest radius ever linked
+} dnf_blockmap;
+
+/**
+ * @brief Creates an empty blockmap covering an area.
+ *
+ * @param map Blockmap to initialize.
+ * @param min_x Left edge of the area.
+ * @param min_y Top edge of the area.
+ * @param max_x Right edge of the area.
+ * @param max_y Bottom edge of the area.
+ * @param block_size Block side in world units (bigger than entity diameters).
+ * @param entity_capacity Capacity of the entity store whose entities get linked.
+ * @return True on success.
+ */
+DNF_API bool8_t blockmap_init(
+    dnf_blockmap *map,
+    float32_t min_x, float32_t min_y,
+    float32_t max_x, float32_t max_y,
+    float32_t block_size,
+    uint32_t entity_capacity);
+
+/**
+ * @brief Creates a blockmap covering a level and links its linedefs.
+ *
+ * @param map Blockmap to initialize.
+ * @param level Level (must outlive the blockmap).
+ * @param block_size Block side in world units.
+ * @param entity_capacity Capacity of the entity store whose entities get linked.
+ * @return True on success.
+ */
+DNF_API bool8_t blockmap_init_level(
+    dnf_blockmap *map,
+    const dnf_bsp_level *level,
+    float32_t block_size,
+    uint32_t entity_capacity);
+
+/**
+ * @brief Frees a blockmap.
+ *
+ * @param map Blockmap.
+ */
+DNF_API void blockmap_shutdown(dnf_blockmap *map);
+
+/**
+ * @brief Links an entity, or moves a linked one (only relinks when it
+ * changes blocks).
+ *
+ * @param map Blockmap.
+ * @param entity Entity handle.
+ * @param x Center X.
+ * @param y Center Y.
+ * @param radius Radius.
+ */
+DNF_API void blockmap_move(dnf_blockmap *map, dnf_entity entity, float32_t x, float32_t y, float32_t radius);
+
+/**
+ * @brief Unlinks an entity.
+ *
+ * @param map Blockmap.
+ * @param entity Entity handle (unlinked handles are ignored).
+ */
+DNF_API void blockmap_remove(dnf_blockmap *map, dnf_entity entity);
+
+/**
+ * @brief Unlinks all entities.
+ *
+ * @param map Blockmap.
+ */
+DNF_API void blockmap_clear_entities(dnf_blockmap *map);
+
+/**
+ * @brief Finds the entities overlapping a circle.
+ *
+ * @param map Blockmap.
+ * @param x Circle center X.
+ * @param y Circle center Y.
+ * @param radius Circle radius.
+ * @param ignore Entity to leave out (DNF_ENTITY_NONE - none).
+ * @param out_entities Found entities.
+ * @param max_entities Size of out_entities.
+ * @return Number of found entities (at most max_entities).
+ */
+DNF_API uint32_t blockmap_query_radius(
+    dnf_blockmap *map,
+    float32_t x, float32_t y, float32_t radius,
+    dnf_entity ignore,
+    dnf_entity *out_entities, uint32_t max_entities);
+
+/**
+ * @brief Finds the linedefs closer to a point than a radius.
+ *
+ * @param map Blockmap.
+ * @param x Point X.
+ * @param y Point Y.
+ * @param radius Radius.
+ * @param out_lines Found linedef indices.
+ * @param max_lines Size of out_lines.
+ * @return Number of found linedefs (at most max_lines).
+ */
+DNF_API uint32_t blockmap_query_lines(
+    dnf_blockmap *map,
+    float32_t x, float32_t y, float32_t radius,
+    uint32_t *out_lines, uint32_t max_lines);
+
+/**
+ * @brief Finds the nearest entities to a point, by center distance.
+ *
+ * @param map Blockmap.
+ * @param x Point X.
+ * @param y Point Y.
+ * @param max_distance Farthest center distance.
+ * @param ignore Entity to leave out (DNF_ENTITY_NONE - none).
+ * @param out_entities Found entities, nearest first.
+ * @param k Most entities to find (up to DNF_BLOCKMAP_MAX_NEAREST).
+ * @return Number of found entities.
+ */
+DNF_API uint32_t blockmap_query_nearest(
+    dnf_blockmap *map,
+    float32_t x, float32_t y, float32_t max_distance,
+    dnf_entity ignore,
+    dnf_entity *out_entities, uint32_t k);
+
+/**
+ * @brief Finds the first one-sided linedef or entity along a segment
+ * (hitscan). Two-sided linedefs don't stop traces.
+ *
+ * @param map Blockmap.
+ * @param x0 Start X.
+ * @param y0 Start Y.
+ * @param x1 End X.
+ * @param y1 End Y.
+ * @param ignore Entity to leave out, e.g. the shooter (DNF_ENTITY_NONE - none).
+ * @param hit_entities False - only linedefs stop the trace.
+ * @return First hit.
+ */
+DNF_API dnf_blockmap_hit blockmap_trace(
+    dnf_blockmap *map,
+    float32_t x0, float32_t y0, float32_t x1, float32_t y1,
+    dnf_entity ignore,
+    bool8_t hit_entities);
+
+/**
+ * @brief Checks if no one-sided linedef crosses a segment.
+ *
+ * @param map Blockmap.
+ * @param x0 Start X.
+ * @param y0 Start Y.
+ * @param x1 End X.
+ * @param y1 End Y.
+ * @return True if the end is visible from the start.
+ */
+DNF_API bool8_t blockmap_line_of_sight(dnf_blockmap *map, float32_t x0, float32_t y0, float32_t x1, float32_t y1);
+
+/**
+ * @brief Pushes a circle out of the linedefs it can't pass: one-sided
+ * linedefs, steps higher than max_step and openings lower than height.
+ *
+ * @param map Blockmap.
+ * @param x Circle center X (updated).
+ * @param y Circle center Y (updated).
+ * @param radius Circle radius.
+ * @param z Height of the bottom of the mover.
+ * @param height Height of the mover.
+ * @param max_step Highest step the mover can climb.
+ * @return True if the circle was pushed.
+ */
+DNF_API bool8_t blockmap_collide_circle(
+    dnf_blockmap *map,
+    float32_t *x, float32_t *y, float32_t radius,
+    float32_t z, float32_t height, float32_t max_step);
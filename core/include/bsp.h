@@ -0,0 +1,181 @@
+// DNF (Doomed and Forgotten): a DOOM-style first-person shooter.
+// Copyright (C) 2025-2026  Alexandr Gorbatenko
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+
+#pragma once
+
+#include "defines.h"
+#include "renderer.h"
+
+// Child index flag that marks a subsector (leaf) instead of a node.
+#define DNF_BSP_SUBSECTOR_BIT 0x80000000u
+// Sector index of a missing (back) side.
+#define DNF_BSP_NO_SECTOR (-1)
+
+struct dnf_pvs;
+
+/**
+ * @brief A 2D map vertex.
+ */
+typedef struct dnf_vertex
+{
+    float32_t x;
+    float32_t y;
+} dnf_vertex;
+
+/**
+ * @brief A structure that represents a sector: an area with its own floor
+ * and ceiling heights.
+ */
+typedef struct dnf_sector
+{
+    float32_t floor_height;    //!< Floor height
+    float32_t ceiling_height;  //!< Ceiling height
+    uint8_t light;             //!< Light level (0 - dark, 255 - full bright)
+    Color floor_color;         //!< Floor color
+    Color ceiling_color;       //!< Ceiling color
+} dnf_sector;
+
+/**
+ * @brief A structure that represents a map line (wall).
+ *
+ * The front side is on the right when walking from v1 to v2 (positive angles
+ * turn clockwise, see dnf_camera).
+ */
+typedef struct dnf_linedef
+{
+    uint32_t v1;           //!< Start vertex index
+    uint32_t v2;           //!< End vertex index
+    int32_t front_sector;  //!< Sector on the front (right) side
+    int32_t back_sector;   //!< Sector on the back side (DNF_BSP_NO_SECTOR - one-sided)
+    Color color;           //!< Wall color
+} dnf_linedef;
+
+/**
+ * @brief Source map data (linedefs and sectors) to build a BSP level from.
+ */
+typedef struct dnf_level_map
+{
+    const dnf_vertex *vertices;
+    uint32_t vertex_count;
+    const dnf_linedef *linedefs;
+    uint32_t linedef_count;
+    const dnf_sector *sectors;
+    uint32_t sector_count;
+} dnf_level_map;
+
+/**
+ * @brief A part of a linedef side that lies in a single subsector.
+ */
+typedef struct dnf_seg
+{
+    dnf_vertex v1;         //!< Start point
+    dnf_vertex v2;         //!< End point
+    uint32_t linedef;      //!< Source linedef index
+    int32_t front_sector;  //!< Sector the seg faces
+    int32_t back_sector;   //!< Sector behind the seg (DNF_BSP_NO_SECTOR - solid)
+    float32_t offset;      //!< Distance from the start of the linedef side
+} dnf_seg;
+
+/**
+ * @brief A convex BSP leaf: a run of segs inside a single sector.
+ */
+typedef struct dnf_subsector
+{
+    uint32_t first_seg;  //!< Index of the first seg
+    uint32_t seg_count;  //!< Number of segs
+    int32_t sector;      //!< Sector index
+} dnf_subsector;
+
+/**
+ * @brief A BSP node: a partition line and two children.
+ */
+typedef struct dnf_bsp_node
+{
+    float32_t x, y;         //!< Partition line start
+    float32_t dx, dy;       //!< Partition line direction
+    float32_t bbox[2][4];   //!< Child bounding boxes (min x, min y, max x, max y)
+    uint32_t children[2];   //!< Front (right side) and back child (DNF_BSP_SUBSECTOR_BIT - subsector)
+} dnf_bsp_node;
+
+/**
+ * @brief A compiled BSP level.
+ */
+typedef struct dnf_bsp_level
+{
+    dnf_vertex *vertices;
+    uint32_t vertex_count;
+    dnf_linedef *linedefs;
+    uint32_t linedef_count;
+    dnf_sector *sectors;
+    uint32_t sector_count;
+
+    dnf_seg *segs;
+    uint32_t seg_count;
+    dnf_subsector *subsectors;
+    uint32_t subsector_count;
+    dnf_bsp_node *nodes;
+    uint32_t node_count;
+    uint32_t root;  //!< Root node index (or a subsector, for single-leaf levels)
+
+    const struct dnf_pvs *pvs;  //!< Subsector PVS (nullptr - no culling), see pvs_build_level()
+} dnf_bsp_level;
+
+/**
+ * @brief Compiles a linedef/sector map into a BSP level.
+ *
+ * Source data is copied, so it can be freed after the call.
+ *
+ * @param map Source map.
+ * @param out_level Resulting level (free with bsp_level_free()).
+ * @return True if the level was built successfully, false otherwise.
+ */
+DNF_API bool8_t bsp_level_build(const dnf_level_map *map, dnf_bsp_level *out_level);
+
+/**
+ * @brief Frees all memory of a BSP level.
+ *
+ * @param level Level to free.
+ */
+DNF_API void bsp_level_free(dnf_bsp_level *level);
+
+/**
+ * @brief Finds the subsector that contains a given point.
+ *
+ * @param level BSP level.
+ * @param x Point X.
+ * @param y Point Y.
+ * @return Subsector index.
+ */
+DNF_API uint32_t bsp_point_subsector(const dnf_bsp_level *level, float32_t x, float32_t y);
+
+/**
+ * @brief Renders a BSP level from the camera into the framebuffer.
+ *
+ * Walks the tree front to back and keeps a list of fully occluded column
+ * ranges, so every column gets its walls drawn once and the traversal stops
+ * as soon as the screen is covered. The level is expected to be closed.
+ * With a PVS attached to the level, subtrees with no subsector potentially
+ * visible from the camera's subsector are skipped without being looked at.
+ *
+ * @param ctx Rendering context to draw into.
+ * @param level Level to render.
+ * @param camera Camera to render from.
+ */
+DNF_API void bsp_render(
+    const renderer_context *ctx,
+    const dnf_bsp_level *level,
+    const dnf_camera *camera);
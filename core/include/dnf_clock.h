@@ -0,0 +1,36 @@
+// DNF (Doomed and Forgotten): a DOOM-style first-person shooter.
+// Copyright (C) 2025-2026  Alexandr Gorbatenko
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+
+#pragma once
+
+#include "defines.h"
+
+/**
+ * @brief Gets the current value of a monotonic clock.
+ *
+ * Unlike raylib's GetTime(), works without a window.
+ *
+ * @return Time in nanoseconds since an unspecified point in the past.
+ */
+DNF_API uint64_t dnf_clock_now_ns(void);
+
+/**
+ * @brief Gets the current value of a monotonic clock in seconds.
+ *
+ * @return Time in seconds since an unspecified point in the past.
+ */
+DNF_API float64_t dnf_clock_now(void);
@@ -17,6 +17,9 @@
 #pragma once
 
 #include "defines.h"
+#include "dnf_memory.h"
+#include "logger.h"
+#include "pixels.h"
 #include "renderer.h"
 
 /**
@@ -30,6 +33,8 @@ typedef enum dnf_game_action
     DNF_GAME_ACTION_MOVE_BACKWARD,
     DNF_GAME_ACTION_MOVE_LEFT,
     DNF_GAME_ACTION_MOVE_RIGHT,
+    DNF_GAME_ACTION_TURN_LEFT,
+    DNF_GAME_ACTION_TURN_RIGHT,
 
     // INTERACTIONS
 
@@ -44,6 +49,10 @@ typedef enum dnf_game_action
 
     DNF_GAME_ACTION_MENU,           //!< Menu button
 
+    // DEBUG
+
+    DNF_GAME_ACTION_DEBUG_NEXT_VIEW,  //!< Switch between test views
+
     // UTIL
 
     DNF_GAME_ACTION_COUNT           //!< Total number of actions
@@ -101,9 +110,34 @@ typedef struct dnf_input_system_handler
  */
 typedef struct dnf_engine_config
 {
-    int32_t start_width;   //!< Initial window width.
-    int32_t start_height;  //!< Initial window height.
-    char *title;           //!< Window title.
+    int32_t start_width;      //!< Initial window width.
+    int32_t start_height;     //!< Initial window height.
+    char *title;              //!< Window title.
+    uint32_t worker_threads;  //!< Job system worker threads (0 - auto).
+    uint32_t framebuffers;    //!< Framebuffer count (1 - no render/present overlap, up to 3).
+    uint32_t target_fps;      //!< Render frame rate cap (0 - uncapped, ignored when headless).
+
+    uint32_t tick_rate;       //!< Simulation ticks per second (0 - DNF_ENGINE_DEFAULT_TICK_RATE).
+    uint32_t max_ticks;       //!< Most ticks per frame before dropping time (0 - DNF_ENGINE_DEFAULT_MAX_TICKS).
+    float32_t asset_budget_ms;  //!< Main thread time per frame for finishing loaded assets (0 - DNF_ENGINE_DEFAULT_ASSET_BUDGET_MS).
+    size_t frame_arena_size;  //!< Per-frame scratch arena size in bytes (0 - DNF_ENGINE_DEFAULT_FRAME_ARENA_SIZE).
+    size_t projectile_size;   //!< Size of a game projectile in bytes (0 - no projectile pool).
+    uint32_t max_projectiles; //!< Projectiles alive at once (0 - DNF_ENGINE_DEFAULT_MAX_PROJECTILES).
+
+    dnf_renderer_backend backend;  //!< Renderer backend (window or headless).
+    dnf_pixel_isa pixel_isa;  //!< Instruction set of the pixel kernels (auto - best supported).
+    bool8_t column_major;     //!< Render into column-major framebuffers, transposed when presented.
+    dnf_pixel_format render_format;  //!< Render target format (indexed - 8-bit palette, expanded before upload).
+    float32_t render_scale;   //!< Rendered image size relative to the start size (0 - 1, stretched to the window).
+    float32_t dynamic_resolution_ms;  //!< Render time the render scale adapts to hold (0 - fixed scale).
+    uint32_t frame_limit;     //!< Exit after this many frames (0 - no limit).
+    float32_t fixed_dt;       //!< Fixed frame time in seconds fed to the tick accumulator (0 - measured, 1/60 when headless).
+    uint32_t dump_interval;   //!< Save every N-th completed frame (0 - never).
+    const char *dump_dir;     //!< Directory for saved frames.
+
+    bool8_t async_logging;    //!< Format and write log messages on a background thread.
+    dnf_log_format log_format;  //!< Log file format (text or binary).
+    const char *log_levels;   //!< Runtime log levels, e.g. "info,renderer=trace" (nullptr - default).
 } dnf_engine_config;
 
 
@@ -124,6 +158,12 @@ typedef struct game
     // Rendering API (for calling raylib functions)
     dnf_renderer_api renderer_api;
 
+    // Scratch memory of the current frame, reset before every frame (set by the engine).
+    dnf_arena *frame_arena;
+
+    // Blocks of engine_config->projectile_size bytes for projectiles (set by the engine, nullptr - none).
+    dnf_pool *projectile_pool;
+
     /**
      * @brief Function pointer to game's initialization function.
      *
@@ -133,22 +173,33 @@ typedef struct game
     bool8_t (*init)(struct game *game_instance);
 
     /**
-     * @brief Function pointer to game's update function.
+     * @brief Function pointer to game's update function, called at the fixed
+     * simulation tick rate (zero or more times per frame).
      *
      * @param game_instance Game instance info.
-     * @param dt Time since last frame in seconds.
+     * @param dt Tick duration in seconds (constant).
      * @return True if game updated successfully.
      */
     bool8_t (*update)(struct game *game_instance, float32_t dt);
 
     /**
-     * @brief Function pointer to game's rendering function.
+     * @brief Function pointer to game's rendering function, called once per
+     * frame.
      *
      * @param game_instance Game instance info.
-     * @param dt Time since last frame in seconds.
+     * @param alpha Interpolation factor between the previous and the latest
+     * tick state (0 to 1).
      * @return True if frame rendered successfully.
      */
-    bool8_t (*render)(struct game *game_instance, float32_t dt);
+    bool8_t (*render)(struct game *game_instance, float32_t alpha);
+
+    /**
+     * @brief Function pointer to game's shutdown function, called after the
+     * last frame before the engine subsystems shut down (optional).
+     *
+     * @param game_instance Game instance info.
+     */
+    void (*shutdown)(struct game *game_instance);
 
     // Game state.
     void *game_state;
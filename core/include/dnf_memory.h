@@ -0,0 +1,183 @@
+// DNF (Doomed and Forgotten): a DOOM-style first-person shooter.
+// Copyright (C) 2025-2026  Alexandr Gorbatenko
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+
+#pragma once
+
+#include "defines.h"
+
+#include <stddef.h>
+
+
+/**
+ * @brief What an allocation is for, memory usage is tracked per tag.
+ */
+typedef enum dnf_memory_tag
+{
+    DNF_MEMORY_TAG_UNKNOWN,   //!< Untagged
+    DNF_MEMORY_TAG_ENGINE,    //!< Engine systems
+    DNF_MEMORY_TAG_RENDERER,  //!< Render targets and renderer scratch buffers
+    DNF_MEMORY_TAG_TEXTURES,  //!< Texture atlases
+    DNF_MEMORY_TAG_LEVEL,     //!< Level geometry
+    DNF_MEMORY_TAG_ENTITIES,  //!< Entities and their components
+    DNF_MEMORY_TAG_ARENA,     //!< Linear arenas (frame scratch memory)
+    DNF_MEMORY_TAG_GAME,      //!< Game state
+
+    DNF_MEMORY_TAG_COUNT
+} dnf_memory_tag;
+
+/**
+ * @brief A linear arena: allocations bump a pointer and are all freed at
+ * once by a reset.
+ */
+typedef struct dnf_arena
+{
+    uint8_t *base;    //!< Memory of the arena
+    size_t capacity;  //!< Size of the memory in bytes
+    size_t used;      //!< Bytes allocated since the last reset
+    size_t peak;      //!< Most bytes allocated between two resets
+} dnf_arena;
+
+/**
+ * @brief A pool of fixed-size blocks (entities, projectiles, ...).
+ *
+ * Free blocks form a list threaded through the blocks themselves, so
+ * allocating and freeing are O(1) and the blocks stay in one allocation.
+ */
+typedef struct dnf_pool
+{
+    uint8_t *blocks;      //!< Memory of the pool
+    size_t block_size;    //!< Size of a block in bytes (aligned)
+    uint32_t capacity;    //!< Number of blocks
+    uint32_t used;        //!< Blocks allocated
+    uint32_t free_head;   //!< First free block (capacity - none)
+} dnf_pool;
+
+/**
+ * @brief Allocates zeroed memory and accounts it to a tag.
+ *
+ * @param size Size in bytes.
+ * @param tag What the memory is for.
+ * @return Memory (16-byte aligned), nullptr on failure.
+ */
+DNF_API void *dnf_alloc(size_t size, dnf_memory_tag tag);
+
+/**
+ * @brief Resizes memory from dnf_alloc() (the grown part isn't zeroed).
+ *
+ * @param block Memory to resize (nullptr - allocate).
+ * @param size New size in bytes.
+ * @param tag What the memory is for (existing blocks are moved to it, with
+ * their bytes and allocation count).
+ * @return Resized memory, nullptr on failure (the old memory stays valid).
+ */
+DNF_API void *dnf_realloc(void *block, size_t size, dnf_memory_tag tag);
+
+/**
+ * @brief Frees memory from dnf_alloc().
+ *
+ * @param block Memory to free (nullptr - nothing).
+ */
+DNF_API void dnf_free(void *block);
+
+/**
+ * @brief Gets the memory allocated under a tag.
+ *
+ * @param tag Tag.
+ * @return Bytes in use.
+ */
+DNF_API size_t dnf_memory_usage(dnf_memory_tag tag);
+
+/**
+ * @brief Gets the name of a tag.
+ *
+ * @param tag Tag.
+ * @return Name ("?" if unknown).
+ */
+DNF_API const char *dnf_memory_tag_name(dnf_memory_tag tag);
+
+/**
+ * @brief Logs the memory in use per tag.
+ */
+DNF_API void dnf_memory_log_usage(void);
+
+/**
+ * @brief Allocates the memory of an arena.
+ *
+ * @param arena Arena to initialize.
+ * @param capacity Size in bytes.
+ * @param tag What the arena is for.
+ * @return True on success.
+ */
+DNF_API bool8_t arena_init(dnf_arena *arena, size_t capacity, dnf_memory_tag tag);
+
+/**
+ * @brief Frees the memory of an arena.
+ *
+ * @param arena Arena.
+ */
+DNF_API void arena_shutdown(dnf_arena *arena);
+
+/**
+ * @brief Allocates memory from an arena. The memory isn't zeroed.
+ *
+ * @param arena Arena.
+ * @param size Size in bytes.
+ * @param alignment Alignment, a power of two (0 - 16 bytes).
+ * @return Memory, nullptr if the arena is full.
+ */
+DNF_API void *arena_alloc(dnf_arena *arena, size_t size, size_t alignment);
+
+/**
+ * @brief Frees everything allocated from an arena.
+ *
+ * @param arena Arena.
+ */
+DNF_API void arena_reset(dnf_arena *arena);
+
+/**
+ * @brief Allocates the blocks of a pool.
+ *
+ * @param pool Pool to initialize.
+ * @param block_size Size of a block in bytes.
+ * @param capacity Number of blocks.
+ * @param tag What the blocks are for.
+ * @return True on success.
+ */
+DNF_API bool8_t pool_init(dnf_pool *pool, size_t block_size, uint32_t capacity, dnf_memory_tag tag);
+
+/**
+ * @brief Frees the blocks of a pool.
+ *
+ * @param pool Pool.
+ */
+DNF_API void pool_shutdown(dnf_pool *pool);
+
+/**
+ * @brief Allocates a zeroed block from a pool.
+ *
+ * @param pool Pool.
+ * @return Block (16-byte aligned), nullptr if the pool is full.
+ */
+DNF_API void *pool_alloc(dnf_pool *pool);
+
+/**
+ * @brief Returns a block to its pool.
+ *
+ * @param pool Pool.
+ * @param block Block from pool_alloc() (nullptr - nothing).
+ */
+DNF_API void pool_free(dnf_pool *pool, void *block);
@@ -0,0 +1,63 @@
+// DNF (Doomed and Forgotten): a DOOM-style first-person shooter.
+// Copyright (C) 2025-2026  Alexandr Gorbatenko
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+#pragma once
+
+#include "defines.h"
+
+
+/**
+ * @brief State of the dynamic resolution governor: picks the render scale
+ * that keeps the render time of a frame near a target.
+ *
+ * Render time is assumed to grow with the pixel count, i.e. with the square
+ * of the scale. The governor smooths it over frames and only changes the
+ * scale in coarse steps, rarely, and when the time is well off the target,
+ * so the framebuffers aren't reallocated over noise.
+ */
+typedef struct dnf_dynamic_resolution
+{
+    float32_t target_ms;   //!< Render time to hold
+    float32_t min_scale;   //!< Lowest scale allowed
+    float32_t max_scale;   //!< Highest scale allowed
+    float32_t scale;       //!< Current scale
+    float64_t average_ms;  //!< Smoothed render time at the current scale
+    uint32_t samples;      //!< Frames measured at the current scale
+} dnf_dynamic_resolution;
+
+/**
+ * @brief Initializes a governor.
+ *
+ * @param governor Governor to initialize.
+ * @param target_ms Render time to hold in milliseconds.
+ * @param scale Starting scale.
+ * @param min_scale Lowest scale allowed.
+ * @param max_scale Highest scale allowed.
+ */
+void dynamic_resolution_init(
+    dnf_dynamic_resolution *governor,
+    float32_t target_ms,
+    float32_t scale,
+    float32_t min_scale,
+    float32_t max_scale);
+
+/**
+ * @brief Feeds the render time of a frame to a governor.
+ *
+ * @param governor Governor.
+ * @param render_ms Render time of the latest frame in milliseconds.
+ * @return True if the scale changed (the new one is in governor->scale).
+ */
+bool8_t dynamic_resolution_update(dnf_dynamic_resolution *governor, float64_t render_ms);
@@ -19,6 +19,30 @@
 #include "defines.h"
 #include "dnf_gametypes.h"
 
+// Default simulation tick rate (DOOM's 35 Hz).
+#define DNF_ENGINE_DEFAULT_TICK_RATE 35
+// Default cap of ticks per frame (avoids the "spiral of death" on slow frames).
+#define DNF_ENGINE_DEFAULT_MAX_TICKS 8
+// Default main thread time per frame for finishing loaded assets, in milliseconds.
+#define DNF_ENGINE_DEFAULT_ASSET_BUDGET_MS 2.0f
+// Default size of the per-frame scratch arena, in bytes.
+#define DNF_ENGINE_DEFAULT_FRAME_ARENA_SIZE (1024 * 1024)
+// Default capacity of the projectile pool.
+#define DNF_ENGINE_DEFAULT_MAX_PROJECTILES 256
+
+/**
+ * @brief Time spent in each stage of a frame, in milliseconds.
+ */
+typedef struct dnf_frame_timings
+{
+    float64_t update_ms;   //!< Game update (all ticks of the frame)
+    float64_t render_ms;   //!< Game render, without upload and present
+    float64_t upload_ms;   //!< Framebuffer upload to the target texture
+    float64_t present_ms;  //!< Presenting the frame (swapping window buffers)
+    float64_t frame_ms;    //!< Whole frame
+    uint32_t ticks;        //!< Simulation ticks run in the frame
+} dnf_frame_timings;
+
 /**
  * @brief Creates a window and initializes the engine loop.
  *
@@ -30,6 +54,16 @@ DNF_API bool8_t engine_init(game *game_instance);
 /**
  * @brief Runs the engine loop.
  *
+ * Shuts all engine systems down when the loop exits, after which the engine
+ * can be initialized again.
+ *
  * @return True if exited out of the loop successfully, false otherwise.
  */
 DNF_API bool8_t engine_run(void);
+
+/**
+ * @brief Gets stage timings of the last completed frame.
+ *
+ * @return Frame timings.
+ */
+DNF_API dnf_frame_timings engine_get_frame_timings(void);
@@ -0,0 +1,222 @@
+// DNF (Doomed and Forgotten): a DOOM-style first-person shooter.
+// Copyright (C) 2025-2026  Alexandr Gorbatenko
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+
+#pragma once
+
+#include "defines.h"
+#include "dnf_memory.h"
+#include "raycaster.h"
+
+// Most entities in a store (slots are 16 bits of a handle).
+#define DNF_ENTITY_MAX_COUNT 65535
+// Handle of no entity.
+#define DNF_ENTITY_NONE 0
+// Dense index of no entity.
+#define DNF_ENTITY_NO_INDEX UINT32_MAX
+// Most neighbors an entity is pushed away from per separation pass.
+#define DNF_ENTITY_MAX_NEIGHBORS 16
+
+struct dnf_blockmap;
+struct dnf_pvs;
+
+
+/**
+ * @brief Handle of an entity: (generation << 16) | (slot + 1). Handles of
+ * destroyed entities never match a later entity in the same slot.
+ */
+typedef uint32_t dnf_entity;
+
+/**
+ * @brief States of the entity AI.
+ */
+typedef enum dnf_entity_ai_state
+{
+    DNF_ENTITY_AI_IDLE,    //!< Waiting for the target to come into sight
+    DNF_ENTITY_AI_CHASE,   //!< Moving towards the target
+    DNF_ENTITY_AI_ATTACK,  //!< Standing next to the target, attacking
+    DNF_ENTITY_AI_DEAD,    //!< Out of health (stays until destroyed)
+    DNF_ENTITY_AI_STATIC,  //!< No AI (pickups, decorations, projectiles)
+} dnf_entity_ai_state;
+
+/**
+ * @brief Initial components of a spawned entity.
+ */
+typedef struct dnf_entity_desc
+{
+    float32_t x;        //!< World X position
+    float32_t y;        //!< World Y position
+    float32_t vel_x;    //!< X velocity in units per second
+    float32_t vel_y;    //!< Y velocity in units per second
+    float32_t radius;   //!< Collision radius
+    float32_t speed;    //!< Chase speed in units per second
+    int32_t health;     //!< Health (0 - dead)
+    uint16_t sprite;    //!< Sprite to draw (game-defined)
+    dnf_entity_ai_state ai_state;  //!< Initial AI state
+} dnf_entity_desc;
+
+/**
+ * @brief Parameters of an AI pass, shared by all entities.
+ */
+typedef struct dnf_entity_ai_params
+{
+    float32_t target_x;         //!< World X position of the target
+    float32_t target_y;         //!< World Y position of the target
+    float32_t sight_range;      //!< Distance at which idle entities notice the target
+    float32_t attack_range;     //!< Distance at which chasing entities stop and attack
+    float32_t attack_cooldown;  //!< Seconds between two attacks of an entity
+    const struct dnf_pvs *pvs;  //!< Grid map PVS (nullptr - idle entities notice the target through walls)
+    const uint8_t *visible;     //!< Clusters potentially visible from the target (see pvs_decompress())
+} dnf_entity_ai_params;
+
+/**
+ * @brief A store of entities with structure-of-arrays components.
+ *
+ * Live entities are packed at the front of every component array (dense
+ * index 0 to count - 1), so passes run over contiguous memory. Destroying
+ * an entity moves the last one into its place, handles stay valid.
+ */
+typedef struct dnf_entity_store
+{
+    uint32_t capacity;     //!< Most entities
+    uint32_t count;        //!< Live entities
+
+    // components, by dense index
+    float32_t *x;          //!< World X position
+    float32_t *y;          //!< World Y position
+    float32_t *prev_x;     //!< X position at the previous tick (for interpolation)
+    float32_t *prev_y;     //!< Y position at the previous tick
+    float32_t *vel_x;      //!< X velocity in units per second
+    float32_t *vel_y;      //!< Y velocity in units per second
+    float32_t *radius;     //!< Collision radius
+    float32_t *speed;      //!< Chase speed in units per second
+    float32_t *ai_timer;   //!< Seconds until the next attack
+    int32_t *health;       //!< Health
+    uint16_t *sprite;      //!< Sprite to draw
+    uint8_t *ai_state;     //!< dnf_entity_ai_state
+    dnf_entity *handles;   //!< Handle of every entity
+
+    // slots, by handle
+    uint32_t *slot_dense;  //!< Dense index of every used slot, next free slot of free slots
+    uint16_t *generations; //!< Generation of every slot
+    uint32_t free_head;    //!< First free slot (capacity - none)
+
+    dnf_arena memory;      //!< Memory of all arrays
+} dnf_entity_store;
+
+/**
+ * @brief Allocates an entity store.
+ *
+ * @param store Store to initialize.
+ * @param capacity Most entities (up to DNF_ENTITY_MAX_COUNT).
+ * @return True on success.
+ */
+DNF_API bool8_t entity_store_init(dnf_entity_store *store, uint32_t capacity);
+
+/**
+ * @brief Frees an entity store.
+ *
+ * @param store Store.
+ */
+DNF_API void entity_store_shutdown(dnf_entity_store *store);
+
+/**
+ * @brief Destroys all entities of a store (all handles become stale).
+ *
+ * @param store Store.
+ */
+DNF_API void entity_store_clear(dnf_entity_store *store);
+
+/**
+ * @brief Spawns an entity.
+ *
+ * @param store Store.
+ * @param desc Initial components.
+ * @return Handle, DNF_ENTITY_NONE if the store is full.
+ */
+DNF_API dnf_entity entity_spawn(dnf_entity_store *store, const dnf_entity_desc *desc);
+
+/**
+ * @brief Destroys an entity. The last entity moves into its dense index, so
+ * don't destroy entities while iterating forwards over the arrays.
+ *
+ * @param store Store.
+ * @param entity Handle.
+ * @return True if the entity was alive.
+ */
+DNF_API bool8_t entity_destroy(dnf_entity_store *store, dnf_entity entity);
+
+/**
+ * @brief Gets the dense index of an entity (valid until an entity is
+ * destroyed).
+ *
+ * @param store Store.
+ * @param entity Handle.
+ * @return Index into the component arrays, DNF_ENTITY_NO_INDEX if the
+ * entity isn't alive.
+ */
+DNF_API uint32_t entity_index(const dnf_entity_store *store, dnf_entity entity);
+
+/**
+ * @brief Moves all entities by their velocity and remembers their previous
+ * positions.
+ *
+ * @param store Store.
+ * @param dt Tick duration in seconds.
+ */
+DNF_API void entity_pass_move(dnf_entity_store *store, float32_t dt);
+
+/**
+ * @brief Runs the AI of all entities: idle entities notice the target,
+ * chasing ones steer towards it and attack when in range. Sets velocities
+ * for the next move pass. With a PVS, only entities in the target's
+ * potentially visible set wake up.
+ *
+ * @param store Store.
+ * @param params Target and AI parameters.
+ * @param dt Tick duration in seconds.
+ * @return Number of attacks on the target during this tick.
+ */
+DNF_API uint32_t entity_pass_ai(dnf_entity_store *store, const dnf_entity_ai_params *params, float32_t dt);
+
+/**
+ * @brief Links all entities into a blockmap at their current positions
+ * (entities that stay in their block aren't relinked).
+ *
+ * @param store Store.
+ * @param map Blockmap.
+ */
+DNF_API void entity_pass_link(const dnf_entity_store *store, struct dnf_blockmap *map);
+
+/**
+ * @brief Adds velocity that pushes overlapping entities apart over the next
+ * move pass. Uses the positions of the last entity_pass_link().
+ *
+ * @param store Store.
+ * @param map Blockmap with the linked entities.
+ * @param dt Tick duration in seconds.
+ */
+DNF_API void entity_pass_separate(dnf_entity_store *store, struct dnf_blockmap *map, float32_t dt);
+
+/**
+ * @brief Pushes entities that moved into walls of a grid map back along the
+ * blocked axis (they slide along walls) and stops them on that axis.
+ *
+ * @param store Store.
+ * @param map Grid map.
+ * @return Number of entities that hit a wall.
+ */
+DNF_API uint32_t entity_pass_collide_grid(dnf_entity_store *store, const dnf_grid_map *map);
@@ -28,6 +28,19 @@
  */
 bool8_t input_handler_init(dnf_input_system_handler* handler);
 
+/**
+ * @brief Latches this frame's presses and releases. Must be called once per
+ * frame, so that actions pressed in frames without a simulation tick are
+ * still seen by the next tick.
+ */
+void input_handler_poll(void);
+
+/**
+ * @brief Clears latched presses and releases after a simulation tick has
+ * seen them.
+ */
+void input_handler_end_tick(void);
+
 /**
  * @brief Shuts down the input handling system.
  */
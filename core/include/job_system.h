@@ -0,0 +1,85 @@
+// DNF (Doomed and Forgotten): a DOOM-style first-person shooter.
+// Copyright (C) 2025-2026  Alexandr Gorbatenko
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+
+#pragma once
+
+#include "defines.h"
+
+// Upper bound on the number of worker threads in the pool.
+#define DNF_JOB_MAX_WORKERS 64
+// Max number of batches queued at the same time.
+#define DNF_JOB_QUEUE_SIZE 16
+
+/**
+ * @brief A job function executed by the job system.
+ *
+ * @param job_index Index of the job in the dispatched batch.
+ * @param user_data User data passed to the dispatch call.
+ */
+typedef void (*dnf_job_fn)(uint32_t job_index, void *user_data);
+
+/**
+ * @brief Initializes the job system and starts a persistent worker pool.
+ *
+ * @param worker_count Number of worker threads (0 - one per extra CPU core).
+ * @return True if the worker pool was started successfully.
+ */
+bool8_t job_system_init(uint32_t worker_count);
+
+/**
+ * @brief Stops and joins all worker threads.
+ */
+void job_system_shutdown(void);
+
+/**
+ * @brief Gets the number of threads that execute jobs (workers + caller).
+ *
+ * @return Thread count (at least 1).
+ */
+DNF_API uint32_t job_system_thread_count(void);
+
+/**
+ * @brief Runs a batch of jobs on the worker pool and waits for it (and all
+ * previously queued batches) to finish.
+ *
+ * The calling thread also executes jobs while waiting. Jobs are picked in
+ * index order, but may run in any order and on any thread.
+ *
+ * @param job_count Number of jobs in the batch.
+ * @param fn Job function.
+ * @param user_data User data passed to every job.
+ */
+DNF_API void job_system_dispatch(uint32_t job_count, dnf_job_fn fn, void *user_data);
+
+/**
+ * @brief Queues a batch of jobs on the worker pool and returns immediately.
+ *
+ * Batches run in submission order: a batch starts only after the previous
+ * one has finished. User data must stay valid until job_system_wait().
+ * Without worker threads the batch runs right away on the calling thread.
+ *
+ * @param job_count Number of jobs in the batch.
+ * @param fn Job function.
+ * @param user_data User data passed to every job.
+ */
+DNF_API void job_system_dispatch_async(uint32_t job_count, dnf_job_fn fn, void *user_data);
+
+/**
+ * @brief Waits until all queued batches are finished, running jobs on the
+ * calling thread in the meantime.
+ */
+DNF_API void job_system_wait(void);
@@ -0,0 +1,154 @@
+// DNF (Doomed and Forgotten): a DOOM-style first-person shooter.
+// Copyright (C) 2025-2026  Alexandr Gorbatenko
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+#pragma once
+
+#include "defines.h"
+
+#include <stdarg.h>
+#include <stddef.h>
+
+// Most arguments (including '*' widths and precisions) a packed message can have.
+#define DNF_LOG_MAX_ARGS 32
+
+// Binary log file signature (8 bytes, including the terminator).
+#define DNF_LOG_BINARY_MAGIC "DNFBLOG"
+// Binary log format version.
+#define DNF_LOG_BINARY_VERSION 1
+
+/*
+ * Binary log layout (host byte order):
+ *
+ * header:  magic[8], u32 version, u8 sizeof(long), u8 sizeof(void *),
+ *          u16 reserved, i64 wall clock seconds at clock_origin,
+ *          u64 clock_origin (monotonic nanoseconds)
+ * records: u8 type, then
+ *   SITE:    u32 site id, u8 level, u32 line, u16 file length, file,
+ *            u16 format length, format
+ *   MESSAGE: u32 site id, u64 timestamp (monotonic nanoseconds),
+ *            u32 packed arguments size, packed arguments
+ *   TEXT:    u8 level, u64 timestamp, u32 line, u16 file length, file,
+ *            u32 message length, message
+ *
+ * A site is always written before its first message. Every rotated file
+ * starts with its own header and repeats the sites it uses.
+ */
+
+/**
+ * @brief Types of binary log records.
+ */
+typedef enum dnf_log_record_type
+{
+    DNF_LOG_RECORD_SITE = 1,     //!< Call site definition (file, line, level, format)
+    DNF_LOG_RECORD_MESSAGE = 2,  //!< Message of a call site with packed arguments
+    DNF_LOG_RECORD_TEXT = 3,     //!< Preformatted message
+} dnf_log_record_type;
+
+/**
+ * @brief Storage types of packed printf arguments.
+ */
+typedef enum dnf_log_arg_kind
+{
+    DNF_LOG_ARG_INT,          //!< int (also char, short and '*' widths)
+    DNF_LOG_ARG_LONG,         //!< long
+    DNF_LOG_ARG_LONG_LONG,    //!< long long
+    DNF_LOG_ARG_INTMAX,       //!< intmax_t
+    DNF_LOG_ARG_SIZE,         //!< size_t
+    DNF_LOG_ARG_PTRDIFF,      //!< ptrdiff_t
+    DNF_LOG_ARG_DOUBLE,       //!< double (also float)
+    DNF_LOG_ARG_LONG_DOUBLE,  //!< long double
+    DNF_LOG_ARG_STRING,       //!< C string (copied: u32 length and characters)
+    DNF_LOG_ARG_POINTER,      //!< void *
+} dnf_log_arg_kind;
+
+// String argument without a precision.
+#define DNF_LOG_PRECISION_NONE (-1)
+// String argument with a '*' precision (taken from the preceding int argument).
+#define DNF_LOG_PRECISION_ARG (-2)
+
+/**
+ * @brief Argument types expected by a printf format string.
+ */
+typedef struct dnf_log_signature
+{
+    uint8_t count;                       //!< Number of arguments
+    uint8_t kinds[DNF_LOG_MAX_ARGS];     //!< Argument kinds (dnf_log_arg_kind)
+    int16_t precisions[DNF_LOG_MAX_ARGS];  //!< String precisions (DNF_LOG_PRECISION_* or a length)
+} dnf_log_signature;
+
+/**
+ * @brief Gets the name of a logging level.
+ *
+ * @param level Logging level (dnf_log_level).
+ * @return Level name ("?" if unknown).
+ */
+DNF_API const char *dnf_log_level_name(uint32_t level);
+
+/**
+ * @brief Formats a full log line (with the trailing newline) as it appears
+ * in the text log.
+ *
+ * @param out Output buffer (always terminated).
+ * @param out_size Output buffer size.
+ * @param wall_time Wall clock time in seconds (time_t).
+ * @param level Logging level (dnf_log_level).
+ * @param file Source file.
+ * @param line Source line.
+ * @param message Formatted message.
+ * @return Length of the line (truncated to out_size - 1).
+ */
+DNF_API size_t dnf_log_format_line(
+    char *out, size_t out_size,
+    int64_t wall_time, uint32_t level,
+    const char *file, uint32_t line,
+    const char *message);
+
+/**
+ * @brief Parses the arguments a printf format string expects.
+ *
+ * @param format Format string.
+ * @param out_signature Resulting signature.
+ * @return False if the format uses conversions that can't be packed (%n,
+ * wide strings or too many arguments).
+ */
+DNF_API bool8_t dnf_log_parse_signature(const char *format, dnf_log_signature *out_signature);
+
+/**
+ * @brief Copies variadic arguments into a byte buffer without formatting them.
+ *
+ * @param signature Argument signature of the format string.
+ * @param args Arguments.
+ * @param out Output buffer.
+ * @param capacity Output buffer size (strings are cut to their precision and
+ * truncated to fit).
+ * @return Number of bytes written.
+ */
+DNF_API size_t dnf_log_pack_args(const dnf_log_signature *signature, va_list args, uint8_t *out, size_t capacity);
+
+/**
+ * @brief Formats a message from packed arguments, producing the same text
+ * as vsnprintf() with the original arguments.
+ *
+ * @param format Format string.
+ * @param args Packed arguments.
+ * @param args_size Size of the packed arguments.
+ * @param out Output buffer (always terminated).
+ * @param out_size Output buffer size.
+ * @return Length of the formatted message (truncated to out_size - 1).
+ */
+DNF_API size_t dnf_log_format_packed(
+    const char *format,
+    const uint8_t *args, size_t args_size,
+    char *out, size_t out_size);
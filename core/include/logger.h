@@ -18,13 +18,29 @@
 #pragma once
 
 #include "defines.h"
+#include "log_binary.h"
 
-#define DNF_LOG_TRACE_ENABLED 1
-#define DNF_LOG_DEBUG_ENABLED 1
-#define DNF_LOG_INFO_ENABLED 1
-#define DNF_LOG_WARN_ENABLED 1
+#include <stdatomic.h>
+
+// Lowest logging level compiled in (0 - TRACE ... 3 - WARN), calls below it
+// are stripped entirely. Release presets raise it.
+#ifndef DNF_LOG_COMPILE_MIN_LEVEL
+    #define DNF_LOG_COMPILE_MIN_LEVEL 0
+#endif
+
+#define DNF_LOG_TRACE_ENABLED (DNF_LOG_COMPILE_MIN_LEVEL <= 0)
+#define DNF_LOG_DEBUG_ENABLED (DNF_LOG_COMPILE_MIN_LEVEL <= 1)
+#define DNF_LOG_INFO_ENABLED (DNF_LOG_COMPILE_MIN_LEVEL <= 2)
+#define DNF_LOG_WARN_ENABLED (DNF_LOG_COMPILE_MIN_LEVEL <= 3)
 // NOTE: ERROR and FATAL are always enabled
 
+// Module (subsystem tag) of the messages of a source file, used by per-module
+// levels. Define it before including any header; by default the module is
+// the file name without its directory and extension (e.g. "renderer").
+#ifndef DNF_LOG_MODULE
+    #define DNF_LOG_MODULE nullptr
+#endif
+
 /**
  * @brief An enum that represents the current program logging level.
  */
@@ -40,25 +56,120 @@ typedef enum dnf_log_level
     DNF_LOG_LEVEL_COUNT = 6,  //!< Total count of logging levels
 } dnf_log_level;
 
+/**
+ * @brief An enum that represents the log file format.
+ */
+typedef enum dnf_log_format
+{
+    DNF_LOG_FORMAT_TEXT,    //!< Human-readable lines (logs/dnf_game.log)
+    DNF_LOG_FORMAT_BINARY,  //!< Interned call sites and packed arguments (logs/dnf_game.dnflog, see dnf_logdump)
+} dnf_log_format;
+
+/**
+ * @brief Runtime filter state of a call site.
+ */
+typedef enum dnf_log_site_filter
+{
+    DNF_LOG_SITE_FILTER_UNKNOWN = 0,  //!< Not checked yet (first call)
+    DNF_LOG_SITE_FILTER_ENABLED,      //!< Messages are logged
+    DNF_LOG_SITE_FILTER_DISABLED,     //!< Messages are skipped before evaluating arguments
+} dnf_log_site_filter;
+
+/**
+ * @brief A logging call site. Every logging macro expands to a static one,
+ * so the format is only parsed once and the binary format can refer to the
+ * site by id instead of repeating its file, line and format.
+ *
+ * Sites register with the logger on their first call; the logger then keeps
+ * their filter up to date whenever the runtime levels change.
+ */
+typedef struct dnf_log_site
+{
+    const char *file;             //!< Source file
+    uint32_t line;                //!< Source line
+    dnf_log_level level;          //!< Logging level
+    const char *format;           //!< Message format string
+    const char *module;           //!< Module tag (nullptr - derived from the file name)
+
+    atomic_int filter;            //!< Runtime filter (dnf_log_site_filter), checked inline
+    struct dnf_log_site *next;    //!< Next registered site
+    bool8_t registered;           //!< The logger knows about this site
+
+    atomic_int state;             //!< Argument signature state (parsed on first use)
+    dnf_log_signature signature;  //!< Argument signature of the format
+    uint32_t binary_generation;   //!< Binary log file the site was last written to
+    uint32_t binary_id;           //!< Site id in that file
+} dnf_log_site;
+
 /**
  * @brief Initializes the logging system.
  *
- * Creates a ./logs directory if it doesn't exist.
+ * Creates a ./logs directory if it doesn't exist and opens the log file for
+ * appending (it is rotated once it grows past a size limit, keeping a few
+ * older files as dnf_game.log.1, .2, ...). In asynchronous mode
+ * callers only format the message and push it into a lock-free ring buffer,
+ * while a writer thread formats the full line and does all output. Messages
+ * logged before initialization (or without async) are written synchronously.
+ *
+ * @param async Use a background writer thread.
+ * @param format Log file format (the binary format needs async mode to
+ * skip formatting; console output is limited to warnings and errors).
+ * @return True if the log file was opened successfully.
+ */
+bool8_t dnf_logger_init(bool8_t async, dnf_log_format format);
+
+/**
+ * @brief Waits until every message logged so far has been written out.
  *
- * @return True if the logging directory was created successfully.
+ * Called automatically for fatal messages.
  */
-bool8_t dnf_logger_init(void);
+DNF_API void dnf_logger_flush(void);
 
 /**
  * @brief Shuts down the logging system.
  *
- * For now, does basically nothing.
+ * Writes out all queued messages, stops the writer thread and closes the
+ * log file. Messages logged afterwards reopen it.
  */
 void dnf_logger_shutdown(void);
 
+/**
+ * @brief Sets the runtime logging level: messages below it are skipped
+ * (unless their module has its own level). Errors and fatal errors are
+ * always logged.
+ *
+ * @param level Minimum logging level.
+ */
+DNF_API void dnf_logger_set_level(dnf_log_level level);
+
+/**
+ * @brief Sets the runtime logging level of a module, overriding the
+ * global level for its messages.
+ *
+ * @param module Module name (a DNF_LOG_MODULE tag or a source file name
+ * without extension).
+ * @param level Minimum logging level of the module.
+ * @return False if there are too many module levels already.
+ */
+DNF_API bool8_t dnf_logger_set_module_level(const char *module, dnf_log_level level);
+
+/**
+ * @brief Applies runtime levels from a comma-separated list of a global
+ * level and module levels, e.g. "info,renderer=trace,bsp=warn". Level
+ * names are case-insensitive.
+ *
+ * @param spec Level list.
+ * @return False if the list contains an invalid entry (valid ones are
+ * still applied).
+ */
+DNF_API bool8_t dnf_logger_set_levels(const char *spec);
+
 /**
  * @brief Main logging function to handle all logging output.
  *
+ * Only the global runtime level applies, the logging macros should be
+ * preferred.
+ *
  * @param file Name of the file where the message originates from.
  * @param line Number of line in the origin file.
  * @param level Logging level (as in dnf_log_level).
@@ -67,41 +178,75 @@ void dnf_logger_shutdown(void);
  */
 DNF_API void dnf_log_message(const char *file, uint32_t line, dnf_log_level level, const char *message, ...);
 
+/**
+ * @brief Logs a message of a call site (used by the logging macros).
+ *
+ * Registers the site and checks its runtime filter on the first call.
+ * In asynchronous mode the arguments are packed without formatting.
+ *
+ * @param site Call site.
+ * @param ... Format string parameters.
+ */
+DNF_API void dnf_log_site_message(dnf_log_site *site, ...);
+
+// Logs a message through a static call site. Disabled sites cost a relaxed load,
+// their arguments aren't evaluated.
+#define DNF_LOG_AT_SITE(log_level, message, ...)                                            \
+    do                                                                                      \
+    {                                                                                       \
+        static dnf_log_site dnf_log_site_ = {                                               \
+            .file = __FILE__, .line = __LINE__, .level = log_level, .format = message,      \
+            .module = DNF_LOG_MODULE                                                        \
+        };                                                                                  \
+        if (atomic_load_explicit(&dnf_log_site_.filter, memory_order_relaxed)               \
+            != DNF_LOG_SITE_FILTER_DISABLED)                                                \
+            dnf_log_site_message(&dnf_log_site_, ##__VA_ARGS__);                            \
+    } while (0)
+
+// Compiles a stripped logging call: nothing is evaluated or emitted, but
+// the arguments still have to compile (and count as used).
+#define DNF_LOG_STRIPPED(log_level, message, ...)                                           \
+    do                                                                                      \
+    {                                                                                       \
+        if (0)                                                                              \
+            dnf_log_message(__FILE__, __LINE__, log_level, message, ##__VA_ARGS__);         \
+    } while (0)
+
 
 #if DNF_LOG_TRACE_ENABLED == 1
     // Logs a tracing level message (in-depth debugging app info).
-    #define DNF_TRACE(message, ...) dnf_log_message(__FILE__, __LINE__, DNF_LOG_LEVEL_TRACE, message, ##__VA_ARGS__)
+    #define DNF_TRACE(message, ...) DNF_LOG_AT_SITE(DNF_LOG_LEVEL_TRACE, message, ##__VA_ARGS__)
 #else
     // Logs a tracing level message (in-depth debugging app info).
-    #define DNF_TRACE(message, ...)
+    #define DNF_TRACE(message, ...) DNF_LOG_STRIPPED(DNF_LOG_LEVEL_TRACE, message, ##__VA_ARGS__)
 #endif
 
 #if DNF_LOG_DEBUG_ENABLED == 1
     // Logs a debug level message (all-purpose debugging app info).
-    #define DNF_DEBUG(message, ...) dnf_log_message(__FILE__, __LINE__, DNF_LOG_LEVEL_DEBUG, message, ##__VA_ARGS__)
+    #define DNF_DEBUG(message, ...) DNF_LOG_AT_SITE(DNF_LOG_LEVEL_DEBUG, message, ##__VA_ARGS__)
 #else
     // Logs a debug level message (all-purpose debugging app info).
-    #define DNF_DEBUG(message, ...)
+    #define DNF_DEBUG(message, ...) DNF_LOG_STRIPPED(DNF_LOG_LEVEL_DEBUG, message, ##__VA_ARGS__)
 #endif
 
 #if DNF_LOG_INFO_ENABLED == 1
     // Logs an information level message (basic app info).
-    #define DNF_INFO(message, ...) dnf_log_message(__FILE__, __LINE__, DNF_LOG_LEVEL_INFO, message, ##__VA_ARGS__)
+    #define DNF_INFO(message, ...) DNF_LOG_AT_SITE(DNF_LOG_LEVEL_INFO, message, ##__VA_ARGS__)
 #else
     // Logs an information level message (basic app info).
-    #define DNF_INFO(message, ...)
+    #define DNF_INFO(message, ...) DNF_LOG_STRIPPED(DNF_LOG_LEVEL_INFO, message, ##__VA_ARGS__)
 #endif
 
 #if DNF_LOG_WARN_ENABLED == 1
     // Logs a warning level message (app will recover from this state).
-    #define DNF_WARN(message, ...) dnf_log_message(__FILE__, __LINE__, DNF_LOG_LEVEL_WARN, message, ##__VA_ARGS__)
+    #define DNF_WARN(message, ...) DNF_LOG_AT_SITE(DNF_LOG_LEVEL_WARN, message, ##__VA_ARGS__)
 #else
     // Logs a warning level message (app will be able to recover from this state).
-    #define DNF_WARN(message, ...)
+    #define DNF_WARN(message, ...) DNF_LOG_STRIPPED(DNF_LOG_LEVEL_WARN, message, ##__VA_ARGS__)
 #endif
 
 // Logs an error level message (app could recover from this state).
-#define DNF_ERROR(message, ...) dnf_log_message(__FILE__, __LINE__, DNF_LOG_LEVEL_ERROR, message, ##__VA_ARGS__)
+#define DNF_ERROR(message, ...) DNF_LOG_AT_SITE(DNF_LOG_LEVEL_ERROR, message, ##__VA_ARGS__)
 
 // Logs a fatal level message (app cannot continue running).
-#define DNF_FATAL(message, ...) dnf_log_message(__FILE__, __LINE__, DNF_LOG_LEVEL_FATAL, message, ##__VA_ARGS__)
+#define DNF_FATAL(message, ...) DNF_LOG_AT_SITE(DNF_LOG_LEVEL_FATAL, message, ##__VA_ARGS__)
@@ -0,0 +1,87 @@
+// DNF (Doomed and Forgotten): a DOOM-style first-person shooter.
+// Copyright (C) 2025-2026  Alexandr Gorbatenko
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+#pragma once
+
+#include "defines.h"
+
+#include <raylib.h>
+
+// Number of colors in a palette.
+#define DNF_PALETTE_SIZE 256
+// Number of light levels (0 - black, DNF_PALETTE_LIGHT_LEVELS - 1 - full bright).
+#define DNF_PALETTE_LIGHT_LEVELS 32
+// Bits per channel of the inverse color table (RGB555).
+#define DNF_PALETTE_INVERSE_BITS 5
+
+
+/**
+ * @brief A 256-color palette with its lighting tables.
+ *
+ * Indexed framebuffers store palette indices, which are expanded to RGBA
+ * once per frame. Lighting is a table lookup (colormaps), as in the classic
+ * DOOM renderer.
+ */
+typedef struct dnf_palette
+{
+    Color colors[DNF_PALETTE_SIZE];  //!< Palette colors (alpha 0 - transparent for keyed blits)
+    uint8_t colormaps[DNF_PALETTE_LIGHT_LEVELS][DNF_PALETTE_SIZE];  //!< Closest index to a color lit by a light level
+    uint8_t inverse[1 << (3 * DNF_PALETTE_INVERSE_BITS)];  //!< Closest index to an RGB555 color
+} dnf_palette;
+
+/**
+ * @brief Initializes a palette and builds its lighting and lookup tables.
+ *
+ * Takes a while (tens of milliseconds): call it on load, not per frame.
+ *
+ * @param palette Resulting palette.
+ * @param colors Palette colors.
+ */
+DNF_API void palette_init(dnf_palette *palette, const Color colors[DNF_PALETTE_SIZE]);
+
+/**
+ * @brief Initializes the default palette: a 6x6x6 color cube and a
+ * 40-step gray ramp.
+ *
+ * @param palette Resulting palette.
+ */
+DNF_API void palette_init_default(dnf_palette *palette);
+
+/**
+ * @brief Finds the palette index closest to a color (alpha is ignored).
+ *
+ * @param palette Palette.
+ * @param color Color to look up.
+ * @return Palette index.
+ */
+DNF_API uint8_t palette_find(const dnf_palette *palette, Color color);
+
+/**
+ * @brief Converts a light factor to a light level.
+ *
+ * @param light Light factor, [0; 1] (clamped).
+ * @return Light level, [0; DNF_PALETTE_LIGHT_LEVELS).
+ */
+DNF_API uint32_t palette_light_level(float32_t light);
+
+/**
+ * @brief Lights a palette index (a colormap lookup).
+ *
+ * @param palette Palette.
+ * @param index Palette index.
+ * @param level Light level (see palette_light_level()).
+ * @return Palette index of the lit color.
+ */
+DNF_API uint8_t palette_light(const dnf_palette *palette, uint8_t index, uint32_t level);
@@ -0,0 +1,290 @@
+// DNF (Doomed and Forgotten): a DOOM-style first-person shooter.
+// Copyright (C) 2025-2026  Alexandr Gorbatenko
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+#pragma once
+
+#include "defines.h"
+#include "renderer.h"
+
+
+/**
+ * @brief Instruction sets the pixel kernels can use.
+ */
+typedef enum dnf_pixel_isa
+{
+    DNF_PIXEL_ISA_AUTO,    //!< Best one supported by the CPU
+    DNF_PIXEL_ISA_SCALAR,  //!< Plain C (any CPU)
+    DNF_PIXEL_ISA_SSE2,    //!< x86 SSE2
+    DNF_PIXEL_ISA_AVX2,    //!< x86 AVX2
+    DNF_PIXEL_ISA_NEON,    //!< ARM NEON
+
+    DNF_PIXEL_ISA_COUNT
+} dnf_pixel_isa;
+
+/**
+ * @brief Selects the pixel kernels.
+ *
+ * Kernels can be used before this is called, they are scalar until then.
+ *
+ * @param requested Instruction set (falls back to the best supported one
+ * if the CPU doesn't support it).
+ * @return Selected instruction set.
+ */
+DNF_API dnf_pixel_isa pixels_init(dnf_pixel_isa requested);
+
+/**
+ * @brief Checks whether the CPU (and the build) supports an instruction set.
+ *
+ * @param isa Instruction set.
+ * @return True if the kernels can use it.
+ */
+DNF_API bool8_t pixels_isa_supported(dnf_pixel_isa isa);
+
+/**
+ * @brief Gets the instruction set the kernels use.
+ *
+ * @return Selected instruction set.
+ */
+DNF_API dnf_pixel_isa pixels_get_isa(void);
+
+/**
+ * @brief Gets the name of an instruction set ("scalar", "sse2", ...).
+ *
+ * @param isa Instruction set.
+ * @return Name ("?" if unknown).
+ */
+DNF_API const char *pixels_isa_name(dnf_pixel_isa isa);
+
+/**
+ * @brief Finds an instruction set by name.
+ *
+ * @param name Instruction set name (as in pixels_isa_name()).
+ * @return Instruction set or DNF_PIXEL_ISA_COUNT if there is none.
+ */
+DNF_API dnf_pixel_isa pixels_isa_find(const char *name);
+
+/**
+ * @brief Fills the whole framebuffer with a color.
+ *
+ * @param fb Framebuffer.
+ * @param color Fill color.
+ */
+DNF_API void pixels_clear(const dnf_framebuffer *fb, Color color);
+
+/**
+ * @brief Fills a rectangle [x0; x1) x [y0; y1), clipped to the framebuffer.
+ *
+ * @param fb Framebuffer.
+ * @param x0 Left column (inclusive).
+ * @param y0 Top row (inclusive).
+ * @param x1 Right column (exclusive).
+ * @param y1 Bottom row (exclusive).
+ * @param color Fill color.
+ */
+DNF_API void pixels_fill_rect(
+    const dnf_framebuffer *fb,
+    int32_t x0, int32_t y0, int32_t x1, int32_t y1,
+    Color color);
+
+/**
+ * @brief Fills a horizontal span [x0; x1) of a row, clipped to the framebuffer.
+ *
+ * @param fb Framebuffer.
+ * @param y Row.
+ * @param x0 First column (inclusive).
+ * @param x1 Last column (exclusive).
+ * @param color Fill color.
+ */
+DNF_API void pixels_fill_span(const dnf_framebuffer *fb, int32_t y, int32_t x0, int32_t x1, Color color);
+
+/**
+ * @brief Fills a vertical run [y0; y1) of a column, clipped to the framebuffer.
+ *
+ * @param fb Framebuffer.
+ * @param x Column.
+ * @param y0 First row (inclusive).
+ * @param y1 Last row (exclusive).
+ * @param color Fill color.
+ */
+DNF_API void pixels_fill_column(const dnf_framebuffer *fb, int32_t x, int32_t y0, int32_t y1, Color color);
+
+/**
+ * @brief pixels_fill_rect() with a palette index (indexed framebuffers only).
+ */
+DNF_API void pixels_fill_rect_index(
+    const dnf_framebuffer *fb,
+    int32_t x0, int32_t y0, int32_t x1, int32_t y1,
+    uint8_t index);
+
+/**
+ * @brief pixels_fill_span() with a palette index (indexed framebuffers only).
+ */
+DNF_API void pixels_fill_span_index(const dnf_framebuffer *fb, int32_t y, int32_t x0, int32_t x1, uint8_t index);
+
+/**
+ * @brief pixels_fill_column() with a palette index (indexed framebuffers
+ * only). Lit colors come from palette_light().
+ */
+DNF_API void pixels_fill_column_index(const dnf_framebuffer *fb, int32_t x, int32_t y0, int32_t y1, uint8_t index);
+
+/**
+ * @brief Draws a vertical run [y0; y1) of a column with the texels of a
+ * texture column, clipped to the framebuffer.
+ *
+ * Texels are stepped in fixed point and wrap around the column, so y0 can
+ * be far above the screen (close walls). Indexed framebuffers get the
+ * closest palette index, lit through the colormaps.
+ *
+ * @param fb Framebuffer.
+ * @param x Column.
+ * @param y0 First row (inclusive, may be off-screen).
+ * @param y1 Last row (exclusive).
+ * @param texels Texture column (see texture_column()).
+ * @param texel_count Texels in the column, a power of two.
+ * @param v Texel coordinate at row y0.
+ * @param v_step Texels per row.
+ * @param light Light factor, [0; 1].
+ */
+DNF_API void pixels_draw_column_textured(
+    const dnf_framebuffer *fb,
+    int32_t x, int32_t y0, int32_t y1,
+    const Color *texels, int32_t texel_count,
+    float32_t v, float32_t v_step,
+    float32_t light);
+
+/**
+ * @brief pixels_draw_column_textured() with palette index texels (indexed
+ * framebuffers only, see texture_column_indices()), lit straight through
+ * the colormaps.
+ */
+DNF_API void pixels_draw_column_textured_index(
+    const dnf_framebuffer *fb,
+    int32_t x, int32_t y0, int32_t y1,
+    const uint8_t *texels, int32_t texel_count,
+    float32_t v, float32_t v_step,
+    float32_t light);
+
+/**
+ * @brief Draws a horizontal span [x0; x1) of a row with the texels of a flat
+ * texture (floors and ceilings), clipped to the framebuffer.
+ *
+ * Texel coordinates are stepped in fixed point and wrap around the texture.
+ * Indexed framebuffers get the closest palette index, lit through the
+ * colormaps.
+ *
+ * @param fb Framebuffer.
+ * @param y Row.
+ * @param x0 First column (inclusive, may be off-screen).
+ * @param x1 Last column (exclusive).
+ * @param texels Flat texture level (row-major, see texture_row()).
+ * @param texel_width Level width, a power of two.
+ * @param texel_height Level height, a power of two.
+ * @param u Texel column coordinate at column x0.
+ * @param v Texel row coordinate at column x0.
+ * @param u_step Texel columns per column.
+ * @param v_step Texel rows per column.
+ * @param light Light factor, [0; 1].
+ */
+DNF_API void pixels_draw_span_textured(
+    const dnf_framebuffer *fb,
+    int32_t y, int32_t x0, int32_t x1,
+    const Color *texels, int32_t texel_width, int32_t texel_height,
+    float32_t u, float32_t v,
+    float32_t u_step, float32_t v_step,
+    float32_t light);
+
+/**
+ * @brief pixels_draw_span_textured() with palette index texels (indexed
+ * framebuffers only, see texture_cache_set_palette()), lit straight
+ * through the colormaps.
+ */
+DNF_API void pixels_draw_span_textured_index(
+    const dnf_framebuffer *fb,
+    int32_t y, int32_t x0, int32_t x1,
+    const uint8_t *texels, int32_t texel_width, int32_t texel_height,
+    float32_t u, float32_t v,
+    float32_t u_step, float32_t v_step,
+    float32_t light);
+
+/**
+ * @brief Draws a vertical run [y0; y1) of a column with the texels of a
+ * masked texture column (sprites), skipping texels with zero alpha.
+ *
+ * Unlike pixels_draw_column_textured(), texels are clamped to the column
+ * instead of wrapping around it, so any texel count works. Column-major
+ * RGBA framebuffers blend whole runs with the SIMD keyed copy kernel.
+ *
+ * @param fb Framebuffer.
+ * @param x Column.
+ * @param y0 First row (inclusive, may be off-screen).
+ * @param y1 Last row (exclusive).
+ * @param texels Texture column (see texture_column()).
+ * @param texel_count Texels in the column.
+ * @param v Texel coordinate at row y0.
+ * @param v_step Texels per row.
+ * @param light Light factor, [0; 1].
+ */
+DNF_API void pixels_draw_column_masked(
+    const dnf_framebuffer *fb,
+    int32_t x, int32_t y0, int32_t y1,
+    const Color *texels, int32_t texel_count,
+    float32_t v, float32_t v_step,
+    float32_t light);
+
+/**
+ * @brief pixels_draw_column_masked() with palette index texels (indexed
+ * framebuffers only, see texture_column_indices()), skipping the
+ * transparent index instead of zero alpha.
+ *
+ * @param transparent_index Index of the masked texels
+ * (dnf_texture::transparent_index).
+ */
+DNF_API void pixels_draw_column_masked_index(
+    const dnf_framebuffer *fb,
+    int32_t x, int32_t y0, int32_t y1,
+    const uint8_t *texels, int32_t texel_count,
+    float32_t v, float32_t v_step,
+    float32_t light, uint8_t transparent_index);
+
+/**
+ * @brief Copies a rectangle of one framebuffer (or image) into another,
+ * clipped to both.
+ *
+ * Indexed sources are expanded through their palette into RGBA
+ * destinations. Copying RGBA pixels into an indexed framebuffer works, but
+ * goes pixel by pixel.
+ *
+ * @param dst Destination framebuffer.
+ * @param dst_x Destination left column.
+ * @param dst_y Destination top row.
+ * @param src Source framebuffer.
+ * @param src_x Source left column.
+ * @param src_y Source top row.
+ * @param width Rectangle width.
+ * @param height Rectangle height.
+ */
+DNF_API void pixels_blit(
+    const dnf_framebuffer *dst, int32_t dst_x, int32_t dst_y,
+    const dnf_framebuffer *src, int32_t src_x, int32_t src_y,
+    int32_t width, int32_t height);
+
+/**
+ * @brief Like pixels_blit(), but skips source pixels with zero alpha
+ * (sprites and masked textures).
+ */
+DNF_API void pixels_blit_keyed(
+    const dnf_framebuffer *dst, int32_t dst_x, int32_t dst_y,
+    const dnf_framebuffer *src, int32_t src_x, int32_t src_y,
+    int32_t width, int32_t height);
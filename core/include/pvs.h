@@ -0,0 +1,202 @@
+// DNF (Doomed and Forgotten): a DOOM-style first-person shooter.
+// Copyright (C) 2025-2026  Alexandr Gorbatenko
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+
+#pragma once
+
+#include "defines.h"
+#include "bsp.h"
+#include "raycaster.h"
+
+#include <stddef.h>
+
+// Lump signature (8 bytes, including the terminator).
+#define DNF_PVS_MAGIC "DNFPVS1"
+// Lump format version.
+#define DNF_PVS_VERSION 2
+// Cluster index of no cluster (outside the map).
+#define DNF_PVS_NO_CLUSTER UINT32_MAX
+
+/*
+ * Lump layout (little-endian, stored as is in a WAD lump):
+ *
+ * header:  dnf_pvs_header
+ * offsets: cluster count u32 offsets of the rows from the start of the data
+ * data:    one compressed row per cluster
+ *
+ * A row is a bitset of the clusters visible from a cluster (bit c of byte
+ * c / 8). Rows are run-length encoded the way DOOM-era engines did it:
+ * non-zero bytes are stored as is, a zero byte is followed by the number of
+ * zero bytes in its run (1 to 255). Rows of big maps are mostly zeros, so
+ * they shrink to a few bytes per visible area.
+ */
+
+/**
+ * @brief Header at the start of a PVS lump.
+ */
+typedef struct dnf_pvs_header
+{
+    char magic[8];           //!< DNF_PVS_MAGIC
+    uint32_t version;        //!< DNF_PVS_VERSION
+    uint32_t cluster_count;  //!< Number of clusters (and rows)
+    int32_t cluster_size;    //!< Grid cells per cluster side (0 - clusters are BSP subsectors)
+    int32_t width;           //!< Grid map width in cells (0 - BSP level)
+    int32_t height;          //!< Grid map height in cells (0 - BSP level)
+    uint32_t data_size;      //!< Size of the compressed rows in bytes
+    uint32_t source_hash;    //!< Hash of the map the PVS was built from (see pvs_matches_grid())
+} dnf_pvs_header;
+
+STATIC_ASSERT(sizeof(dnf_pvs_header) == 36, "Expected the PVS header to be 36 bytes");
+
+/**
+ * @brief A potentially visible set: which clusters of a map can be seen
+ * from anywhere in every cluster.
+ *
+ * Clusters of a grid map are squares of cluster_size cells, numbered row by
+ * row; clusters of a BSP level are its subsectors. Sets are built offline
+ * (pvs_build_grid(), pvs_build_level()) and stored as a lump; at runtime a
+ * row is decompressed once per frame for the viewer's cluster and anything
+ * outside it (geometry, sprites, monsters) is skipped.
+ */
+typedef struct dnf_pvs
+{
+    uint32_t cluster_count;  //!< Number of clusters
+    uint32_t row_bytes;      //!< Size of a decompressed row in bytes
+    int32_t cluster_size;    //!< Grid cells per cluster side (0 - BSP subsectors)
+    int32_t clusters_x;      //!< Clusters per grid map row (0 - BSP subsectors)
+    int32_t width;           //!< Grid map width in cells
+    int32_t height;          //!< Grid map height in cells
+    uint32_t source_hash;    //!< Hash of the map the PVS was built from
+
+    const uint32_t *offsets; //!< Row offsets into data, per cluster
+    const uint8_t *data;     //!< Compressed rows
+    size_t data_size;        //!< Size of the compressed rows in bytes
+    const void *lump;        //!< Whole lump (header, offsets and rows)
+    size_t lump_size;        //!< Lump size in bytes
+    bool8_t owned;           //!< True if the lump was built (freed by pvs_free())
+} dnf_pvs;
+
+/**
+ * @brief Builds the PVS of a grid map.
+ *
+ * Parallel lines are sampled across the whole map in every direction and
+ * walked through the grid (DDA, like the raycaster); the clusters along a
+ * stretch of a line between two walls, walls included, all see each other.
+ * Lines are spaced to cover every cell at the far end of the map and go on
+ * past walls they only clip the corner of, so the views between two lines
+ * are kept too. Every sight line is walked once for all the clusters along
+ * it, so the cost grows with the number of lines times the map size rather
+ * than with the number of cluster pairs. Jobs on the job system fill
+ * interleaved rows.
+ *
+ * @param pvs Resulting PVS (free with pvs_free()).
+ * @param map Grid map.
+ * @param cluster_size Cells per cluster side (bigger clusters - smaller, coarser sets).
+ * @return True on success.
+ */
+DNF_API bool8_t pvs_build_grid(dnf_pvs *pvs, const dnf_grid_map *map, int32_t cluster_size);
+
+/**
+ * @brief Builds the subsector-to-subsector PVS of a BSP level.
+ *
+ * Lines sampled as in pvs_build_grid() are walked down the tree, split into
+ * the subsectors they cross, and cut at the one-sided segs of those
+ * subsectors; the subsectors along a stretch between two walls that lies
+ * inside the level all see each other. Jobs on the job system fill
+ * interleaved rows.
+ *
+ * @param pvs Resulting PVS (free with pvs_free()).
+ * @param level BSP level.
+ * @return True on success.
+ */
+DNF_API bool8_t pvs_build_level(dnf_pvs *pvs, const dnf_bsp_level *level);
+
+/**
+ * @brief Uses a PVS lump in place (zero-copy), e.g. from a WAD archive.
+ *
+ * @param pvs Resulting PVS.
+ * @param lump Lump data (must outlive the PVS and be 4-byte aligned).
+ * @param size Lump size in bytes.
+ * @return False if the lump is malformed.
+ */
+DNF_API bool8_t pvs_load(dnf_pvs *pvs, const void *lump, size_t size);
+
+/**
+ * @brief Checks if a PVS was built from a grid map as it is now (a loaded
+ * lump may be older than the map).
+ *
+ * Only walls and empty cells count, wall types don't change visibility.
+ *
+ * @param pvs PVS.
+ * @param map Grid map.
+ * @param cluster_size Cells per cluster side the PVS is expected to use.
+ * @return True if the PVS matches the map.
+ */
+DNF_API bool8_t pvs_matches_grid(const dnf_pvs *pvs, const dnf_grid_map *map, int32_t cluster_size);
+
+/**
+ * @brief Checks if a PVS was built from a BSP level as it is now (the tree,
+ * its subsector numbering and its one-sided segs).
+ *
+ * @param pvs PVS.
+ * @param level BSP level.
+ * @return True if the PVS matches the level.
+ */
+DNF_API bool8_t pvs_matches_level(const dnf_pvs *pvs, const dnf_bsp_level *level);
+
+/**
+ * @brief Frees a built PVS (loaded lumps are left alone).
+ *
+ * @param pvs PVS.
+ */
+DNF_API void pvs_free(dnf_pvs *pvs);
+
+/**
+ * @brief Writes the lump of a PVS to a file (to be packed into a WAD).
+ *
+ * @param pvs PVS.
+ * @param path Output file path.
+ * @return True on success.
+ */
+DNF_API bool8_t pvs_save(const dnf_pvs *pvs, const char *path);
+
+/**
+ * @brief Decompresses the set of clusters visible from a cluster.
+ *
+ * @param pvs PVS.
+ * @param cluster Viewer cluster (out of range - everything is visible).
+ * @param out_visible Bitset of row_bytes bytes.
+ */
+DNF_API void pvs_decompress(const dnf_pvs *pvs, uint32_t cluster, uint8_t *out_visible);
+
+/**
+ * @brief Checks a cluster in a decompressed set.
+ *
+ * @param visible Bitset from pvs_decompress().
+ * @param cluster Cluster (DNF_PVS_NO_CLUSTER - never visible).
+ * @return True if the cluster is potentially visible.
+ */
+DNF_API bool8_t pvs_is_visible(const uint8_t *visible, uint32_t cluster);
+
+/**
+ * @brief Finds the cluster of a point on a grid map.
+ *
+ * @param pvs Grid map PVS.
+ * @param x Point X.
+ * @param y Point Y.
+ * @return Cluster index, DNF_PVS_NO_CLUSTER outside the map.
+ */
+DNF_API uint32_t pvs_grid_cluster(const dnf_pvs *pvs, float32_t x, float32_t y);
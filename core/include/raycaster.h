@@ -0,0 +1,76 @@
+// DNF (Doomed and Forgotten): a DOOM-style first-person shooter.
+// Copyright (C) 2025-2026  Alexandr Gorbatenko
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+
+#pragma once
+
+#include "defines.h"
+#include "renderer.h"
+#include "texture_cache.h"
+
+// Number of distinct wall types in a grid map.
+#define DNF_GRID_MAP_WALL_TYPES 16
+
+/**
+ * @brief A structure that represents a grid map for the raycaster.
+ *
+ * Every cell is one world unit wide. Cells outside the map are solid walls.
+ * A wall type with a texture is drawn textured (one texture repeat per
+ * cell), otherwise with its flat color. The same goes for the floor and the
+ * ceiling, which are drawn in horizontal spans.
+ */
+typedef struct dnf_grid_map
+{
+    int32_t width;          //!< Map width in cells
+    int32_t height;         //!< Map height in cells
+    const uint8_t *cells;   //!< Row-major cells (0 - empty, otherwise wall type)
+
+    Color wall_colors[DNF_GRID_MAP_WALL_TYPES];  //!< Color of every wall type
+    const dnf_texture_cache *textures;           //!< Cache of the wall textures (nullptr - none)
+    dnf_texture_handle wall_textures[DNF_GRID_MAP_WALL_TYPES];  //!< Texture of every wall type (DNF_TEXTURE_WALL)
+    Color ceiling_color;    //!< Color above the walls
+    Color floor_color;      //!< Color below the walls
+    dnf_texture_handle ceiling_texture;  //!< Texture of the ceiling (DNF_TEXTURE_FLAT, DNF_TEXTURE_INVALID - flat color)
+    dnf_texture_handle floor_texture;    //!< Texture of the floor (DNF_TEXTURE_FLAT, DNF_TEXTURE_INVALID - flat color)
+} dnf_grid_map;
+
+/**
+ * @brief Gets a cell of the grid map.
+ *
+ * @param map Grid map.
+ * @param x Cell column.
+ * @param y Cell row.
+ * @return Cell wall type (0 - empty); out-of-bounds cells are walls of type 1.
+ */
+DNF_API uint8_t grid_map_get_cell(const dnf_grid_map *map, int32_t x, int32_t y);
+
+/**
+ * @brief Renders a grid map from the camera into the framebuffer.
+ *
+ * Casts one ray per framebuffer column (using the precomputed view tables of
+ * the context) and draws the ceiling, wall and floor spans of every column.
+ * Textured ceilings and floors are drawn in horizontal spans instead, merged
+ * across the columns of a band so that every row is set up once per run.
+ * Columns are rendered in parallel bands (see renderer_draw_bands()).
+ *
+ * @param ctx Rendering context to draw into.
+ * @param map Grid map to render.
+ * @param camera Camera to render from.
+ */
+DNF_API void raycaster_render(
+    const renderer_context *ctx,
+    const dnf_grid_map *map,
+    const dnf_camera *camera);
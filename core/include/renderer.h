@@ -18,20 +18,150 @@
 #pragma once
 
 #include "defines.h"
+#include "palette.h"
 
 #include <raylib.h>
 
+#include <stdatomic.h>
+#include <stddef.h>
+
+// Max number of framebuffers a rendering context can cycle through.
+#define DNF_RENDERER_MAX_BUFFERS 3
+// Rows per dirty tracking tile.
+#define DNF_FRAMEBUFFER_DIRTY_TILE 16
+
+
+/**
+ * @brief An enum that represents where rendered frames go.
+ */
+typedef enum dnf_renderer_backend
+{
+    DNF_RENDERER_BACKEND_WINDOW,    //!< Upload to a texture and present in a window
+    DNF_RENDERER_BACKEND_HEADLESS,  //!< No window or GPU resources (benchmarks, CI)
+} dnf_renderer_backend;
 
 /**
- * @brief Basic framebuffer with R8G8B8A8 values
+ * @brief An enum that represents the order of framebuffer pixels in memory.
+ */
+typedef enum dnf_framebuffer_layout
+{
+    DNF_FRAMEBUFFER_ROW_MAJOR,     //!< pixels[y * width + x] (what textures expect)
+    DNF_FRAMEBUFFER_COLUMN_MAJOR,  //!< pixels[x * height + y] (columns are contiguous)
+} dnf_framebuffer_layout;
+
+/**
+ * @brief An enum that represents what a framebuffer pixel is.
+ */
+typedef enum dnf_pixel_format
+{
+    DNF_PIXEL_FORMAT_RGBA8,     //!< Color (uint8_t * 4)
+    DNF_PIXEL_FORMAT_INDEXED8,  //!< Palette index (uint8_t)
+} dnf_pixel_format;
+
+/**
+ * @brief Rows of a framebuffer written since the tracker was cleared, in
+ * tiles of DNF_FRAMEBUFFER_DIRTY_TILE rows.
+ *
+ * Band jobs mark tiles concurrently (relaxed atomics, only ever set).
+ */
+typedef struct dnf_dirty_rows
+{
+    atomic_uchar *tiles;  //!< Nonzero for every written tile
+    int32_t tile_count;
+} dnf_dirty_rows;
+
+struct renderer_context;
+struct dnf_clip_range;
+struct dnf_renderer_passes;
+struct dnf_bsp_level;
+struct dnf_pvs;
+
+/**
+ * @brief Buffers the BSP renderer keeps between frames (see bsp_render()),
+ * grown with the framebuffer and freed with the rendering context.
+ */
+typedef struct dnf_bsp_scratch
+{
+    int32_t *clips;                 //!< Ceiling and floor clips (2 per column)
+    struct dnf_clip_range *ranges;  //!< Occlusion list storage (3 per column)
+    int32_t width;                  //!< Number of columns the buffers fit
+
+    uint8_t *visible_sets;          //!< PVS sets of the camera's subsector (subsectors, then nodes)
+    size_t visible_sets_capacity;   //!< Size of the visible_sets allocation
+    const struct dnf_bsp_level *visible_level;  //!< Level the sets were made for (nullptr - none)
+    const struct dnf_pvs *visible_pvs;          //!< PVS the sets were made from
+    uint32_t visible_level_serial;  //!< Levels freed before the sets were made
+    uint32_t visible_subsector;     //!< Subsector the sets were made for
+} dnf_bsp_scratch;
+
+/**
+ * @brief Basic framebuffer with R8G8B8A8 values or palette indices
+ *
+ * Draw through the pixels.h primitives rather than indexing pixels
+ * directly: they handle every layout and format, and record written rows.
  */
 typedef struct dnf_framebuffer
 {
-    Color *pixels;  //!< Array of pixels (colors - uint8_t * 4)
+    void *pixels;  //!< Array of pixels (Colors or palette indices)
     int32_t width;
     int32_t height;
+    dnf_framebuffer_layout layout;  //!< Pixel order
+    dnf_pixel_format format;        //!< Pixel format
+    const dnf_palette *palette;     //!< Palette of an indexed framebuffer
+    dnf_dirty_rows *dirty;          //!< Written rows (nullptr - not tracked)
 } dnf_framebuffer;
 
+/**
+ * @brief A structure that represents a first-person camera in world space.
+ *
+ * The world is viewed from above with X pointing right and Y pointing down,
+ * so an angle of 0 looks along +X and positive angles turn clockwise (right).
+ */
+typedef struct dnf_camera
+{
+    float32_t x;      //!< World X position
+    float32_t y;      //!< World Y position
+    float32_t z;      //!< Eye height above the world origin
+    float32_t angle;  //!< View direction in radians
+} dnf_camera;
+
+/**
+ * @brief Per-column and per-row view tables, precomputed for the framebuffer
+ * size and the field of view so that world renderers don't do trigonometry
+ * per column or divisions per floor and ceiling row.
+ *
+ * The depth buffer is the only per-frame table: the world renderer writes the
+ * depth of the nearest solid wall of every column, and the sprite pass clips
+ * sprites against it (passes run in submission order).
+ */
+typedef struct dnf_view_tables
+{
+    float32_t fov;         //!< Horizontal field of view in radians
+    float32_t projection;  //!< Distance to the projection plane in pixels
+    float32_t *ray_dir_x;  //!< Camera-space ray direction (forward part), per column
+    float32_t *ray_dir_y;  //!< Camera-space ray direction (right part), per column
+    float32_t *fisheye;    //!< Fish-eye correction (cosine of ray angle), per column
+    float32_t *depth;      //!< Perpendicular depth of the nearest solid wall, per column (INFINITY - none)
+    float32_t *row_depth;  //!< Depth of the floor or ceiling seen through a row, per unit of height from the eye, per row
+    float32_t *row_step;   //!< World distance between column centers at that depth, per unit of height, per row
+} dnf_view_tables;
+
+/**
+ * @brief A function that draws into a vertical band of the framebuffer.
+ *
+ * Bands never overlap, so band functions can write their columns without any
+ * synchronization.
+ *
+ * @param fb Framebuffer to draw into.
+ * @param x_begin First column of the band (inclusive).
+ * @param x_end Last column of the band (exclusive).
+ * @param user_data User data passed to renderer_draw_bands().
+ */
+typedef void (*dnf_band_draw_fn)(
+    const dnf_framebuffer *fb,
+    int32_t x_begin, int32_t x_end,
+    void *user_data);
+
 /**
  * @brief A structure that represents the rendering engine API.
  *
@@ -48,6 +178,7 @@ typedef struct dnf_renderer_api
      * @brief Render text (wrapper for raylib's DrawText())
      */
     void (*draw_text)(
+        const struct renderer_context *ctx,
         const char *text,
         int32_t x,int32_t y,
         int32_t size,
@@ -56,17 +187,57 @@ typedef struct dnf_renderer_api
     /**
      * @brief A special variant of DrawText() which draws current FPS.
      */
-    void (*draw_fps)(int32_t x, int32_t y);
+    void (*draw_fps)(const struct renderer_context *ctx, int32_t x, int32_t y);
 } dnf_renderer_api;
 
+/**
+ * @brief Time spent by the renderer on the main thread since the last reset.
+ */
+typedef struct dnf_renderer_stats
+{
+    uint64_t upload_ns;   //!< Framebuffer uploads
+    uint64_t present_ns;  //!< Frame presentation
+} dnf_renderer_stats;
+
 /**
  * @brief A structure that represents a rendering context.
+ *
+ * With more than one framebuffer the context is pipelined: the game renders
+ * frame N into the back buffer on the worker pool while the main thread
+ * uploads and presents frame N - 1 (the front buffer).
+ *
+ * With an indexed render target every frame is drawn into it instead, and
+ * then expanded through the palette into the back buffer once the frame is
+ * complete. Column-major framebuffers are uploaded as they are, the GPU
+ * transposes them when the frame is presented.
+ *
+ * The pixels.h primitives record the rows every frame writes, so only rows
+ * last written by a frame a buffer doesn't hold yet are resolved into it or
+ * uploaded from it.
  */
 typedef struct renderer_context
 {
-    dnf_framebuffer framebuffer;  //!< Pixel buffer
-    Texture2D target;             //!< Target texture
-    Rectangle screen_rect;        //!< Actual screen size
+    dnf_framebuffer framebuffers[DNF_RENDERER_MAX_BUFFERS];  //!< Pixel buffers
+    uint32_t buffer_count;   //!< Number of pixel buffers in use
+    uint32_t back_buffer;    //!< Index of the buffer being rendered into
+    uint32_t front_buffer;   //!< Index of the latest completed buffer
+    bool8_t front_uploaded;  //!< True if the front buffer is already in the target texture
+    dnf_framebuffer render_target;  //!< Indexed render target (no pixels - draw into the back buffer)
+    bool8_t back_finished;   //!< True if the back buffer is already complete (resolved, changes collected)
+    dnf_dirty_rows dirty;    //!< Rows written by the frame being drawn
+    uint32_t frame_stamp;    //!< Number of finished frames
+    uint32_t *tile_frames[DNF_RENDERER_MAX_BUFFERS];  //!< Frame that last wrote each row tile of a buffer
+    uint32_t *target_tile_frames;   //!< Frame that last wrote each row tile of the render target
+    uint32_t *texture_tile_frames;  //!< Frame each row tile of the texture was uploaded from
+    uint8_t *resolve_tiles;  //!< Row tiles of the render target to convert into the back buffer
+    dnf_palette *palette;    //!< Palette of an indexed render target (nullptr otherwise)
+    dnf_renderer_backend backend;  //!< Window or headless
+    Texture2D target;        //!< Target texture (only sizes are set when headless)
+    Rectangle screen_rect;   //!< Actual screen size
+    dnf_view_tables view;    //!< Per-column tables for world renderers
+    struct dnf_renderer_passes *passes;  //!< Passes queued into the frame being drawn
+    dnf_bsp_scratch *bsp_scratch;  //!< BSP renderer buffers
+    dnf_renderer_stats stats;  //!< Upload/present timings (reset by the engine every frame)
 } renderer_context;
 
 /**
@@ -75,12 +246,41 @@ typedef struct renderer_context
  * @param ctx Resulting rendering context.
  * @param out_width Target image width.
  * @param out_height Target image height.
- * @return True if successful, false otherwise.
+ * @param buffer_count Number of framebuffers (1 - no pipelining, up to
+ * DNF_RENDERER_MAX_BUFFERS).
+ * @param backend Renderer backend (headless skips all GPU resources).
+ * @param column_major Draw into column-major framebuffers (faster column
+ * drawing, slower row spans, presented transposed).
+ * @param format Render target format (indexed targets start with the
+ * default palette and are expanded to RGBA once per frame).
+ * @return True if successful, false otherwise (nothing is left allocated).
  */
 bool8_t renderer_init(
     renderer_context *ctx,
     int32_t out_width,
-    int32_t out_height);
+    int32_t out_height,
+    uint32_t buffer_count,
+    dnf_renderer_backend backend,
+    bool8_t column_major,
+    dnf_pixel_format format);
+
+/**
+ * @brief Changes the size of the rendered image (the internal resolution).
+ *
+ * Reallocates the framebuffers, the render target and the texture, so call
+ * it between frames. The latest frame stays on the screen (stretched) until
+ * a frame of the new size is presented. Call renderer_resize_window()
+ * afterwards to refit the image into the window.
+ *
+ * @param ctx Rendering context.
+ * @param width New target image width.
+ * @param height New target image height.
+ * @return True if successful, false otherwise.
+ */
+bool8_t renderer_resize_target(
+    renderer_context *ctx,
+    int32_t width,
+    int32_t height);
 
 /**
  * @brief Resizes the renderer window (not the output) in a given context.
@@ -109,16 +309,104 @@ void renderer_shutdown(renderer_context *ctx);
  */
 DNF_API dnf_renderer_api renderer_get_api(void);
 
+/**
+ * @brief Gets the buffer the current frame is rendered into (the back
+ * buffer or the render target).
+ *
+ * Waits for queued band drawing first, so the caller can safely draw into
+ * the buffer directly.
+ *
+ * @param ctx Rendering context.
+ * @return Render target.
+ */
+DNF_API const dnf_framebuffer *renderer_get_back_buffer(const renderer_context *ctx);
+
+/**
+ * @brief Allocates storage for band drawing parameters.
+ *
+ * The storage stays valid until the next renderer_swap_buffers(), which
+ * makes it suitable for user data of renderer_draw_bands() in pipelined
+ * contexts.
+ *
+ * @param ctx Rendering context.
+ * @param size Size in bytes.
+ * @return Zeroed storage (16-byte aligned).
+ */
+DNF_API void *renderer_alloc_pass_data(const renderer_context *ctx, size_t size);
+
+/**
+ * @brief Draws into the back buffer in parallel, split into column bands.
+ *
+ * Splits the framebuffer into vertical bands and runs the draw function for
+ * each band on the job system worker pool. Passes run in submission order.
+ *
+ * Single-buffered contexts wait until all bands are finished. Pipelined
+ * contexts return immediately, and the bands are finished by
+ * renderer_swap_buffers(), so user data must stay valid until then (see
+ * renderer_alloc_pass_data()).
+ *
+ * @param ctx Rendering context to draw into.
+ * @param draw Band drawing function.
+ * @param user_data User data passed to every band.
+ */
+DNF_API void renderer_draw_bands(
+    const renderer_context *ctx,
+    dnf_band_draw_fn draw,
+    void *user_data);
+
 /**
  * @brief Begins rendering a frame of a given context.
  *
+ * Uploads the front buffer (the latest completed frame) into the target
+ * texture, if it has not been uploaded yet, and draws it to the screen.
+ * Single-buffered contexts upload the back buffer instead.
+ *
+ * Only rows that may differ from the texture are uploaded (the whole buffer
+ * if most of them do), so buffers must only be written through the
+ * pixels.h primitives.
+ *
  * @param ctx Rendering context to render.
  */
-DNF_API void renderer_begin_frame(const renderer_context *ctx);
+DNF_API void renderer_begin_frame(renderer_context *ctx);
 
 /**
  * @brief Stops rendering a frame of a given context.
  *
- * @param ctx
+ * @param ctx Rendering context to render.
+ */
+DNF_API void renderer_end_frame(renderer_context *ctx);
+
+/**
+ * @brief Replaces the palette of an indexed render target.
+ *
+ * Waits for queued band drawing first. Rebuilding the lookup tables takes
+ * tens of milliseconds, so don't call it every frame. Texture caches
+ * converted for the palette have to be converted again (see
+ * texture_cache_set_palette()).
+ *
+ * @param ctx Rendering context.
+ * @param colors Palette colors.
+ */
+DNF_API void renderer_set_palette(renderer_context *ctx, const Color colors[DNF_PALETTE_SIZE]);
+
+/**
+ * @brief Saves the latest completed frame to an image file.
+ *
+ * Works with any backend. The format is picked by the file extension.
+ *
+ * @param ctx Rendering context.
+ * @param filename Output file name.
+ * @return True if the image was saved successfully.
+ */
+DNF_API bool8_t renderer_dump_frame(const renderer_context *ctx, const char *filename);
+
+/**
+ * @brief Finishes the back buffer and makes it the front buffer.
+ *
+ * Waits for queued band drawing, converts the render target (if any) into
+ * the back buffer, then moves on to the next back buffer.
+ * Call once per frame after renderer_end_frame().
+ *
+ * @param ctx Rendering context.
  */
-DNF_API void renderer_end_frame(const renderer_context *ctx);
+DNF_API void renderer_swap_buffers(renderer_context *ctx);
@@ -0,0 +1,120 @@
+// DNF (Doomed and Forgotten): a DOOM-style first-person shooter.
+// Copyright (C) 2025-2026  Alexandr Gorbatenko
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+
+#pragma once
+
+#include "defines.h"
+#include "dnf_memory.h"
+#include "renderer.h"
+#include "texture_cache.h"
+
+// Most sprites in a batch (sort keys carry a 16-bit sprite index).
+#define DNF_SPRITE_MAX_COUNT 65535
+
+
+/**
+ * @brief A camera-facing billboard standing in the world (monsters, items,
+ * projectiles).
+ */
+typedef struct dnf_sprite
+{
+    float32_t x;       //!< World X of the center
+    float32_t y;       //!< World Y of the center
+    float32_t z;       //!< World height of the bottom edge
+    float32_t width;   //!< Width in world units
+    float32_t height;  //!< Height in world units
+    float32_t light;   //!< Light factor, [0; 1]
+    dnf_texture_handle texture;  //!< Texture (DNF_TEXTURE_SPRITE, DNF_TEXTURE_INVALID - solid color)
+    Color color;       //!< Color of an untextured sprite
+} dnf_sprite;
+
+/**
+ * @brief Sprites collected for a frame and drawn in one pass.
+ *
+ * sprite_batch_render() projects the visible sprites, sorts them back to
+ * front and draws them over the world, clipped against the depth buffer of
+ * the view tables. The sort is an LSD radix sort of 16-bit quantized depths,
+ * stable, so sprites at the same depth keep the order they were added in.
+ *
+ * Upper and lower walls of two-sided BSP lines don't clip sprites, only
+ * solid walls do.
+ *
+ * The batch only keeps the sprites: the projected ones, their draw order
+ * and the sort scratch are per-frame memory of the frame arena.
+ */
+typedef struct dnf_sprite_batch
+{
+    dnf_sprite *sprites;  //!< Sprites added since the last clear
+    uint32_t count;       //!< Sprites added
+    uint32_t capacity;    //!< Most sprites
+    uint32_t visible;     //!< Sprites drawn by the last render
+} dnf_sprite_batch;
+
+/**
+ * @brief Allocates a sprite batch.
+ *
+ * @param batch Batch to initialize.
+ * @param capacity Most sprites per frame (up to DNF_SPRITE_MAX_COUNT).
+ * @return True on success.
+ */
+DNF_API bool8_t sprite_batch_init(dnf_sprite_batch *batch, uint32_t capacity);
+
+/**
+ * @brief Frees a sprite batch.
+ *
+ * @param batch Batch.
+ */
+DNF_API void sprite_batch_shutdown(dnf_sprite_batch *batch);
+
+/**
+ * @brief Removes all sprites of a batch (start of a frame).
+ *
+ * @param batch Batch.
+ */
+DNF_API void sprite_batch_clear(dnf_sprite_batch *batch);
+
+/**
+ * @brief Adds a sprite to a batch.
+ *
+ * @param batch Batch.
+ * @param sprite Sprite (copied).
+ * @return False if the batch is full.
+ */
+DNF_API bool8_t sprite_batch_add(dnf_sprite_batch *batch, const dnf_sprite *sprite);
+
+/**
+ * @brief Draws the sprites of a batch over the world.
+ *
+ * Submit it after the world pass of the frame: sprites are clipped against
+ * the wall depth that pass writes. Columns are drawn in parallel bands (see
+ * renderer_draw_bands()) from a copy of the sprites projected into the frame
+ * arena, so the batch can be cleared and refilled right away; the arena
+ * must not be reset before renderer_swap_buffers().
+ *
+ * @param ctx Rendering context to draw into.
+ * @param batch Sprites to draw.
+ * @param textures Cache of the sprite textures (nullptr - all solid colors).
+ * @param camera Camera to render from.
+ * @param frame_arena Scratch memory of the frame (see game::frame_arena).
+ * @return Number of sprites in the view.
+ */
+DNF_API uint32_t sprite_batch_render(
+    const renderer_context *ctx,
+    dnf_sprite_batch *batch,
+    const dnf_texture_cache *textures,
+    const dnf_camera *camera,
+    dnf_arena *frame_arena);
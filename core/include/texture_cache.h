@@ -0,0 +1,247 @@
+// DNF (Doomed and Forgotten): a DOOM-style first-person shooter.
+// Copyright (C) 2025-2026  Alexandr Gorbatenko
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+#pragma once
+
+#include "defines.h"
+#include "palette.h"
+
+#include <raylib.h>
+#include <stddef.h>
+
+// Handle of no texture.
+#define DNF_TEXTURE_INVALID 0
+// Most mip levels of a texture (enough for 2048 texels).
+#define DNF_TEXTURE_MAX_MIPS 12
+// Longest texture name (including the terminator).
+#define DNF_TEXTURE_NAME_LENGTH 32
+// Mip levels start on multiples of this many texels (a 64-byte cache line).
+#define DNF_TEXTURE_ALIGNMENT 16
+
+
+/**
+ * @brief Stable handle of a texture in a cache (DNF_TEXTURE_INVALID - none).
+ */
+typedef uint32_t dnf_texture_handle;
+
+/**
+ * @brief What a texture is used for, which decides how it is stored.
+ */
+typedef enum dnf_texture_kind
+{
+    DNF_TEXTURE_WALL,    //!< Column-major, power-of-two sides (drawn by columns)
+    DNF_TEXTURE_FLAT,    //!< Row-major, power-of-two sides (drawn by spans)
+    DNF_TEXTURE_SPRITE,  //!< Column-major, any size, alpha is a mask
+
+    DNF_TEXTURE_KIND_COUNT
+} dnf_texture_kind;
+
+/**
+ * @brief A texture in the atlas of a cache.
+ *
+ * Every mip level is half the size of the previous one (but at least one
+ * texel), down to 1x1 or DNF_TEXTURE_MAX_MIPS levels.
+ */
+typedef struct dnf_texture
+{
+    char name[DNF_TEXTURE_NAME_LENGTH];         //!< Name the texture was added under
+    dnf_texture_kind kind;                      //!< Storage of the texture
+    int32_t width;                              //!< Width of level 0
+    int32_t height;                             //!< Height of level 0
+    uint32_t mip_count;                         //!< Number of mip levels
+    size_t mip_offsets[DNF_TEXTURE_MAX_MIPS];   //!< First texel of every level in the atlas
+    uint8_t transparent_index;                  //!< Index of the masked texels of a sprite (index atlas)
+} dnf_texture;
+
+/**
+ * @brief A cache of textures sharing one contiguous atlas.
+ *
+ * The atlas and the texture table are allocated once, so texels and
+ * descriptors never move: the renderer can keep pointers to them for as
+ * long as the cache lives.
+ *
+ * A cache can also keep the texels as palette indices (see
+ * texture_cache_set_palette()), laid out like the atlas, so indexed
+ * targets light them with a single colormap lookup.
+ */
+typedef struct dnf_texture_cache
+{
+    Color *atlas;                  //!< Texels of all textures and their mips
+    size_t atlas_capacity;         //!< Atlas size in texels
+    size_t atlas_used;             //!< Texels taken
+    dnf_texture *textures;         //!< Texture table (handle - 1 is the index)
+    uint32_t texture_count;        //!< Textures added
+    uint32_t texture_capacity;     //!< Size of the texture table
+    uint8_t *indices;              //!< Palette index of every atlas texel (nullptr - none)
+    const dnf_palette *palette;    //!< Palette of the indices (nullptr - none)
+} dnf_texture_cache;
+
+/**
+ * @brief Initializes a texture cache and allocates its atlas.
+ *
+ * @param cache Cache to initialize.
+ * @param atlas_texels Atlas size in texels (mips take a third more than
+ * the textures themselves).
+ * @param max_textures Most textures the cache can hold.
+ * @return True on success.
+ */
+DNF_API bool8_t texture_cache_init(dnf_texture_cache *cache, size_t atlas_texels, uint32_t max_textures);
+
+/**
+ * @brief Frees a texture cache. Handles and texel pointers become invalid.
+ *
+ * @param cache Cache to free.
+ */
+DNF_API void texture_cache_shutdown(dnf_texture_cache *cache);
+
+/**
+ * @brief Converts the texels of a cache to palette indices, now and as
+ * textures are added, for rendering into targets with that palette.
+ *
+ * Masked sprite texels get an index none of the sprite's opaque texels
+ * use (dnf_texture::transparent_index). The palette has to outlive the
+ * cache; if its colors change (renderer_set_palette()), call this again.
+ *
+ * @param cache Cache.
+ * @param palette Palette of the target (nullptr - drop the indices).
+ * @return True on success.
+ */
+DNF_API bool8_t texture_cache_set_palette(dnf_texture_cache *cache, const dnf_palette *palette);
+
+/**
+ * @brief Adds an image to a cache and builds its mip levels.
+ *
+ * Walls and flats that aren't power-of-two sized are resized up to the
+ * next power of two. A texture added under a name that is already in
+ * the cache isn't added again: the existing handle is returned.
+ *
+ * @param cache Cache.
+ * @param name Texture name.
+ * @param image Image to add (any format, it isn't modified).
+ * @param kind What the texture is used for.
+ * @return Texture handle, DNF_TEXTURE_INVALID if the cache is full.
+ */
+DNF_API dnf_texture_handle texture_cache_add(
+    dnf_texture_cache *cache,
+    const char *name,
+    Image image,
+    dnf_texture_kind kind);
+
+/**
+ * @brief Loads an image file into a cache (once, see texture_cache_add()).
+ *
+ * @param cache Cache.
+ * @param name Texture name.
+ * @param path Image file path.
+ * @param kind What the texture is used for.
+ * @return Texture handle, DNF_TEXTURE_INVALID on failure.
+ */
+DNF_API dnf_texture_handle texture_cache_load(
+    dnf_texture_cache *cache,
+    const char *name,
+    const char *path,
+    dnf_texture_kind kind);
+
+/**
+ * @brief Decodes an image file held in memory (an archive lump, see
+ * wad_lump()) into a cache (once, see texture_cache_add()).
+ *
+ * @param cache Cache.
+ * @param name Texture name.
+ * @param file_type File extension of the encoded image (".png", ...).
+ * @param data Encoded image.
+ * @param size Encoded image size in bytes.
+ * @param kind What the texture is used for.
+ * @return Texture handle, DNF_TEXTURE_INVALID on failure.
+ */
+DNF_API dnf_texture_handle texture_cache_load_memory(
+    dnf_texture_cache *cache,
+    const char *name,
+    const char *file_type,
+    const void *data,
+    size_t size,
+    dnf_texture_kind kind);
+
+/**
+ * @brief Finds a texture by name.
+ *
+ * @param cache Cache.
+ * @param name Texture name.
+ * @return Texture handle, DNF_TEXTURE_INVALID if there is none.
+ */
+DNF_API dnf_texture_handle texture_cache_find(const dnf_texture_cache *cache, const char *name);
+
+/**
+ * @brief Gets a texture by handle.
+ *
+ * @param cache Cache.
+ * @param handle Texture handle.
+ * @return Texture, nullptr if the handle is invalid.
+ */
+DNF_API const dnf_texture *texture_cache_get(const dnf_texture_cache *cache, dnf_texture_handle handle);
+
+/**
+ * @brief Picks the mip level for a texture drawn at a given minification.
+ *
+ * The level whose texels are closest to one per screen pixel (rounded
+ * towards the sharper level) keeps fetches local and avoids shimmering.
+ *
+ * @param texture Texture.
+ * @param texels_per_pixel Level 0 texels covered by one screen pixel.
+ * @return Mip level.
+ */
+DNF_API uint32_t texture_select_mip(const dnf_texture *texture, float32_t texels_per_pixel);
+
+/**
+ * @brief Gets the width of a mip level.
+ */
+DNF_API int32_t texture_mip_width(const dnf_texture *texture, uint32_t mip);
+
+/**
+ * @brief Gets the height of a mip level.
+ */
+DNF_API int32_t texture_mip_height(const dnf_texture *texture, uint32_t mip);
+
+/**
+ * @brief Gets a column of a wall or sprite mip level.
+ *
+ * @param cache Cache.
+ * @param texture Texture (column-major).
+ * @param mip Mip level.
+ * @param u Column, wrapped to the level width.
+ * @return Contiguous texels of the column (texture_mip_height() of them).
+ */
+DNF_API const Color *texture_column(const dnf_texture_cache *cache, const dnf_texture *texture, uint32_t mip, int32_t u);
+
+/**
+ * @brief texture_column() of the palette indices (caches with a palette
+ * only, see texture_cache_set_palette()).
+ */
+DNF_API const uint8_t *texture_column_indices(
+    const dnf_texture_cache *cache,
+    const dnf_texture *texture,
+    uint32_t mip,
+    int32_t u);
+
+/**
+ * @brief Gets a row of a flat mip level.
+ *
+ * @param cache Cache.
+ * @param texture Texture (row-major).
+ * @param mip Mip level.
+ * @param v Row, wrapped to the level height.
+ * @return Contiguous texels of the row (texture_mip_width() of them).
+ */
+DNF_API const Color *texture_row(const dnf_texture_cache *cache, const dnf_texture *texture, uint32_t mip, int32_t v);
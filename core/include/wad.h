@@ -0,0 +1,137 @@
+// DNF (Doomed and Forgotten): a DOOM-style first-person shooter.
+// Copyright (C) 2025-2026  Alexandr Gorbatenko
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+#pragma once
+
+#include "defines.h"
+
+#include <stddef.h>
+
+// Archive file signature (8 bytes, including the terminator).
+#define DNF_WAD_MAGIC "DNFWAD1"
+// Archive format version.
+#define DNF_WAD_VERSION 1
+// Longest lump name (including the terminator).
+#define DNF_WAD_NAME_LENGTH 48
+// Lump data starts on multiples of this many bytes (a cache line), so
+// lumps can be used in place as arrays of any type.
+#define DNF_WAD_LUMP_ALIGNMENT 64
+// Index of no lump.
+#define DNF_WAD_NO_LUMP UINT32_MAX
+
+/*
+ * Archive layout (little-endian):
+ *
+ * header:    magic[8], u32 version, u32 lump count, u64 directory offset
+ * lumps:     lump data, each starting on a DNF_WAD_LUMP_ALIGNMENT boundary
+ * directory: lump count entries of u64 offset, u64 size,
+ *            char name[DNF_WAD_NAME_LENGTH] (terminated), sorted by name
+ *
+ * Sorted names make lookups a binary search over the directory alone, so
+ * opening an archive touches nothing but the header and the directory.
+ */
+
+/**
+ * @brief Header at the start of an archive.
+ */
+typedef struct dnf_wad_header
+{
+    char magic[8];              //!< DNF_WAD_MAGIC
+    uint32_t version;           //!< DNF_WAD_VERSION
+    uint32_t lump_count;        //!< Number of directory entries
+    uint64_t directory_offset;  //!< Offset of the directory from the start of the file
+} dnf_wad_header;
+
+/**
+ * @brief Directory entry of a lump.
+ */
+typedef struct dnf_wad_entry
+{
+    uint64_t offset;                 //!< Offset of the lump data from the start of the file
+    uint64_t size;                   //!< Lump size in bytes
+    char name[DNF_WAD_NAME_LENGTH];  //!< Lump name (terminated)
+} dnf_wad_entry;
+
+STATIC_ASSERT(sizeof(dnf_wad_header) == 24, "Expected the archive header to be 24 bytes");
+STATIC_ASSERT(sizeof(dnf_wad_entry) == 16 + DNF_WAD_NAME_LENGTH, "Expected directory entries to be packed");
+
+/**
+ * @brief An archive mapped into memory.
+ *
+ * The file is mapped read-only and never copied: lumps are paged in by the
+ * OS the first time they are read, so only the lumps a level touches take
+ * time to load and stay resident.
+ */
+typedef struct dnf_wad
+{
+    const uint8_t *data;             //!< Mapped file
+    size_t size;                     //!< File size in bytes
+    const dnf_wad_entry *directory;  //!< Directory (points into the mapping)
+    uint32_t lump_count;             //!< Number of lumps
+    void *mapping;                   //!< Platform mapping handle (Windows)
+} dnf_wad;
+
+/**
+ * @brief Maps an archive and validates its directory.
+ *
+ * @param wad Resulting archive.
+ * @param path Archive file path.
+ * @return True on success.
+ */
+DNF_API bool8_t wad_open(dnf_wad *wad, const char *path);
+
+/**
+ * @brief Unmaps an archive. Lump pointers become invalid.
+ *
+ * @param wad Archive to close.
+ */
+DNF_API void wad_close(dnf_wad *wad);
+
+/**
+ * @brief Finds a lump by name.
+ *
+ * @param wad Archive.
+ * @param name Lump name.
+ * @return Lump index, DNF_WAD_NO_LUMP if there is none.
+ */
+DNF_API uint32_t wad_find(const dnf_wad *wad, const char *name);
+
+/**
+ * @brief Gets the data of a lump, in place (zero-copy).
+ *
+ * @param wad Archive.
+ * @param lump Lump index.
+ * @param out_size Lump size in bytes (optional).
+ * @return Read-only lump data, nullptr if the index is invalid.
+ */
+DNF_API const void *wad_lump(const dnf_wad *wad, uint32_t lump, size_t *out_size);
+
+/**
+ * @brief Gets the name of a lump.
+ *
+ * @param wad Archive.
+ * @param lump Lump index.
+ * @return Lump name, nullptr if the index is invalid.
+ */
+DNF_API const char *wad_lump_name(const dnf_wad *wad, uint32_t lump);
+
+/**
+ * @brief Asks the OS to start reading a lump in the background, so the
+ * first access doesn't stall on the disk.
+ *
+ * @param wad Archive.
+ * @param lump Lump index.
+ */
+DNF_API void wad_prefetch(const dnf_wad *wad, uint32_t lump);
@@ -0,0 +1,438 @@
+// DNF (Doomed and Forgotten): a DOOM-style first-person shooter.
+// Copyright (C) 2025-2026  Alexandr Gorbatenko
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+#include "asset_loader.h"
+
+#include "dnf_clock.h"
+#include "logger.h"
+
+#include <math.h>  // INFINITY
+#include <threads.h>
+
+// End of a slot list.
+#define DNF_ASSET_NIL UINT32_MAX
+
+
+/**
+ * @brief States of a request slot.
+ */
+typedef enum dnf_asset_state
+{
+    DNF_ASSET_STATE_FREE,     //!< Not in use
+    DNF_ASSET_STATE_QUEUED,   //!< Waiting in a priority queue
+    DNF_ASSET_STATE_LOADING,  //!< Being loaded on the I/O thread
+    DNF_ASSET_STATE_LOADED,   //!< Waiting to be finished on the main thread
+} dnf_asset_state;
+
+/**
+ * @brief A load request.
+ */
+typedef struct dnf_asset_slot
+{
+    dnf_asset_load_fn load;      //!< Load function
+    dnf_asset_finish_fn finish;  //!< Finish function (optional)
+    void *user_data;             //!< User data of both functions
+    uint32_t next;               //!< Next slot in the same list
+    uint32_t prev;               //!< Previous slot in the same list
+    uint16_t generation;         //!< Bumped on every reuse (stale handles don't match)
+    uint8_t state;               //!< dnf_asset_state
+    uint8_t priority;            //!< dnf_asset_priority
+    bool8_t loaded;              //!< Result of the load function
+} dnf_asset_slot;
+
+/**
+ * @brief A FIFO list of slots linked through the slots themselves.
+ */
+typedef struct dnf_asset_list
+{
+    uint32_t head;  //!< First slot (DNF_ASSET_NIL - empty)
+    uint32_t tail;  //!< Last slot
+} dnf_asset_list;
+
+static dnf_asset_slot slots[DNF_ASSET_MAX_REQUESTS];
+static uint32_t free_slots[DNF_ASSET_MAX_REQUESTS];  // stack of free slot indices
+static uint32_t free_count = 0;
+
+static dnf_asset_list queues[DNF_ASSET_PRIORITY_COUNT];  // queued requests per priority
+static dnf_asset_list loaded;  // loaded requests in load order
+
+static thrd_t loader_thread;
+static mtx_t loader_mutex;  // guards the slots and the lists
+static cnd_t loader_wake;   // signaled when a request is queued or on shutdown
+static cnd_t loader_done;   // signaled when a request is loaded
+static bool8_t shutting_down = false;
+static bool8_t threaded = false;  // false - the I/O thread failed to start, loads run on the main thread
+static bool8_t dnf_asset_loader_initialized = false;
+
+
+/**
+ * @brief Appends a slot to a list.
+ */
+static void list_push(dnf_asset_list *list, const uint32_t slot)
+{
+    slots[slot].next = DNF_ASSET_NIL;
+    slots[slot].prev = list->tail;
+    if (list->tail != DNF_ASSET_NIL)
+        slots[list->tail].next = slot;
+    else
+        list->head = slot;
+    list->tail = slot;
+}
+
+/**
+ * @brief Unlinks a slot from a list.
+ */
+static void list_remove(dnf_asset_list *list, const uint32_t slot)
+{
+    if (slots[slot].prev != DNF_ASSET_NIL)
+        slots[slots[slot].prev].next = slots[slot].next;
+    else
+        list->head = slots[slot].next;
+    if (slots[slot].next != DNF_ASSET_NIL)
+        slots[slots[slot].next].prev = slots[slot].prev;
+    else
+        list->tail = slots[slot].prev;
+}
+
+/**
+ * @brief Unlinks the first slot of a list.
+ *
+ * @return Slot index, DNF_ASSET_NIL if the list is empty.
+ */
+static uint32_t list_pop(dnf_asset_list *list)
+{
+    const uint32_t slot = list->head;
+    if (slot != DNF_ASSET_NIL)
+        list_remove(list, slot);
+    return slot;
+}
+
+/**
+ * @brief Resets all slots and lists.
+ */
+static void reset_slots(void)
+{
+    for (uint32_t i = 0; i < DNF_ASSET_MAX_REQUESTS; i++)
+    {
+        slots[i].state = DNF_ASSET_STATE_FREE;
+        // hand out the low slots first
+        free_slots[i] = DNF_ASSET_MAX_REQUESTS - 1 - i;
+    }
+    free_count = DNF_ASSET_MAX_REQUESTS;
+
+    for (uint32_t i = 0; i < DNF_ASSET_PRIORITY_COUNT; i++)
+        queues[i] = (dnf_asset_list){ DNF_ASSET_NIL, DNF_ASSET_NIL };
+    loaded = (dnf_asset_list){ DNF_ASSET_NIL, DNF_ASSET_NIL };
+}
+
+/**
+ * @brief Returns a slot to the free stack.
+ *
+ * Must be called with loader_mutex locked.
+ */
+static void release_slot(const uint32_t slot)
+{
+    slots[slot].state = DNF_ASSET_STATE_FREE;
+    slots[slot].generation++;
+    free_slots[free_count++] = slot;
+}
+
+/**
+ * @brief Finds the slot of a request in a given state.
+ *
+ * Must be called with loader_mutex locked.
+ *
+ * @return Slot index, DNF_ASSET_NIL if the handle is stale or the request
+ * is in another state.
+ */
+static uint32_t find_slot(const dnf_asset_request request, const dnf_asset_state state)
+{
+    const uint32_t slot = (request & 0xffffu) - 1;
+    if (slot >= DNF_ASSET_MAX_REQUESTS
+        || slots[slot].generation != (uint16_t)(request >> 16)
+        || slots[slot].state != state)
+        return DNF_ASSET_NIL;
+    return slot;
+}
+
+/**
+ * @brief Takes the most urgent queued request.
+ *
+ * Must be called with loader_mutex locked.
+ *
+ * @return Slot index, DNF_ASSET_NIL if nothing is queued.
+ */
+static uint32_t pop_queued(void)
+{
+    for (uint32_t i = 0; i < DNF_ASSET_PRIORITY_COUNT; i++)
+    {
+        const uint32_t slot = list_pop(&queues[i]);
+        if (slot != DNF_ASSET_NIL)
+            return slot;
+    }
+    return DNF_ASSET_NIL;
+}
+
+/**
+ * @brief I/O thread: loads queued requests one by one, most urgent first.
+ */
+static int loader_main(void *arg)
+{
+    (void)arg;
+
+    mtx_lock(&loader_mutex);
+    for (;;)
+    {
+        uint32_t slot = pop_queued();
+        while (slot == DNF_ASSET_NIL && !shutting_down)
+        {
+            cnd_wait(&loader_wake, &loader_mutex);
+            slot = pop_queued();
+        }
+        if (slot == DNF_ASSET_NIL)
+            break;
+
+        // load without the lock, requests keep coming in meanwhile
+        slots[slot].state = DNF_ASSET_STATE_LOADING;
+        const dnf_asset_load_fn load = slots[slot].load;
+        void *user_data = slots[slot].user_data;
+        mtx_unlock(&loader_mutex);
+
+        const bool8_t result = load(user_data);
+
+        mtx_lock(&loader_mutex);
+        slots[slot].loaded = result;
+        slots[slot].state = DNF_ASSET_STATE_LOADED;
+        list_push(&loaded, slot);
+        cnd_broadcast(&loader_done);
+    }
+    mtx_unlock(&loader_mutex);
+
+    return 0;
+}
+
+bool8_t asset_loader_init(void)
+{
+    if (dnf_asset_loader_initialized)
+    {
+        DNF_ERROR("Tried to initialize the asset loader more than once!");
+        return false;
+    }
+
+    reset_slots();
+    shutting_down = false;
+
+    if (mtx_init(&loader_mutex, mtx_plain) != thrd_success
+        || cnd_init(&loader_wake) != thrd_success
+        || cnd_init(&loader_done) != thrd_success)
+    {
+        DNF_ERROR("Failed to create asset loader synchronization primitives");
+        return false;
+    }
+
+    threaded = thrd_create(&loader_thread, loader_main, nullptr) == thrd_success;
+    if (threaded)
+        DNF_INFO("Asset loader started");
+    else
+        DNF_WARN("Failed to start the asset loader thread, assets will load on the main thread");
+
+    dnf_asset_loader_initialized = true;
+    return true;
+}
+
+void asset_loader_shutdown(void)
+{
+    if (!dnf_asset_loader_initialized)
+        return;
+
+    // the request being loaded completes, the rest stays queued
+    if (threaded)
+    {
+        mtx_lock(&loader_mutex);
+        shutting_down = true;
+        cnd_broadcast(&loader_wake);
+        mtx_unlock(&loader_mutex);
+        thrd_join(loader_thread, nullptr);
+        // requests made by the finish functions below load right away
+        threaded = false;
+    }
+
+    // finish functions free what the requests own, so all of them run
+    uint32_t dropped = 0;
+    for (uint32_t i = 0; i < DNF_ASSET_PRIORITY_COUNT; i++)
+    {
+        for (uint32_t slot = list_pop(&queues[i]); slot != DNF_ASSET_NIL; slot = list_pop(&queues[i]))
+        {
+            const dnf_asset_slot request = slots[slot];
+            release_slot(slot);
+            if (request.finish)
+                request.finish(request.user_data, false);
+            dropped++;
+        }
+    }
+    asset_loader_finish(INFINITY);
+    if (dropped > 0)
+        DNF_WARN("Asset loader shut down with %u request(s) not loaded", dropped);
+
+    cnd_destroy(&loader_done);
+    cnd_destroy(&loader_wake);
+    mtx_destroy(&loader_mutex);
+
+    dnf_asset_loader_initialized = false;
+    DNF_INFO("Asset loader shut down");
+}
+
+uint32_t asset_loader_finish(const float64_t budget_ms)
+{
+    if (!dnf_asset_loader_initialized)
+        return 0;
+
+    const uint64_t start = dnf_clock_now_ns();
+    uint32_t finished = 0;
+
+    for (;;)
+    {
+        mtx_lock(&loader_mutex);
+        const uint32_t slot = list_pop(&loaded);
+        const dnf_asset_slot request = slot != DNF_ASSET_NIL ? slots[slot] : (dnf_asset_slot){0};
+        if (slot != DNF_ASSET_NIL)
+            release_slot(slot);
+        mtx_unlock(&loader_mutex);
+        if (slot == DNF_ASSET_NIL)
+            break;
+
+        // the slot may be reused by requests the finish function makes
+        if (request.finish)
+            request.finish(request.user_data, request.loaded);
+        finished++;
+
+        if ((float64_t)(dnf_clock_now_ns() - start) * 1e-6 >= budget_ms)
+            break;
+    }
+
+    return finished;
+}
+
+dnf_asset_request asset_loader_request(
+    const dnf_asset_priority priority,
+    const dnf_asset_load_fn load,
+    const dnf_asset_finish_fn finish,
+    void *user_data)
+{
+    if (!dnf_asset_loader_initialized || priority >= DNF_ASSET_PRIORITY_COUNT || !load)
+        return DNF_ASSET_NO_REQUEST;
+
+    mtx_lock(&loader_mutex);
+    if (free_count == 0)
+    {
+        mtx_unlock(&loader_mutex);
+        DNF_WARN("Asset loader queue is full (%u requests)", DNF_ASSET_MAX_REQUESTS);
+        return DNF_ASSET_NO_REQUEST;
+    }
+
+    const uint32_t slot = free_slots[--free_count];
+    slots[slot].load = load;
+    slots[slot].finish = finish;
+    slots[slot].user_data = user_data;
+    slots[slot].priority = (uint8_t)priority;
+    const dnf_asset_request request = ((uint32_t)slots[slot].generation << 16) | (slot + 1);
+
+    if (!threaded)
+    {
+        // no I/O thread - load right away (unlocked, it may request more), finish as usual
+        slots[slot].state = DNF_ASSET_STATE_LOADING;
+        mtx_unlock(&loader_mutex);
+        const bool8_t result = load(user_data);
+        mtx_lock(&loader_mutex);
+        slots[slot].loaded = result;
+        slots[slot].state = DNF_ASSET_STATE_LOADED;
+        list_push(&loaded, slot);
+        mtx_unlock(&loader_mutex);
+        return request;
+    }
+
+    slots[slot].state = DNF_ASSET_STATE_QUEUED;
+    list_push(&queues[priority], slot);
+    cnd_signal(&loader_wake);
+    mtx_unlock(&loader_mutex);
+
+    return request;
+}
+
+bool8_t asset_loader_set_priority(const dnf_asset_request request, const dnf_asset_priority priority)
+{
+    if (!dnf_asset_loader_initialized || priority >= DNF_ASSET_PRIORITY_COUNT)
+        return false;
+
+    mtx_lock(&loader_mutex);
+    const uint32_t slot = find_slot(request, DNF_ASSET_STATE_QUEUED);
+    if (slot != DNF_ASSET_NIL && slots[slot].priority != priority)
+    {
+        list_remove(&queues[slots[slot].priority], slot);
+        slots[slot].priority = (uint8_t)priority;
+        list_push(&queues[priority], slot);
+    }
+    mtx_unlock(&loader_mutex);
+
+    return slot != DNF_ASSET_NIL;
+}
+
+bool8_t asset_loader_cancel(const dnf_asset_request request)
+{
+    if (!dnf_asset_loader_initialized)
+        return false;
+
+    mtx_lock(&loader_mutex);
+    const uint32_t slot = find_slot(request, DNF_ASSET_STATE_QUEUED);
+    if (slot != DNF_ASSET_NIL)
+    {
+        list_remove(&queues[slots[slot].priority], slot);
+        release_slot(slot);
+    }
+    mtx_unlock(&loader_mutex);
+
+    return slot != DNF_ASSET_NIL;
+}
+
+void asset_loader_flush(void)
+{
+    for (;;)
+    {
+        if (!dnf_asset_loader_initialized)
+            return;
+        asset_loader_finish(INFINITY);
+
+        // finish functions may queue more requests, so check again after waiting
+        mtx_lock(&loader_mutex);
+        while (free_count < DNF_ASSET_MAX_REQUESTS && loaded.head == DNF_ASSET_NIL)
+            cnd_wait(&loader_done, &loader_mutex);
+        const bool8_t idle = free_count == DNF_ASSET_MAX_REQUESTS;
+        mtx_unlock(&loader_mutex);
+
+        if (idle)
+            return;
+    }
+}
+
+uint32_t asset_loader_pending(void)
+{
+    if (!dnf_asset_loader_initialized)
+        return 0;
+
+    mtx_lock(&loader_mutex);
+    const uint32_t pending = DNF_ASSET_MAX_REQUESTS - free_count;
+    mtx_unlock(&loader_mutex);
+    return pending;
+}
@@ -0,0 +1,743 @@
+// DNF (Doomed and Forgotten): a DOOM-style first-person shooter.
+// Copyright (C) 2025-2026  Alexandr Gorbatenko
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+
+#include "blockmap.h"
+
+#include "logger.h"
+
+#include <math.h>  // floorf, sqrtf, fabsf
+
+// End of an entity list (and the block of unlinked slots).
+#define DNF_BLOCKMAP_NIL UINT32_MAX
+// Margin around the level bounds (entities may stand on the outer lines).
+#define DNF_BLOCKMAP_MARGIN 1.0f
+// Push-out passes of blockmap_collide_circle() (corners need more than one).
+#define DNF_BLOCKMAP_COLLIDE_PASSES 3
+// Most linedefs a collision test looks at.
+#define DNF_BLOCKMAP_MAX_COLLIDE_LINES 64
+
+
+/**
+ * @brief Gets the block column of a world X (clamped to the grid).
+ */
+static int32_t block_x(const dnf_blockmap *map, const float32_t x)
+{
+    const int32_t bx = (int32_t)floorf((x - map->origin_x) / map->block_size);
+    return bx < 0 ? 0 : bx >= map->width ? map->width - 1 : bx;
+}
+
+/**
+ * @brief Gets the block row of a world Y (clamped to the grid).
+ */
+static int32_t block_y(const dnf_blockmap *map, const float32_t y)
+{
+    const int32_t by = (int32_t)floorf((y - map->origin_y) / map->block_size);
+    return by < 0 ? 0 : by >= map->height ? map->height - 1 : by;
+}
+
+/**
+ * @brief Starts a new query: linedefs and entities marked by earlier
+ * queries count as unvisited again.
+ */
+static void begin_query(dnf_blockmap *map)
+{
+    if (++map->mark == 0)
+    {
+        // wrapped around, old marks could match again
+        if (map->level)
+            for (uint32_t i = 0; i < map->level->linedef_count; i++)
+                map->line_marks[i] = 0;
+        for (uint32_t i = 0; i < map->entity_capacity; i++)
+            map->entity_marks[i] = 0;
+        map->mark = 1;
+    }
+}
+
+/**
+ * @brief Gets the squared distance from a point to a segment.
+ *
+ * @param px Point X.
+ * @param py Point Y.
+ * @param a Segment start.
+ * @param b Segment end.
+ * @param out_cx Closest point X on the segment.
+ * @param out_cy Closest point Y on the segment.
+ * @return Squared distance.
+ */
+static float32_t segment_distance2(
+    const float32_t px, const float32_t py,
+    const dnf_vertex a, const dnf_vertex b,
+    float32_t *out_cx, float32_t *out_cy)
+{
+    const float32_t dx = b.x - a.x, dy = b.y - a.y;
+    const float32_t length2 = dx * dx + dy * dy;
+    float32_t t = length2 > 0.0f ? ((px - a.x) * dx + (py - a.y) * dy) / length2 : 0.0f;
+    t = t < 0.0f ? 0.0f : t > 1.0f ? 1.0f : t;
+
+    *out_cx = a.x + dx * t;
+    *out_cy = a.y + dy * t;
+    const float32_t ex = px - *out_cx, ey = py - *out_cy;
+    return ex * ex + ey * ey;
+}
+
+/**
+ * @brief Checks if a segment crosses an axis-aligned box (slab test).
+ */
+static bool8_t segment_touches_box(
+    const dnf_vertex a, const dnf_vertex b,
+    const float32_t min_x, const float32_t min_y,
+    const float32_t max_x, const float32_t max_y)
+{
+    float32_t t0 = 0.0f, t1 = 1.0f;
+    const float32_t d[2] = { b.x - a.x, b.y - a.y };
+    const float32_t start[2] = { a.x, a.y };
+    const float32_t box_min[2] = { min_x, min_y };
+    const float32_t box_max[2] = { max_x, max_y };
+
+    for (uint32_t axis = 0; axis < 2; axis++)
+    {
+        if (d[axis] == 0.0f)
+        {
+            if (start[axis] < box_min[axis] || start[axis] > box_max[axis])
+                return false;
+            continue;
+        }
+        float32_t near = (box_min[axis] - start[axis]) / d[axis];
+        float32_t far = (box_max[axis] - start[axis]) / d[axis];
+        if (near > far)
+        {
+            const float32_t swap = near;
+            near = far;
+            far = swap;
+        }
+        t0 = near > t0 ? near : t0;
+        t1 = far < t1 ? far : t1;
+        if (t0 > t1)
+            return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Intersects two segments.
+ *
+ * @return Position of the crossing along p (0 to 1), or a negative value if
+ * the segments don't cross.
+ */
+static float32_t segment_crossing(
+    const float32_t px, const float32_t py, const float32_t pdx, const float32_t pdy,
+    const dnf_vertex a, const dnf_vertex b)
+{
+    const float32_t qdx = b.x - a.x, qdy = b.y - a.y;
+    const float32_t denominator = pdx * qdy - pdy * qdx;
+    if (denominator == 0.0f)
+        return -1.0f;  // parallel
+
+    const float32_t ax = a.x - px, ay = a.y - py;
+    const float32_t t = (ax * qdy - ay * qdx) / denominator;  // along p
+    const float32_t u = (ax * pdy - ay * pdx) / denominator;  // along q
+    if (t < 0.0f || t > 1.0f || u < 0.0f || u > 1.0f)
+        return -1.0f;
+    return t;
+}
+
+/**
+ * @brief Intersects a segment with a circle.
+ *
+ * @return Position of the first crossing along the segment (0 to 1; 0 if it
+ * starts inside), or a negative value if it misses.
+ */
+static float32_t circle_crossing(
+    const float32_t px, const float32_t py, const float32_t dx, const float32_t dy,
+    const float32_t cx, const float32_t cy, const float32_t radius)
+{
+    const float32_t fx = px - cx, fy = py - cy;
+    const float32_t c = fx * fx + fy * fy - radius * radius;
+    if (c <= 0.0f)
+        return 0.0f;
+
+    const float32_t a = dx * dx + dy * dy;
+    const float32_t b = fx * dx + fy * dy;
+    const float32_t discriminant = b * b - a * c;
+    if (a == 0.0f || b >= 0.0f || discriminant < 0.0f)
+        return -1.0f;  // standing still, moving away or missing
+
+    const float32_t t = (-b - sqrtf(discriminant)) / a;
+    return t <= 1.0f ? t : -1.0f;
+}
+
+/**
+ * @brief Checks if a linedef stops a mover.
+ */
+static bool8_t line_blocks(
+    const dnf_bsp_level *level, const dnf_linedef *line,
+    const float32_t z, const float32_t height, const float32_t max_step)
+{
+    if (line->back_sector == DNF_BSP_NO_SECTOR)
+        return true;
+
+    const dnf_sector *front = &level->sectors[line->front_sector];
+    const dnf_sector *back = &level->sectors[line->back_sector];
+    const float32_t floor = fmaxf(front->floor_height, back->floor_height);
+    const float32_t ceiling = fminf(front->ceiling_height, back->ceiling_height);
+    return floor > z + max_step || ceiling - floor < height || ceiling < z + height;
+}
+
+/**
+ * @brief Links the linedefs of a level into the blocks they cross.
+ *
+ * @return True on success.
+ */
+static bool8_t link_lines(dnf_blockmap *map, const dnf_bsp_level *level)
+{
+    const uint32_t block_count = (uint32_t)(map->width * map->height);
+    map->level = level;
+    map->line_offsets = dnf_alloc((block_count + 1) * sizeof(uint32_t), DNF_MEMORY_TAG_LEVEL);
+    map->line_marks = dnf_alloc((level->linedef_count > 0 ? level->linedef_count : 1) * sizeof(uint32_t), DNF_MEMORY_TAG_LEVEL);
+    if (!map->line_offsets || !map->line_marks)
+        return false;
+
+    // two passes: count the lines of every block, then fill them in
+    for (uint32_t pass = 0; pass < 2; pass++)
+    {
+        for (uint32_t i = 0; i < level->linedef_count; i++)
+        {
+            const dnf_vertex a = level->vertices[level->linedefs[i].v1];
+            const dnf_vertex b = level->vertices[level->linedefs[i].v2];
+            const int32_t bx0 = block_x(map, fminf(a.x, b.x)), bx1 = block_x(map, fmaxf(a.x, b.x));
+            const int32_t by0 = block_y(map, fminf(a.y, b.y)), by1 = block_y(map, fmaxf(a.y, b.y));
+
+            for (int32_t by = by0; by <= by1; by++)
+            {
+                for (int32_t bx = bx0; bx <= bx1; bx++)
+                {
+                    const float32_t min_x = map->origin_x + (float32_t)bx * map->block_size;
+                    const float32_t min_y = map->origin_y + (float32_t)by * map->block_size;
+                    if (!segment_touches_box(a, b, min_x, min_y, min_x + map->block_size, min_y + map->block_size))
+                        continue;
+
+                    const uint32_t block = (uint32_t)(by * map->width + bx);
+                    if (pass == 0)
+                        map->line_offsets[block + 1]++;
+                    else
+                        map->lines[map->line_offsets[block]++] = i;
+                }
+            }
+        }
+
+        if (pass == 0)
+        {
+            // counts to offsets
+            for (uint32_t block = 0; block < block_count; block++)
+                map->line_offsets[block + 1] += map->line_offsets[block];
+            const uint32_t total = map->line_offsets[block_count];
+            map->lines = dnf_alloc((total > 0 ? total : 1) * sizeof(uint32_t), DNF_MEMORY_TAG_LEVEL);
+            if (!map->lines)
+                return false;
+        }
+    }
+
+    // filling moved every offset to the start of the next block
+    for (uint32_t block = block_count; block > 0; block--)
+        map->line_offsets[block] = map->line_offsets[block - 1];
+    map->line_offsets[0] = 0;
+    return true;
+}
+
+/**
+ * @brief Unlinks a slot from its block list.
+ */
+static void unlink_slot(dnf_blockmap *map, const uint32_t slot)
+{
+    const uint32_t block = map->entity_block[slot];
+    const uint32_t next = map->entity_next[slot];
+    const uint32_t prev = map->entity_prev[slot];
+    if (prev != DNF_BLOCKMAP_NIL)
+        map->entity_next[prev] = next;
+    else
+        map->block_entities[block] = next;
+    if (next != DNF_BLOCKMAP_NIL)
+        map->entity_prev[next] = prev;
+    map->entity_block[slot] = DNF_BLOCKMAP_NIL;
+}
+
+/**
+ * @brief Visits the entities in a block range that overlap a circle and
+ * haven't been visited by the current query.
+ *
+ * @return Number of entities written to out_entities.
+ */
+static uint32_t gather_entities(
+    dnf_blockmap *map,
+    const int32_t bx0, const int32_t by0, const int32_t bx1, const int32_t by1,
+    const float32_t x, const float32_t y, const float32_t radius,
+    const dnf_entity ignore,
+    dnf_entity *out_entities, uint32_t count, const uint32_t max_entities)
+{
+    for (int32_t by = by0; by <= by1; by++)
+    {
+        for (int32_t bx = bx0; bx <= bx1; bx++)
+        {
+            uint32_t slot = map->block_entities[by * map->width + bx];
+            for (; slot != DNF_BLOCKMAP_NIL; slot = map->entity_next[slot])
+            {
+                if (map->entity_marks[slot] == map->mark || map->entity_handles[slot] == ignore)
+                    continue;
+                map->entity_marks[slot] = map->mark;
+
+                const float32_t dx = map->entity_x[slot] - x, dy = map->entity_y[slot] - y;
+                const float32_t reach = radius + map->entity_radius[slot];
+                if (dx * dx + dy * dy >= reach * reach)
+                    continue;
+                if (count == max_entities)
+                    return count;
+                out_entities[count++] = map->entity_handles[slot];
+            }
+        }
+    }
+    return count;
+}
+
+
+bool8_t blockmap_init(
+    dnf_blockmap *map,
+    const float32_t min_x, const float32_t min_y,
+    const float32_t max_x, const float32_t max_y,
+    const float32_t block_size,
+    const uint32_t entity_capacity)
+{
+    *map = (dnf_blockmap){0};
+    if (block_size <= 0.0f || max_x < min_x || max_y < min_y || entity_capacity > DNF_ENTITY_MAX_COUNT)
+    {
+        DNF_ERROR("Invalid blockmap parameters");
+        return false;
+    }
+
+    map->origin_x = min_x;
+    map->origin_y = min_y;
+    map->block_size = block_size;
+    map->width = (int32_t)ceilf((max_x - min_x) / block_size);
+    map->height = (int32_t)ceilf((max_y - min_y) / block_size);
+    map->width = map->width > 0 ? map->width : 1;
+    map->height = map->height > 0 ? map->height : 1;
+    map->entity_capacity = entity_capacity;
+
+    const uint32_t block_count = (uint32_t)(map->width * map->height);
+    const uint32_t slots = entity_capacity > 0 ? entity_capacity : 1;
+    map->block_entities = dnf_alloc(block_count * sizeof(uint32_t), DNF_MEMORY_TAG_ENTITIES);
+    map->entity_next = dnf_alloc(slots * sizeof(uint32_t), DNF_MEMORY_TAG_ENTITIES);
+    map->entity_prev = dnf_alloc(slots * sizeof(uint32_t), DNF_MEMORY_TAG_ENTITIES);
+    map->entity_block = dnf_alloc(slots * sizeof(uint32_t), DNF_MEMORY_TAG_ENTITIES);
+    map->entity_marks = dnf_alloc(slots * sizeof(uint32_t), DNF_MEMORY_TAG_ENTITIES);
+    map->entity_handles = dnf_alloc(slots * sizeof(dnf_entity), DNF_MEMORY_TAG_ENTITIES);
+    map->entity_x = dnf_alloc(slots * sizeof(float32_t), DNF_MEMORY_TAG_ENTITIES);
+    map->entity_y = dnf_alloc(slots * sizeof(float32_t), DNF_MEMORY_TAG_ENTITIES);
+    map->entity_radius = dnf_alloc(slots * sizeof(float32_t), DNF_MEMORY_TAG_ENTITIES);
+    if (!map->block_entities || !map->entity_next || !map->entity_prev || !map->entity_block
+        || !map->entity_marks || !map->entity_handles || !map->entity_x || !map->entity_y || !map->entity_radius)
+    {
+        DNF_ERROR("Failed to allocate a %dx%d blockmap", map->width, map->height);
+        blockmap_shutdown(map);
+        return false;
+    }
+
+    for (uint32_t block = 0; block < block_count; block++)
+        map->block_entities[block] = DNF_BLOCKMAP_NIL;
+    for (uint32_t slot = 0; slot < entity_capacity; slot++)
+        map->entity_block[slot] = DNF_BLOCKMAP_NIL;
+    return true;
+}
+
+bool8_t blockmap_init_level(
+    dnf_blockmap *map,
+    const dnf_bsp_level *level,
+    const float32_t block_size,
+    const uint32_t entity_capacity)
+{
+    float32_t min_x = INFINITY, min_y = INFINITY, max_x = -INFINITY, max_y = -INFINITY;
+    for (uint32_t i = 0; i < level->vertex_count; i++)
+    {
+        min_x = fminf(min_x, level->vertices[i].x);
+        min_y = fminf(min_y, level->vertices[i].y);
+        max_x = fmaxf(max_x, level->vertices[i].x);
+        max_y = fmaxf(max_y, level->vertices[i].y);
+    }
+    if (level->vertex_count == 0)
+        min_x = min_y = max_x = max_y = 0.0f;
+
+    if (!blockmap_init(
+        map,
+        min_x - DNF_BLOCKMAP_MARGIN, min_y - DNF_BLOCKMAP_MARGIN,
+        max_x + DNF_BLOCKMAP_MARGIN, max_y + DNF_BLOCKMAP_MARGIN,
+        block_size, entity_capacity))
+        return false;
+
+    if (!link_lines(map, level))
+    {
+        DNF_ERROR("Failed to allocate the blockmap lines");
+        blockmap_shutdown(map);
+        return false;
+    }
+
+    DNF_INFO(
+        "Built %dx%d blockmap: %u linedefs, %u block links",
+        map->width, map->height, level->linedef_count, map->line_offsets[map->width * map->height]);
+    return true;
+}
+
+void blockmap_shutdown(dnf_blockmap *map)
+{
+    dnf_free(map->line_offsets);
+    dnf_free(map->lines);
+    dnf_free(map->line_marks);
+    dnf_free(map->block_entities);
+    dnf_free(map->entity_next);
+    dnf_free(map->entity_prev);
+    dnf_free(map->entity_block);
+    dnf_free(map->entity_marks);
+    dnf_free(map->entity_handles);
+    dnf_free(map->entity_x);
+    dnf_free(map->entity_y);
+    dnf_free(map->entity_radius);
+    *map = (dnf_blockmap){0};
+}
+
+void blockmap_move(dnf_blockmap *map, const dnf_entity entity, const float32_t x, const float32_t y, const float32_t radius)
+{
+    const uint32_t slot = (entity & 0xFFFF) - 1;
+    if (entity == DNF_ENTITY_NONE || slot >= map->entity_capacity)
+        return;
+
+    map->entity_handles[slot] = entity;
+    map->entity_x[slot] = x;
+    map->entity_y[slot] = y;
+    map->entity_radius[slot] = radius;
+    if (radius > map->max_radius)
+        map->max_radius = radius;
+
+    // most moves stay in the same block
+    const uint32_t block = (uint32_t)(block_y(map, y) * map->width + block_x(map, x));
+    if (map->entity_block[slot] == block)
+        return;
+    if (map->entity_block[slot] != DNF_BLOCKMAP_NIL)
+        unlink_slot(map, slot);
+
+    map->entity_block[slot] = block;
+    map->entity_prev[slot] = DNF_BLOCKMAP_NIL;
+    map->entity_next[slot] = map->block_entities[block];
+    if (map->entity_next[slot] != DNF_BLOCKMAP_NIL)
+        map->entity_prev[map->entity_next[slot]] = slot;
+    map->block_entities[block] = slot;
+}
+
+void blockmap_remove(dnf_blockmap *map, const dnf_entity entity)
+{
+    const uint32_t slot = (entity & 0xFFFF) - 1;
+    if (entity == DNF_ENTITY_NONE || slot >= map->entity_capacity
+        || map->entity_block[slot] == DNF_BLOCKMAP_NIL || map->entity_handles[slot] != entity)
+        return;
+    unlink_slot(map, slot);
+}
+
+void blockmap_clear_entities(dnf_blockmap *map)
+{
+    for (int32_t block = 0; block < map->width * map->height; block++)
+        map->block_entities[block] = DNF_BLOCKMAP_NIL;
+    for (uint32_t slot = 0; slot < map->entity_capacity; slot++)
+        map->entity_block[slot] = DNF_BLOCKMAP_NIL;
+    map->max_radius = 0.0f;
+}
+
+uint32_t blockmap_query_radius(
+    dnf_blockmap *map,
+    const float32_t x, const float32_t y, const float32_t radius,
+    const dnf_entity ignore,
+    dnf_entity *out_entities, const uint32_t max_entities)
+{
+    begin_query(map);
+    const float32_t reach = radius + map->max_radius;
+    return gather_entities(
+        map,
+        block_x(map, x - reach), block_y(map, y - reach),
+        block_x(map, x + reach), block_y(map, y + reach),
+        x, y, radius, ignore, out_entities, 0, max_entities);
+}
+
+uint32_t blockmap_query_lines(
+    dnf_blockmap *map,
+    const float32_t x, const float32_t y, const float32_t radius,
+    uint32_t *out_lines, const uint32_t max_lines)
+{
+    if (!map->level)
+        return 0;
+
+    begin_query(map);
+    const int32_t bx0 = block_x(map, x - radius), bx1 = block_x(map, x + radius);
+    const int32_t by0 = block_y(map, y - radius), by1 = block_y(map, y + radius);
+    uint32_t count = 0;
+
+    for (int32_t by = by0; by <= by1; by++)
+    {
+        for (int32_t bx = bx0; bx <= bx1; bx++)
+        {
+            const uint32_t block = (uint32_t)(by * map->width + bx);
+            for (uint32_t i = map->line_offsets[block]; i < map->line_offsets[block + 1]; i++)
+            {
+                const uint32_t line = map->lines[i];
+                if (map->line_marks[line] == map->mark)
+                    continue;
+                map->line_marks[line] = map->mark;
+
+                const dnf_linedef *linedef = &map->level->linedefs[line];
+                float32_t cx, cy;
+                const float32_t distance2 = segment_distance2(
+                    x, y, map->level->vertices[linedef->v1], map->level->vertices[linedef->v2], &cx, &cy);
+                if (distance2 >= radius * radius)
+                    continue;
+                if (count == max_lines)
+                    return count;
+                out_lines[count++] = line;
+            }
+        }
+    }
+    return count;
+}
+
+uint32_t blockmap_query_nearest(
+    dnf_blockmap *map,
+    const float32_t x, const float32_t y, const float32_t max_distance,
+    const dnf_entity ignore,
+    dnf_entity *out_entities, uint32_t k)
+{
+    k = k < DNF_BLOCKMAP_MAX_NEAREST ? k : DNF_BLOCKMAP_MAX_NEAREST;
+    if (k == 0)
+        return 0;
+
+    float32_t distances2[DNF_BLOCKMAP_MAX_NEAREST];
+    uint32_t count = 0;
+    const int32_t cx = block_x(map, x), cy = block_y(map, y);
+    const int32_t max_ring = map->width > map->height ? map->width : map->height;
+
+    // rings of blocks around the center block, nearest first
+    for (int32_t ring = 0; ring <= max_ring; ring++)
+    {
+        // anything in this ring or beyond is at least this far away
+        const float32_t ring_distance = (float32_t)(ring > 0 ? ring - 1 : 0) * map->block_size;
+        if (ring_distance > max_distance)
+            break;
+        if (count == k && ring_distance * ring_distance >= distances2[k - 1])
+            break;
+
+        for (int32_t by = cy - ring; by <= cy + ring; by++)
+        {
+            if (by < 0 || by >= map->height)
+                continue;
+            // inner rows only have the two edge blocks
+            const int32_t step = (by == cy - ring || by == cy + ring) ? 1 : 2 * ring;
+            for (int32_t bx = cx - ring; bx <= cx + ring; bx += step > 0 ? step : 1)
+            {
+                if (bx < 0 || bx >= map->width)
+                    continue;
+
+                uint32_t slot = map->block_entities[by * map->width + bx];
+                for (; slot != DNF_BLOCKMAP_NIL; slot = map->entity_next[slot])
+                {
+                    if (map->entity_handles[slot] == ignore)
+                        continue;
+                    const float32_t dx = map->entity_x[slot] - x, dy = map->entity_y[slot] - y;
+                    const float32_t distance2 = dx * dx + dy * dy;
+                    if (distance2 > max_distance * max_distance)
+                        continue;
+                    if (count == k && distance2 >= distances2[k - 1])
+                        continue;
+
+                    // insertion into the sorted list
+                    uint32_t i = count < k ? count++ : k - 1;
+                    for (; i > 0 && distances2[i - 1] > distance2; i--)
+                    {
+                        distances2[i] = distances2[i - 1];
+                        out_entities[i] = out_entities[i - 1];
+                    }
+                    distances2[i] = distance2;
+                    out_entities[i] = map->entity_handles[slot];
+                }
+            }
+        }
+    }
+    return count;
+}
+
+dnf_blockmap_hit blockmap_trace(
+    dnf_blockmap *map,
+    const float32_t x0, const float32_t y0, const float32_t x1, const float32_t y1,
+    const dnf_entity ignore,
+    const bool8_t hit_entities)
+{
+    dnf_blockmap_hit hit = { .fraction = 1.0f, .line = DNF_BLOCKMAP_NO_LINE, .entity = DNF_ENTITY_NONE };
+    begin_query(map);
+
+    const float32_t dx = x1 - x0, dy = y1 - y0;
+    int32_t bx = block_x(map, x0), by = block_y(map, y0);
+    const int32_t end_bx = block_x(map, x1), end_by = block_y(map, y1);
+
+    // grid traversal (Amanatides & Woo): t of the next block border on every axis
+    const int32_t step_x = dx > 0.0f ? 1 : -1, step_y = dy > 0.0f ? 1 : -1;
+    const float32_t delta_x = dx != 0.0f ? map->block_size / fabsf(dx) : INFINITY;
+    const float32_t delta_y = dy != 0.0f ? map->block_size / fabsf(dy) : INFINITY;
+    const float32_t border_x = map->origin_x + (float32_t)(bx + (step_x > 0)) * map->block_size;
+    const float32_t border_y = map->origin_y + (float32_t)(by + (step_y > 0)) * map->block_size;
+    float32_t next_x = dx != 0.0f ? (border_x - x0) / dx : INFINITY;
+    float32_t next_y = dy != 0.0f ? (border_y - y0) / dy : INFINITY;
+
+    // entities are linked by center, a block also checks its neighbors
+    const int32_t reach = map->max_radius > 0.0f ? 1 + (int32_t)(map->max_radius / map->block_size) : 0;
+
+    for (;;)
+    {
+        if (map->level)
+        {
+            const uint32_t block = (uint32_t)(by * map->width + bx);
+            for (uint32_t i = map->line_offsets[block]; i < map->line_offsets[block + 1]; i++)
+            {
+                const uint32_t line = map->lines[i];
+                if (map->line_marks[line] == map->mark)
+                    continue;
+                map->line_marks[line] = map->mark;
+
+                const dnf_linedef *linedef = &map->level->linedefs[line];
+                if (linedef->back_sector != DNF_BSP_NO_SECTOR)
+                    continue;
+                const float32_t t = segment_crossing(
+                    x0, y0, dx, dy, map->level->vertices[linedef->v1], map->level->vertices[linedef->v2]);
+                if (t >= 0.0f && t < hit.fraction)
+                {
+                    hit.fraction = t;
+                    hit.line = line;
+                    hit.entity = DNF_ENTITY_NONE;
+                }
+            }
+        }
+
+        if (hit_entities)
+        {
+            for (int32_t ny = by - reach; ny <= by + reach; ny++)
+            {
+                if (ny < 0 || ny >= map->height)
+                    continue;
+                for (int32_t nx = bx - reach; nx <= bx + reach; nx++)
+                {
+                    if (nx < 0 || nx >= map->width)
+                        continue;
+                    uint32_t slot = map->block_entities[ny * map->width + nx];
+                    for (; slot != DNF_BLOCKMAP_NIL; slot = map->entity_next[slot])
+                    {
+                        if (map->entity_marks[slot] == map->mark || map->entity_handles[slot] == ignore)
+                            continue;
+                        map->entity_marks[slot] = map->mark;
+
+                        const float32_t t = circle_crossing(
+                            x0, y0, dx, dy, map->entity_x[slot], map->entity_y[slot], map->entity_radius[slot]);
+                        if (t >= 0.0f && t < hit.fraction)
+                        {
+                            hit.fraction = t;
+                            hit.line = DNF_BLOCKMAP_NO_LINE;
+                            hit.entity = map->entity_handles[slot];
+                        }
+                    }
+                }
+            }
+        }
+
+        // later blocks can't hold anything nearer than this block's exit
+        const float32_t exit = fminf(next_x, next_y);
+        if (hit.fraction <= exit || (bx == end_bx && by == end_by))
+            break;
+
+        if (next_x < next_y)
+        {
+            bx += step_x;
+            next_x += delta_x;
+        }
+        else
+        {
+            by += step_y;
+            next_y += delta_y;
+        }
+        if (bx < 0 || by < 0 || bx >= map->width || by >= map->height)
+            break;
+    }
+
+    return hit;
+}
+
+bool8_t blockmap_line_of_sight(
+    dnf_blockmap *map,
+    const float32_t x0, const float32_t y0, const float32_t x1, const float32_t y1)
+{
+    return blockmap_trace(map, x0, y0, x1, y1, DNF_ENTITY_NONE, false).line == DNF_BLOCKMAP_NO_LINE;
+}
+
+bool8_t blockmap_collide_circle(
+    dnf_blockmap *map,
+    float32_t *x, float32_t *y, const float32_t radius,
+    const float32_t z, const float32_t height, const float32_t max_step)
+{
+    bool8_t pushed = false;
+    uint32_t lines[DNF_BLOCKMAP_MAX_COLLIDE_LINES];
+
+    for (uint32_t pass = 0; pass < DNF_BLOCKMAP_COLLIDE_PASSES; pass++)
+    {
+        const uint32_t count = blockmap_query_lines(map, *x, *y, radius, lines, DNF_BLOCKMAP_MAX_COLLIDE_LINES);
+        bool8_t moved = false;
+        for (uint32_t i = 0; i < count; i++)
+        {
+            const dnf_linedef *line = &map->level->linedefs[lines[i]];
+            if (!line_blocks(map->level, line, z, height, max_step))
+                continue;
+
+            const dnf_vertex a = map->level->vertices[line->v1];
+            const dnf_vertex b = map->level->vertices[line->v2];
+            float32_t cx, cy;
+            const float32_t distance2 = segment_distance2(*x, *y, a, b, &cx, &cy);
+            if (distance2 >= radius * radius)
+                continue;  // an earlier push moved away from it
+
+            // push out along the line normal, or away from the closest point
+            float32_t nx, ny, distance = sqrtf(distance2);
+            if (distance > 1e-6f)
+            {
+                nx = (*x - cx) / distance;
+                ny = (*y - cy) / distance;
+            }
+            else
+            {
+                const float32_t length = sqrtf((b.x - a.x) * (b.x - a.x) + (b.y - a.y) * (b.y - a.y));
+                nx = -(b.y - a.y) / length;
+                ny = (b.x - a.x) / length;
+                distance = 0.0f;
+            }
+            *x += nx * (radius - distance);
+            *y += ny * (radius - distance);
+            moved = true;
+        }
+
+        if (!moved)
+            break;
+        pushed = true;
+    }
+    return pushed;
+}
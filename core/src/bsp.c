@@ -0,0 +1,1068 @@
+// DNF (Doomed and Forgotten): a DOOM-style first-person shooter.
+// Copyright (C) 2025-2026  Alexandr Gorbatenko
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+
+#include "bsp.h"
+
+#include "dnf_memory.h"
+#include "job_system.h"
+#include "logger.h"
+#include "pixels.h"
+#include "pvs.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Distance below which a point is considered to lie on a partition line.
+#define DNF_BSP_EPSILON 1e-3f
+// Max number of partition candidates scored per node (evenly sampled).
+#define DNF_BSP_MAX_SPLIT_CANDIDATES 128
+// Cost of splitting a seg relative to an unbalanced seg.
+#define DNF_BSP_SPLIT_COST 4
+// Near clipping plane distance.
+#define DNF_BSP_NEAR_PLANE 0.01f
+
+
+/**
+ * @brief Working state of the BSP builder.
+ */
+typedef struct dnf_bsp_builder
+{
+    dnf_bsp_level *level;
+    uint32_t seg_capacity;
+    uint32_t subsector_capacity;
+    uint32_t node_capacity;
+} dnf_bsp_builder;
+
+/**
+ * @brief A range of fully occluded columns (inclusive).
+ */
+typedef struct dnf_clip_range
+{
+    int32_t first;
+    int32_t last;
+} dnf_clip_range;
+
+/**
+ * @brief Per-frame BSP rendering parameters shared by all column bands.
+ */
+typedef struct dnf_bsp_frame
+{
+    const dnf_bsp_level *level;
+    const dnf_view_tables *view;
+    float32_t origin_x, origin_y, origin_z;  //!< Camera position
+    float32_t forward_x, forward_y;          //!< Camera forward vector
+    int32_t *ceiling_clip;                   //!< Lowest row covered from above, per column
+    int32_t *floor_clip;                     //!< Highest row covered from below, per column
+    dnf_clip_range *ranges;                  //!< Occlusion list storage (3 entries per column)
+    const dnf_palette *palette;              //!< Palette of an indexed target (nullptr - RGBA)
+    const uint8_t *visible_subsectors;       //!< Subsectors in the camera's PVS (nullptr - no culling)
+    const uint8_t *visible_nodes;            //!< Nodes with a subsector in the camera's PVS
+} dnf_bsp_frame;
+
+/**
+ * @brief Per-band BSP rendering state.
+ */
+typedef struct dnf_bsp_band
+{
+    const dnf_bsp_frame *frame;
+    const dnf_framebuffer *fb;
+    int32_t x_begin, x_end;   //!< Band columns
+    dnf_clip_range *solid;    //!< Sorted list of occluded column ranges
+    uint32_t solid_count;     //!< Number of occluded ranges
+} dnf_bsp_band;
+
+/**
+ * @brief A seg transformed into camera space, ready to be drawn.
+ */
+typedef struct dnf_seg_view
+{
+    const dnf_seg *seg;
+    const dnf_sector *front;
+    const dnf_sector *back;   //!< nullptr for one-sided segs
+    float32_t p1_forward, p1_right;  //!< Start point in camera space
+    float32_t edge_forward, edge_right;  //!< Seg vector in camera space
+    Color wall_color;         //!< Lit wall color
+    Color ceiling_color;      //!< Lit front ceiling color
+    Color floor_color;        //!< Lit front floor color
+    uint8_t wall_index;       //!< Lit wall palette index (indexed targets)
+    uint8_t ceiling_index;    //!< Lit front ceiling palette index (indexed targets)
+    uint8_t floor_index;      //!< Lit front floor palette index (indexed targets)
+} dnf_seg_view;
+
+// Number of levels freed so far; a new level may get the address of a freed
+// one, so PVS sets made before a level was freed are made again.
+static uint32_t level_serial = 0;
+
+
+/////////////////////////////////////
+///           BSP BUILDER         ///
+/////////////////////////////////////
+
+/**
+ * @brief Signed distance from a point to the line through a seg (positive -
+ * front/right side).
+ */
+static float32_t seg_point_side(const dnf_seg *seg, const float32_t x, const float32_t y)
+{
+    const float32_t dx = seg->v2.x - seg->v1.x;
+    const float32_t dy = seg->v2.y - seg->v1.y;
+    const float32_t length = sqrtf(dx * dx + dy * dy);
+    return ((x - seg->v1.x) * -dy + (y - seg->v1.y) * dx) / length;
+}
+
+/**
+ * @brief Appends a seg to the level seg array.
+ *
+ * @return Index of the seg, or UINT32_MAX on allocation failure.
+ */
+static uint32_t push_seg(dnf_bsp_builder *builder, const dnf_seg *seg)
+{
+    dnf_bsp_level *level = builder->level;
+    if (level->seg_count == builder->seg_capacity)
+    {
+        const uint32_t capacity = builder->seg_capacity ? builder->seg_capacity * 2 : 64;
+        dnf_seg *segs = dnf_realloc(level->segs, capacity * sizeof(dnf_seg), DNF_MEMORY_TAG_LEVEL);
+        if (!segs)
+            return UINT32_MAX;
+        level->segs = segs;
+        builder->seg_capacity = capacity;
+    }
+    level->segs[level->seg_count] = *seg;
+    return level->seg_count++;
+}
+
+/**
+ * @brief Computes the bounding box of a seg list.
+ */
+static void segs_bbox(const dnf_seg *segs, const uint32_t count, float32_t bbox[4])
+{
+    bbox[0] = bbox[1] = INFINITY;
+    bbox[2] = bbox[3] = -INFINITY;
+    for (uint32_t i = 0; i < count; i++)
+    {
+        bbox[0] = fminf(bbox[0], fminf(segs[i].v1.x, segs[i].v2.x));
+        bbox[1] = fminf(bbox[1], fminf(segs[i].v1.y, segs[i].v2.y));
+        bbox[2] = fmaxf(bbox[2], fmaxf(segs[i].v1.x, segs[i].v2.x));
+        bbox[3] = fmaxf(bbox[3], fmaxf(segs[i].v1.y, segs[i].v2.y));
+    }
+}
+
+/**
+ * @brief Classifies a seg against a partition.
+ *
+ * @return 0 - front, 1 - back, 2 - needs a split.
+ */
+static int32_t classify_seg(const dnf_seg *partition, const dnf_seg *seg, float32_t *out_side1, float32_t *out_side2)
+{
+    const float32_t side1 = seg_point_side(partition, seg->v1.x, seg->v1.y);
+    const float32_t side2 = seg_point_side(partition, seg->v2.x, seg->v2.y);
+    *out_side1 = side1;
+    *out_side2 = side2;
+
+    if (fabsf(side1) <= DNF_BSP_EPSILON && fabsf(side2) <= DNF_BSP_EPSILON)
+    {
+        // collinear: goes to the side the seg is facing
+        const float32_t dot =
+            (partition->v2.x - partition->v1.x) * (seg->v2.x - seg->v1.x)
+            + (partition->v2.y - partition->v1.y) * (seg->v2.y - seg->v1.y);
+        return dot > 0.0f ? 0 : 1;
+    }
+    if (side1 >= -DNF_BSP_EPSILON && side2 >= -DNF_BSP_EPSILON)
+        return 0;
+    if (side1 <= DNF_BSP_EPSILON && side2 <= DNF_BSP_EPSILON)
+        return 1;
+    return 2;
+}
+
+/**
+ * @brief Scores a partition candidate (lower is better).
+ *
+ * @return Score, or -1 if the partition doesn't divide the segs at all.
+ */
+static int64_t score_partition(const dnf_seg *partition, const dnf_seg *segs, const uint32_t count)
+{
+    int64_t front = 0, back = 0, splits = 0;
+    for (uint32_t i = 0; i < count; i++)
+    {
+        float32_t side1, side2;
+        switch (classify_seg(partition, &segs[i], &side1, &side2))
+        {
+        case 0: front++; break;
+        case 1: back++; break;
+        default: splits++; break;
+        }
+    }
+
+    if (back == 0 && splits == 0)
+        return -1;
+    return splits * DNF_BSP_SPLIT_COST + llabs(front - back);
+}
+
+/**
+ * @brief Picks the best partition seg for a seg list.
+ *
+ * @return Index of the partition seg, or UINT32_MAX if the segs are convex.
+ */
+static uint32_t choose_partition(const dnf_seg *segs, const uint32_t count)
+{
+    uint32_t best = UINT32_MAX;
+    int64_t best_score = INT64_MAX;
+
+    const uint32_t stride = count > DNF_BSP_MAX_SPLIT_CANDIDATES ? count / DNF_BSP_MAX_SPLIT_CANDIDATES : 1;
+    for (uint32_t i = 0; i < count; i += stride)
+    {
+        const int64_t score = score_partition(&segs[i], segs, count);
+        if (score >= 0 && score < best_score)
+        {
+            best_score = score;
+            best = i;
+        }
+    }
+
+    // the sample found nothing, make sure the set is really convex
+    if (best == UINT32_MAX && stride > 1)
+        for (uint32_t i = 0; i < count; i++)
+            if (score_partition(&segs[i], segs, count) >= 0)
+                return i;
+
+    return best;
+}
+
+/**
+ * @brief Recursively builds a BSP subtree from a seg list.
+ *
+ * @param builder Builder state.
+ * @param segs Segs to partition (the array is consumed).
+ * @param count Number of segs.
+ * @param out_child Resulting child index (node or subsector).
+ * @return True if successful, false on allocation failure.
+ */
+static bool8_t build_subtree(dnf_bsp_builder *builder, dnf_seg *segs, const uint32_t count, uint32_t *out_child)
+{
+    dnf_bsp_level *level = builder->level;
+    const uint32_t partition_index = choose_partition(segs, count);
+
+    // convex set - make a leaf
+    if (partition_index == UINT32_MAX)
+    {
+        if (level->subsector_count == builder->subsector_capacity)
+        {
+            const uint32_t capacity = builder->subsector_capacity ? builder->subsector_capacity * 2 : 32;
+            dnf_subsector *subsectors = dnf_realloc(level->subsectors, capacity * sizeof(dnf_subsector), DNF_MEMORY_TAG_LEVEL);
+            if (!subsectors)
+                return false;
+            level->subsectors = subsectors;
+            builder->subsector_capacity = capacity;
+        }
+
+        dnf_subsector *subsector = &level->subsectors[level->subsector_count];
+        subsector->first_seg = level->seg_count;
+        subsector->seg_count = count;
+        subsector->sector = segs[0].front_sector;
+        for (uint32_t i = 0; i < count; i++)
+            if (push_seg(builder, &segs[i]) == UINT32_MAX)
+                return false;
+
+        *out_child = level->subsector_count++ | DNF_BSP_SUBSECTOR_BIT;
+        return true;
+    }
+
+    const dnf_seg partition = segs[partition_index];
+
+    // every seg can be split in two, so each side fits in 2 * count
+    dnf_seg *front = dnf_alloc(2 * count * sizeof(dnf_seg), DNF_MEMORY_TAG_LEVEL);
+    dnf_seg *back = front ? front + count : nullptr;
+    if (!front)
+        return false;
+    uint32_t front_count = 0, back_count = 0;
+
+    for (uint32_t i = 0; i < count; i++)
+    {
+        const dnf_seg *seg = &segs[i];
+        float32_t side1, side2;
+        switch (classify_seg(&partition, seg, &side1, &side2))
+        {
+        case 0:
+            front[front_count++] = *seg;
+            break;
+        case 1:
+            back[back_count++] = *seg;
+            break;
+        default:
+        {
+            // split at the intersection with the partition line
+            const float32_t t = side1 / (side1 - side2);
+            const dnf_vertex split = {
+                seg->v1.x + t * (seg->v2.x - seg->v1.x),
+                seg->v1.y + t * (seg->v2.y - seg->v1.y)
+            };
+            dnf_seg first = *seg, second = *seg;
+            first.v2 = split;
+            second.v1 = split;
+            second.offset += sqrtf(
+                (split.x - seg->v1.x) * (split.x - seg->v1.x)
+                + (split.y - seg->v1.y) * (split.y - seg->v1.y));
+
+            if (side1 > 0.0f)
+            {
+                front[front_count++] = first;
+                back[back_count++] = second;
+            }
+            else
+            {
+                back[back_count++] = first;
+                front[front_count++] = second;
+            }
+            break;
+        }
+        }
+    }
+
+    // reserve the node before the children (they may reallocate the array)
+    if (level->node_count == builder->node_capacity)
+    {
+        const uint32_t capacity = builder->node_capacity ? builder->node_capacity * 2 : 32;
+        dnf_bsp_node *nodes = dnf_realloc(level->nodes, capacity * sizeof(dnf_bsp_node), DNF_MEMORY_TAG_LEVEL);
+        if (!nodes)
+        {
+            dnf_free(front);
+            return false;
+        }
+        level->nodes = nodes;
+        builder->node_capacity = capacity;
+    }
+    const uint32_t node_index = level->node_count++;
+
+    dnf_bsp_node node = {
+        .x = partition.v1.x,
+        .y = partition.v1.y,
+        .dx = partition.v2.x - partition.v1.x,
+        .dy = partition.v2.y - partition.v1.y
+    };
+    segs_bbox(front, front_count, node.bbox[0]);
+    segs_bbox(back, back_count, node.bbox[1]);
+
+    const bool8_t success =
+        build_subtree(builder, front, front_count, &node.children[0])
+        && build_subtree(builder, back, back_count, &node.children[1]);
+    dnf_free(front);
+    if (!success)
+        return false;
+
+    level->nodes[node_index] = node;
+    *out_child = node_index;
+    return true;
+}
+
+bool8_t bsp_level_build(const dnf_level_map *map, dnf_bsp_level *out_level)
+{
+    *out_level = (dnf_bsp_level){0};
+    if (map->linedef_count == 0)
+    {
+        DNF_ERROR("Can't build a BSP level without linedefs");
+        return false;
+    }
+
+    // copy source data
+    out_level->vertices = dnf_alloc(map->vertex_count * sizeof(dnf_vertex), DNF_MEMORY_TAG_LEVEL);
+    out_level->linedefs = dnf_alloc(map->linedef_count * sizeof(dnf_linedef), DNF_MEMORY_TAG_LEVEL);
+    out_level->sectors = dnf_alloc(map->sector_count * sizeof(dnf_sector), DNF_MEMORY_TAG_LEVEL);
+    // one seg per linedef side
+    dnf_seg *segs = dnf_alloc(2 * map->linedef_count * sizeof(dnf_seg), DNF_MEMORY_TAG_LEVEL);
+    if (!out_level->vertices || !out_level->linedefs || !out_level->sectors || !segs)
+    {
+        DNF_ERROR("Failed to allocate BSP level data");
+        dnf_free(segs);
+        bsp_level_free(out_level);
+        return false;
+    }
+    memcpy(out_level->vertices, map->vertices, map->vertex_count * sizeof(dnf_vertex));
+    memcpy(out_level->linedefs, map->linedefs, map->linedef_count * sizeof(dnf_linedef));
+    memcpy(out_level->sectors, map->sectors, map->sector_count * sizeof(dnf_sector));
+    out_level->vertex_count = map->vertex_count;
+    out_level->linedef_count = map->linedef_count;
+    out_level->sector_count = map->sector_count;
+
+    uint32_t seg_count = 0;
+    for (uint32_t i = 0; i < map->linedef_count; i++)
+    {
+        const dnf_linedef *line = &map->linedefs[i];
+        const dnf_vertex v1 = map->vertices[line->v1];
+        const dnf_vertex v2 = map->vertices[line->v2];
+
+        segs[seg_count++] = (dnf_seg){
+            .v1 = v1, .v2 = v2,
+            .linedef = i,
+            .front_sector = line->front_sector,
+            .back_sector = line->back_sector,
+            .offset = 0.0f
+        };
+
+        // back side of a two-sided line faces the other way
+        if (line->back_sector != DNF_BSP_NO_SECTOR)
+            segs[seg_count++] = (dnf_seg){
+                .v1 = v2, .v2 = v1,
+                .linedef = i,
+                .front_sector = line->back_sector,
+                .back_sector = line->front_sector,
+                .offset = 0.0f
+            };
+    }
+
+    dnf_bsp_builder builder = { .level = out_level };
+    const bool8_t success = build_subtree(&builder, segs, seg_count, &out_level->root);
+    dnf_free(segs);
+
+    if (!success)
+    {
+        DNF_ERROR("Failed to allocate BSP tree");
+        bsp_level_free(out_level);
+        return false;
+    }
+
+    DNF_INFO(
+        "Built BSP level: %u linedefs -> %u segs, %u subsectors, %u nodes",
+        out_level->linedef_count, out_level->seg_count,
+        out_level->subsector_count, out_level->node_count);
+    return true;
+}
+
+void bsp_level_free(dnf_bsp_level *level)
+{
+    dnf_free(level->vertices);
+    dnf_free(level->linedefs);
+    dnf_free(level->sectors);
+    dnf_free(level->segs);
+    dnf_free(level->subsectors);
+    dnf_free(level->nodes);
+    *level = (dnf_bsp_level){0};
+    level_serial++;
+}
+
+/**
+ * @brief Checks on which side of a node partition a point lies.
+ *
+ * @return 0 - front (right) side, 1 - back side.
+ */
+static uint32_t node_point_side(const dnf_bsp_node *node, const float32_t x, const float32_t y)
+{
+    return (x - node->x) * -node->dy + (y - node->y) * node->dx >= 0.0f ? 0 : 1;
+}
+
+uint32_t bsp_point_subsector(const dnf_bsp_level *level, const float32_t x, const float32_t y)
+{
+    uint32_t child = level->root;
+    while (!(child & DNF_BSP_SUBSECTOR_BIT))
+    {
+        const dnf_bsp_node *node = &level->nodes[child];
+        child = node->children[node_point_side(node, x, y)];
+    }
+    return child & ~DNF_BSP_SUBSECTOR_BIT;
+}
+
+
+/////////////////////////////////////
+///           BSP RENDERER        ///
+/////////////////////////////////////
+
+/**
+ * @brief Scales a color by a light factor.
+ */
+static Color shade_color(const Color color, const float32_t light)
+{
+    return (Color){
+        (uint8_t)((float32_t)color.r * light),
+        (uint8_t)((float32_t)color.g * light),
+        (uint8_t)((float32_t)color.b * light),
+        color.a
+    };
+}
+
+/**
+ * @brief Lights a color through the palette's colormaps.
+ */
+static uint8_t shade_index(const dnf_palette *palette, const Color color, const float32_t light)
+{
+    return palette_light(palette, palette_find(palette, color), palette_light_level(light));
+}
+
+/**
+ * @brief Fills a vertical run of pixels [top; bottom] of a column with a
+ * color, or a palette index if the framebuffer is indexed.
+ */
+static void fill_column(
+    const dnf_framebuffer *fb,
+    const int32_t col, const int32_t top, const int32_t bottom,
+    const Color color, const uint8_t index)
+{
+    if (fb->format == DNF_PIXEL_FORMAT_INDEXED8)
+        pixels_fill_column_index(fb, col, top, bottom + 1, index);
+    else
+        pixels_fill_column(fb, col, top, bottom + 1, color);
+}
+
+/**
+ * @brief Converts a world height to a (fractional) screen row at a given
+ * projection scale.
+ */
+static float32_t height_to_row(const dnf_bsp_band *band, const float32_t height, const float32_t scale)
+{
+    return (float32_t)band->fb->height * 0.5f - (height - band->frame->origin_z) * scale;
+}
+
+/**
+ * @brief Converts a fractional screen row to the first row whose center is
+ * below it.
+ */
+static int32_t row_ceil(const float32_t row)
+{
+    return (int32_t)ceilf(row - 0.5f);
+}
+
+/**
+ * @brief Draws columns [first; last] of a seg, clipped by the per-column
+ * ceiling and floor clip arrays.
+ */
+static void draw_seg_columns(const dnf_bsp_band *band, const dnf_seg_view *sv, const int32_t first, const int32_t last)
+{
+    const dnf_bsp_frame *frame = band->frame;
+    const dnf_view_tables *view = frame->view;
+    const dnf_framebuffer *fb = band->fb;
+    const dnf_sector *front = sv->front;
+    const dnf_sector *back = sv->back;
+
+    // a two-sided line with no opening is drawn as a solid wall
+    const bool8_t solid = !back
+        || back->ceiling_height <= front->floor_height
+        || back->floor_height >= front->ceiling_height;
+
+    for (int32_t col = first; col <= last; col++)
+    {
+        // intersect the column ray with the seg in camera space
+        const float32_t ray_forward = view->ray_dir_x[col];
+        const float32_t ray_right = view->ray_dir_y[col];
+        const float32_t denominator = ray_forward * sv->edge_right - ray_right * sv->edge_forward;
+        if (fabsf(denominator) < 1e-8f)
+            continue;
+        const float32_t distance = (sv->p1_forward * sv->edge_right - sv->p1_right * sv->edge_forward) / denominator;
+        const float32_t depth = fmaxf(distance * view->fisheye[col], DNF_BSP_NEAR_PLANE);
+        const float32_t scale = view->projection / depth;
+
+        int32_t ceiling_clip = frame->ceiling_clip[col];
+        int32_t floor_clip = frame->floor_clip[col];
+
+        int32_t top = row_ceil(height_to_row(band, front->ceiling_height, scale));
+        int32_t bottom = row_ceil(height_to_row(band, front->floor_height, scale)) - 1;
+        if (top <= ceiling_clip)
+            top = ceiling_clip + 1;
+        if (bottom >= floor_clip)
+            bottom = floor_clip - 1;
+
+        // visible parts of the front sector's ceiling and floor planes
+        if (front->ceiling_height > frame->origin_z)
+            fill_column(fb, col, ceiling_clip + 1, (top < floor_clip ? top : floor_clip) - 1,
+                sv->ceiling_color, sv->ceiling_index);
+        if (front->floor_height < frame->origin_z)
+            fill_column(fb, col, bottom > ceiling_clip ? bottom + 1 : ceiling_clip + 1, floor_clip - 1,
+                sv->floor_color, sv->floor_index);
+
+        if (solid)
+        {
+            fill_column(fb, col, top, bottom, sv->wall_color, sv->wall_index);
+            view->depth[col] = depth;
+            continue;  // the column is now occluded
+        }
+
+        // upper wall between the front and back ceilings
+        if (back->ceiling_height < front->ceiling_height)
+        {
+            int32_t upper_bottom = row_ceil(height_to_row(band, back->ceiling_height, scale)) - 1;
+            if (upper_bottom > bottom)
+                upper_bottom = bottom;
+            fill_column(fb, col, top, upper_bottom, sv->wall_color, sv->wall_index);
+            ceiling_clip = upper_bottom > top - 1 ? upper_bottom : top - 1;
+        }
+        else
+            ceiling_clip = top - 1;
+
+        // lower wall between the back and front floors
+        if (back->floor_height > front->floor_height)
+        {
+            int32_t lower_top = row_ceil(height_to_row(band, back->floor_height, scale));
+            if (lower_top < top)
+                lower_top = top;
+            fill_column(fb, col, lower_top, bottom, sv->wall_color, sv->wall_index);
+            floor_clip = lower_top < bottom + 1 ? lower_top : bottom + 1;
+        }
+        else
+            floor_clip = bottom + 1;
+
+        frame->ceiling_clip[col] = ceiling_clip;
+        frame->floor_clip[col] = floor_clip;
+    }
+}
+
+/**
+ * @brief Draws the visible parts of a solid wall and marks its columns as
+ * occluded.
+ */
+static void clip_solid_wall(dnf_bsp_band *band, const dnf_seg_view *sv, const int32_t first, const int32_t last)
+{
+    dnf_clip_range *start = band->solid;
+    while (start->last < first - 1)
+        start++;
+
+    if (first < start->first)
+    {
+        if (last < start->first - 1)
+        {
+            // entirely visible - insert a new range
+            draw_seg_columns(band, sv, first, last);
+            memmove(start + 1, start, (size_t)(band->solid + band->solid_count - start) * sizeof(dnf_clip_range));
+            band->solid_count++;
+            *start = (dnf_clip_range){ first, last };
+            return;
+        }
+
+        // the fragment before the range is visible
+        draw_seg_columns(band, sv, first, start->first - 1);
+        start->first = first;
+    }
+
+    if (last <= start->last)
+        return;
+
+    dnf_clip_range *next = start;
+    while (last >= (next + 1)->first - 1)
+    {
+        // visible fragment between two ranges
+        draw_seg_columns(band, sv, next->last + 1, (next + 1)->first - 1);
+        next++;
+
+        if (last <= next->last)
+        {
+            start->last = next->last;
+            goto merge;
+        }
+    }
+
+    draw_seg_columns(band, sv, next->last + 1, last);
+    start->last = last;
+
+merge:
+    // remove ranges swallowed by the start range
+    if (next != start)
+    {
+        const dnf_clip_range *tail = band->solid + band->solid_count;
+        memmove(start + 1, next + 1, (size_t)(tail - (next + 1)) * sizeof(dnf_clip_range));
+        band->solid_count -= (uint32_t)(next - start);
+    }
+}
+
+/**
+ * @brief Draws the visible parts of a wall with an opening, without marking
+ * its columns as occluded.
+ */
+static void clip_pass_wall(const dnf_bsp_band *band, const dnf_seg_view *sv, const int32_t first, const int32_t last)
+{
+    const dnf_clip_range *start = band->solid;
+    while (start->last < first - 1)
+        start++;
+
+    if (first < start->first)
+    {
+        if (last < start->first - 1)
+        {
+            draw_seg_columns(band, sv, first, last);
+            return;
+        }
+        draw_seg_columns(band, sv, first, start->first - 1);
+    }
+
+    if (last <= start->last)
+        return;
+
+    while (last >= (start + 1)->first - 1)
+    {
+        draw_seg_columns(band, sv, start->last + 1, (start + 1)->first - 1);
+        start++;
+        if (last <= start->last)
+            return;
+    }
+
+    draw_seg_columns(band, sv, start->last + 1, last);
+}
+
+/**
+ * @brief Projects a camera-space point to a fractional screen column.
+ */
+static float32_t project_column(const dnf_bsp_band *band, const float32_t forward, const float32_t right)
+{
+    const float32_t column = (float32_t)band->fb->width * 0.5f + right * band->frame->view->projection / forward;
+    // keep far-off-screen points in a sane integer range
+    return fmaxf(-1e6f, fminf(1e6f, column));
+}
+
+/**
+ * @brief Clips a seg to the view and draws its visible columns.
+ */
+static void render_seg(dnf_bsp_band *band, const dnf_seg *seg)
+{
+    const dnf_bsp_frame *frame = band->frame;
+    const dnf_bsp_level *level = frame->level;
+
+    // back faces are drawn by the opposite seg
+    const float32_t dx = seg->v2.x - seg->v1.x;
+    const float32_t dy = seg->v2.y - seg->v1.y;
+    if ((frame->origin_x - seg->v1.x) * -dy + (frame->origin_y - seg->v1.y) * dx <= 0.0f)
+        return;
+
+    // transform to camera space
+    const float32_t rel1_x = seg->v1.x - frame->origin_x, rel1_y = seg->v1.y - frame->origin_y;
+    const float32_t rel2_x = seg->v2.x - frame->origin_x, rel2_y = seg->v2.y - frame->origin_y;
+    float32_t forward1 = rel1_x * frame->forward_x + rel1_y * frame->forward_y;
+    float32_t right1 = -rel1_x * frame->forward_y + rel1_y * frame->forward_x;
+    float32_t forward2 = rel2_x * frame->forward_x + rel2_y * frame->forward_y;
+    float32_t right2 = -rel2_x * frame->forward_y + rel2_y * frame->forward_x;
+
+    dnf_seg_view sv = {
+        .seg = seg,
+        .p1_forward = forward1,
+        .p1_right = right1,
+        .edge_forward = forward2 - forward1,
+        .edge_right = right2 - right1
+    };
+
+    // clip to the near plane
+    if (forward1 < DNF_BSP_NEAR_PLANE && forward2 < DNF_BSP_NEAR_PLANE)
+        return;
+    if (forward1 < DNF_BSP_NEAR_PLANE)
+    {
+        const float32_t t = (DNF_BSP_NEAR_PLANE - forward1) / (forward2 - forward1);
+        right1 += t * (right2 - right1);
+        forward1 = DNF_BSP_NEAR_PLANE;
+    }
+    else if (forward2 < DNF_BSP_NEAR_PLANE)
+    {
+        const float32_t t = (DNF_BSP_NEAR_PLANE - forward2) / (forward1 - forward2);
+        right2 += t * (right1 - right2);
+        forward2 = DNF_BSP_NEAR_PLANE;
+    }
+
+    // columns whose centers lie within the projected seg
+    int32_t first = (int32_t)ceilf(project_column(band, forward1, right1) - 0.5f);
+    int32_t last = (int32_t)ceilf(project_column(band, forward2, right2) - 0.5f) - 1;
+    if (first < band->x_begin)
+        first = band->x_begin;
+    if (last >= band->x_end)
+        last = band->x_end - 1;
+    if (first > last)
+        return;
+
+    sv.front = &level->sectors[seg->front_sector];
+    sv.back = seg->back_sector != DNF_BSP_NO_SECTOR ? &level->sectors[seg->back_sector] : nullptr;
+
+    // sector light plus a bit of contrast between X and Y aligned walls
+    const float32_t light = (float32_t)sv.front->light / 255.0f;
+    const float32_t contrast = 0.85f + 0.15f * fabsf(dx) / sqrtf(dx * dx + dy * dy);
+    const dnf_palette *palette = band->frame->palette;
+    if (palette)
+    {
+        sv.wall_index = shade_index(palette, level->linedefs[seg->linedef].color, light * contrast);
+        sv.ceiling_index = shade_index(palette, sv.front->ceiling_color, light);
+        sv.floor_index = shade_index(palette, sv.front->floor_color, light);
+    }
+    else
+    {
+        sv.wall_color = shade_color(level->linedefs[seg->linedef].color, light * contrast);
+        sv.ceiling_color = shade_color(sv.front->ceiling_color, light);
+        sv.floor_color = shade_color(sv.front->floor_color, light);
+    }
+
+    const bool8_t solid = !sv.back
+        || sv.back->ceiling_height <= sv.front->floor_height
+        || sv.back->floor_height >= sv.front->ceiling_height;
+    if (solid)
+        clip_solid_wall(band, &sv, first, last);
+    else
+        clip_pass_wall(band, &sv, first, last);
+}
+
+/**
+ * @brief Checks if any part of a bounding box can be visible in the band.
+ */
+static bool8_t check_bbox(const dnf_bsp_band *band, const float32_t bbox[4])
+{
+    const dnf_bsp_frame *frame = band->frame;
+
+    // inside the box - always visible
+    if (frame->origin_x >= bbox[0] && frame->origin_x <= bbox[2]
+        && frame->origin_y >= bbox[1] && frame->origin_y <= bbox[3])
+        return true;
+
+    // box corners in camera space (in polygon order)
+    const float32_t corners[4][2] = {
+        { bbox[0], bbox[1] }, { bbox[2], bbox[1] }, { bbox[2], bbox[3] }, { bbox[0], bbox[3] }
+    };
+    float32_t forward[4], right[4];
+    for (int32_t i = 0; i < 4; i++)
+    {
+        const float32_t rel_x = corners[i][0] - frame->origin_x;
+        const float32_t rel_y = corners[i][1] - frame->origin_y;
+        forward[i] = rel_x * frame->forward_x + rel_y * frame->forward_y;
+        right[i] = -rel_x * frame->forward_y + rel_y * frame->forward_x;
+    }
+
+    // clip the box outline to the near plane and find its column span
+    float32_t min_column = INFINITY, max_column = -INFINITY;
+    for (int32_t i = 0; i < 4; i++)
+    {
+        const int32_t j = (i + 1) % 4;
+        if (forward[i] >= DNF_BSP_NEAR_PLANE)
+        {
+            const float32_t column = project_column(band, forward[i], right[i]);
+            min_column = fminf(min_column, column);
+            max_column = fmaxf(max_column, column);
+        }
+        if ((forward[i] < DNF_BSP_NEAR_PLANE) != (forward[j] < DNF_BSP_NEAR_PLANE))
+        {
+            const float32_t t = (DNF_BSP_NEAR_PLANE - forward[i]) / (forward[j] - forward[i]);
+            const float32_t column = project_column(band, DNF_BSP_NEAR_PLANE, right[i] + t * (right[j] - right[i]));
+            min_column = fminf(min_column, column);
+            max_column = fmaxf(max_column, column);
+        }
+    }
+    if (min_column > max_column)
+        return false;  // entirely behind the camera
+
+    int32_t first = (int32_t)floorf(min_column);
+    int32_t last = (int32_t)ceilf(max_column);
+    if (first < band->x_begin)
+        first = band->x_begin;
+    if (last >= band->x_end)
+        last = band->x_end - 1;
+    if (first > last)
+        return false;
+
+    // hidden if a single occluded range covers the whole span
+    const dnf_clip_range *range = band->solid;
+    while (range->last < last)
+        range++;
+    return !(first >= range->first && last <= range->last);
+}
+
+/**
+ * @brief Renders a subtree front to back.
+ *
+ * @return False if the band is fully covered and the traversal should stop.
+ */
+static bool8_t render_node(dnf_bsp_band *band, const uint32_t child)
+{
+    const dnf_bsp_frame *frame = band->frame;
+    const dnf_bsp_level *level = frame->level;
+
+    if (frame->visible_subsectors)
+    {
+        const bool8_t visible = child & DNF_BSP_SUBSECTOR_BIT
+            ? pvs_is_visible(frame->visible_subsectors, child & ~DNF_BSP_SUBSECTOR_BIT)
+            : pvs_is_visible(frame->visible_nodes, child);
+        if (!visible)
+            return true;
+    }
+
+    if (child & DNF_BSP_SUBSECTOR_BIT)
+    {
+        const dnf_subsector *subsector = &level->subsectors[child & ~DNF_BSP_SUBSECTOR_BIT];
+        for (uint32_t i = 0; i < subsector->seg_count; i++)
+            render_seg(band, &level->segs[subsector->first_seg + i]);
+
+        // a single range left means the sentinels have merged
+        return band->solid_count > 1;
+    }
+
+    const dnf_bsp_node *node = &level->nodes[child];
+    const uint32_t side = node_point_side(node, frame->origin_x, frame->origin_y);
+
+    if (!render_node(band, node->children[side]))
+        return false;
+    if (check_bbox(band, node->bbox[side ^ 1]))
+        return render_node(band, node->children[side ^ 1]);
+    return true;
+}
+
+/**
+ * @brief Renders a band of columns (see renderer_draw_bands()).
+ *
+ * @param user_data Pointer to dnf_bsp_frame.
+ */
+static void bsp_render_band(const dnf_framebuffer *fb, const int32_t x_begin, const int32_t x_end, void *user_data)
+{
+    const dnf_bsp_frame *frame = user_data;
+
+    for (int32_t col = x_begin; col < x_end; col++)
+    {
+        frame->ceiling_clip[col] = -1;
+        frame->floor_clip[col] = fb->height;
+        frame->view->depth[col] = INFINITY;
+    }
+
+    // the band owns 3 ranges per column, enough for the worst case
+    // (alternating visible/occluded columns) plus the two sentinels
+    dnf_bsp_band band = {
+        .frame = frame,
+        .fb = fb,
+        .x_begin = x_begin,
+        .x_end = x_end,
+        .solid = frame->ranges + 3 * x_begin,
+        .solid_count = 2
+    };
+    band.solid[0] = (dnf_clip_range){ INT32_MIN + 1, x_begin - 1 };
+    band.solid[1] = (dnf_clip_range){ x_end, INT32_MAX - 1 };
+
+    render_node(&band, frame->level->root);
+}
+
+/**
+ * @brief Gets the size of the PVS sets of a frame (see mark_visible_nodes()).
+ *
+ * @return Size in bytes, 0 if the level isn't culled.
+ */
+static size_t visible_sets_size(const dnf_bsp_level *level)
+{
+    if (!level->pvs || level->pvs->cluster_count != level->subsector_count)
+        return 0;
+    return level->pvs->row_bytes + (level->node_count + 7) / 8;
+}
+
+/**
+ * @brief Decompresses the PVS of the camera's subsector and marks the nodes
+ * that have a potentially visible subsector below them.
+ *
+ * The sets live in the scratch buffers of the context and are only made
+ * again when the camera enters another subsector. Nodes are stored before
+ * their children, so walking them backwards visits the children first.
+ * Without memory for the sets the frame isn't culled.
+ */
+static void mark_visible_nodes(
+    dnf_bsp_scratch *scratch,
+    const dnf_bsp_level *level,
+    const dnf_camera *camera,
+    dnf_bsp_frame *frame)
+{
+    const dnf_pvs *pvs = level->pvs;
+    const size_t size = visible_sets_size(level);
+    const uint32_t subsector = bsp_point_subsector(level, camera->x, camera->y);
+    if (scratch->visible_level != level || scratch->visible_pvs != pvs
+        || scratch->visible_level_serial != level_serial || scratch->visible_subsector != subsector)
+    {
+        // bands of earlier frames may still read the sets
+        job_system_wait();
+        scratch->visible_level = nullptr;
+        if (size > scratch->visible_sets_capacity)
+        {
+            uint8_t *sets = dnf_realloc(scratch->visible_sets, size, DNF_MEMORY_TAG_RENDERER);
+            if (!sets)
+            {
+                DNF_ERROR("Failed to allocate BSP visibility sets, drawing the level unculled");
+                return;
+            }
+            scratch->visible_sets = sets;
+            scratch->visible_sets_capacity = size;
+        }
+
+        uint8_t *visible = scratch->visible_sets;
+        uint8_t *nodes = visible + pvs->row_bytes;
+        memset(visible, 0, size);
+        pvs_decompress(pvs, subsector, visible);
+        for (uint32_t i = level->node_count; i-- > 0;)
+        {
+            const dnf_bsp_node *node = &level->nodes[i];
+            for (uint32_t side = 0; side < 2; side++)
+            {
+                const uint32_t child = node->children[side];
+                const bool8_t child_visible = child & DNF_BSP_SUBSECTOR_BIT
+                    ? pvs_is_visible(visible, child & ~DNF_BSP_SUBSECTOR_BIT)
+                    : pvs_is_visible(nodes, child);
+                if (child_visible)
+                    nodes[i >> 3] |= (uint8_t)(1u << (i & 7));
+            }
+        }
+        scratch->visible_level = level;
+        scratch->visible_pvs = pvs;
+        scratch->visible_level_serial = level_serial;
+        scratch->visible_subsector = subsector;
+    }
+
+    frame->visible_subsectors = scratch->visible_sets;
+    frame->visible_nodes = scratch->visible_sets + pvs->row_bytes;
+}
+
+void bsp_render(
+    const renderer_context *ctx,
+    const dnf_bsp_level *level,
+    const dnf_camera *camera)
+{
+    dnf_bsp_scratch *scratch = ctx->bsp_scratch;
+    const int32_t width = ctx->framebuffers[ctx->back_buffer].width;
+    if (width > scratch->width)
+    {
+        // earlier passes may still use the old buffers
+        job_system_wait();
+
+        int32_t *clips = dnf_realloc(scratch->clips, 2 * width * sizeof(int32_t), DNF_MEMORY_TAG_RENDERER);
+        if (!clips)
+        {
+            DNF_ERROR("Failed to allocate BSP clip buffers");
+            return;
+        }
+        scratch->clips = clips;
+
+        dnf_clip_range *ranges = dnf_realloc(scratch->ranges, 3 * width * sizeof(dnf_clip_range), DNF_MEMORY_TAG_RENDERER);
+        if (!ranges)
+        {
+            DNF_ERROR("Failed to allocate BSP occlusion buffers");
+            return;
+        }
+        scratch->ranges = ranges;
+        scratch->width = width;
+    }
+
+    // bands may run after we return (pipelined contexts)
+    dnf_bsp_frame *frame = renderer_alloc_pass_data(ctx, sizeof(dnf_bsp_frame));
+    if (!frame)
+        return;
+
+    *frame = (dnf_bsp_frame){
+        .level = level,
+        .view = &ctx->view,
+        .origin_x = camera->x,
+        .origin_y = camera->y,
+        .origin_z = camera->z,
+        .forward_x = cosf(camera->angle),
+        .forward_y = sinf(camera->angle),
+        .ceiling_clip = scratch->clips,
+        .floor_clip = scratch->clips + width,
+        .ranges = scratch->ranges,
+        .palette = ctx->palette
+    };
+
+    if (visible_sets_size(level) > 0)
+        mark_visible_nodes(scratch, level, camera, frame);
+
+    renderer_draw_bands(ctx, bsp_render_band, frame);
+}
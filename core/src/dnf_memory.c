@@ -0,0 +1,264 @@
+// DNF (Doomed and Forgotten): a DOOM-style first-person shooter.
+// Copyright (C) 2025-2026  Alexandr Gorbatenko
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+
+#include "dnf_memory.h"
+
+#include "dnf_assertions.h"
+#include "logger.h"
+
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Alignment of arena and pool allocations (and of the tagged allocator).
+#define DNF_MEMORY_ALIGNMENT 16
+// Space in front of every tagged allocation (keeps the memory aligned).
+#define DNF_MEMORY_HEADER_SIZE 16
+
+
+/**
+ * @brief Bookkeeping stored in front of every tagged allocation.
+ */
+typedef struct dnf_memory_header
+{
+    size_t size;         //!< Size requested by the caller
+    dnf_memory_tag tag;  //!< Tag the size is accounted to
+} dnf_memory_header;
+
+STATIC_ASSERT(sizeof(dnf_memory_header) <= DNF_MEMORY_HEADER_SIZE, "Memory header doesn't fit in front of the allocation");
+
+static const char *tag_names[DNF_MEMORY_TAG_COUNT] = {
+    "unknown",
+    "engine",
+    "renderer",
+    "textures",
+    "level",
+    "entities",
+    "arena",
+    "game",
+};
+
+// Bytes and allocations in use per tag (updated from any thread).
+static atomic_size_t tag_bytes[DNF_MEMORY_TAG_COUNT];
+static atomic_size_t tag_allocations[DNF_MEMORY_TAG_COUNT];
+
+
+/**
+ * @brief Gets the header of a tagged allocation.
+ *
+ * @param block Memory from dnf_alloc().
+ * @return Header.
+ */
+static dnf_memory_header *header_of(void *block)
+{
+    return (dnf_memory_header *)((uint8_t *)block - DNF_MEMORY_HEADER_SIZE);
+}
+
+/**
+ * @brief Rounds a size up to a multiple of a power of two.
+ *
+ * @param size Size.
+ * @param alignment Power of two.
+ * @return Rounded size.
+ */
+static size_t align_up(size_t size, size_t alignment)
+{
+    return (size + alignment - 1) & ~(alignment - 1);
+}
+
+
+void *dnf_alloc(size_t size, dnf_memory_tag tag)
+{
+    if (tag >= DNF_MEMORY_TAG_COUNT)
+        tag = DNF_MEMORY_TAG_UNKNOWN;
+    if (size > SIZE_MAX - DNF_MEMORY_HEADER_SIZE)
+        return nullptr;
+
+    uint8_t *memory = calloc(1, DNF_MEMORY_HEADER_SIZE + size);
+    if (!memory)
+    {
+        DNF_ERROR("Failed to allocate %zu bytes (%s)", size, tag_names[tag]);
+        return nullptr;
+    }
+
+    dnf_memory_header *header = (dnf_memory_header *)memory;
+    header->size = size;
+    header->tag = tag;
+    atomic_fetch_add_explicit(&tag_bytes[tag], size, memory_order_relaxed);
+    atomic_fetch_add_explicit(&tag_allocations[tag], 1, memory_order_relaxed);
+    return memory + DNF_MEMORY_HEADER_SIZE;
+}
+
+void *dnf_realloc(void *block, size_t size, dnf_memory_tag tag)
+{
+    if (!block)
+        return dnf_alloc(size, tag);
+    if (size > SIZE_MAX - DNF_MEMORY_HEADER_SIZE)
+        return nullptr;
+
+    const dnf_memory_header old_header = *header_of(block);
+    uint8_t *memory = realloc(header_of(block), DNF_MEMORY_HEADER_SIZE + size);
+    if (!memory)
+    {
+        DNF_ERROR("Failed to reallocate %zu bytes (%s)", size, tag_names[old_header.tag]);
+        return nullptr;
+    }
+
+    // the block moves to the new tag along with its bytes
+    if (tag >= DNF_MEMORY_TAG_COUNT)
+        tag = old_header.tag;
+    dnf_memory_header *header = (dnf_memory_header *)memory;
+    header->size = size;
+    header->tag = tag;
+    atomic_fetch_sub_explicit(&tag_bytes[old_header.tag], old_header.size, memory_order_relaxed);
+    atomic_fetch_add_explicit(&tag_bytes[tag], size, memory_order_relaxed);
+    if (tag != old_header.tag)
+    {
+        atomic_fetch_sub_explicit(&tag_allocations[old_header.tag], 1, memory_order_relaxed);
+        atomic_fetch_add_explicit(&tag_allocations[tag], 1, memory_order_relaxed);
+    }
+    return memory + DNF_MEMORY_HEADER_SIZE;
+}
+
+void dnf_free(void *block)
+{
+    if (!block)
+        return;
+
+    dnf_memory_header *header = header_of(block);
+    atomic_fetch_sub_explicit(&tag_bytes[header->tag], header->size, memory_order_relaxed);
+    atomic_fetch_sub_explicit(&tag_allocations[header->tag], 1, memory_order_relaxed);
+    free(header);
+}
+
+size_t dnf_memory_usage(dnf_memory_tag tag)
+{
+    if (tag >= DNF_MEMORY_TAG_COUNT)
+        return 0;
+    return atomic_load_explicit(&tag_bytes[tag], memory_order_relaxed);
+}
+
+const char *dnf_memory_tag_name(dnf_memory_tag tag)
+{
+    return tag < DNF_MEMORY_TAG_COUNT ? tag_names[tag] : "?";
+}
+
+void dnf_memory_log_usage(void)
+{
+    size_t total = 0;
+    for (uint32_t tag = 0; tag < DNF_MEMORY_TAG_COUNT; tag++)
+    {
+        const size_t bytes = atomic_load_explicit(&tag_bytes[tag], memory_order_relaxed);
+        const size_t allocations = atomic_load_explicit(&tag_allocations[tag], memory_order_relaxed);
+        total += bytes;
+        if (allocations > 0)
+            DNF_INFO("Memory %-9s %10zu bytes in %zu allocation(s)", tag_names[tag], bytes, allocations);
+    }
+    DNF_INFO("Memory total     %10zu bytes", total);
+}
+
+
+bool8_t arena_init(dnf_arena *arena, size_t capacity, dnf_memory_tag tag)
+{
+    *arena = (dnf_arena){0};
+    arena->base = dnf_alloc(capacity, tag);
+    if (!arena->base)
+        return false;
+    arena->capacity = capacity;
+    return true;
+}
+
+void arena_shutdown(dnf_arena *arena)
+{
+    dnf_free(arena->base);
+    *arena = (dnf_arena){0};
+}
+
+void *arena_alloc(dnf_arena *arena, size_t size, size_t alignment)
+{
+    if (alignment == 0)
+        alignment = DNF_MEMORY_ALIGNMENT;
+
+    // the base is 16-byte aligned, bigger alignments are done on the address
+    const uintptr_t address = (uintptr_t)(arena->base + arena->used);
+    const size_t offset = arena->used + (align_up(address, alignment) - address);
+    if (offset > arena->capacity || size > arena->capacity - offset)
+        return nullptr;
+
+    arena->used = offset + size;
+    if (arena->used > arena->peak)
+        arena->peak = arena->used;
+    return arena->base + offset;
+}
+
+void arena_reset(dnf_arena *arena)
+{
+    arena->used = 0;
+}
+
+
+bool8_t pool_init(dnf_pool *pool, size_t block_size, uint32_t capacity, dnf_memory_tag tag)
+{
+    *pool = (dnf_pool){0};
+
+    // a free block holds the index of the next free block
+    block_size = align_up(block_size < sizeof(uint32_t) ? sizeof(uint32_t) : block_size, DNF_MEMORY_ALIGNMENT);
+    if (capacity == 0 || block_size > SIZE_MAX / capacity)
+        return false;
+
+    pool->blocks = dnf_alloc(block_size * capacity, tag);
+    if (!pool->blocks)
+        return false;
+    pool->block_size = block_size;
+    pool->capacity = capacity;
+
+    for (uint32_t i = 0; i < capacity; i++)
+        *(uint32_t *)(pool->blocks + i * block_size) = i + 1;
+    pool->free_head = 0;
+    return true;
+}
+
+void pool_shutdown(dnf_pool *pool)
+{
+    dnf_free(pool->blocks);
+    *pool = (dnf_pool){0};
+}
+
+void *pool_alloc(dnf_pool *pool)
+{
+    if (pool->free_head >= pool->capacity)
+        return nullptr;
+
+    uint8_t *block = pool->blocks + (size_t)pool->free_head * pool->block_size;
+    pool->free_head = *(uint32_t *)block;
+    pool->used++;
+    memset(block, 0, pool->block_size);
+    return block;
+}
+
+void pool_free(dnf_pool *pool, void *block)
+{
+    if (!block)
+        return;
+
+    const size_t offset = (size_t)((uint8_t *)block - pool->blocks);
+    DNF_ASSERT_MSG(offset < pool->block_size * pool->capacity && offset % pool->block_size == 0, "Block isn't from this pool");
+
+    *(uint32_t *)block = pool->free_head;
+    pool->free_head = (uint32_t)(offset / pool->block_size);
+    pool->used--;
+}
@@ -0,0 +1,90 @@
+// DNF (Doomed and Forgotten): a DOOM-style first-person shooter.
+// Copyright (C) 2025-2026  Alexandr Gorbatenko
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+#include "dynamic_resolution.h"
+
+#include <math.h>  // sqrt, round
+
+
+// Frames measured at a new scale before the governor may change it again.
+#define DNF_DYNAMIC_RESOLUTION_SETTLE_FRAMES 30
+// Weight of the latest frame in the smoothed render time.
+#define DNF_DYNAMIC_RESOLUTION_SMOOTHING 0.1
+// The scale goes down once the smoothed time is this far over the target...
+#define DNF_DYNAMIC_RESOLUTION_OVER 1.05
+// ...and up once it is this far under it (the gap keeps it from oscillating).
+#define DNF_DYNAMIC_RESOLUTION_UNDER 0.8
+// Scales are multiples of this (every change reallocates the framebuffers).
+#define DNF_DYNAMIC_RESOLUTION_STEP 0.05
+// Most the scale grows by in one change (dropping is not limited: a slow
+// frame rate is worse than a blurry image).
+#define DNF_DYNAMIC_RESOLUTION_MAX_GROWTH 1.15
+
+
+/**
+ * @brief Clamps a scale to the range of a governor.
+ */
+static float64_t clamp_scale(const dnf_dynamic_resolution *governor, const float64_t scale)
+{
+    if (scale < governor->min_scale)
+        return governor->min_scale;
+    if (scale > governor->max_scale)
+        return governor->max_scale;
+    return scale;
+}
+
+void dynamic_resolution_init(
+    dnf_dynamic_resolution *governor,
+    const float32_t target_ms,
+    const float32_t scale,
+    const float32_t min_scale,
+    const float32_t max_scale)
+{
+    *governor = (dnf_dynamic_resolution){
+        .target_ms = target_ms,
+        .min_scale = min_scale,
+        .max_scale = max_scale,
+        .scale = scale,
+        .average_ms = 0.0,
+        .samples = 0
+    };
+    governor->scale = (float32_t)clamp_scale(governor, scale);
+}
+
+bool8_t dynamic_resolution_update(dnf_dynamic_resolution *governor, const float64_t render_ms)
+{
+    governor->average_ms = governor->samples == 0
+        ? render_ms
+        : governor->average_ms + (render_ms - governor->average_ms) * DNF_DYNAMIC_RESOLUTION_SMOOTHING;
+    governor->samples++;
+
+    if (governor->samples < DNF_DYNAMIC_RESOLUTION_SETTLE_FRAMES || governor->average_ms <= 0.0)
+        return false;
+    if (governor->average_ms <= governor->target_ms * DNF_DYNAMIC_RESOLUTION_OVER
+        && governor->average_ms >= governor->target_ms * DNF_DYNAMIC_RESOLUTION_UNDER)
+        return false;
+
+    // the pixel count (and the time) goes with the square of the scale
+    float64_t scale = governor->scale * sqrt(governor->target_ms / governor->average_ms);
+    if (scale > governor->scale * DNF_DYNAMIC_RESOLUTION_MAX_GROWTH)
+        scale = governor->scale * DNF_DYNAMIC_RESOLUTION_MAX_GROWTH;
+    scale = clamp_scale(governor, round(scale / DNF_DYNAMIC_RESOLUTION_STEP) * DNF_DYNAMIC_RESOLUTION_STEP);
+    if (fabs(scale - governor->scale) < DNF_DYNAMIC_RESOLUTION_STEP * 0.5)
+        return false;
+
+    governor->scale = (float32_t)scale;
+    governor->samples = 0;
+    return true;
+}
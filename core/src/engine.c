@@ -17,16 +17,77 @@
 
 #include "engine.h"
 
+#include "asset_loader.h"
+#include "dnf_clock.h"
+#include "dnf_memory.h"
+#include "dynamic_resolution.h"
 #include "input_system.h"
+#include "job_system.h"
 #include "logger.h"
+#include "pixels.h"
 #include "renderer.h"
 
 #include <raylib.h>
 
+#include <math.h>   // fmod, lroundf
+#include <stdio.h>  // frame dump file names
+
+// Frame time used by headless runs without a configured fixed_dt.
+#define DNF_ENGINE_HEADLESS_DT (1.0f / 60.0f)
+// Longest frame time fed to the tick accumulator (e.g. after a debugger break).
+#define DNF_ENGINE_MAX_FRAME_DT 0.25
+// Lowest render scale the dynamic resolution goes down to.
+#define DNF_ENGINE_MIN_RENDER_SCALE 0.25f
+
 
 static game *dnf_game_instance;  // a "singleton" game instance pointer
 static bool8_t dnf_engine_is_running = false;  // is the engine running
 static bool8_t dnf_engine_initialized = false;  // flag to prevent re-initialization
+static bool8_t dnf_engine_headless = false;  // running without a window
+static dnf_frame_timings dnf_last_frame_timings;  // stage timings of the last frame
+static dnf_dynamic_resolution dnf_resolution_governor;  // render scale picker (dynamic resolution only)
+static dnf_arena dnf_frame_arena;  // scratch memory of the current frame
+static dnf_pool dnf_projectile_pool;  // projectiles of the game
+
+
+/**
+ * @brief Gets the rendered image size for a render scale.
+ *
+ * @param config Engine config.
+ * @param scale Render scale.
+ * @param out_width Resulting image width.
+ * @param out_height Resulting image height.
+ */
+static void scaled_size(
+    const dnf_engine_config *config,
+    const float32_t scale,
+    int32_t *out_width,
+    int32_t *out_height)
+{
+    *out_width = (int32_t)lroundf((float32_t)config->start_width * scale);
+    *out_height = (int32_t)lroundf((float32_t)config->start_height * scale);
+    if (*out_width < 1)
+        *out_width = 1;
+    if (*out_height < 1)
+        *out_height = 1;
+}
+
+/**
+ * @brief Refits the rendered image into the window (or the start size when
+ * headless).
+ */
+static void fit_to_window(void)
+{
+    if (dnf_engine_headless)
+        renderer_resize_window(
+            dnf_game_instance->renderer_context,
+            dnf_game_instance->engine_config->start_width,
+            dnf_game_instance->engine_config->start_height);
+    else
+        renderer_resize_window(
+            dnf_game_instance->renderer_context,
+            GetScreenWidth(), GetScreenHeight());
+}
 
 
 bool8_t engine_init(game *game_instance)
@@ -41,29 +102,104 @@ bool8_t engine_init(game *game_instance)
     dnf_game_instance = game_instance;
 
     // Initialize engine systems
-    if (dnf_logger_init())
+    if (dnf_logger_init(
+        game_instance->engine_config->async_logging,
+        game_instance->engine_config->log_format))
         DNF_INFO("Logger initialized");
+    if (game_instance->engine_config->log_levels
+        && !dnf_logger_set_levels(game_instance->engine_config->log_levels))
+        DNF_WARN("Invalid log levels \"%s\"", game_instance->engine_config->log_levels);
+
 
+    dnf_engine_headless = game_instance->engine_config->backend == DNF_RENDERER_BACKEND_HEADLESS;
 
     // Initialize window and create OpenGL context
-    InitWindow(
-        game_instance->engine_config->start_width,
-        game_instance->engine_config->start_height,
-        game_instance->engine_config->title);
-    SetTargetFPS(60);  // TODO: add FPS settings
+    if (!dnf_engine_headless)
+    {
+        InitWindow(
+            game_instance->engine_config->start_width,
+            game_instance->engine_config->start_height,
+            game_instance->engine_config->title);
+        SetTargetFPS((int32_t)game_instance->engine_config->target_fps);  // 0 - uncapped
+    }
+    else
+        DNF_INFO("Running headless, no window will be created");
+
+    // create the frame dump directory
+    const dnf_engine_config *config = game_instance->engine_config;
+    if (config->dump_interval > 0 && config->dump_dir && !DirectoryExists(config->dump_dir))
+        if (MakeDirectory(config->dump_dir) != 0)
+            DNF_WARN("Could not create frame dump directory %s", config->dump_dir);
+
+    DNF_INFO("Initializing job system");
+    if (job_system_init(game_instance->engine_config->worker_threads))
+        DNF_INFO("Job system initialized");
+
+    DNF_INFO("Initializing asset loader");
+    if (asset_loader_init())
+        DNF_INFO("Asset loader initialized");
+
+    const dnf_pixel_isa pixel_isa = pixels_init(config->pixel_isa);
+    if (config->pixel_isa != DNF_PIXEL_ISA_AUTO && pixel_isa != config->pixel_isa)
+        DNF_WARN("Pixel kernels: %s is not supported by this CPU", pixels_isa_name(config->pixel_isa));
+    DNF_INFO("Pixel kernels: %s", pixels_isa_name(pixel_isa));
+
+    // render smaller (or bigger) and stretch to the window
+    const float32_t render_scale = config->render_scale > 0.0f ? config->render_scale : 1.0f;
+    int32_t render_width, render_height;
+    scaled_size(config, render_scale, &render_width, &render_height);
+    if (config->dynamic_resolution_ms > 0.0f)
+    {
+        dynamic_resolution_init(
+            &dnf_resolution_governor, config->dynamic_resolution_ms, render_scale,
+            DNF_ENGINE_MIN_RENDER_SCALE, render_scale > 1.0f ? render_scale : 1.0f);
+        DNF_INFO("Dynamic resolution: holding %.2f ms of render time per frame", config->dynamic_resolution_ms);
+    }
 
     DNF_INFO("Initializing renderer");
-    if (renderer_init(
+    if (!renderer_init(
         game_instance->renderer_context,
-        game_instance->engine_config->start_width,
-        game_instance->engine_config->start_height))
-        DNF_INFO("Renderer initialized");
-    SetWindowState(FLAG_WINDOW_RESIZABLE);
+        render_width,
+        render_height,
+        game_instance->engine_config->framebuffers,
+        game_instance->engine_config->backend,
+        game_instance->engine_config->column_major,
+        game_instance->engine_config->render_format))
+    {
+        DNF_FATAL("Failed to initialize the renderer");
+        return false;
+    }
+    DNF_INFO("Renderer initialized");
+    if (!dnf_engine_headless)
+        SetWindowState(FLAG_WINDOW_RESIZABLE);
 
     DNF_INFO("Initializing input system");
     if (input_handler_init(game_instance->input_handler))
         DNF_INFO("Input system initialized");
 
+    const size_t frame_arena_size = config->frame_arena_size > 0
+        ? config->frame_arena_size
+        : DNF_ENGINE_DEFAULT_FRAME_ARENA_SIZE;
+    if (!arena_init(&dnf_frame_arena, frame_arena_size, DNF_MEMORY_TAG_ARENA))
+    {
+        DNF_FATAL("Failed to allocate the frame arena (%zu bytes)", frame_arena_size);
+        return false;
+    }
+    game_instance->frame_arena = &dnf_frame_arena;
+
+    if (config->projectile_size > 0)
+    {
+        const uint32_t max_projectiles = config->max_projectiles > 0
+            ? config->max_projectiles
+            : DNF_ENGINE_DEFAULT_MAX_PROJECTILES;
+        if (!pool_init(&dnf_projectile_pool, config->projectile_size, max_projectiles, DNF_MEMORY_TAG_ENTITIES))
+        {
+            DNF_FATAL("Failed to allocate the projectile pool (%u of %zu bytes)", max_projectiles, config->projectile_size);
+            return false;
+        }
+        game_instance->projectile_pool = &dnf_projectile_pool;
+    }
+
 
     // All subsystems are running
     dnf_engine_is_running = true;
@@ -74,9 +210,8 @@ bool8_t engine_init(game *game_instance)
         DNF_FATAL("Failed to initialize the game");
         return false;
     }
-    renderer_resize_window(
-        dnf_game_instance->renderer_context,
-        GetScreenWidth(), GetScreenHeight());
+    fit_to_window();
+    dnf_memory_log_usage();
 
     // Prevent re-initialization after initializing everything else
     dnf_engine_initialized = true;
@@ -86,40 +221,181 @@ bool8_t engine_init(game *game_instance)
 
 bool8_t engine_run(void)
 {
+    const dnf_engine_config *config = dnf_game_instance->engine_config;
+
+    // headless runs are deterministic: a fixed dt unless told otherwise
+    float32_t fixed_dt = config->fixed_dt;
+    if (dnf_engine_headless && fixed_dt <= 0.0f)
+        fixed_dt = DNF_ENGINE_HEADLESS_DT;
+
+    // the simulation runs at a fixed rate, independent of the frame rate
+    const uint32_t tick_rate = config->tick_rate > 0 ? config->tick_rate : DNF_ENGINE_DEFAULT_TICK_RATE;
+    const uint32_t max_ticks = config->max_ticks > 0 ? config->max_ticks : DNF_ENGINE_DEFAULT_MAX_TICKS;
+    const float64_t tick_dt = 1.0 / tick_rate;
+    const float64_t asset_budget_ms = config->asset_budget_ms > 0.0f
+        ? config->asset_budget_ms
+        : DNF_ENGINE_DEFAULT_ASSET_BUDGET_MS;
+    float64_t accumulator = 0.0;
+    uint64_t dropped_ticks = 0;
+
+    uint32_t frame = 0;
+    const uint64_t run_start = dnf_clock_now_ns();
+    uint64_t previous_frame_start = run_start;
+    renderer_context *render_ctx = dnf_game_instance->renderer_context;
+
     while (dnf_engine_is_running)
     {
-        if (WindowShouldClose())
-            dnf_engine_is_running = false;
+        const uint64_t frame_start = dnf_clock_now_ns();
+        render_ctx->stats = (dnf_renderer_stats){0};
+        arena_reset(&dnf_frame_arena);
+
+        if (!dnf_engine_headless)
+        {
+            if (WindowShouldClose())
+                dnf_engine_is_running = false;
+
+            if (IsWindowResized())
+                fit_to_window();
+        }
 
-        if (IsWindowResized())
-            renderer_resize_window(
-                dnf_game_instance->renderer_context,
-                GetScreenWidth(), GetScreenHeight());
+        float64_t frame_dt = fixed_dt > 0.0f
+            ? fixed_dt
+            : (float64_t)(frame_start - previous_frame_start) * 1e-9;
+        previous_frame_start = frame_start;
+        if (frame_dt > DNF_ENGINE_MAX_FRAME_DT)
+            frame_dt = DNF_ENGINE_MAX_FRAME_DT;
+        accumulator += frame_dt;
 
-        float32_t dt = GetFrameTime();
+        input_handler_poll();
 
-        if (!dnf_game_instance->update(dnf_game_instance, dt))
+        // loaded assets become visible to the game before its ticks
+        asset_loader_finish(asset_budget_ms);
+
+        uint32_t ticks = 0;
+        bool8_t update_failed = false;
+        while (accumulator >= tick_dt && ticks < max_ticks)
+        {
+            if (!dnf_game_instance->update(dnf_game_instance, (float32_t)tick_dt))
+            {
+                update_failed = true;
+                break;
+            }
+            input_handler_end_tick();
+            accumulator -= tick_dt;
+            ticks++;
+        }
+        if (update_failed)
         {
             DNF_FATAL("Game update failed! Exiting...");
             dnf_engine_is_running = false;
             break;
         }
 
-        if (!dnf_game_instance->render(dnf_game_instance, dt))
+        // can't keep up: drop the backlog instead of falling further behind
+        if (accumulator >= tick_dt)
+        {
+            dropped_ticks += (uint64_t)(accumulator / tick_dt);
+            accumulator = fmod(accumulator, tick_dt);
+        }
+        const uint64_t update_end = dnf_clock_now_ns();
+
+        // how far between the last two ticks this frame is
+        const float32_t alpha = (float32_t)(accumulator / tick_dt);
+
+        if (!dnf_game_instance->render(dnf_game_instance, alpha))
         {
             DNF_ERROR("Frame rendering failed! Exiting...");
             dnf_engine_is_running = false;
             break;
         }
+        const uint64_t render_end = dnf_clock_now_ns();
+
+        // upload and present happen inside the game's render callback
+        const uint64_t upload_ns = render_ctx->stats.upload_ns;
+        const uint64_t present_ns = render_ctx->stats.present_ns;
+        dnf_last_frame_timings = (dnf_frame_timings){
+            .update_ms = (float64_t)(update_end - frame_start) * 1e-6,
+            .render_ms = (float64_t)(render_end - update_end - upload_ns - present_ns) * 1e-6,
+            .upload_ms = (float64_t)upload_ns * 1e-6,
+            .present_ms = (float64_t)present_ns * 1e-6,
+            .frame_ms = (float64_t)(render_end - frame_start) * 1e-6,
+            .ticks = ticks
+        };
+
+        DNF_TRACE(
+            "Frame %u: %u tick(s), update %.3f ms, render %.3f ms, upload %.3f ms, present %.3f ms",
+            frame, ticks, dnf_last_frame_timings.update_ms, dnf_last_frame_timings.render_ms,
+            dnf_last_frame_timings.upload_ms, dnf_last_frame_timings.present_ms);
+
+        frame++;
+
+        // the frame is complete after the game's render (buffers swapped)
+        if (config->dump_interval > 0 && frame % config->dump_interval == 0)
+        {
+            char filename[512];
+            snprintf(filename, sizeof(filename), "%s/frame_%06u.png",
+                config->dump_dir ? config->dump_dir : ".", frame);
+            renderer_dump_frame(dnf_game_instance->renderer_context, filename);
+        }
+
+        if (config->frame_limit > 0 && frame >= config->frame_limit)
+            dnf_engine_is_running = false;
+
+        // the buffers are idle between frames, a good time to reallocate them
+        if (config->dynamic_resolution_ms > 0.0f
+            && dynamic_resolution_update(&dnf_resolution_governor, dnf_last_frame_timings.render_ms))
+        {
+            int32_t render_width, render_height;
+            scaled_size(config, dnf_resolution_governor.scale, &render_width, &render_height);
+            DNF_INFO(
+                "Render scale %.2f (%dx%d): render time %.2f ms, target %.2f ms",
+                dnf_resolution_governor.scale, render_width, render_height,
+                dnf_resolution_governor.average_ms, config->dynamic_resolution_ms);
+            if (!renderer_resize_target(render_ctx, render_width, render_height))
+            {
+                DNF_ERROR("Failed to resize the render target! Exiting...");
+                dnf_engine_is_running = false;
+                break;
+            }
+            fit_to_window();
+        }
     }
 
+    const float64_t run_time = (float64_t)(dnf_clock_now_ns() - run_start) * 1e-9;
+    if (frame > 0)
+        DNF_INFO(
+            "Ran %u frames in %.3f s (%.3f ms/frame, %.1f FPS)",
+            frame, run_time, run_time * 1000.0 / frame, frame / run_time);
+    if (dropped_ticks > 0)
+        DNF_WARN("Dropped %llu simulation tick(s) to keep up", (unsigned long long)dropped_ticks);
+    DNF_INFO("Frame arena: %zu of %zu bytes used at peak", dnf_frame_arena.peak, dnf_frame_arena.capacity);
+
 
     // Shutdown all systems
+    input_handler_shutdown();
+    asset_loader_shutdown();  // finish functions may still use the renderer
+    if (dnf_game_instance->shutdown)
+        dnf_game_instance->shutdown(dnf_game_instance);
     renderer_shutdown(dnf_game_instance->renderer_context);
+    arena_shutdown(&dnf_frame_arena);
+    dnf_game_instance->frame_arena = nullptr;
+    pool_shutdown(&dnf_projectile_pool);
+    dnf_game_instance->projectile_pool = nullptr;
+    job_system_shutdown();
     // explicitly tell the window to close
-    CloseWindow();
+    if (!dnf_engine_headless)
+        CloseWindow();
 
+    dnf_memory_log_usage();
     dnf_logger_shutdown();
 
+    // allow running the engine again
+    dnf_engine_initialized = false;
+
     return true;
 }
+
+dnf_frame_timings engine_get_frame_timings(void)
+{
+    return dnf_last_frame_timings;
+}
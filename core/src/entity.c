@@ -0,0 +1,399 @@
+// DNF (Doomed and Forgotten): a DOOM-style first-person shooter.
+// Copyright (C) 2025-2026  Alexandr Gorbatenko
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+
+#include "entity.h"
+
+#include "blockmap.h"
+#include "logger.h"
+#include "pvs.h"
+
+#include <math.h>  // sqrtf
+
+// Alignment of the component arrays (a cache line).
+#define DNF_ENTITY_ARRAY_ALIGNMENT 64
+// Number of arrays carved from the store memory.
+#define DNF_ENTITY_ARRAY_COUNT 15
+
+
+/**
+ * @brief Carves an array from the store memory.
+ *
+ * @param store Store.
+ * @param element_size Size of an element.
+ * @return Array of capacity elements.
+ */
+static void *alloc_array(dnf_entity_store *store, const size_t element_size)
+{
+    return arena_alloc(&store->memory, element_size * store->capacity, DNF_ENTITY_ARRAY_ALIGNMENT);
+}
+
+/**
+ * @brief Rounds down to an integer (floorf() is a library call without
+ * SSE4.1).
+ *
+ * @param value Value.
+ * @return Largest integer not above the value.
+ */
+static int32_t floor_to_int(const float32_t value)
+{
+    const int32_t truncated = (int32_t)value;
+    return truncated - ((float32_t)truncated > value);
+}
+
+/**
+ * @brief Checks if a range of grid map cells contains a wall.
+ *
+ * @param map Grid map.
+ * @param x0 First cell column.
+ * @param x1 Last cell column.
+ * @param y0 First cell row.
+ * @param y1 Last cell row.
+ * @return True if any cell is a wall or outside the map.
+ */
+static bool8_t cells_blocked(
+    const dnf_grid_map *map,
+    const int32_t x0, const int32_t x1,
+    const int32_t y0, const int32_t y1)
+{
+    // outside the map counts as a wall (like grid_map_get_cell())
+    if (x0 < 0 || y0 < 0 || x1 >= map->width || y1 >= map->height)
+        return true;
+
+    for (int32_t cy = y0; cy <= y1; cy++)
+    {
+        const uint8_t *row = map->cells + cy * map->width;
+        for (int32_t cx = x0; cx <= x1; cx++)
+            if (row[cx] != 0)
+                return true;
+    }
+    return false;
+}
+
+
+bool8_t entity_store_init(dnf_entity_store *store, const uint32_t capacity)
+{
+    *store = (dnf_entity_store){0};
+    if (capacity == 0 || capacity > DNF_ENTITY_MAX_COUNT)
+    {
+        DNF_ERROR("Invalid entity store capacity %u (1 to %u)", capacity, DNF_ENTITY_MAX_COUNT);
+        return false;
+    }
+
+    // every array starts on its own cache line
+    const size_t entity_size =
+        9 * sizeof(float32_t) + sizeof(int32_t) + sizeof(uint16_t) + sizeof(uint8_t)
+        + sizeof(dnf_entity) + sizeof(uint32_t) + sizeof(uint16_t);
+    const size_t size = entity_size * capacity + DNF_ENTITY_ARRAY_COUNT * DNF_ENTITY_ARRAY_ALIGNMENT;
+    if (!arena_init(&store->memory, size, DNF_MEMORY_TAG_ENTITIES))
+    {
+        DNF_ERROR("Failed to allocate an entity store of %u entities", capacity);
+        return false;
+    }
+
+    store->capacity = capacity;
+    store->x = alloc_array(store, sizeof(float32_t));
+    store->y = alloc_array(store, sizeof(float32_t));
+    store->prev_x = alloc_array(store, sizeof(float32_t));
+    store->prev_y = alloc_array(store, sizeof(float32_t));
+    store->vel_x = alloc_array(store, sizeof(float32_t));
+    store->vel_y = alloc_array(store, sizeof(float32_t));
+    store->radius = alloc_array(store, sizeof(float32_t));
+    store->speed = alloc_array(store, sizeof(float32_t));
+    store->ai_timer = alloc_array(store, sizeof(float32_t));
+    store->health = alloc_array(store, sizeof(int32_t));
+    store->sprite = alloc_array(store, sizeof(uint16_t));
+    store->ai_state = alloc_array(store, sizeof(uint8_t));
+    store->handles = alloc_array(store, sizeof(dnf_entity));
+    store->slot_dense = alloc_array(store, sizeof(uint32_t));
+    store->generations = alloc_array(store, sizeof(uint16_t));
+
+    for (uint32_t slot = 0; slot < capacity; slot++)
+        store->generations[slot] = 0;
+    entity_store_clear(store);
+    return true;
+}
+
+void entity_store_shutdown(dnf_entity_store *store)
+{
+    arena_shutdown(&store->memory);
+    *store = (dnf_entity_store){0};
+}
+
+void entity_store_clear(dnf_entity_store *store)
+{
+    // live slots move to a new generation, stale handles don't match
+    for (uint32_t i = 0; i < store->count; i++)
+    {
+        const uint32_t slot = (store->handles[i] & 0xFFFF) - 1;
+        store->generations[slot]++;
+    }
+    for (uint32_t slot = 0; slot < store->capacity; slot++)
+        store->slot_dense[slot] = slot + 1;
+    store->free_head = 0;
+    store->count = 0;
+}
+
+dnf_entity entity_spawn(dnf_entity_store *store, const dnf_entity_desc *desc)
+{
+    if (store->free_head >= store->capacity)
+        return DNF_ENTITY_NONE;
+
+    const uint32_t slot = store->free_head;
+    store->free_head = store->slot_dense[slot];
+
+    const uint32_t i = store->count++;
+    store->slot_dense[slot] = i;
+    store->handles[i] = ((dnf_entity)store->generations[slot] << 16) | (slot + 1);
+
+    store->x[i] = desc->x;
+    store->y[i] = desc->y;
+    store->prev_x[i] = desc->x;
+    store->prev_y[i] = desc->y;
+    store->vel_x[i] = desc->vel_x;
+    store->vel_y[i] = desc->vel_y;
+    store->radius[i] = desc->radius;
+    store->speed[i] = desc->speed;
+    store->ai_timer[i] = 0.0f;
+    store->health[i] = desc->health;
+    store->sprite[i] = desc->sprite;
+    store->ai_state[i] = (uint8_t)desc->ai_state;
+    return store->handles[i];
+}
+
+bool8_t entity_destroy(dnf_entity_store *store, const dnf_entity entity)
+{
+    const uint32_t i = entity_index(store, entity);
+    if (i == DNF_ENTITY_NO_INDEX)
+        return false;
+
+    // the last entity fills the hole, the arrays stay packed
+    const uint32_t last = --store->count;
+    if (i != last)
+    {
+        store->x[i] = store->x[last];
+        store->y[i] = store->y[last];
+        store->prev_x[i] = store->prev_x[last];
+        store->prev_y[i] = store->prev_y[last];
+        store->vel_x[i] = store->vel_x[last];
+        store->vel_y[i] = store->vel_y[last];
+        store->radius[i] = store->radius[last];
+        store->speed[i] = store->speed[last];
+        store->ai_timer[i] = store->ai_timer[last];
+        store->health[i] = store->health[last];
+        store->sprite[i] = store->sprite[last];
+        store->ai_state[i] = store->ai_state[last];
+        store->handles[i] = store->handles[last];
+        store->slot_dense[(store->handles[i] & 0xFFFF) - 1] = i;
+    }
+
+    const uint32_t slot = (entity & 0xFFFF) - 1;
+    store->generations[slot]++;
+    store->slot_dense[slot] = store->free_head;
+    store->free_head = slot;
+    return true;
+}
+
+uint32_t entity_index(const dnf_entity_store *store, const dnf_entity entity)
+{
+    const uint32_t slot = (entity & 0xFFFF) - 1;
+    if (entity == DNF_ENTITY_NONE || slot >= store->capacity || store->generations[slot] != (entity >> 16))
+        return DNF_ENTITY_NO_INDEX;
+
+    // free slots hold the next free slot, check it really points back
+    const uint32_t i = store->slot_dense[slot];
+    if (i >= store->count || store->handles[i] != entity)
+        return DNF_ENTITY_NO_INDEX;
+    return i;
+}
+
+void entity_pass_move(dnf_entity_store *store, const float32_t dt)
+{
+    const uint32_t count = store->count;
+    float32_t *restrict x = store->x;
+    float32_t *restrict y = store->y;
+    float32_t *restrict prev_x = store->prev_x;
+    float32_t *restrict prev_y = store->prev_y;
+    const float32_t *restrict vel_x = store->vel_x;
+    const float32_t *restrict vel_y = store->vel_y;
+
+    // separate loops over two arrays each vectorize
+    for (uint32_t i = 0; i < count; i++)
+    {
+        prev_x[i] = x[i];
+        x[i] += vel_x[i] * dt;
+    }
+    for (uint32_t i = 0; i < count; i++)
+    {
+        prev_y[i] = y[i];
+        y[i] += vel_y[i] * dt;
+    }
+}
+
+uint32_t entity_pass_ai(dnf_entity_store *store, const dnf_entity_ai_params *params, const float32_t dt)
+{
+    const uint32_t count = store->count;
+    const float32_t *restrict x = store->x;
+    const float32_t *restrict y = store->y;
+    float32_t *restrict vel_x = store->vel_x;
+    float32_t *restrict vel_y = store->vel_y;
+    const float32_t *restrict speed = store->speed;
+    float32_t *restrict timer = store->ai_timer;
+    const int32_t *restrict health = store->health;
+    uint8_t *restrict state = store->ai_state;
+
+    const float32_t sight2 = params->sight_range * params->sight_range;
+    const float32_t attack2 = params->attack_range * params->attack_range;
+    uint32_t attacks = 0;
+
+    for (uint32_t i = 0; i < count; i++)
+    {
+        if (state[i] == DNF_ENTITY_AI_STATIC || state[i] == DNF_ENTITY_AI_DEAD)
+            continue;
+        if (health[i] <= 0)
+        {
+            state[i] = DNF_ENTITY_AI_DEAD;
+            vel_x[i] = 0.0f;
+            vel_y[i] = 0.0f;
+            continue;
+        }
+
+        const float32_t dx = params->target_x - x[i];
+        const float32_t dy = params->target_y - y[i];
+        const float32_t distance2 = dx * dx + dy * dy;
+        timer[i] = timer[i] > dt ? timer[i] - dt : 0.0f;
+
+        if (state[i] == DNF_ENTITY_AI_IDLE && distance2 < sight2)
+        {
+            // the target is close, but may be behind walls
+            if (!params->pvs || pvs_is_visible(params->visible, pvs_grid_cluster(params->pvs, x[i], y[i])))
+                state[i] = DNF_ENTITY_AI_CHASE;
+        }
+        else if (state[i] == DNF_ENTITY_AI_CHASE && distance2 < attack2)
+            state[i] = DNF_ENTITY_AI_ATTACK;
+        else if (state[i] == DNF_ENTITY_AI_ATTACK && distance2 >= attack2)
+            state[i] = DNF_ENTITY_AI_CHASE;
+
+        if (state[i] == DNF_ENTITY_AI_CHASE && distance2 > 0.0f)
+        {
+            const float32_t scale = speed[i] / sqrtf(distance2);
+            vel_x[i] = dx * scale;
+            vel_y[i] = dy * scale;
+        }
+        else
+        {
+            vel_x[i] = 0.0f;
+            vel_y[i] = 0.0f;
+            if (state[i] == DNF_ENTITY_AI_ATTACK && timer[i] <= 0.0f)
+            {
+                timer[i] = params->attack_cooldown;
+                attacks++;
+            }
+        }
+    }
+
+    return attacks;
+}
+
+void entity_pass_link(const dnf_entity_store *store, dnf_blockmap *map)
+{
+    for (uint32_t i = 0; i < store->count; i++)
+        blockmap_move(map, store->handles[i], store->x[i], store->y[i], store->radius[i]);
+}
+
+void entity_pass_separate(dnf_entity_store *store, dnf_blockmap *map, const float32_t dt)
+{
+    dnf_entity neighbors[DNF_ENTITY_MAX_NEIGHBORS];
+    const float32_t inv_dt = 1.0f / dt;
+
+    for (uint32_t i = 0; i < store->count; i++)
+    {
+        const uint32_t slot = (store->handles[i] & 0xFFFF) - 1;
+        const float32_t x = map->entity_x[slot], y = map->entity_y[slot], radius = map->entity_radius[slot];
+        const uint32_t count = blockmap_query_radius(
+            map, x, y, radius, store->handles[i], neighbors, DNF_ENTITY_MAX_NEIGHBORS);
+
+        // both sides of an overlap move half of it (each one in its own iteration)
+        float32_t push_x = 0.0f, push_y = 0.0f;
+        for (uint32_t n = 0; n < count; n++)
+        {
+            const uint32_t other = (neighbors[n] & 0xFFFF) - 1;
+            const float32_t dx = x - map->entity_x[other], dy = y - map->entity_y[other];
+            const float32_t distance = sqrtf(dx * dx + dy * dy);
+            const float32_t overlap = radius + map->entity_radius[other] - distance;
+            if (distance > 1e-6f)
+            {
+                push_x += dx / distance * overlap * 0.5f;
+                push_y += dy / distance * overlap * 0.5f;
+            }
+            else
+            {
+                // same spot, split them by slot order
+                push_x += (slot < other ? -0.5f : 0.5f) * overlap;
+            }
+        }
+
+        store->vel_x[i] += push_x * inv_dt;
+        store->vel_y[i] += push_y * inv_dt;
+    }
+}
+
+uint32_t entity_pass_collide_grid(dnf_entity_store *store, const dnf_grid_map *map)
+{
+    const uint32_t count = store->count;
+    float32_t *restrict x = store->x;
+    float32_t *restrict y = store->y;
+    const float32_t *restrict prev_x = store->prev_x;
+    const float32_t *restrict prev_y = store->prev_y;
+    float32_t *restrict vel_x = store->vel_x;
+    float32_t *restrict vel_y = store->vel_y;
+    const float32_t *restrict radius = store->radius;
+    uint32_t hits = 0;
+
+    for (uint32_t i = 0; i < count; i++)
+    {
+        if (x[i] == prev_x[i] && y[i] == prev_y[i])
+            continue;
+
+        // cells under the bounding square before and after the move
+        const float32_t r = radius[i];
+        const int32_t old_x0 = floor_to_int(prev_x[i] - r), old_x1 = floor_to_int(prev_x[i] + r);
+        const int32_t old_y0 = floor_to_int(prev_y[i] - r), old_y1 = floor_to_int(prev_y[i] + r);
+        int32_t x0 = floor_to_int(x[i] - r), x1 = floor_to_int(x[i] + r);
+        const int32_t y0 = floor_to_int(y[i] - r), y1 = floor_to_int(y[i] + r);
+
+        // resolve one axis at a time, the other one keeps sliding; moves
+        // within the same cells can't touch a new wall (most of them)
+        bool8_t hit = false;
+        if ((x0 != old_x0 || x1 != old_x1) && cells_blocked(map, x0, x1, old_y0, old_y1))
+        {
+            x[i] = prev_x[i];
+            vel_x[i] = 0.0f;
+            x0 = old_x0;
+            x1 = old_x1;
+            hit = true;
+        }
+        if ((y0 != old_y0 || y1 != old_y1) && cells_blocked(map, x0, x1, y0, y1))
+        {
+            y[i] = prev_y[i];
+            vel_y[i] = 0.0f;
+            hit = true;
+        }
+        hits += hit;
+    }
+
+    return hits;
+}
@@ -24,6 +24,10 @@
 // A LUT map from game actions to bindings.
 static dnf_input_binding actions[DNF_GAME_ACTION_COUNT];
 
+// Presses and releases since the last simulation tick.
+static bool8_t latched_pressed[DNF_GAME_ACTION_COUNT];
+static bool8_t latched_released[DNF_GAME_ACTION_COUNT];
+
 static dnf_input_system_handler *input_handler;  // a "singleton" handler
 static bool8_t dnf_input_system_initialized = false;  // flag to prevent re-initialization
 
@@ -70,7 +74,7 @@ bool8_t binding_is_released(const dnf_input_binding binding)
 
 bool8_t is_pressed(const dnf_game_action action)
 {
-    return binding_is_pressed(actions[action]);
+    return latched_pressed[action];
 }
 
 bool8_t is_held(const dnf_game_action action)
@@ -80,7 +84,25 @@ bool8_t is_held(const dnf_game_action action)
 
 bool8_t is_released(const dnf_game_action action)
 {
-    return binding_is_released(actions[action]);
+    return latched_released[action];
+}
+
+void input_handler_poll(void)
+{
+    for (uint32_t action = 0; action < DNF_GAME_ACTION_COUNT; action++)
+    {
+        latched_pressed[action] |= binding_is_pressed(actions[action]);
+        latched_released[action] |= binding_is_released(actions[action]);
+    }
+}
+
+void input_handler_end_tick(void)
+{
+    for (uint32_t action = 0; action < DNF_GAME_ACTION_COUNT; action++)
+    {
+        latched_pressed[action] = false;
+        latched_released[action] = false;
+    }
 }
 
 bool8_t input_handler_init(dnf_input_system_handler* handler)
@@ -99,12 +121,16 @@ bool8_t input_handler_init(dnf_input_system_handler* handler)
     input_handler->is_held = is_held;
     input_handler->is_released = is_released;
 
+    input_handler_end_tick();
+
     // set default keybinds
     // TODO: add config and change it in entrypoints, not here
     actions[DNF_GAME_ACTION_MOVE_FORWARD] = (dnf_input_binding){DNF_INPUT_TYPE_KEYBOARD, KEY_W};
     actions[DNF_GAME_ACTION_MOVE_BACKWARD] = (dnf_input_binding){DNF_INPUT_TYPE_KEYBOARD, KEY_S};
     actions[DNF_GAME_ACTION_MOVE_LEFT] = (dnf_input_binding){DNF_INPUT_TYPE_KEYBOARD, KEY_A};
     actions[DNF_GAME_ACTION_MOVE_RIGHT] = (dnf_input_binding){DNF_INPUT_TYPE_KEYBOARD, KEY_D};
+    actions[DNF_GAME_ACTION_TURN_LEFT] = (dnf_input_binding){DNF_INPUT_TYPE_KEYBOARD, KEY_LEFT};
+    actions[DNF_GAME_ACTION_TURN_RIGHT] = (dnf_input_binding){DNF_INPUT_TYPE_KEYBOARD, KEY_RIGHT};
 
     actions[DNF_GAME_ACTION_INTERACT] = (dnf_input_binding){DNF_INPUT_TYPE_KEYBOARD, KEY_E};
 
@@ -113,9 +139,12 @@ bool8_t input_handler_init(dnf_input_system_handler* handler)
 
     actions[DNF_GAME_ACTION_MENU] = (dnf_input_binding){DNF_INPUT_TYPE_KEYBOARD, KEY_ESCAPE};
 
+    actions[DNF_GAME_ACTION_DEBUG_NEXT_VIEW] = (dnf_input_binding){DNF_INPUT_TYPE_KEYBOARD, KEY_TAB};
+
     return true;
 }
 
 void input_handler_shutdown()
 {
+    dnf_input_system_initialized = false;
 }
@@ -0,0 +1,299 @@
+// DNF (Doomed and Forgotten): a DOOM-style first-person shooter.
+// Copyright (C) 2025-2026  Alexandr Gorbatenko
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+
+#include "job_system.h"
+
+#include "logger.h"
+
+#include <stdatomic.h>
+#include <threads.h>
+
+#if defined(_WIN32)
+    #define WIN32_LEAN_AND_MEAN
+    #include <windows.h>  // GetActiveProcessorCount (no raylib in this file)
+#else
+    #include <unistd.h>   // sysconf
+#endif
+
+
+/**
+ * @brief A queued batch of jobs.
+ */
+typedef struct dnf_job_batch
+{
+    dnf_job_fn fn;               //!< Job function
+    void *user_data;             //!< Job function user data
+    uint32_t count;              //!< Number of jobs
+    atomic_uint next_job;        //!< Next unclaimed job index
+    atomic_uint jobs_remaining;  //!< Jobs not yet finished
+    uint32_t attached;           //!< Threads claiming jobs from this batch (guarded by job_mutex)
+} dnf_job_batch;
+
+static thrd_t workers[DNF_JOB_MAX_WORKERS];  // worker threads
+static uint32_t worker_count = 0;  // number of running workers
+static bool8_t dnf_job_system_initialized = false;  // flag to prevent re-initialization
+
+static mtx_t job_mutex;    // guards the queue and batch attachment
+static cnd_t job_wake;     // signaled when a batch becomes claimable
+static cnd_t job_done;     // signaled when a batch finishes or a thread detaches
+
+// FIFO of batches, indices grow monotonically (slot = index % DNF_JOB_QUEUE_SIZE)
+static dnf_job_batch queue[DNF_JOB_QUEUE_SIZE];
+static uint32_t queue_head = 0;  // oldest unfinished batch
+static uint32_t queue_tail = 0;  // next free slot
+static bool8_t shutting_down = false;
+
+
+/**
+ * @brief Queries the number of online logical CPUs.
+ *
+ * @return CPU count (at least 1).
+ */
+static uint32_t get_cpu_count(void)
+{
+#if defined(_WIN32)
+    const long count = (long)GetActiveProcessorCount(ALL_PROCESSOR_GROUPS);
+#else
+    const long count = sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+    return count > 0 ? (uint32_t)count : 1;
+}
+
+/**
+ * @brief Gets the head batch if it still has unclaimed jobs. Only the head
+ * batch is ever claimable, which keeps batches ordered.
+ *
+ * Must be called with job_mutex locked.
+ *
+ * @return Claimable batch or nullptr.
+ */
+static dnf_job_batch *claimable_batch(void)
+{
+    if (queue_head == queue_tail)
+        return nullptr;
+
+    dnf_job_batch *batch = &queue[queue_head % DNF_JOB_QUEUE_SIZE];
+    if (atomic_load_explicit(&batch->next_job, memory_order_relaxed) >= batch->count)
+        return nullptr;
+    return batch;
+}
+
+/**
+ * @brief Claims and runs jobs of a batch until none are left.
+ *
+ * Must be called with job_mutex unlocked while attached to the batch.
+ *
+ * @param batch Batch to run.
+ */
+static void run_batch(dnf_job_batch *batch)
+{
+    for (;;)
+    {
+        const uint32_t index = atomic_fetch_add_explicit(&batch->next_job, 1, memory_order_relaxed);
+        if (index >= batch->count)
+            return;
+
+        batch->fn(index, batch->user_data);
+
+        // the thread that finishes the last job retires the batch
+        if (atomic_fetch_sub_explicit(&batch->jobs_remaining, 1, memory_order_acq_rel) == 1)
+        {
+            mtx_lock(&job_mutex);
+            queue_head++;
+            cnd_broadcast(&job_wake);
+            cnd_broadcast(&job_done);
+            mtx_unlock(&job_mutex);
+        }
+    }
+}
+
+/**
+ * @brief Attaches to a batch, runs its jobs and detaches.
+ *
+ * Must be called with job_mutex locked; returns with it locked.
+ *
+ * @param batch Claimable batch.
+ */
+static void help_with_batch(dnf_job_batch *batch)
+{
+    batch->attached++;
+    mtx_unlock(&job_mutex);
+
+    run_batch(batch);
+
+    mtx_lock(&job_mutex);
+    // a slot can only be reused once every thread has left it
+    if (--batch->attached == 0)
+        cnd_broadcast(&job_done);
+}
+
+/**
+ * @brief Worker thread main loop: sleeps until a batch is queued, then
+ * helps to run it.
+ */
+static int worker_main(void *arg)
+{
+    (void)arg;
+
+    mtx_lock(&job_mutex);
+    for (;;)
+    {
+        dnf_job_batch *batch;
+        while (!shutting_down && !(batch = claimable_batch()))
+            cnd_wait(&job_wake, &job_mutex);
+        if (shutting_down)
+            break;
+
+        help_with_batch(batch);
+    }
+    mtx_unlock(&job_mutex);
+
+    return 0;
+}
+
+bool8_t job_system_init(uint32_t requested_workers)
+{
+    if (dnf_job_system_initialized)
+    {
+        DNF_ERROR("Tried to initialize job system more than once!");
+        return false;
+    }
+
+    // by default leave one core for the main thread, which also runs jobs
+    if (requested_workers == 0)
+        requested_workers = get_cpu_count() - 1;
+    if (requested_workers > DNF_JOB_MAX_WORKERS)
+        requested_workers = DNF_JOB_MAX_WORKERS;
+
+    if (mtx_init(&job_mutex, mtx_plain) != thrd_success
+        || cnd_init(&job_wake) != thrd_success
+        || cnd_init(&job_done) != thrd_success)
+    {
+        DNF_ERROR("Failed to create job system synchronization primitives");
+        return false;
+    }
+
+    shutting_down = false;
+    queue_head = queue_tail = 0;
+    for (uint32_t i = 0; i < DNF_JOB_QUEUE_SIZE; i++)
+    {
+        queue[i].attached = 0;
+        atomic_init(&queue[i].next_job, 0);
+        atomic_init(&queue[i].jobs_remaining, 0);
+    }
+
+    worker_count = 0;
+    for (uint32_t i = 0; i < requested_workers; i++)
+    {
+        if (thrd_create(&workers[i], worker_main, nullptr) != thrd_success)
+        {
+            DNF_WARN("Failed to create job worker #%u, continuing with %u", i, worker_count);
+            break;
+        }
+        worker_count++;
+    }
+
+    DNF_INFO("Job system started with %u worker thread(s)", worker_count);
+
+    dnf_job_system_initialized = true;
+    return true;
+}
+
+void job_system_shutdown(void)
+{
+    if (!dnf_job_system_initialized)
+        return;
+
+    // finish queued work first
+    job_system_wait();
+
+    mtx_lock(&job_mutex);
+    shutting_down = true;
+    cnd_broadcast(&job_wake);
+    mtx_unlock(&job_mutex);
+
+    for (uint32_t i = 0; i < worker_count; i++)
+        thrd_join(workers[i], nullptr);
+    worker_count = 0;
+
+    cnd_destroy(&job_done);
+    cnd_destroy(&job_wake);
+    mtx_destroy(&job_mutex);
+
+    dnf_job_system_initialized = false;
+    DNF_INFO("Job system shut down");
+}
+
+uint32_t job_system_thread_count(void)
+{
+    return worker_count + 1;
+}
+
+void job_system_dispatch(const uint32_t job_count, const dnf_job_fn fn, void *user_data)
+{
+    job_system_dispatch_async(job_count, fn, user_data);
+    job_system_wait();
+}
+
+void job_system_dispatch_async(const uint32_t job_count, const dnf_job_fn fn, void *user_data)
+{
+    if (job_count == 0)
+        return;
+
+    // no workers - run right away, there is nobody to hand the jobs to
+    if (!dnf_job_system_initialized || worker_count == 0)
+    {
+        for (uint32_t i = 0; i < job_count; i++)
+            fn(i, user_data);
+        return;
+    }
+
+    mtx_lock(&job_mutex);
+    // wait for a free slot that nobody is still attached to
+    while (queue_tail - queue_head == DNF_JOB_QUEUE_SIZE
+        || queue[queue_tail % DNF_JOB_QUEUE_SIZE].attached > 0)
+        cnd_wait(&job_done, &job_mutex);
+
+    dnf_job_batch *batch = &queue[queue_tail % DNF_JOB_QUEUE_SIZE];
+    batch->fn = fn;
+    batch->user_data = user_data;
+    batch->count = job_count;
+    atomic_store_explicit(&batch->next_job, 0, memory_order_relaxed);
+    atomic_store_explicit(&batch->jobs_remaining, job_count, memory_order_relaxed);
+    queue_tail++;
+
+    cnd_broadcast(&job_wake);
+    mtx_unlock(&job_mutex);
+}
+
+void job_system_wait(void)
+{
+    if (!dnf_job_system_initialized || worker_count == 0)
+        return;
+
+    // help out instead of idling
+    mtx_lock(&job_mutex);
+    while (queue_head != queue_tail)
+    {
+        dnf_job_batch *batch = claimable_batch();
+        if (batch)
+            help_with_batch(batch);
+        else
+            cnd_wait(&job_done, &job_mutex);
+    }
+    mtx_unlock(&job_mutex);
+}
@@ -0,0 +1,421 @@
+// DNF (Doomed and Forgotten): a DOOM-style first-person shooter.
+// Copyright (C) 2025-2026  Alexandr Gorbatenko
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+#include "log_binary.h"
+
+#include <stdio.h>   // snprintf
+#include <string.h>  // memcpy, memchr
+#include <time.h>    // time formatting
+
+
+/**
+ * @brief Length modifiers of printf conversions.
+ */
+typedef enum dnf_log_length
+{
+    DNF_LOG_LENGTH_NONE,
+    DNF_LOG_LENGTH_HH,
+    DNF_LOG_LENGTH_H,
+    DNF_LOG_LENGTH_L,
+    DNF_LOG_LENGTH_LL,
+    DNF_LOG_LENGTH_J,
+    DNF_LOG_LENGTH_Z,
+    DNF_LOG_LENGTH_T,
+    DNF_LOG_LENGTH_BIG_L,
+} dnf_log_length;
+
+// Names of logging levels.
+static const char* log_level_names[] = {
+    "TRACE", "DEBUG", "INFO", "WARN", "ERROR", "FATAL"
+};
+
+/**
+ * @brief A parsed printf conversion specification.
+ */
+typedef struct dnf_log_spec
+{
+    const char *begin;   //!< The '%' character
+    const char *end;     //!< One past the conversion character
+    uint32_t stars;      //!< '*' width/precision arguments (ints, before the value)
+    int32_t kind;        //!< Value kind (dnf_log_arg_kind), -1 for "%%"
+    int32_t precision;   //!< Precision (DNF_LOG_PRECISION_* or a value)
+} dnf_log_spec;
+
+
+/**
+ * @brief Parses the conversion specification starting at a '%'.
+ *
+ * @param p Pointer to the '%' character.
+ * @param out_spec Parsed specification.
+ * @return False if the conversion can't be packed.
+ */
+static bool8_t parse_spec(const char *p, dnf_log_spec *out_spec)
+{
+    out_spec->begin = p++;
+    out_spec->stars = 0;
+    out_spec->kind = -1;
+    out_spec->precision = DNF_LOG_PRECISION_NONE;
+
+    if (*p == '%')
+    {
+        out_spec->end = p + 1;
+        return true;
+    }
+
+    // flags
+    while (*p == '-' || *p == '+' || *p == ' ' || *p == '#' || *p == '0' || *p == '\'')
+        p++;
+
+    // width
+    if (*p == '*')
+    {
+        out_spec->stars++;
+        p++;
+    }
+    else
+        while (*p >= '0' && *p <= '9')
+            p++;
+
+    // precision
+    if (*p == '.')
+    {
+        p++;
+        if (*p == '*')
+        {
+            out_spec->stars++;
+            out_spec->precision = DNF_LOG_PRECISION_ARG;
+            p++;
+        }
+        else
+        {
+            out_spec->precision = 0;
+            while (*p >= '0' && *p <= '9')
+            {
+                if (out_spec->precision < INT16_MAX)
+                    out_spec->precision = out_spec->precision * 10 + (*p - '0');
+                p++;
+            }
+            if (out_spec->precision > INT16_MAX)
+                out_spec->precision = INT16_MAX;
+        }
+    }
+
+    // length modifier
+    dnf_log_length length = DNF_LOG_LENGTH_NONE;
+    switch (*p)
+    {
+        case 'h':
+            length = p[1] == 'h' ? DNF_LOG_LENGTH_HH : DNF_LOG_LENGTH_H;
+            p += length == DNF_LOG_LENGTH_HH ? 2 : 1;
+            break;
+        case 'l':
+            length = p[1] == 'l' ? DNF_LOG_LENGTH_LL : DNF_LOG_LENGTH_L;
+            p += length == DNF_LOG_LENGTH_LL ? 2 : 1;
+            break;
+        case 'j': length = DNF_LOG_LENGTH_J; p++; break;
+        case 'z': length = DNF_LOG_LENGTH_Z; p++; break;
+        case 't': length = DNF_LOG_LENGTH_T; p++; break;
+        case 'L': length = DNF_LOG_LENGTH_BIG_L; p++; break;
+        default: break;
+    }
+
+    // conversion
+    switch (*p)
+    {
+        case 'd': case 'i': case 'o': case 'u': case 'x': case 'X':
+            switch (length)
+            {
+                case DNF_LOG_LENGTH_L: out_spec->kind = DNF_LOG_ARG_LONG; break;
+                case DNF_LOG_LENGTH_LL: out_spec->kind = DNF_LOG_ARG_LONG_LONG; break;
+                case DNF_LOG_LENGTH_J: out_spec->kind = DNF_LOG_ARG_INTMAX; break;
+                case DNF_LOG_LENGTH_Z: out_spec->kind = DNF_LOG_ARG_SIZE; break;
+                case DNF_LOG_LENGTH_T: out_spec->kind = DNF_LOG_ARG_PTRDIFF; break;
+                case DNF_LOG_LENGTH_BIG_L: return false;
+                default: out_spec->kind = DNF_LOG_ARG_INT; break;  // promoted to int
+            }
+            break;
+        case 'c':
+            if (length != DNF_LOG_LENGTH_NONE)
+                return false;
+            out_spec->kind = DNF_LOG_ARG_INT;
+            break;
+        case 'e': case 'E': case 'f': case 'F': case 'g': case 'G': case 'a': case 'A':
+            out_spec->kind = length == DNF_LOG_LENGTH_BIG_L ? DNF_LOG_ARG_LONG_DOUBLE : DNF_LOG_ARG_DOUBLE;
+            break;
+        case 's':
+            if (length != DNF_LOG_LENGTH_NONE)
+                return false;  // no wide strings
+            out_spec->kind = DNF_LOG_ARG_STRING;
+            break;
+        case 'p':
+            out_spec->kind = DNF_LOG_ARG_POINTER;
+            break;
+        default:
+            return false;  // %n, unknown or truncated conversions
+    }
+
+    out_spec->end = p + 1;
+    return true;
+}
+
+/**
+ * @brief Reads a fixed-size value from packed arguments (zero if missing).
+ */
+static void read_arg(const uint8_t **cursor, const uint8_t *end, void *out, const size_t size)
+{
+    if ((size_t)(end - *cursor) < size)
+    {
+        memset(out, 0, size);
+        *cursor = end;
+        return;
+    }
+    memcpy(out, *cursor, size);
+    *cursor += size;
+}
+
+const char *dnf_log_level_name(const uint32_t level)
+{
+    return level < sizeof(log_level_names) / sizeof(log_level_names[0]) ? log_level_names[level] : "?";
+}
+
+size_t dnf_log_format_line(
+    char *out, const size_t out_size,
+    const int64_t wall_time, const uint32_t level,
+    const char *file, const uint32_t line,
+    const char *message)
+{
+    // time formatting
+    const time_t timer = (time_t)wall_time;
+    struct tm tm_info;
+    char time_buffer[32];
+#if defined(_WIN32)
+    localtime_s(&tm_info, &timer);
+#else
+    localtime_r(&timer, &tm_info);
+#endif
+    strftime(time_buffer, 32, "%Y-%m-%d %H:%M:%S", &tm_info);
+
+    const int32_t length = snprintf(
+        out, out_size,
+        "%s - [%s] in (%s:%u): %s\n",
+        time_buffer, dnf_log_level_name(level), file, line, message);
+    if (length < 0)
+    {
+        out[0] = '\0';
+        return 0;
+    }
+    return (size_t)length < out_size ? (size_t)length : out_size - 1;
+}
+
+bool8_t dnf_log_parse_signature(const char *format, dnf_log_signature *out_signature)
+{
+    out_signature->count = 0;
+
+    for (const char *p = format; *p; p++)
+    {
+        if (*p != '%')
+            continue;
+
+        dnf_log_spec spec;
+        if (!parse_spec(p, &spec))
+            return false;
+        p = spec.end - 1;
+        if (spec.kind < 0)
+            continue;
+
+        if (out_signature->count + spec.stars + 1 > DNF_LOG_MAX_ARGS)
+            return false;
+        for (uint32_t i = 0; i < spec.stars; i++)
+        {
+            out_signature->precisions[out_signature->count] = DNF_LOG_PRECISION_NONE;
+            out_signature->kinds[out_signature->count++] = DNF_LOG_ARG_INT;
+        }
+        out_signature->precisions[out_signature->count] = (int16_t)spec.precision;
+        out_signature->kinds[out_signature->count++] = (uint8_t)spec.kind;
+    }
+
+    return true;
+}
+
+size_t dnf_log_pack_args(const dnf_log_signature *signature, va_list args, uint8_t *out, const size_t capacity)
+{
+    size_t written = 0;
+    int last_int = 0;  // a '*' precision precedes its string
+
+// copies a value of the given type if it fits (the argument is consumed either way)
+#define DNF_PACK(type)                                      \
+    {                                                       \
+        const type value = va_arg(args, type);              \
+        if (written + sizeof(type) <= capacity)             \
+        {                                                   \
+            memcpy(out + written, &value, sizeof(type));    \
+            written += sizeof(type);                        \
+        }                                                   \
+    }
+
+    for (uint32_t i = 0; i < signature->count; i++)
+    {
+        switch ((dnf_log_arg_kind)signature->kinds[i])
+        {
+            case DNF_LOG_ARG_INT:
+            {
+                last_int = va_arg(args, int);
+                if (written + sizeof(int) <= capacity)
+                {
+                    memcpy(out + written, &last_int, sizeof(int));
+                    written += sizeof(int);
+                }
+                break;
+            }
+            case DNF_LOG_ARG_LONG: DNF_PACK(long) break;
+            case DNF_LOG_ARG_LONG_LONG: DNF_PACK(long long) break;
+            case DNF_LOG_ARG_INTMAX: DNF_PACK(intmax_t) break;
+            case DNF_LOG_ARG_SIZE: DNF_PACK(size_t) break;
+            case DNF_LOG_ARG_PTRDIFF: DNF_PACK(ptrdiff_t) break;
+            case DNF_LOG_ARG_DOUBLE: DNF_PACK(double) break;
+            case DNF_LOG_ARG_LONG_DOUBLE: DNF_PACK(long double) break;
+            case DNF_LOG_ARG_POINTER: DNF_PACK(void *) break;
+            case DNF_LOG_ARG_STRING:
+            {
+                // strings are copied: the caller's memory won't live until formatting
+                const char *string = va_arg(args, const char *);
+                if (!string)
+                    string = "(null)";
+                if (written + sizeof(uint32_t) + 1 > capacity)
+                    break;
+
+                // only the characters the precision lets through are needed
+                size_t limit = capacity - written - sizeof(uint32_t) - 1;
+                const int32_t precision = signature->precisions[i] == DNF_LOG_PRECISION_ARG
+                    ? (last_int >= 0 ? last_int : DNF_LOG_PRECISION_NONE)
+                    : signature->precisions[i];
+                if (precision >= 0 && (size_t)precision < limit)
+                    limit = (size_t)precision;
+                const char *terminator = memchr(string, '\0', limit);
+                const size_t length = terminator ? (size_t)(terminator - string) : limit;
+                const uint32_t length32 = (uint32_t)length;
+                memcpy(out + written, &length32, sizeof(uint32_t));
+                memcpy(out + written + sizeof(uint32_t), string, length);
+                out[written + sizeof(uint32_t) + length] = '\0';
+                written += sizeof(uint32_t) + length + 1;
+                break;
+            }
+        }
+    }
+
+#undef DNF_PACK
+
+    return written;
+}
+
+size_t dnf_log_format_packed(
+    const char *format,
+    const uint8_t *args, const size_t args_size,
+    char *out, const size_t out_size)
+{
+    if (out_size == 0)
+        return 0;
+
+    const uint8_t *cursor = args;
+    const uint8_t *end = args + args_size;
+    size_t pos = 0;
+
+// appends snprintf output, clamped to the buffer
+#define DNF_APPEND(...)                                                     \
+    {                                                                       \
+        const int32_t appended = snprintf(out + pos, out_size - pos, __VA_ARGS__); \
+        if (appended > 0)                                                   \
+            pos += (size_t)appended < out_size - pos ? (size_t)appended : out_size - pos - 1; \
+    }
+
+// formats a value with 0-2 star arguments in front of it
+#define DNF_APPEND_VALUE(value)                                             \
+    {                                                                       \
+        if (spec.stars == 0)                                                \
+            DNF_APPEND(spec_format, value)                                  \
+        else if (spec.stars == 1)                                           \
+            DNF_APPEND(spec_format, stars[0], value)                        \
+        else                                                                \
+            DNF_APPEND(spec_format, stars[0], stars[1], value)              \
+    }
+
+    const char *p = format;
+    while (*p && pos + 1 < out_size)
+    {
+        if (*p != '%')
+        {
+            out[pos++] = *p++;
+            continue;
+        }
+
+        dnf_log_spec spec;
+        char spec_format[64];
+        if (!parse_spec(p, &spec) || (size_t)(spec.end - spec.begin) >= sizeof(spec_format))
+        {
+            // not packable - copy the rest verbatim
+            while (*p && pos + 1 < out_size)
+                out[pos++] = *p++;
+            break;
+        }
+        p = spec.end;
+
+        if (spec.kind < 0)
+        {
+            out[pos++] = '%';
+            continue;
+        }
+
+        memcpy(spec_format, spec.begin, (size_t)(spec.end - spec.begin));
+        spec_format[spec.end - spec.begin] = '\0';
+
+        int stars[2] = {0, 0};
+        for (uint32_t i = 0; i < spec.stars; i++)
+            read_arg(&cursor, end, &stars[i], sizeof(int));
+
+        switch ((dnf_log_arg_kind)spec.kind)
+        {
+            case DNF_LOG_ARG_INT: { int v; read_arg(&cursor, end, &v, sizeof(v)); DNF_APPEND_VALUE(v) break; }
+            case DNF_LOG_ARG_LONG: { long v; read_arg(&cursor, end, &v, sizeof(v)); DNF_APPEND_VALUE(v) break; }
+            case DNF_LOG_ARG_LONG_LONG: { long long v; read_arg(&cursor, end, &v, sizeof(v)); DNF_APPEND_VALUE(v) break; }
+            case DNF_LOG_ARG_INTMAX: { intmax_t v; read_arg(&cursor, end, &v, sizeof(v)); DNF_APPEND_VALUE(v) break; }
+            case DNF_LOG_ARG_SIZE: { size_t v; read_arg(&cursor, end, &v, sizeof(v)); DNF_APPEND_VALUE(v) break; }
+            case DNF_LOG_ARG_PTRDIFF: { ptrdiff_t v; read_arg(&cursor, end, &v, sizeof(v)); DNF_APPEND_VALUE(v) break; }
+            case DNF_LOG_ARG_DOUBLE: { double v; read_arg(&cursor, end, &v, sizeof(v)); DNF_APPEND_VALUE(v) break; }
+            case DNF_LOG_ARG_LONG_DOUBLE: { long double v; read_arg(&cursor, end, &v, sizeof(v)); DNF_APPEND_VALUE(v) break; }
+            case DNF_LOG_ARG_POINTER: { void *v; read_arg(&cursor, end, &v, sizeof(v)); DNF_APPEND_VALUE(v) break; }
+            case DNF_LOG_ARG_STRING:
+            {
+                uint32_t length = 0;
+                read_arg(&cursor, end, &length, sizeof(length));
+                const char *v = "";
+                if ((size_t)(end - cursor) > length)
+                {
+                    v = (const char *)cursor;  // terminated when packed
+                    cursor += length + 1;
+                }
+                else
+                    cursor = end;
+                DNF_APPEND_VALUE(v)
+                break;
+            }
+        }
+    }
+
+#undef DNF_APPEND_VALUE
+#undef DNF_APPEND
+
+    out[pos] = '\0';
+    return pos;
+}
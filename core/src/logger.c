@@ -13,96 +13,434 @@
 //
 // You should have received a copy of the GNU General Public License
 // along with this program.  If not, see <https://www.gnu.org/licenses/>.
-
-
 #include "logger.h"
 #include "dnf_assertions.h"
+#include "dnf_clock.h"
+#include "log_binary.h"
 
 #include <raylib.h>  // cross-platform file operations
 
-#include <stdio.h>   // message formatting and console output
-#include <time.h>    // time formatting
-#include <string.h>  // memset
+#include <ctype.h>      // toupper
+#include <stdalign.h>   // alignas (compilers without C23 keywords)
+#include <stdarg.h>     // variadic arguments
+#include <stdatomic.h>  // lock-free ring buffer
+#include <stdio.h>      // message formatting and console output
+#include <string.h>     // memcpy, strcmp
+#include <threads.h>    // writer thread
+#include <time.h>       // time formatting
 
-// A bad practice!
-#define DNF_LOG_BUFFER_SIZE 32768
-// Another bad practice! It is OK for now, though.
+// Log file directory and name.
+#define DNF_LOG_DIRECTORY "./logs"
 #define DNF_LOG_FILENAME "dnf_game.log"
+#define DNF_LOG_BINARY_FILENAME "dnf_game.dnflog"
+// stdio buffer of the log file (bounds the memory used for file output).
+#define DNF_LOG_FILE_BUFFER_SIZE 65536
+// Size at which the log file is rotated.
+#define DNF_LOG_MAX_FILE_SIZE (8 * 1024 * 1024)
+// Number of rotated files kept (dnf_game.log.1 is the newest).
+#define DNF_LOG_MAX_ROTATED_FILES 5
 // And yet another bad practice!
 #define DNF_LOG_MAX_MSG_LENGTH 8192
 
-static char log_buffer[DNF_LOG_BUFFER_SIZE];  // Log buffer.
-static size_t log_buffer_pos = 0;  // Last character in the log buffer.
+// Size of a ring buffer cell; longer records take several consecutive cells.
+#define DNF_LOG_CELL_SIZE 256
+// Number of ring buffer cells (must be a power of two).
+#define DNF_LOG_RING_CELLS 4096
+// How long the writer sleeps when the ring buffer is empty.
+#define DNF_LOG_WRITER_IDLE_NS 10000000
+
+// Runtime level used until one is set.
+#define DNF_LOG_DEFAULT_LEVEL DNF_LOG_LEVEL_DEBUG
+// Maximum number of module levels and module name length.
+#define DNF_LOG_MAX_MODULES 32
+#define DNF_LOG_MAX_MODULE_NAME 32
 
-// Names of logging levels.
-static const char* log_level_names[DNF_LOG_LEVEL_COUNT] = {
-    "TRACE", "DEBUG", "INFO", "WARN", "ERROR", "FATAL"
-};
+STATIC_ASSERT((DNF_LOG_RING_CELLS & (DNF_LOG_RING_CELLS - 1)) == 0, "Ring size must be a power of two");
 
+/**
+ * @brief Header of a queued log record, stored at the start of its first
+ * cell and followed by the payload: packed arguments of the call site's
+ * format, or the formatted (terminated) message if there is no site.
+ */
+typedef struct dnf_log_record
+{
+    uint64_t timestamp;        //!< Monotonic time of the call (nanoseconds)
+    dnf_log_site *site;        //!< Call site (nullptr - preformatted message)
+    const char *file;          //!< Source file (string literal)
+    uint32_t line;             //!< Source line
+    uint32_t length;           //!< Payload size
+    uint16_t level;            //!< Logging level
+    uint16_t cell_count;       //!< Cells taken by the record
+} dnf_log_record;
 
 /**
- * @brief Flushes the log buffer to the specified log file, then resets
- * log_buffer_pos to 0.
+ * @brief States of a call site's argument signature.
+ */
+typedef enum dnf_log_site_state
+{
+    DNF_LOG_SITE_UNPARSED = 0,
+    DNF_LOG_SITE_PARSING,
+    DNF_LOG_SITE_PACKED,   //!< Arguments are packed, formatting happens on the writer
+    DNF_LOG_SITE_TEXT,     //!< Format can't be packed, formatted by the caller
+} dnf_log_site_state;
+
+/**
+ * @brief A ring buffer cell (Vyukov's bounded queue with a single consumer).
  *
- * @param filename Name of the log file.
+ * The sequence equals the cell's position while it is free, position + 1
+ * once a producer has filled it and position + DNF_LOG_RING_CELLS once the
+ * writer has consumed it.
+ */
+typedef struct dnf_log_cell
+{
+    alignas(64) atomic_size_t sequence;
+    char data[DNF_LOG_CELL_SIZE - sizeof(atomic_size_t)];
+} dnf_log_cell;
+
+STATIC_ASSERT(sizeof(dnf_log_cell) == DNF_LOG_CELL_SIZE, "Unexpected log cell padding");
+
+#define DNF_LOG_CELL_DATA (DNF_LOG_CELL_SIZE - sizeof(atomic_size_t))
+
+/**
+ * @brief Runtime level of a module.
+ */
+typedef struct dnf_log_module_level
+{
+    char name[DNF_LOG_MAX_MODULE_NAME];  //!< Module name
+    dnf_log_level level;                 //!< Minimum logging level
+} dnf_log_module_level;
+
+static FILE *log_file = nullptr;  // Log file (opened for appending).
+static size_t log_file_size = 0;  // Current log file size.
+static bool8_t log_file_failed = false;  // don't retry opening after a failure
+static dnf_log_format log_format = DNF_LOG_FORMAT_TEXT;  // log file format
+static const char *log_file_name = DNF_LOG_FILENAME;
+
+// timestamps are monotonic, these map them to the wall clock
+static uint64_t clock_origin = 0;
+static int64_t wall_origin = 0;
+
+// binary format: sites get ids per file (generation), 0 - not written yet
+static uint32_t binary_generation = 0;
+static uint32_t next_site_id = 0;
+
+// asynchronous mode state
+static dnf_log_cell ring[DNF_LOG_RING_CELLS];
+static atomic_size_t enqueue_pos;  // next position claimed by producers
+static atomic_size_t written_pos;  // all records before this position are written out
+static size_t dequeue_pos = 0;     // next position read by the writer (writer only)
+
+static atomic_bool async_enabled = false;  // records go through the ring buffer
+static atomic_uint active_producers = 0;   // producers that may still push (see submit_record())
+static atomic_bool writer_stopping = false;
+static atomic_bool writer_sleeping = false;
+static thrd_t writer_thread;
+static mtx_t writer_mutex;  // only used to sleep/wake the writer
+static cnd_t writer_wake;
+
+// serializes output (the writer thread and the synchronous mode)
+static atomic_flag output_lock = ATOMIC_FLAG_INIT;
+
+// runtime filtering (sites and module levels are guarded by filter_lock)
+static atomic_int runtime_level = DNF_LOG_DEFAULT_LEVEL;
+static dnf_log_module_level module_levels[DNF_LOG_MAX_MODULES];
+static uint32_t module_level_count = 0;
+static dnf_log_site *registered_sites = nullptr;  // list of sites that were called
+static atomic_flag filter_lock = ATOMIC_FLAG_INIT;
+
+
+/**
+ * @brief Acquires the output lock.
+ */
+static void lock_output(void)
+{
+    while (atomic_flag_test_and_set_explicit(&output_lock, memory_order_acquire))
+        thrd_yield();
+}
+
+/**
+ * @brief Releases the output lock.
+ */
+static void unlock_output(void)
+{
+    atomic_flag_clear_explicit(&output_lock, memory_order_release);
+}
+
+/**
+ * @brief Acquires the filter lock.
+ */
+static void lock_filters(void)
+{
+    while (atomic_flag_test_and_set_explicit(&filter_lock, memory_order_acquire))
+        thrd_yield();
+}
+
+/**
+ * @brief Releases the filter lock.
+ */
+static void unlock_filters(void)
+{
+    atomic_flag_clear_explicit(&filter_lock, memory_order_release);
+}
+
+/**
+ * @brief Checks whether a site belongs to a module: its DNF_LOG_MODULE tag
+ * or else its file name without directory and extension.
+ */
+static bool8_t site_in_module(const dnf_log_site *site, const char *module)
+{
+    if (site->module)
+        return strcmp(site->module, module) == 0;
+
+    const char *name = site->file;
+    for (const char *p = site->file; *p; p++)
+        if (*p == '/' || *p == '\\')
+            name = p + 1;
+    const char *extension = strrchr(name, '.');
+    const size_t length = extension ? (size_t)(extension - name) : strlen(name);
+
+    return strncmp(name, module, length) == 0 && module[length] == '\0';
+}
+
+/**
+ * @brief Recomputes the filter of a site. Must be called with the filter
+ * lock held.
+ */
+static void update_site_filter(dnf_log_site *site)
+{
+    dnf_log_level min_level = (dnf_log_level)atomic_load(&runtime_level);
+    for (uint32_t i = 0; i < module_level_count; i++)
+    {
+        if (site_in_module(site, module_levels[i].name))
+        {
+            min_level = module_levels[i].level;
+            break;
+        }
+    }
+
+    // errors always get through
+    const bool8_t enabled = site->level >= min_level || site->level >= DNF_LOG_LEVEL_ERROR;
+    atomic_store_explicit(
+        &site->filter,
+        enabled ? DNF_LOG_SITE_FILTER_ENABLED : DNF_LOG_SITE_FILTER_DISABLED,
+        memory_order_relaxed);
+}
+
+/**
+ * @brief Recomputes the filters of all registered sites. Must be called
+ * with the filter lock held.
+ */
+static void update_site_filters(void)
+{
+    for (dnf_log_site *site = registered_sites; site; site = site->next)
+        update_site_filter(site);
+}
+
+/**
+ * @brief Adds a site to the registered sites and computes its filter.
+ */
+static void register_site(dnf_log_site *site)
+{
+    lock_filters();
+    if (!site->registered)
+    {
+        site->next = registered_sites;
+        registered_sites = site;
+        site->registered = true;
+        update_site_filter(site);
+    }
+    unlock_filters();
+}
+
+/**
+ * @brief Parses a logging level name (case-insensitive).
  *
- * @return True if the file write was successful.
+ * @param name Level name.
+ * @param length Name length.
+ * @param out_level Parsed level.
+ * @return False if the name is unknown.
  */
-static bool8_t flush_log_buffer_to_file(const char *filename)
+static bool8_t parse_level(const char *name, const size_t length, dnf_log_level *out_level)
 {
-    // no need to flush
-    if (log_buffer_pos == 0)
+    for (uint32_t level = 0; level < DNF_LOG_LEVEL_COUNT; level++)
+    {
+        const char *level_name = dnf_log_level_name(level);
+        if (strlen(level_name) != length)
+            continue;
+
+        size_t i = 0;
+        while (i < length && toupper((unsigned char)name[i]) == level_name[i])
+            i++;
+        if (i == length)
+        {
+            *out_level = (dnf_log_level)level;
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief Captures the wall clock time of the monotonic clock's "now", used
+ * to show record timestamps as dates. Must be called with the output lock
+ * held.
+ */
+static void init_clock_origin(void)
+{
+    if (clock_origin != 0)
+        return;
+
+    clock_origin = dnf_clock_now_ns();
+    wall_origin = (int64_t)time(nullptr);
+}
+
+/**
+ * @brief Opens the log file for appending (creating the log directory if
+ * needed). Must be called with the output lock held.
+ *
+ * @return True if the log file is open.
+ */
+static bool8_t open_log_file(void)
+{
+    if (log_file)
         return true;
+    if (log_file_failed)
+        return false;
 
-    if (!SaveFileData(filename, log_buffer, (int32_t)log_buffer_pos))
+    if (!DirectoryExists(DNF_LOG_DIRECTORY) && MakeDirectory(DNF_LOG_DIRECTORY) != 0)
+    {
+        log_file_failed = true;
+        return false;
+    }
+
+    char path[256];
+    snprintf(path, sizeof(path), DNF_LOG_DIRECTORY"/%s", log_file_name);
+    log_file = fopen(path, "ab");
+    if (!log_file)
+    {
+        log_file_failed = true;
         return false;
+    }
+    setvbuf(log_file, nullptr, _IOFBF, DNF_LOG_FILE_BUFFER_SIZE);
+
+    fseek(log_file, 0, SEEK_END);
+    const long size = ftell(log_file);
+    log_file_size = size > 0 ? (size_t)size : 0;
+
+    // every binary session (and rotated file) starts with a header and redefines its sites
+    if (log_format == DNF_LOG_FORMAT_BINARY)
+    {
+        init_clock_origin();
+
+        uint8_t header[32] = {0};
+        memcpy(header, DNF_LOG_BINARY_MAGIC, 8);
+        const uint32_t version = DNF_LOG_BINARY_VERSION;
+        memcpy(header + 8, &version, sizeof(version));
+        header[12] = (uint8_t)sizeof(long);
+        header[13] = (uint8_t)sizeof(void *);
+        memcpy(header + 16, &wall_origin, sizeof(wall_origin));
+        memcpy(header + 24, &clock_origin, sizeof(clock_origin));
+        fwrite(header, 1, sizeof(header), log_file);
+        log_file_size += sizeof(header);
 
-    log_buffer_pos = 0;
+        binary_generation++;
+        next_site_id = 0;
+    }
     return true;
 }
 
-bool8_t dnf_logger_init(void)
+/**
+ * @brief Closes the log file, writing out everything buffered. Must be
+ * called with the output lock held.
+ */
+static void close_log_file(void)
 {
-    // create log file if it doesn't exist
-    if (!DirectoryExists("./logs"))
-        if (MakeDirectory("./logs") != 0)
-            return false;
-    return true;
+    if (!log_file)
+        return;
+
+    fclose(log_file);
+    log_file = nullptr;
+    log_file_size = 0;
 }
 
-void dnf_logger_shutdown(void)
+/**
+ * @brief Moves the current log file to <name>.1 (shifting older
+ * rotated files, the oldest is removed) and starts a new one. Must be
+ * called with the output lock held.
+ */
+static void rotate_log_file(void)
 {
-    flush_log_buffer_to_file("./logs/"DNF_LOG_FILENAME);
+    close_log_file();
+
+    char from[256], to[256];
+    snprintf(to, sizeof(to), DNF_LOG_DIRECTORY"/%s.%d", log_file_name, DNF_LOG_MAX_ROTATED_FILES);
+    remove(to);
+    for (int32_t i = DNF_LOG_MAX_ROTATED_FILES; i >= 1; i--)
+    {
+        if (i > 1)
+            snprintf(from, sizeof(from), DNF_LOG_DIRECTORY"/%s.%d", log_file_name, i - 1);
+        else
+            snprintf(from, sizeof(from), DNF_LOG_DIRECTORY"/%s", log_file_name);
+        snprintf(to, sizeof(to), DNF_LOG_DIRECTORY"/%s.%d", log_file_name, i);
+        rename(from, to);
+    }
+
+    open_log_file();
 }
 
-void dnf_log_message(const char* file, const uint32_t line, const dnf_log_level level, const char* message, ...)
+/**
+ * @brief Makes sure the log file is open and has room for a write, rotating
+ * it when it grows too big. Must be called with the output lock held.
+ *
+ * @param size Size of the upcoming write.
+ * @return True if the log file can be written.
+ */
+static bool8_t reserve_log_file(const size_t size)
 {
-    const bool8_t is_error = level > DNF_LOG_LEVEL_WARN;
+    if (!open_log_file())
+        return false;
 
-    // message formatted with given args
-    char formatted_message[DNF_LOG_MAX_MSG_LENGTH] = {0};
+    if (log_file_size > 0 && log_file_size + size > DNF_LOG_MAX_FILE_SIZE)
+        rotate_log_file();
+    return log_file != nullptr;
+}
+
+/**
+ * @brief Appends bytes to the log file. Must be called with the output
+ * lock held after reserve_log_file().
+ */
+static void append_log_file(const void *data, const size_t size)
+{
+    // stdio writes data bigger than its buffer straight through, nothing is dropped
+    fwrite(data, 1, size, log_file);
+    log_file_size += size;
+}
 
-    // time formatting
-    time_t timer;
-    struct tm tm_info;
-    char time_buffer[32];
-    time(&timer);
-    localtime_s(&tm_info, &timer);
-    strftime(time_buffer, 32, "%Y-%m-%d %H:%M:%S", &tm_info);
+/**
+ * @brief Converts a record timestamp to wall clock seconds.
+ */
+static int64_t record_wall_time(const uint64_t timestamp)
+{
+    return wall_origin + ((int64_t)(timestamp - clock_origin)) / 1000000000;
+}
 
-    // pasting in variadic arguments
-    va_list arg_ptr = nullptr;
-    va_start(arg_ptr, message);
-    vsnprintf(formatted_message, DNF_LOG_MAX_MSG_LENGTH, message, arg_ptr);
-    va_end(arg_ptr);
+/**
+ * @brief Formats a full log line and writes it to the console and (in text
+ * format) the log file. Must be called with the output lock held.
+ *
+ * @param record Record header.
+ * @param message Formatted message.
+ * @param to_file Also write the line to the log file.
+ */
+static void write_text(const dnf_log_record *record, const char *message, const bool8_t to_file)
+{
+    const bool8_t is_error = record->level > DNF_LOG_LEVEL_WARN;
 
     // full log line
-    char out_message[DNF_LOG_MAX_MSG_LENGTH];
-    const uint32_t message_len = sprintf_s(
-        out_message,
-        DNF_LOG_MAX_MSG_LENGTH,
-        "%s - [%s] in (%s:%d): %s\n",
-        time_buffer, log_level_names[level], file, line, formatted_message);
+    char out_message[DNF_LOG_MAX_MSG_LENGTH + 256];
+    const size_t message_len = dnf_log_format_line(
+        out_message, sizeof(out_message),
+        record_wall_time(record->timestamp), record->level, record->file, record->line, message);
 
     // print to stdout/stderr (should work on Windows and Linux?)
     if (is_error)
@@ -110,14 +448,602 @@ void dnf_log_message(const char* file, const uint32_t line, const dnf_log_level
     else
         fprintf(stdout, "%s", out_message);
 
-    // flush buffer if overflown
-    if (message_len >= DNF_LOG_MAX_MSG_LENGTH || log_buffer_pos + message_len >= DNF_LOG_BUFFER_SIZE)
-        flush_log_buffer_to_file("./logs/"DNF_LOG_FILENAME);
+    if (to_file && reserve_log_file(message_len))
+    {
+        append_log_file(out_message, message_len);
+
+        // errors must reach the disk even if the program dies right after
+        if (is_error)
+            fflush(log_file);
+    }
+}
+
+/**
+ * @brief Writes a record to the binary log file (and its site, if this
+ * file doesn't have it yet). Must be called with the output lock held.
+ *
+ * @param record Record header.
+ * @param payload Packed arguments (with a site) or the terminated message.
+ */
+static void write_binary(const dnf_log_record *record, const uint8_t *payload)
+{
+    static uint8_t buffer[DNF_LOG_MAX_MSG_LENGTH + 1024];
+    size_t size = 0;
+
+// appends a value/bytes to the record buffer
+#define DNF_PUT(data, bytes) { memcpy(buffer + size, (data), (bytes)); size += (bytes); }
+
+    const size_t file_length = strnlen(record->file, 512);
+    if (!reserve_log_file(file_length + record->length + 64))
+        return;
+
+    dnf_log_site *site = record->site;
+    if (site)
+    {
+        // ids are assigned per file, only the output lock holder touches them
+        if (site->binary_generation != binary_generation)
+        {
+            site->binary_generation = binary_generation;
+            site->binary_id = ++next_site_id;
+
+            const uint8_t type = DNF_LOG_RECORD_SITE;
+            const uint8_t level = (uint8_t)site->level;
+            const uint16_t file_length16 = (uint16_t)file_length;
+            const size_t format_length = strnlen(site->format, 4096);
+            const uint16_t format_length16 = (uint16_t)format_length;
+            DNF_PUT(&type, 1)
+            DNF_PUT(&site->binary_id, 4)
+            DNF_PUT(&level, 1)
+            DNF_PUT(&site->line, 4)
+            DNF_PUT(&file_length16, 2)
+            DNF_PUT(site->file, file_length)
+            DNF_PUT(&format_length16, 2)
+            DNF_PUT(site->format, format_length)
+        }
+
+        const uint8_t type = DNF_LOG_RECORD_MESSAGE;
+        DNF_PUT(&type, 1)
+        DNF_PUT(&site->binary_id, 4)
+        DNF_PUT(&record->timestamp, 8)
+        DNF_PUT(&record->length, 4)
+        append_log_file(buffer, size);
+        append_log_file(payload, record->length);
+    }
     else
     {
-        memcpy(log_buffer + log_buffer_pos, out_message, message_len);
-        log_buffer_pos += message_len;
+        const uint8_t type = DNF_LOG_RECORD_TEXT;
+        const uint8_t level = (uint8_t)record->level;
+        const uint16_t file_length16 = (uint16_t)file_length;
+        const uint32_t message_length = record->length > 0 ? record->length - 1 : 0;
+        DNF_PUT(&type, 1)
+        DNF_PUT(&level, 1)
+        DNF_PUT(&record->timestamp, 8)
+        DNF_PUT(&record->line, 4)
+        DNF_PUT(&file_length16, 2)
+        DNF_PUT(record->file, file_length)
+        DNF_PUT(&message_length, 4)
+        append_log_file(buffer, size);
+        append_log_file(payload, message_length);
     }
+
+#undef DNF_PUT
+
+    if (record->level > DNF_LOG_LEVEL_WARN)
+        fflush(log_file);
+}
+
+/**
+ * @brief Writes a record out in the current log format. Must be called
+ * with the output lock held.
+ *
+ * @param record Record header.
+ * @param payload Packed arguments (with a site) or the terminated message.
+ */
+static void write_record(const dnf_log_record *record, const uint8_t *payload)
+{
+    init_clock_origin();
+
+    const bool8_t binary = log_format == DNF_LOG_FORMAT_BINARY;
+
+    // the binary format only prints what deserves attention right away
+    if (!binary || record->level >= DNF_LOG_LEVEL_WARN)
+    {
+        if (record->site)
+        {
+            static char message[DNF_LOG_MAX_MSG_LENGTH];
+            dnf_log_format_packed(record->site->format, payload, record->length, message, sizeof(message));
+            write_text(record, message, !binary);
+        }
+        else
+            write_text(record, (const char *)payload, !binary);
+    }
+
+    if (binary)
+        write_binary(record, payload);
+}
+
+/**
+ * @brief Wakes the writer thread if it is sleeping (signals it only once).
+ */
+static void wake_writer(void)
+{
+    // order the record publication before checking the flag
+    atomic_thread_fence(memory_order_seq_cst);
+    if (atomic_load(&writer_sleeping) && atomic_exchange(&writer_sleeping, false))
+    {
+        mtx_lock(&writer_mutex);
+        cnd_signal(&writer_wake);
+        mtx_unlock(&writer_mutex);
+    }
+}
+
+/**
+ * @brief Pushes a record into the ring buffer. Lock-free for producers;
+ * only waits for the writer when the ring buffer is full.
+ *
+ * @param record Record header (cell_count is filled in).
+ * @param payload Payload of record->length bytes.
+ */
+static void ring_push(dnf_log_record *record, const void *payload)
+{
+    const uint8_t *bytes = payload;
+    const size_t total = sizeof(dnf_log_record) + record->length;
+    const size_t cell_count = (total + DNF_LOG_CELL_DATA - 1) / DNF_LOG_CELL_DATA;
+    record->cell_count = (uint16_t)cell_count;
+
+    // claim cell_count consecutive cells; the writer frees cells in order, so
+    // if the last one is free all of them are
+    size_t pos = atomic_load_explicit(&enqueue_pos, memory_order_relaxed);
+    for (;;)
+    {
+        const size_t last = pos + cell_count - 1;
+        const size_t sequence = atomic_load_explicit(
+            &ring[last & (DNF_LOG_RING_CELLS - 1)].sequence, memory_order_acquire);
+        const intptr_t diff = (intptr_t)sequence - (intptr_t)last;
+
+        if (diff == 0)
+        {
+            if (atomic_compare_exchange_weak_explicit(
+                &enqueue_pos, &pos, pos + cell_count, memory_order_relaxed, memory_order_relaxed))
+                break;
+        }
+        else if (diff < 0)
+        {
+            // full - never drop messages, wait for the writer instead
+            wake_writer();
+            thrd_yield();
+            pos = atomic_load_explicit(&enqueue_pos, memory_order_relaxed);
+        }
+        else
+            pos = atomic_load_explicit(&enqueue_pos, memory_order_relaxed);
+    }
+
+    // copy the header and the payload cell by cell
+    size_t copied = 0;
+    for (size_t i = 0; i < cell_count; i++)
+    {
+        dnf_log_cell *cell = &ring[(pos + i) & (DNF_LOG_RING_CELLS - 1)];
+        size_t offset = 0;
+        if (i == 0)
+        {
+            memcpy(cell->data, record, sizeof(dnf_log_record));
+            offset = sizeof(dnf_log_record);
+        }
+
+        size_t chunk = DNF_LOG_CELL_DATA - offset;
+        if (chunk > record->length - copied)
+            chunk = record->length - copied;
+        memcpy(cell->data + offset, bytes + copied, chunk);
+        copied += chunk;
+
+        atomic_store_explicit(&cell->sequence, pos + i + 1, memory_order_release);
+    }
+
+    // routine messages wait for the writer's next poll, urgent ones and a
+    // filling ring buffer wake it up right away
+    if (record->level >= DNF_LOG_LEVEL_WARN
+        || pos + cell_count - atomic_load_explicit(&written_pos, memory_order_relaxed) > DNF_LOG_RING_CELLS / 2)
+        wake_writer();
+}
+
+/**
+ * @brief Pops a record from the ring buffer (writer thread only).
+ *
+ * @param out_record Record header.
+ * @param out_payload Payload buffer of at least DNF_LOG_MAX_MSG_LENGTH bytes.
+ * @return True if a record was popped, false if the ring buffer is empty.
+ */
+static bool8_t ring_pop(dnf_log_record *out_record, uint8_t *out_payload)
+{
+    dnf_log_cell *first = &ring[dequeue_pos & (DNF_LOG_RING_CELLS - 1)];
+    if (atomic_load_explicit(&first->sequence, memory_order_acquire) != dequeue_pos + 1)
+        return false;
+
+    memcpy(out_record, first->data, sizeof(dnf_log_record));
+
+    size_t copied = 0;
+    const size_t total = out_record->length;
+    for (size_t i = 0; i < out_record->cell_count; i++)
+    {
+        const size_t pos = dequeue_pos + i;
+        dnf_log_cell *cell = &ring[pos & (DNF_LOG_RING_CELLS - 1)];
+
+        // the producer may still be filling the following cells
+        while (atomic_load_explicit(&cell->sequence, memory_order_acquire) != pos + 1)
+            thrd_yield();
+
+        const size_t offset = i == 0 ? sizeof(dnf_log_record) : 0;
+        size_t chunk = DNF_LOG_CELL_DATA - offset;
+        if (chunk > total - copied)
+            chunk = total - copied;
+        memcpy(out_payload + copied, cell->data + offset, chunk);
+        copied += chunk;
+
+        atomic_store_explicit(&cell->sequence, pos + DNF_LOG_RING_CELLS, memory_order_release);
+    }
+
+    dequeue_pos += out_record->cell_count;
+    return true;
+}
+
+/**
+ * @brief Writer thread main loop: formats and writes queued records, sleeps
+ * while there are none.
+ */
+static int writer_main(void *arg)
+{
+    (void)arg;
+
+    dnf_log_record record;
+    static uint8_t payload[DNF_LOG_MAX_MSG_LENGTH];
+
+    for (;;)
+    {
+        if (ring_pop(&record, payload))
+        {
+            lock_output();
+            write_record(&record, payload);
+            unlock_output();
+            atomic_store_explicit(&written_pos, dequeue_pos, memory_order_release);
+            continue;
+        }
+
+        if (atomic_load(&writer_stopping)
+            && atomic_load_explicit(&enqueue_pos, memory_order_acquire) == dequeue_pos)
+            break;
+
+        // nothing to do - sleep until a producer wakes us (or time out to be safe)
+        mtx_lock(&writer_mutex);
+        atomic_store(&writer_sleeping, true);
+        if (atomic_load_explicit(&enqueue_pos, memory_order_acquire) == dequeue_pos
+            && !atomic_load(&writer_stopping))
+        {
+            struct timespec deadline;
+            timespec_get(&deadline, TIME_UTC);
+            deadline.tv_nsec += DNF_LOG_WRITER_IDLE_NS;
+            if (deadline.tv_nsec >= 1000000000)
+            {
+                deadline.tv_sec++;
+                deadline.tv_nsec -= 1000000000;
+            }
+            cnd_timedwait(&writer_wake, &writer_mutex, &deadline);
+        }
+        atomic_store(&writer_sleeping, false);
+        mtx_unlock(&writer_mutex);
+    }
+
+    return 0;
+}
+
+bool8_t dnf_logger_init(const bool8_t async, const dnf_log_format format)
+{
+    // create the log directory and open the log file
+    lock_output();
+    if (format != log_format)
+    {
+        close_log_file();
+        log_format = format;
+        log_file_name = format == DNF_LOG_FORMAT_BINARY ? DNF_LOG_BINARY_FILENAME : DNF_LOG_FILENAME;
+    }
+    init_clock_origin();
+    log_file_failed = false;
+    const bool8_t file_opened = open_log_file();
+    unlock_output();
+    if (!file_opened)
+        return false;
+
+    if (!async || atomic_load(&async_enabled))
+        return true;
+
+    // every cell starts free for the first lap
+    for (size_t i = 0; i < DNF_LOG_RING_CELLS; i++)
+        atomic_init(&ring[i].sequence, i);
+    atomic_store(&enqueue_pos, 0);
+    atomic_store(&written_pos, 0);
+    dequeue_pos = 0;
+    atomic_store(&writer_stopping, false);
+    atomic_store(&writer_sleeping, false);
+
+    if (mtx_init(&writer_mutex, mtx_plain) != thrd_success
+        || cnd_init(&writer_wake) != thrd_success
+        || thrd_create(&writer_thread, writer_main, nullptr) != thrd_success)
+    {
+        // stay synchronous
+        DNF_WARN("Could not start the log writer thread, logging synchronously");
+        return true;
+    }
+
+    atomic_store(&async_enabled, true);
+    return true;
+}
+
+void dnf_logger_flush(void)
+{
+    if (!atomic_load(&async_enabled))
+        return;
+
+    const size_t target = atomic_load_explicit(&enqueue_pos, memory_order_acquire);
+    while (atomic_load_explicit(&written_pos, memory_order_acquire) < target)
+    {
+        wake_writer();
+        thrd_yield();
+    }
+}
+
+void dnf_logger_shutdown(void)
+{
+    if (atomic_load(&async_enabled))
+    {
+        // go back to synchronous logging; producers that saw the asynchronous
+        // mode finish their pushes first (the writer keeps draining, so a
+        // full ring buffer frees up)
+        atomic_store(&async_enabled, false);
+        while (atomic_load(&active_producers) > 0)
+        {
+            wake_writer();
+            thrd_yield();
+        }
+
+        // nothing is pushed anymore, the writer stops once the queue is empty
+        atomic_store(&writer_stopping, true);
+        mtx_lock(&writer_mutex);
+        cnd_signal(&writer_wake);
+        mtx_unlock(&writer_mutex);
+        thrd_join(writer_thread, nullptr);
+
+        cnd_destroy(&writer_wake);
+        mtx_destroy(&writer_mutex);
+
+        // write out whatever is still queued
+        static uint8_t payload[DNF_LOG_MAX_MSG_LENGTH];
+        dnf_log_record record;
+        while (ring_pop(&record, payload))
+        {
+            lock_output();
+            write_record(&record, payload);
+            unlock_output();
+        }
+        atomic_store_explicit(&written_pos, dequeue_pos, memory_order_release);
+    }
+
+    lock_output();
+    close_log_file();
+    unlock_output();
+}
+
+/**
+ * @brief Submits a record: queues it for the writer thread in asynchronous
+ * mode, writes it right away otherwise.
+ *
+ * @param record Record header.
+ * @param payload Record payload.
+ */
+static void submit_record(dnf_log_record *record, const void *payload)
+{
+    if (atomic_load(&async_enabled))
+    {
+        // announce the push before checking the mode again: shutdown either
+        // waits for it, or this record goes the synchronous way
+        atomic_fetch_add(&active_producers, 1);
+        if (atomic_load(&async_enabled))
+        {
+            // formatting and output happen on the writer thread
+            ring_push(record, payload);
+            atomic_fetch_sub(&active_producers, 1);
+
+            // the program may not survive a fatal error, get it out now
+            if (record->level == DNF_LOG_LEVEL_FATAL)
+                dnf_logger_flush();
+            return;
+        }
+        atomic_fetch_sub(&active_producers, 1);
+    }
+
+    lock_output();
+    write_record(record, payload);
+    unlock_output();
+}
+
+/**
+ * @brief Formats a message on the calling thread and submits it.
+ */
+static void submit_formatted(
+    const char *file, const uint32_t line, const dnf_log_level level,
+    const uint64_t timestamp, const char *message, va_list args)
+{
+    // message formatted with given args
+    char formatted_message[DNF_LOG_MAX_MSG_LENGTH];
+    int32_t length = vsnprintf(formatted_message, DNF_LOG_MAX_MSG_LENGTH, message, args);
+    if (length < 0)
+        length = 0;
+    if (length >= DNF_LOG_MAX_MSG_LENGTH)
+        length = DNF_LOG_MAX_MSG_LENGTH - 1;
+    formatted_message[length] = '\0';
+
+    dnf_log_record record = {
+        .timestamp = timestamp,
+        .site = nullptr,
+        .file = file,
+        .line = line,
+        .length = (uint32_t)length + 1,  // with the terminator
+        .level = (uint16_t)level,
+        .cell_count = 0,
+    };
+    submit_record(&record, formatted_message);
+}
+
+/**
+ * @brief Checks whether a site's arguments can be packed, parsing its format
+ * on first use.
+ *
+ * @param site Call site.
+ * @return True if the arguments can be packed.
+ */
+static bool8_t site_is_packable(dnf_log_site *site)
+{
+    int state = atomic_load_explicit(&site->state, memory_order_acquire);
+    if (state == DNF_LOG_SITE_UNPARSED)
+    {
+        if (!atomic_compare_exchange_strong(&site->state, &state, DNF_LOG_SITE_PARSING))
+            return state == DNF_LOG_SITE_PACKED;
+
+        const bool8_t packable = dnf_log_parse_signature(site->format, &site->signature);
+        atomic_store_explicit(
+            &site->state, packable ? DNF_LOG_SITE_PACKED : DNF_LOG_SITE_TEXT, memory_order_release);
+        return packable;
+    }
+
+    // still being parsed by another thread - format this one as text
+    return state == DNF_LOG_SITE_PACKED;
+}
+
+void dnf_logger_set_level(const dnf_log_level level)
+{
+    lock_filters();
+    atomic_store(&runtime_level, level);
+    update_site_filters();
+    unlock_filters();
+}
+
+bool8_t dnf_logger_set_module_level(const char *module, const dnf_log_level level)
+{
+    if (!module || !*module || strlen(module) >= DNF_LOG_MAX_MODULE_NAME)
+        return false;
+
+    lock_filters();
+    uint32_t index = 0;
+    while (index < module_level_count && strcmp(module_levels[index].name, module) != 0)
+        index++;
+
+    if (index == DNF_LOG_MAX_MODULES)
+    {
+        unlock_filters();
+        return false;
+    }
+    if (index == module_level_count)
+    {
+        strcpy(module_levels[index].name, module);
+        module_level_count++;
+    }
+    module_levels[index].level = level;
+
+    update_site_filters();
+    unlock_filters();
+    return true;
+}
+
+bool8_t dnf_logger_set_levels(const char *spec)
+{
+    bool8_t valid = true;
+
+    while (*spec)
+    {
+        const char *end = strchr(spec, ',');
+        if (!end)
+            end = spec + strlen(spec);
+
+        // "level" or "module=level"
+        const char *equals = memchr(spec, '=', (size_t)(end - spec));
+        dnf_log_level level;
+        if (!equals)
+        {
+            if (parse_level(spec, (size_t)(end - spec), &level))
+                dnf_logger_set_level(level);
+            else
+                valid = false;
+        }
+        else
+        {
+            char module[DNF_LOG_MAX_MODULE_NAME];
+            const size_t module_length = (size_t)(equals - spec);
+            if (module_length < sizeof(module)
+                && parse_level(equals + 1, (size_t)(end - equals - 1), &level))
+            {
+                memcpy(module, spec, module_length);
+                module[module_length] = '\0';
+                valid = dnf_logger_set_module_level(module, level) && valid;
+            }
+            else
+                valid = false;
+        }
+
+        spec = *end ? end + 1 : end;
+    }
+
+    return valid;
+}
+
+void dnf_log_site_message(dnf_log_site *site, ...)
+{
+    // first call - let the runtime levels decide
+    if (atomic_load_explicit(&site->filter, memory_order_relaxed) == DNF_LOG_SITE_FILTER_UNKNOWN)
+    {
+        register_site(site);
+        if (atomic_load_explicit(&site->filter, memory_order_relaxed) == DNF_LOG_SITE_FILTER_DISABLED)
+            return;
+    }
+
+    const uint64_t timestamp = dnf_clock_now_ns();
+
+    va_list arg_ptr;
+    va_start(arg_ptr, site);
+
+    if (atomic_load_explicit(&async_enabled, memory_order_relaxed) && site_is_packable(site))
+    {
+        // only copy the arguments, the writer formats them (or stores them as is)
+        uint8_t packed[DNF_LOG_MAX_MSG_LENGTH];
+        const size_t size = dnf_log_pack_args(&site->signature, arg_ptr, packed, sizeof(packed));
+        va_end(arg_ptr);
+
+        dnf_log_record record = {
+            .timestamp = timestamp,
+            .site = site,
+            .file = site->file,
+            .line = site->line,
+            .length = (uint32_t)size,
+            .level = (uint16_t)site->level,
+            .cell_count = 0,
+        };
+        submit_record(&record, packed);
+        return;
+    }
+
+    submit_formatted(site->file, site->line, site->level, timestamp, site->format, arg_ptr);
+    va_end(arg_ptr);
+}
+
+void dnf_log_message(const char* file, const uint32_t line, const dnf_log_level level, const char* message, ...)
+{
+    if ((int)level < atomic_load_explicit(&runtime_level, memory_order_relaxed) && level < DNF_LOG_LEVEL_ERROR)
+        return;
+
+    const uint64_t timestamp = dnf_clock_now_ns();
+
+    // pasting in variadic arguments
+    va_list arg_ptr;
+    va_start(arg_ptr, message);
+    submit_formatted(file, line, level, timestamp, message, arg_ptr);
+    va_end(arg_ptr);
 }
 
 void log_assertion_failure(const char *expression, const char *file, const uint32_t line, const char *message)
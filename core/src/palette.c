@@ -0,0 +1,129 @@
+// DNF (Doomed and Forgotten): a DOOM-style first-person shooter.
+// Copyright (C) 2025-2026  Alexandr Gorbatenko
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+#include "palette.h"
+
+// Steps of the default palette color cube per channel.
+#define DNF_PALETTE_CUBE_STEPS 6
+// Steps of the default palette gray ramp.
+#define DNF_PALETTE_GRAY_STEPS (DNF_PALETTE_SIZE - DNF_PALETTE_CUBE_STEPS * DNF_PALETTE_CUBE_STEPS * DNF_PALETTE_CUBE_STEPS)
+
+
+/**
+ * @brief Finds the palette color closest to an RGB triple by brute force.
+ */
+static uint8_t find_closest(const Color colors[DNF_PALETTE_SIZE], const int32_t r, const int32_t g, const int32_t b)
+{
+    uint32_t best = 0;
+    int32_t best_distance = INT32_MAX;
+    for (uint32_t i = 0; i < DNF_PALETTE_SIZE && best_distance > 0; i++)
+    {
+        // weighted a bit towards green, the eye is most sensitive to it
+        const int32_t dr = colors[i].r - r, dg = colors[i].g - g, db = colors[i].b - b;
+        const int32_t distance = 2 * dr * dr + 4 * dg * dg + 3 * db * db;
+        if (distance < best_distance)
+        {
+            best_distance = distance;
+            best = i;
+        }
+    }
+    return (uint8_t)best;
+}
+
+/**
+ * @brief Gets the inverse table entry of a color.
+ */
+static uint32_t inverse_slot(const Color color)
+{
+    const uint32_t shift = 8 - DNF_PALETTE_INVERSE_BITS;
+    return ((uint32_t)(color.r >> shift) << (2 * DNF_PALETTE_INVERSE_BITS))
+        | ((uint32_t)(color.g >> shift) << DNF_PALETTE_INVERSE_BITS)
+        | (uint32_t)(color.b >> shift);
+}
+
+void palette_init(dnf_palette *palette, const Color colors[DNF_PALETTE_SIZE])
+{
+    for (uint32_t i = 0; i < DNF_PALETTE_SIZE; i++)
+        palette->colors[i] = colors[i];
+
+    // inverse table: the center of every RGB555 cell
+    const int32_t cells = 1 << DNF_PALETTE_INVERSE_BITS;
+    const int32_t cell_size = 256 / cells;
+    for (int32_t r = 0; r < cells; r++)
+        for (int32_t g = 0; g < cells; g++)
+            for (int32_t b = 0; b < cells; b++)
+                palette->inverse[(r * cells + g) * cells + b] = find_closest(
+                    colors,
+                    r * cell_size + cell_size / 2,
+                    g * cell_size + cell_size / 2,
+                    b * cell_size + cell_size / 2);
+
+    // colormaps are exact (not through the inverse table), they are small
+    for (uint32_t level = 0; level < DNF_PALETTE_LIGHT_LEVELS; level++)
+    {
+        for (uint32_t i = 0; i < DNF_PALETTE_SIZE; i++)
+        {
+            palette->colormaps[level][i] = find_closest(
+                colors,
+                (int32_t)(colors[i].r * level / (DNF_PALETTE_LIGHT_LEVELS - 1)),
+                (int32_t)(colors[i].g * level / (DNF_PALETTE_LIGHT_LEVELS - 1)),
+                (int32_t)(colors[i].b * level / (DNF_PALETTE_LIGHT_LEVELS - 1)));
+        }
+    }
+}
+
+void palette_init_default(dnf_palette *palette)
+{
+    Color colors[DNF_PALETTE_SIZE];
+    uint32_t count = 0;
+
+    for (uint32_t r = 0; r < DNF_PALETTE_CUBE_STEPS; r++)
+        for (uint32_t g = 0; g < DNF_PALETTE_CUBE_STEPS; g++)
+            for (uint32_t b = 0; b < DNF_PALETTE_CUBE_STEPS; b++)
+                colors[count++] = (Color){
+                    (uint8_t)(r * 255 / (DNF_PALETTE_CUBE_STEPS - 1)),
+                    (uint8_t)(g * 255 / (DNF_PALETTE_CUBE_STEPS - 1)),
+                    (uint8_t)(b * 255 / (DNF_PALETTE_CUBE_STEPS - 1)),
+                    255
+                };
+
+    // the cube only has 6 grays, and dark scenes are mostly gray
+    for (uint32_t i = 0; i < DNF_PALETTE_GRAY_STEPS; i++)
+    {
+        const uint8_t gray = (uint8_t)((i + 1) * 255 / (DNF_PALETTE_GRAY_STEPS + 1));
+        colors[count++] = (Color){ gray, gray, gray, 255 };
+    }
+
+    palette_init(palette, colors);
+}
+
+uint8_t palette_find(const dnf_palette *palette, const Color color)
+{
+    return palette->inverse[inverse_slot(color)];
+}
+
+uint32_t palette_light_level(const float32_t light)
+{
+    if (light <= 0.0f)
+        return 0;
+    if (light >= 1.0f)
+        return DNF_PALETTE_LIGHT_LEVELS - 1;
+    return (uint32_t)(light * (float32_t)(DNF_PALETTE_LIGHT_LEVELS - 1) + 0.5f);
+}
+
+uint8_t palette_light(const dnf_palette *palette, const uint8_t index, const uint32_t level)
+{
+    return palette->colormaps[level < DNF_PALETTE_LIGHT_LEVELS ? level : DNF_PALETTE_LIGHT_LEVELS - 1][index];
+}
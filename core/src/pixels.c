@@ -0,0 +1,1499 @@
+// DNF (Doomed and Forgotten): a DOOM-style first-person shooter.
+// Copyright (C) 2025-2026  Alexandr Gorbatenko
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+#include "pixels.h"
+
+#include "palette.h"
+
+#include <string.h>  // memcpy, memset
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+    #define DNF_PIXELS_X86 1
+    #include <immintrin.h>
+    #if defined(_MSC_VER)
+        #include <intrin.h>  // __cpuidex, _xgetbv
+    #else
+        #include <cpuid.h>   // __get_cpuid_count
+    #endif
+#elif defined(__aarch64__) || defined(_M_ARM64) || (defined(__ARM_NEON) && defined(__arm__))
+    #define DNF_PIXELS_NEON 1
+    #include <arm_neon.h>
+#endif
+
+// Code paths using instructions beyond the build's baseline.
+#if defined(DNF_PIXELS_X86) && (defined(__GNUC__) || defined(__clang__))
+    #define DNF_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+    #define DNF_TARGET_AVX2
+#endif
+
+// Fills this big (bytes) bypass the cache: the pixels won't be read again
+// before the upload and would only evict everything else.
+#define DNF_PIXELS_STREAM_THRESHOLD (256 * 1024)
+
+// Alpha bits of a Color loaded as a little-endian uint32_t.
+#define DNF_PIXELS_ALPHA_MASK 0xff000000u
+
+// Transposes go tile by tile, so both the source and the destination tile
+// stay in L1 (32x32 pixels = 4 KB each).
+#define DNF_PIXELS_TRANSPOSE_TILE 32
+
+// Fractional bits of texture coordinates stepped down a column.
+#define DNF_PIXELS_TEXEL_FRACTION 16
+
+// Pixels of a masked column gathered on the stack before the keyed copy.
+#define DNF_PIXELS_MASKED_RUN 64
+
+
+/**
+ * @brief Texel coordinates stepped in fixed point across a power-of-two
+ * row-major texture (a flat).
+ */
+typedef struct dnf_texel_walk
+{
+    uint32_t u;           //!< Texel column at the first pixel (DNF_PIXELS_TEXEL_FRACTION fraction bits)
+    uint32_t v;           //!< Texel row at the first pixel
+    uint32_t u_step;      //!< Texel columns per pixel
+    uint32_t v_step;      //!< Texel rows per pixel
+    uint32_t u_mask;      //!< Texture width - 1
+    uint32_t v_mask;      //!< Texture height - 1
+    uint32_t width_bits;  //!< Texture width as a power of two
+} dnf_texel_walk;
+
+/**
+ * @brief Kernels of one instruction set. Pixels are Colors treated as
+ * uint32_t values.
+ */
+typedef struct dnf_pixel_kernels
+{
+    void (*fill)(uint32_t *dst, size_t count, uint32_t value);         //!< Fills a run of pixels
+    void (*copy_keyed)(uint32_t *dst, const uint32_t *src, size_t count);  //!< Copies non-transparent pixels
+    void (*transpose)(uint32_t *dst, size_t dst_stride,                 //!< Transposes a rows x cols block
+        const uint32_t *src, size_t src_stride, size_t rows, size_t cols);
+    void (*expand)(uint32_t *dst, const uint8_t *src, size_t count,    //!< Converts palette indices to pixels
+        const uint32_t *palette);
+    void (*span_textured)(uint32_t *dst, size_t count,                 //!< Draws texels along a walk, shaded
+        const uint32_t *texels, const dnf_texel_walk *walk, uint32_t scale);
+} dnf_pixel_kernels;
+
+/**
+ * @brief Pixels in storage order: a row-major view of a framebuffer (a
+ * column-major framebuffer is stored as its transpose).
+ */
+typedef struct dnf_pixel_storage
+{
+    uint8_t *bytes;       //!< Pixels
+    int32_t width;        //!< Length of a contiguous run (row or column)
+    int32_t height;       //!< Number of runs
+    uint32_t pixel_size;  //!< Bytes per pixel
+} dnf_pixel_storage;
+
+/**
+ * @brief Converts a color to its pixel value.
+ */
+static uint32_t color_to_pixel(const Color color)
+{
+    uint32_t value;
+    memcpy(&value, &color, sizeof(value));
+    return value;
+}
+
+/**
+ * @brief Gets the storage of a framebuffer.
+ */
+static dnf_pixel_storage storage_of(const dnf_framebuffer *fb)
+{
+    const uint32_t pixel_size = fb->format == DNF_PIXEL_FORMAT_INDEXED8 ? sizeof(uint8_t) : sizeof(uint32_t);
+    if (fb->layout == DNF_FRAMEBUFFER_COLUMN_MAJOR)
+        return (dnf_pixel_storage){ fb->pixels, fb->height, fb->width, pixel_size };
+    return (dnf_pixel_storage){ fb->pixels, fb->width, fb->height, pixel_size };
+}
+
+/**
+ * @brief Gets a pointer to a pixel in storage coordinates.
+ */
+static void *storage_at(const dnf_pixel_storage *storage, const int32_t x, const int32_t y)
+{
+    return storage->bytes + ((size_t)y * storage->width + x) * storage->pixel_size;
+}
+
+/**
+ * @brief Converts a color to a pixel value of a framebuffer (a palette
+ * index for indexed framebuffers).
+ */
+static uint32_t color_to_value(const dnf_framebuffer *fb, const Color color)
+{
+    if (fb->format == DNF_PIXEL_FORMAT_INDEXED8)
+        return palette_find(fb->palette, color);
+    return color_to_pixel(color);
+}
+
+/**
+ * @brief Converts framebuffer coordinates to storage coordinates.
+ */
+static void to_storage(const dnf_framebuffer *fb, int32_t *x, int32_t *y)
+{
+    if (fb->layout == DNF_FRAMEBUFFER_COLUMN_MAJOR)
+    {
+        const int32_t t = *x;
+        *x = *y;
+        *y = t;
+    }
+}
+
+/**
+ * @brief Records that rows [y0; y1) of a framebuffer were written (already
+ * clipped).
+ */
+static void mark_rows(const dnf_framebuffer *fb, const int32_t y0, const int32_t y1)
+{
+    if (!fb->dirty || y0 >= y1)
+        return;
+
+    // test before storing: once set, the tiles stay shared between the cores
+    const int32_t last = (y1 - 1) / DNF_FRAMEBUFFER_DIRTY_TILE;
+    for (int32_t tile = y0 / DNF_FRAMEBUFFER_DIRTY_TILE; tile <= last; tile++)
+    {
+        if (!atomic_load_explicit(&fb->dirty->tiles[tile], memory_order_relaxed))
+            atomic_store_explicit(&fb->dirty->tiles[tile], 1, memory_order_relaxed);
+    }
+}
+
+/**
+ * @brief Scales the color channels of a pixel (alpha is kept).
+ *
+ * @param scale Light in 1/256 steps, [0; 256].
+ */
+static uint32_t shade_pixel(const uint32_t pixel, const uint32_t scale)
+{
+    // red and blue, then green, each with room for the product
+    const uint32_t red_blue = ((pixel & 0x00ff00ffu) * scale >> 8) & 0x00ff00ffu;
+    const uint32_t green = ((pixel & 0x0000ff00u) * scale >> 8) & 0x0000ff00u;
+    return red_blue | green | (pixel & DNF_PIXELS_ALPHA_MASK);
+}
+
+/**
+ * @brief Gets the texel a walk is at.
+ */
+static uint32_t walk_texel(const dnf_texel_walk *walk, const uint32_t u, const uint32_t v)
+{
+    return ((v >> DNF_PIXELS_TEXEL_FRACTION) & walk->v_mask) << walk->width_bits
+        | ((u >> DNF_PIXELS_TEXEL_FRACTION) & walk->u_mask);
+}
+
+
+// scalar kernels (any CPU)
+
+/**
+ * @brief Fills a run of pixels with a value.
+ */
+static void fill_scalar(uint32_t *dst, const size_t count, const uint32_t value)
+{
+    for (size_t i = 0; i < count; i++)
+        dst[i] = value;
+}
+
+/**
+ * @brief Copies a run of pixels, skipping transparent ones.
+ */
+static void copy_keyed_scalar(uint32_t *dst, const uint32_t *src, const size_t count)
+{
+    for (size_t i = 0; i < count; i++)
+        if (src[i] & DNF_PIXELS_ALPHA_MASK)
+            dst[i] = src[i];
+}
+
+/**
+ * @brief Transposes a block of rows x cols source pixels into cols x rows
+ * destination pixels (dst[c][r] = src[r][c]).
+ */
+static void transpose_scalar(
+    uint32_t *dst, const size_t dst_stride,
+    const uint32_t *src, const size_t src_stride,
+    const size_t rows, const size_t cols)
+{
+    for (size_t r = 0; r < rows; r++)
+        for (size_t c = 0; c < cols; c++)
+            dst[c * dst_stride + r] = src[r * src_stride + c];
+}
+
+/**
+ * @brief Converts palette indices to pixels.
+ */
+static void expand_scalar(uint32_t *dst, const uint8_t *src, size_t count, const uint32_t *palette)
+{
+    for (; count >= 4; count -= 4, src += 4, dst += 4)
+    {
+        dst[0] = palette[src[0]];
+        dst[1] = palette[src[1]];
+        dst[2] = palette[src[2]];
+        dst[3] = palette[src[3]];
+    }
+    for (; count > 0; count--)
+        *dst++ = palette[*src++];
+}
+
+/**
+ * @brief Draws a run of texels along a walk.
+ *
+ * @param scale Light in 1/256 steps (256 - the texels as they are).
+ */
+static void span_textured_scalar(
+    uint32_t *dst, const size_t count,
+    const uint32_t *texels, const dnf_texel_walk *walk, const uint32_t scale)
+{
+    uint32_t u = walk->u, v = walk->v;
+    if (scale == 256)
+    {
+        // full light is the common case, keep the loop to the bare fetches
+        for (size_t i = 0; i < count; i++, u += walk->u_step, v += walk->v_step)
+            dst[i] = texels[walk_texel(walk, u, v)];
+        return;
+    }
+    for (size_t i = 0; i < count; i++, u += walk->u_step, v += walk->v_step)
+        dst[i] = shade_pixel(texels[walk_texel(walk, u, v)], scale);
+}
+
+/**
+ * @brief Transposes the edges of a block a SIMD kernel left over: the
+ * columns from cols_done on, and the rows from rows_done on.
+ */
+static void transpose_edges(
+    uint32_t *dst, const size_t dst_stride,
+    const uint32_t *src, const size_t src_stride,
+    const size_t rows, const size_t cols,
+    const size_t rows_done, const size_t cols_done)
+{
+    transpose_scalar(dst + cols_done * dst_stride, dst_stride, src + cols_done, src_stride, rows_done, cols - cols_done);
+    transpose_scalar(dst + rows_done, dst_stride, src + rows_done * src_stride, src_stride, rows - rows_done, cols);
+}
+
+
+// SSE2 kernels
+
+#if defined(DNF_PIXELS_X86)
+
+/**
+ * @brief fill_scalar() with 16-byte stores.
+ */
+static void fill_sse2(uint32_t *dst, size_t count, const uint32_t value)
+{
+    // align to 16 bytes (pixels are 4-byte aligned)
+    while (count > 0 && ((uintptr_t)dst & 15) != 0)
+    {
+        *dst++ = value;
+        count--;
+    }
+
+    const __m128i v = _mm_set1_epi32((int32_t)value);
+    if (count * sizeof(uint32_t) >= DNF_PIXELS_STREAM_THRESHOLD)
+    {
+        for (; count >= 16; count -= 16, dst += 16)
+        {
+            _mm_stream_si128((__m128i *)dst + 0, v);
+            _mm_stream_si128((__m128i *)dst + 1, v);
+            _mm_stream_si128((__m128i *)dst + 2, v);
+            _mm_stream_si128((__m128i *)dst + 3, v);
+        }
+        _mm_sfence();
+    }
+    for (; count >= 16; count -= 16, dst += 16)
+    {
+        _mm_store_si128((__m128i *)dst + 0, v);
+        _mm_store_si128((__m128i *)dst + 1, v);
+        _mm_store_si128((__m128i *)dst + 2, v);
+        _mm_store_si128((__m128i *)dst + 3, v);
+    }
+    for (; count >= 4; count -= 4, dst += 4)
+        _mm_store_si128((__m128i *)dst, v);
+
+    fill_scalar(dst, count, value);
+}
+
+/**
+ * @brief copy_keyed_scalar() 4 pixels at a time.
+ */
+static void copy_keyed_sse2(uint32_t *dst, const uint32_t *src, size_t count)
+{
+    const __m128i alpha = _mm_set1_epi32((int32_t)DNF_PIXELS_ALPHA_MASK);
+    const __m128i zero = _mm_setzero_si128();
+    for (; count >= 4; count -= 4, dst += 4, src += 4)
+    {
+        const __m128i s = _mm_loadu_si128((const __m128i *)src);
+        const __m128i d = _mm_loadu_si128((const __m128i *)dst);
+        // all ones where the source is transparent: keep the destination there
+        const __m128i keep = _mm_cmpeq_epi32(_mm_and_si128(s, alpha), zero);
+        _mm_storeu_si128((__m128i *)dst, _mm_or_si128(_mm_and_si128(keep, d), _mm_andnot_si128(keep, s)));
+    }
+
+    copy_keyed_scalar(dst, src, count);
+}
+
+/**
+ * @brief transpose_scalar() in 4x4 blocks.
+ */
+static void transpose_sse2(
+    uint32_t *dst, const size_t dst_stride,
+    const uint32_t *src, const size_t src_stride,
+    const size_t rows, const size_t cols)
+{
+    const size_t rows4 = rows & ~(size_t)3, cols4 = cols & ~(size_t)3;
+    for (size_t r = 0; r < rows4; r += 4)
+    {
+        for (size_t c = 0; c < cols4; c += 4)
+        {
+            const uint32_t *s = src + r * src_stride + c;
+            const __m128i a0 = _mm_loadu_si128((const __m128i *)(s + 0 * src_stride));
+            const __m128i a1 = _mm_loadu_si128((const __m128i *)(s + 1 * src_stride));
+            const __m128i a2 = _mm_loadu_si128((const __m128i *)(s + 2 * src_stride));
+            const __m128i a3 = _mm_loadu_si128((const __m128i *)(s + 3 * src_stride));
+
+            const __m128i t0 = _mm_unpacklo_epi32(a0, a1);  // 00 10 01 11
+            const __m128i t1 = _mm_unpacklo_epi32(a2, a3);  // 20 30 21 31
+            const __m128i t2 = _mm_unpackhi_epi32(a0, a1);  // 02 12 03 13
+            const __m128i t3 = _mm_unpackhi_epi32(a2, a3);  // 22 32 23 33
+
+            uint32_t *d = dst + c * dst_stride + r;
+            _mm_storeu_si128((__m128i *)(d + 0 * dst_stride), _mm_unpacklo_epi64(t0, t1));
+            _mm_storeu_si128((__m128i *)(d + 1 * dst_stride), _mm_unpackhi_epi64(t0, t1));
+            _mm_storeu_si128((__m128i *)(d + 2 * dst_stride), _mm_unpacklo_epi64(t2, t3));
+            _mm_storeu_si128((__m128i *)(d + 3 * dst_stride), _mm_unpackhi_epi64(t2, t3));
+        }
+    }
+
+    transpose_edges(dst, dst_stride, src, src_stride, rows, cols, rows4, cols4);
+}
+
+
+// AVX2 kernels
+//
+// Every kernel ends with _mm256_zeroupper(): compilers do not always clear
+// the upper halves after target("avx2") code, and the SSE code running next
+// (the float math of the renderers) is slowed down until something does.
+
+/**
+ * @brief fill_scalar() with 32-byte stores.
+ */
+DNF_TARGET_AVX2 static void fill_avx2(uint32_t *dst, size_t count, const uint32_t value)
+{
+    // align to 32 bytes
+    while (count > 0 && ((uintptr_t)dst & 31) != 0)
+    {
+        *dst++ = value;
+        count--;
+    }
+
+    const __m256i v = _mm256_set1_epi32((int32_t)value);
+    if (count * sizeof(uint32_t) >= DNF_PIXELS_STREAM_THRESHOLD)
+    {
+        for (; count >= 32; count -= 32, dst += 32)
+        {
+            _mm256_stream_si256((__m256i *)dst + 0, v);
+            _mm256_stream_si256((__m256i *)dst + 1, v);
+            _mm256_stream_si256((__m256i *)dst + 2, v);
+            _mm256_stream_si256((__m256i *)dst + 3, v);
+        }
+        _mm_sfence();
+    }
+    for (; count >= 32; count -= 32, dst += 32)
+    {
+        _mm256_store_si256((__m256i *)dst + 0, v);
+        _mm256_store_si256((__m256i *)dst + 1, v);
+        _mm256_store_si256((__m256i *)dst + 2, v);
+        _mm256_store_si256((__m256i *)dst + 3, v);
+    }
+    for (; count >= 8; count -= 8, dst += 8)
+        _mm256_store_si256((__m256i *)dst, v);
+
+    _mm256_zeroupper();
+    fill_scalar(dst, count, value);
+}
+
+/**
+ * @brief copy_keyed_scalar() 8 pixels at a time.
+ */
+DNF_TARGET_AVX2 static void copy_keyed_avx2(uint32_t *dst, const uint32_t *src, size_t count)
+{
+    const __m256i alpha = _mm256_set1_epi32((int32_t)DNF_PIXELS_ALPHA_MASK);
+    const __m256i zero = _mm256_setzero_si256();
+    for (; count >= 8; count -= 8, dst += 8, src += 8)
+    {
+        const __m256i s = _mm256_loadu_si256((const __m256i *)src);
+        const __m256i d = _mm256_loadu_si256((const __m256i *)dst);
+        const __m256i keep = _mm256_cmpeq_epi32(_mm256_and_si256(s, alpha), zero);
+        _mm256_storeu_si256((__m256i *)dst, _mm256_blendv_epi8(s, d, keep));
+    }
+
+    _mm256_zeroupper();
+    copy_keyed_scalar(dst, src, count);
+}
+
+/**
+ * @brief transpose_scalar() in 8x8 blocks.
+ */
+DNF_TARGET_AVX2 static void transpose_avx2(
+    uint32_t *dst, const size_t dst_stride,
+    const uint32_t *src, const size_t src_stride,
+    const size_t rows, const size_t cols)
+{
+    const size_t rows8 = rows & ~(size_t)7, cols8 = cols & ~(size_t)7;
+    for (size_t r = 0; r < rows8; r += 8)
+    {
+        for (size_t c = 0; c < cols8; c += 8)
+        {
+            const uint32_t *s = src + r * src_stride + c;
+            __m256i a[8];
+            for (uint32_t i = 0; i < 8; i++)
+                a[i] = _mm256_loadu_si256((const __m256i *)(s + i * src_stride));
+
+            // pairs of rows, then quads (per 128-bit lane), then swap the lanes
+            __m256i t[8], u[8];
+            for (uint32_t i = 0; i < 8; i += 4)
+            {
+                t[i + 0] = _mm256_unpacklo_epi32(a[i + 0], a[i + 1]);
+                t[i + 1] = _mm256_unpackhi_epi32(a[i + 0], a[i + 1]);
+                t[i + 2] = _mm256_unpacklo_epi32(a[i + 2], a[i + 3]);
+                t[i + 3] = _mm256_unpackhi_epi32(a[i + 2], a[i + 3]);
+                u[i + 0] = _mm256_unpacklo_epi64(t[i + 0], t[i + 2]);
+                u[i + 1] = _mm256_unpackhi_epi64(t[i + 0], t[i + 2]);
+                u[i + 2] = _mm256_unpacklo_epi64(t[i + 1], t[i + 3]);
+                u[i + 3] = _mm256_unpackhi_epi64(t[i + 1], t[i + 3]);
+            }
+
+            uint32_t *d = dst + c * dst_stride + r;
+            for (uint32_t i = 0; i < 4; i++)
+            {
+                _mm256_storeu_si256((__m256i *)(d + i * dst_stride), _mm256_permute2x128_si256(u[i], u[i + 4], 0x20));
+                _mm256_storeu_si256((__m256i *)(d + (i + 4) * dst_stride), _mm256_permute2x128_si256(u[i], u[i + 4], 0x31));
+            }
+        }
+    }
+
+    _mm256_zeroupper();
+    transpose_edges(dst, dst_stride, src, src_stride, rows, cols, rows8, cols8);
+}
+
+/**
+ * @brief span_textured_scalar() with 8-texel gathers.
+ */
+DNF_TARGET_AVX2 static void span_textured_avx2(
+    uint32_t *dst, const size_t count,
+    const uint32_t *texels, const dnf_texel_walk *walk, const uint32_t scale)
+{
+    // eight consecutive coordinates, stepped eight pixels at a time
+    const __m256i lanes = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+    __m256i u = _mm256_add_epi32(_mm256_set1_epi32((int32_t)walk->u),
+        _mm256_mullo_epi32(lanes, _mm256_set1_epi32((int32_t)walk->u_step)));
+    __m256i v = _mm256_add_epi32(_mm256_set1_epi32((int32_t)walk->v),
+        _mm256_mullo_epi32(lanes, _mm256_set1_epi32((int32_t)walk->v_step)));
+    const __m256i u_step = _mm256_set1_epi32((int32_t)(walk->u_step * 8));
+    const __m256i v_step = _mm256_set1_epi32((int32_t)(walk->v_step * 8));
+    const __m256i u_mask = _mm256_set1_epi32((int32_t)walk->u_mask);
+    const __m256i v_mask = _mm256_set1_epi32((int32_t)walk->v_mask);
+    const __m128i width_bits = _mm_cvtsi32_si128((int32_t)walk->width_bits);
+
+    const __m256i light = _mm256_set1_epi32((int32_t)scale);
+    const __m256i red_blue = _mm256_set1_epi32(0x00ff00ff);
+    const __m256i green = _mm256_set1_epi32(0x0000ff00);
+    const __m256i alpha = _mm256_set1_epi32((int32_t)DNF_PIXELS_ALPHA_MASK);
+
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        const __m256i row = _mm256_and_si256(_mm256_srli_epi32(v, DNF_PIXELS_TEXEL_FRACTION), v_mask);
+        const __m256i column = _mm256_and_si256(_mm256_srli_epi32(u, DNF_PIXELS_TEXEL_FRACTION), u_mask);
+        __m256i pixels = _mm256_i32gather_epi32(
+            (const int *)texels, _mm256_or_si256(_mm256_sll_epi32(row, width_bits), column), 4);
+        if (scale != 256)
+        {
+            // shade_pixel() on all eight
+            const __m256i rb = _mm256_and_si256(
+                _mm256_srli_epi32(_mm256_mullo_epi32(_mm256_and_si256(pixels, red_blue), light), 8), red_blue);
+            const __m256i g = _mm256_and_si256(
+                _mm256_srli_epi32(_mm256_mullo_epi32(_mm256_and_si256(pixels, green), light), 8), green);
+            pixels = _mm256_or_si256(_mm256_or_si256(rb, g), _mm256_and_si256(pixels, alpha));
+        }
+        _mm256_storeu_si256((__m256i *)(dst + i), pixels);
+        u = _mm256_add_epi32(u, u_step);
+        v = _mm256_add_epi32(v, v_step);
+    }
+
+    dnf_texel_walk rest = *walk;
+    rest.u += (uint32_t)i * walk->u_step;
+    rest.v += (uint32_t)i * walk->v_step;
+    _mm256_zeroupper();
+    span_textured_scalar(dst + i, count - i, texels, &rest, scale);
+}
+
+/**
+ * @brief expand_scalar() with 8-pixel gathers.
+ */
+DNF_TARGET_AVX2 static void expand_avx2(uint32_t *dst, const uint8_t *src, size_t count, const uint32_t *palette)
+{
+    for (; count >= 8; count -= 8, src += 8, dst += 8)
+    {
+        const __m256i indices = _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i *)src));
+        _mm256_storeu_si256((__m256i *)dst, _mm256_i32gather_epi32((const int *)palette, indices, 4));
+    }
+    _mm256_zeroupper();
+    expand_scalar(dst, src, count, palette);
+}
+
+/**
+ * @brief Runs CPUID.
+ */
+static void cpuid(const uint32_t leaf, uint32_t out_regs[4])
+{
+#if defined(_MSC_VER)
+    int regs[4];
+    __cpuidex(regs, (int)leaf, 0);
+    memcpy(out_regs, regs, sizeof(regs));
+#else
+    out_regs[0] = out_regs[1] = out_regs[2] = out_regs[3] = 0;
+    __get_cpuid_count(leaf, 0, &out_regs[0], &out_regs[1], &out_regs[2], &out_regs[3]);
+#endif
+}
+
+/**
+ * @brief Checks that the CPU has AVX2 and the OS saves the YMM registers.
+ */
+static bool8_t cpu_has_avx2(void)
+{
+    uint32_t regs[4];
+    cpuid(0, regs);
+    if (regs[0] < 7)
+        return false;
+
+    cpuid(1, regs);
+    const bool8_t osxsave = (regs[2] & (1u << 27)) != 0;
+    const bool8_t avx = (regs[2] & (1u << 28)) != 0;
+    if (!osxsave || !avx)
+        return false;
+
+    // XCR0: SSE and AVX state enabled by the OS
+#if defined(_MSC_VER)
+    const uint64_t xcr0 = _xgetbv(0);
+#else
+    uint32_t xcr0_low, xcr0_high;
+    __asm__ volatile("xgetbv" : "=a"(xcr0_low), "=d"(xcr0_high) : "c"(0));
+    const uint64_t xcr0 = ((uint64_t)xcr0_high << 32) | xcr0_low;
+#endif
+    if ((xcr0 & 0x6) != 0x6)
+        return false;
+
+    cpuid(7, regs);
+    return (regs[1] & (1u << 5)) != 0;
+}
+
+#endif  // DNF_PIXELS_X86
+
+
+// NEON kernels
+
+#if defined(DNF_PIXELS_NEON)
+
+/**
+ * @brief fill_scalar() with 16-byte stores.
+ */
+static void fill_neon(uint32_t *dst, size_t count, const uint32_t value)
+{
+    const uint32x4_t v = vdupq_n_u32(value);
+    for (; count >= 16; count -= 16, dst += 16)
+    {
+        vst1q_u32(dst + 0, v);
+        vst1q_u32(dst + 4, v);
+        vst1q_u32(dst + 8, v);
+        vst1q_u32(dst + 12, v);
+    }
+    for (; count >= 4; count -= 4, dst += 4)
+        vst1q_u32(dst, v);
+
+    fill_scalar(dst, count, value);
+}
+
+/**
+ * @brief copy_keyed_scalar() 4 pixels at a time.
+ */
+static void copy_keyed_neon(uint32_t *dst, const uint32_t *src, size_t count)
+{
+    const uint32x4_t alpha = vdupq_n_u32(DNF_PIXELS_ALPHA_MASK);
+    for (; count >= 4; count -= 4, dst += 4, src += 4)
+    {
+        const uint32x4_t s = vld1q_u32(src);
+        const uint32x4_t d = vld1q_u32(dst);
+        // all ones where the source is opaque: take the source there
+        const uint32x4_t take = vtstq_u32(s, alpha);
+        vst1q_u32(dst, vbslq_u32(take, s, d));
+    }
+
+    copy_keyed_scalar(dst, src, count);
+}
+
+/**
+ * @brief transpose_scalar() in 4x4 blocks.
+ */
+static void transpose_neon(
+    uint32_t *dst, const size_t dst_stride,
+    const uint32_t *src, const size_t src_stride,
+    const size_t rows, const size_t cols)
+{
+    const size_t rows4 = rows & ~(size_t)3, cols4 = cols & ~(size_t)3;
+    for (size_t r = 0; r < rows4; r += 4)
+    {
+        for (size_t c = 0; c < cols4; c += 4)
+        {
+            const uint32_t *s = src + r * src_stride + c;
+            const uint32x4x2_t p01 = vtrnq_u32(vld1q_u32(s), vld1q_u32(s + src_stride));  // 00 10 02 12, 01 11 03 13
+            const uint32x4x2_t p23 = vtrnq_u32(vld1q_u32(s + 2 * src_stride), vld1q_u32(s + 3 * src_stride));
+
+            uint32_t *d = dst + c * dst_stride + r;
+            vst1q_u32(d + 0 * dst_stride, vcombine_u32(vget_low_u32(p01.val[0]), vget_low_u32(p23.val[0])));
+            vst1q_u32(d + 1 * dst_stride, vcombine_u32(vget_low_u32(p01.val[1]), vget_low_u32(p23.val[1])));
+            vst1q_u32(d + 2 * dst_stride, vcombine_u32(vget_high_u32(p01.val[0]), vget_high_u32(p23.val[0])));
+            vst1q_u32(d + 3 * dst_stride, vcombine_u32(vget_high_u32(p01.val[1]), vget_high_u32(p23.val[1])));
+        }
+    }
+
+    transpose_edges(dst, dst_stride, src, src_stride, rows, cols, rows4, cols4);
+}
+
+#endif  // DNF_PIXELS_NEON
+
+
+// kernel selection
+
+// SSE2 and NEON have no gathers, table lookups are as fast as it gets there
+static const dnf_pixel_kernels scalar_kernels = {
+    fill_scalar, copy_keyed_scalar, transpose_scalar, expand_scalar, span_textured_scalar
+};
+#if defined(DNF_PIXELS_X86)
+static const dnf_pixel_kernels sse2_kernels = {
+    fill_sse2, copy_keyed_sse2, transpose_sse2, expand_scalar, span_textured_scalar
+};
+static const dnf_pixel_kernels avx2_kernels = {
+    fill_avx2, copy_keyed_avx2, transpose_avx2, expand_avx2, span_textured_avx2
+};
+#endif
+#if defined(DNF_PIXELS_NEON)
+static const dnf_pixel_kernels neon_kernels = {
+    fill_neon, copy_keyed_neon, transpose_neon, expand_scalar, span_textured_scalar
+};
+#endif
+
+static const char *isa_names[DNF_PIXEL_ISA_COUNT] = {
+    "auto", "scalar", "sse2", "avx2", "neon"
+};
+
+// selected kernels (scalar until pixels_init())
+static const dnf_pixel_kernels *kernels = &scalar_kernels;
+static dnf_pixel_isa selected_isa = DNF_PIXEL_ISA_SCALAR;
+
+
+bool8_t pixels_isa_supported(const dnf_pixel_isa isa)
+{
+    switch (isa)
+    {
+        case DNF_PIXEL_ISA_AUTO:
+        case DNF_PIXEL_ISA_SCALAR:
+            return true;
+#if defined(DNF_PIXELS_X86)
+        case DNF_PIXEL_ISA_SSE2:
+            return true;  // x86-64 baseline (32-bit builds are assumed to have it as well)
+        case DNF_PIXEL_ISA_AVX2:
+            return cpu_has_avx2();
+#endif
+#if defined(DNF_PIXELS_NEON)
+        case DNF_PIXEL_ISA_NEON:
+            return true;
+#endif
+        default:
+            return false;
+    }
+}
+
+dnf_pixel_isa pixels_init(dnf_pixel_isa requested)
+{
+    if (requested == DNF_PIXEL_ISA_AUTO || !pixels_isa_supported(requested))
+    {
+        // best first
+        static const dnf_pixel_isa preferred[] = {
+            DNF_PIXEL_ISA_AVX2, DNF_PIXEL_ISA_NEON, DNF_PIXEL_ISA_SSE2, DNF_PIXEL_ISA_SCALAR
+        };
+        for (uint32_t i = 0; i < sizeof(preferred) / sizeof(preferred[0]); i++)
+        {
+            if (pixels_isa_supported(preferred[i]))
+            {
+                requested = preferred[i];
+                break;
+            }
+        }
+    }
+
+    switch (requested)
+    {
+#if defined(DNF_PIXELS_X86)
+        case DNF_PIXEL_ISA_SSE2: kernels = &sse2_kernels; break;
+        case DNF_PIXEL_ISA_AVX2: kernels = &avx2_kernels; break;
+#endif
+#if defined(DNF_PIXELS_NEON)
+        case DNF_PIXEL_ISA_NEON: kernels = &neon_kernels; break;
+#endif
+        default:
+            requested = DNF_PIXEL_ISA_SCALAR;
+            kernels = &scalar_kernels;
+            break;
+    }
+
+    selected_isa = requested;
+    return selected_isa;
+}
+
+dnf_pixel_isa pixels_get_isa(void)
+{
+    return selected_isa;
+}
+
+const char *pixels_isa_name(const dnf_pixel_isa isa)
+{
+    return (uint32_t)isa < DNF_PIXEL_ISA_COUNT ? isa_names[isa] : "?";
+}
+
+dnf_pixel_isa pixels_isa_find(const char *name)
+{
+    for (uint32_t i = 0; i < DNF_PIXEL_ISA_COUNT; i++)
+        if (strcmp(isa_names[i], name) == 0)
+            return (dnf_pixel_isa)i;
+    return DNF_PIXEL_ISA_COUNT;
+}
+
+
+// drawing primitives
+
+/**
+ * @brief Fills a contiguous run of storage.
+ */
+static void storage_fill_run(const dnf_pixel_storage *storage, void *dst, const size_t count, const uint32_t value)
+{
+    if (storage->pixel_size == sizeof(uint8_t))
+        memset(dst, (int)value, count);
+    else
+        kernels->fill(dst, count, value);
+}
+
+/**
+ * @brief Fills a rectangle of storage (already clipped).
+ */
+static void storage_fill_rect(
+    const dnf_pixel_storage *storage,
+    const int32_t x0, const int32_t y0, const int32_t x1, const int32_t y1,
+    const uint32_t value)
+{
+    // full runs are one contiguous run
+    if (x0 == 0 && x1 == storage->width)
+    {
+        storage_fill_run(storage, storage_at(storage, 0, y0), (size_t)(y1 - y0) * storage->width, value);
+        return;
+    }
+
+    for (int32_t y = y0; y < y1; y++)
+        storage_fill_run(storage, storage_at(storage, x0, y), (size_t)(x1 - x0), value);
+}
+
+/**
+ * @brief Stores a pixel every stride pixels.
+ */
+static void fill_strided(uint32_t *pixel, const size_t stride, int32_t count, const uint32_t value)
+{
+    for (; count >= 4; count -= 4, pixel += 4 * stride)
+    {
+        pixel[0] = value;
+        pixel[stride] = value;
+        pixel[2 * stride] = value;
+        pixel[3 * stride] = value;
+    }
+    for (; count > 0; count--, pixel += stride)
+        *pixel = value;
+}
+
+/**
+ * @brief fill_strided() for palette indices.
+ */
+static void fill_strided_indices(uint8_t *pixel, const size_t stride, int32_t count, const uint8_t value)
+{
+    for (; count >= 4; count -= 4, pixel += 4 * stride)
+    {
+        pixel[0] = value;
+        pixel[stride] = value;
+        pixel[2 * stride] = value;
+        pixel[3 * stride] = value;
+    }
+    for (; count > 0; count--, pixel += stride)
+        *pixel = value;
+}
+
+/**
+ * @brief Fills a run across storage runs [y0; y1) at x (already clipped).
+ */
+static void storage_fill_across(
+    const dnf_pixel_storage *storage,
+    const int32_t x, const int32_t y0, const int32_t y1,
+    const uint32_t value)
+{
+    // one pixel per run: a vector can't help, the stores are what it costs
+    if (storage->pixel_size == sizeof(uint8_t))
+        fill_strided_indices(storage_at(storage, x, y0), (size_t)storage->width, y1 - y0, (uint8_t)value);
+    else
+        fill_strided(storage_at(storage, x, y0), (size_t)storage->width, y1 - y0, value);
+}
+
+/**
+ * @brief Fills a clipped rectangle with a pixel value.
+ */
+static void fill_rect_value(
+    const dnf_framebuffer *fb,
+    int32_t x0, int32_t y0, int32_t x1, int32_t y1,
+    const uint32_t value)
+{
+    if (x0 < 0) x0 = 0;
+    if (y0 < 0) y0 = 0;
+    if (x1 > fb->width) x1 = fb->width;
+    if (y1 > fb->height) y1 = fb->height;
+    if (x0 >= x1 || y0 >= y1)
+        return;
+
+    mark_rows(fb, y0, y1);
+    const dnf_pixel_storage storage = storage_of(fb);
+    to_storage(fb, &x0, &y0);
+    to_storage(fb, &x1, &y1);
+    storage_fill_rect(&storage, x0, y0, x1, y1, value);
+}
+
+/**
+ * @brief Fills a clipped horizontal span with a pixel value.
+ */
+static void fill_span_value(const dnf_framebuffer *fb, const int32_t y, int32_t x0, int32_t x1, const uint32_t value)
+{
+    if (y < 0 || y >= fb->height)
+        return;
+    if (x0 < 0) x0 = 0;
+    if (x1 > fb->width) x1 = fb->width;
+    if (x0 >= x1)
+        return;
+
+    mark_rows(fb, y, y + 1);
+    const dnf_pixel_storage storage = storage_of(fb);
+    if (fb->layout == DNF_FRAMEBUFFER_COLUMN_MAJOR)
+        storage_fill_across(&storage, y, x0, x1, value);
+    else
+        storage_fill_run(&storage, storage_at(&storage, x0, y), (size_t)(x1 - x0), value);
+}
+
+/**
+ * @brief Fills a clipped vertical run with a pixel value.
+ */
+static void fill_column_value(const dnf_framebuffer *fb, const int32_t x, int32_t y0, int32_t y1, const uint32_t value)
+{
+    if (x < 0 || x >= fb->width)
+        return;
+    if (y0 < 0) y0 = 0;
+    if (y1 > fb->height) y1 = fb->height;
+    if (y0 >= y1)
+        return;
+
+    mark_rows(fb, y0, y1);
+    const dnf_pixel_storage storage = storage_of(fb);
+    if (fb->layout == DNF_FRAMEBUFFER_COLUMN_MAJOR)
+        storage_fill_run(&storage, storage_at(&storage, y0, x), (size_t)(y1 - y0), value);
+    else
+        storage_fill_across(&storage, x, y0, y1, value);
+}
+
+void pixels_clear(const dnf_framebuffer *fb, const Color color)
+{
+    mark_rows(fb, 0, fb->height);
+    const dnf_pixel_storage storage = storage_of(fb);
+    storage_fill_run(&storage, fb->pixels, (size_t)fb->width * fb->height, color_to_value(fb, color));
+}
+
+void pixels_fill_rect(
+    const dnf_framebuffer *fb,
+    const int32_t x0, const int32_t y0, const int32_t x1, const int32_t y1,
+    const Color color)
+{
+    fill_rect_value(fb, x0, y0, x1, y1, color_to_value(fb, color));
+}
+
+void pixels_fill_span(const dnf_framebuffer *fb, const int32_t y, const int32_t x0, const int32_t x1, const Color color)
+{
+    fill_span_value(fb, y, x0, x1, color_to_value(fb, color));
+}
+
+void pixels_fill_column(const dnf_framebuffer *fb, const int32_t x, const int32_t y0, const int32_t y1, const Color color)
+{
+    fill_column_value(fb, x, y0, y1, color_to_value(fb, color));
+}
+
+void pixels_fill_rect_index(
+    const dnf_framebuffer *fb,
+    const int32_t x0, const int32_t y0, const int32_t x1, const int32_t y1,
+    const uint8_t index)
+{
+    fill_rect_value(fb, x0, y0, x1, y1, index);
+}
+
+void pixels_fill_span_index(const dnf_framebuffer *fb, const int32_t y, const int32_t x0, const int32_t x1, const uint8_t index)
+{
+    fill_span_value(fb, y, x0, x1, index);
+}
+
+void pixels_fill_column_index(const dnf_framebuffer *fb, const int32_t x, const int32_t y0, const int32_t y1, const uint8_t index)
+{
+    fill_column_value(fb, x, y0, y1, index);
+}
+
+void pixels_draw_column_textured(
+    const dnf_framebuffer *fb,
+    const int32_t x, int32_t y0, int32_t y1,
+    const Color *texels, const int32_t texel_count,
+    float32_t v, const float32_t v_step,
+    const float32_t light)
+{
+    if (x < 0 || x >= fb->width)
+        return;
+    if (y0 < 0)
+    {
+        v += v_step * (float32_t)-y0;
+        y0 = 0;
+    }
+    if (y1 > fb->height) y1 = fb->height;
+    if (y0 >= y1)
+        return;
+
+    mark_rows(fb, y0, y1);
+    const dnf_pixel_storage storage = storage_of(fb);
+    int32_t sx = x, sy = y0;
+    to_storage(fb, &sx, &sy);
+    // column-major columns are contiguous, row-major ones a row apart
+    const size_t stride = fb->layout == DNF_FRAMEBUFFER_COLUMN_MAJOR ? 1 : (size_t)storage.width;
+
+    // the coordinate wraps with the mask, in two's complement for negative ones
+    const uint32_t mask = (uint32_t)texel_count - 1;
+    uint32_t position = (uint32_t)(int32_t)(v * (float32_t)(1 << DNF_PIXELS_TEXEL_FRACTION));
+    const uint32_t step = (uint32_t)(int32_t)(v_step * (float32_t)(1 << DNF_PIXELS_TEXEL_FRACTION));
+
+    if (fb->format == DNF_PIXEL_FORMAT_INDEXED8)
+    {
+        const uint32_t level = palette_light_level(light);
+        uint8_t *pixel = storage_at(&storage, sx, sy);
+        for (int32_t y = y0; y < y1; y++, pixel += stride, position += step)
+        {
+            const Color texel = texels[(position >> DNF_PIXELS_TEXEL_FRACTION) & mask];
+            *pixel = palette_light(fb->palette, palette_find(fb->palette, texel), level);
+        }
+        return;
+    }
+
+    const uint32_t scale = light >= 1.0f ? 256 : light <= 0.0f ? 0 : (uint32_t)(light * 256.0f);
+    uint32_t *pixel = storage_at(&storage, sx, sy);
+    for (int32_t y = y0; y < y1; y++, pixel += stride, position += step)
+        *pixel = shade_pixel(color_to_pixel(texels[(position >> DNF_PIXELS_TEXEL_FRACTION) & mask]), scale);
+}
+
+void pixels_draw_column_textured_index(
+    const dnf_framebuffer *fb,
+    const int32_t x, int32_t y0, int32_t y1,
+    const uint8_t *texels, const int32_t texel_count,
+    float32_t v, const float32_t v_step,
+    const float32_t light)
+{
+    if (x < 0 || x >= fb->width)
+        return;
+    if (y0 < 0)
+    {
+        v += v_step * (float32_t)-y0;
+        y0 = 0;
+    }
+    if (y1 > fb->height) y1 = fb->height;
+    if (y0 >= y1)
+        return;
+
+    mark_rows(fb, y0, y1);
+    const dnf_pixel_storage storage = storage_of(fb);
+    int32_t sx = x, sy = y0;
+    to_storage(fb, &sx, &sy);
+    const size_t stride = fb->layout == DNF_FRAMEBUFFER_COLUMN_MAJOR ? 1 : (size_t)storage.width;
+
+    const uint32_t mask = (uint32_t)texel_count - 1;
+    uint32_t position = (uint32_t)(int32_t)(v * (float32_t)(1 << DNF_PIXELS_TEXEL_FRACTION));
+    const uint32_t step = (uint32_t)(int32_t)(v_step * (float32_t)(1 << DNF_PIXELS_TEXEL_FRACTION));
+
+    const uint8_t *colormap = fb->palette->colormaps[palette_light_level(light)];
+    uint8_t *pixel = storage_at(&storage, sx, sy);
+    for (int32_t y = y0; y < y1; y++, pixel += stride, position += step)
+        *pixel = colormap[texels[(position >> DNF_PIXELS_TEXEL_FRACTION) & mask]];
+}
+
+/**
+ * @brief Converts a texel coordinate to fixed point, keeping the low bits of
+ * coordinates too big for 32 bits (they only wrap).
+ */
+static uint32_t to_fixed(const float32_t value)
+{
+    return (uint32_t)(int64_t)(value * (float32_t)(1 << DNF_PIXELS_TEXEL_FRACTION));
+}
+
+void pixels_draw_span_textured(
+    const dnf_framebuffer *fb,
+    const int32_t y, int32_t x0, int32_t x1,
+    const Color *texels, const int32_t texel_width, const int32_t texel_height,
+    float32_t u, float32_t v,
+    const float32_t u_step, const float32_t v_step,
+    const float32_t light)
+{
+    if (y < 0 || y >= fb->height)
+        return;
+    if (x0 < 0)
+    {
+        u += u_step * (float32_t)-x0;
+        v += v_step * (float32_t)-x0;
+        x0 = 0;
+    }
+    if (x1 > fb->width) x1 = fb->width;
+    if (x0 >= x1)
+        return;
+
+    mark_rows(fb, y, y + 1);
+    const dnf_pixel_storage storage = storage_of(fb);
+    int32_t sx = x0, sy = y;
+    to_storage(fb, &sx, &sy);
+    // row-major rows are contiguous, column-major ones a column apart
+    const size_t stride = fb->layout == DNF_FRAMEBUFFER_COLUMN_MAJOR ? (size_t)storage.width : 1;
+
+    // both coordinates wrap with the masks; the row is shifted into place
+    const uint32_t u_mask = (uint32_t)texel_width - 1;
+    const uint32_t v_mask = (uint32_t)texel_height - 1;
+    uint32_t width_bits = 0;
+    while ((1u << width_bits) < (uint32_t)texel_width)
+        width_bits++;
+    uint32_t u_position = to_fixed(u), v_position = to_fixed(v);
+    const uint32_t u_delta = to_fixed(u_step), v_delta = to_fixed(v_step);
+
+    if (fb->format == DNF_PIXEL_FORMAT_INDEXED8)
+    {
+        const uint32_t level = palette_light_level(light);
+        uint8_t *pixel = storage_at(&storage, sx, sy);
+        for (int32_t x = x0; x < x1; x++, pixel += stride, u_position += u_delta, v_position += v_delta)
+        {
+            const Color texel = texels[
+                ((v_position >> DNF_PIXELS_TEXEL_FRACTION) & v_mask) << width_bits
+                | ((u_position >> DNF_PIXELS_TEXEL_FRACTION) & u_mask)];
+            *pixel = palette_light(fb->palette, palette_find(fb->palette, texel), level);
+        }
+        return;
+    }
+
+    const uint32_t scale = light >= 1.0f ? 256 : light <= 0.0f ? 0 : (uint32_t)(light * 256.0f);
+    const uint32_t *source = (const uint32_t *)texels;
+    uint32_t *pixel = storage_at(&storage, sx, sy);
+    if (stride == 1)
+    {
+        // contiguous row: the kernel steps several texels at a time
+        const dnf_texel_walk walk = {
+            .u = u_position, .v = v_position,
+            .u_step = u_delta, .v_step = v_delta,
+            .u_mask = u_mask, .v_mask = v_mask,
+            .width_bits = width_bits
+        };
+        kernels->span_textured(pixel, (size_t)(x1 - x0), source, &walk, scale);
+        return;
+    }
+    if (scale == 256)
+    {
+        // full light is the common case, keep the loop to the bare fetches
+        for (int32_t x = x0; x < x1; x++, pixel += stride, u_position += u_delta, v_position += v_delta)
+            *pixel = source[
+                ((v_position >> DNF_PIXELS_TEXEL_FRACTION) & v_mask) << width_bits
+                | ((u_position >> DNF_PIXELS_TEXEL_FRACTION) & u_mask)];
+        return;
+    }
+    for (int32_t x = x0; x < x1; x++, pixel += stride, u_position += u_delta, v_position += v_delta)
+        *pixel = shade_pixel(source[
+            ((v_position >> DNF_PIXELS_TEXEL_FRACTION) & v_mask) << width_bits
+            | ((u_position >> DNF_PIXELS_TEXEL_FRACTION) & u_mask)], scale);
+}
+
+void pixels_draw_span_textured_index(
+    const dnf_framebuffer *fb,
+    const int32_t y, int32_t x0, int32_t x1,
+    const uint8_t *texels, const int32_t texel_width, const int32_t texel_height,
+    float32_t u, float32_t v,
+    const float32_t u_step, const float32_t v_step,
+    const float32_t light)
+{
+    if (y < 0 || y >= fb->height)
+        return;
+    if (x0 < 0)
+    {
+        u += u_step * (float32_t)-x0;
+        v += v_step * (float32_t)-x0;
+        x0 = 0;
+    }
+    if (x1 > fb->width) x1 = fb->width;
+    if (x0 >= x1)
+        return;
+
+    mark_rows(fb, y, y + 1);
+    const dnf_pixel_storage storage = storage_of(fb);
+    int32_t sx = x0, sy = y;
+    to_storage(fb, &sx, &sy);
+    const size_t stride = fb->layout == DNF_FRAMEBUFFER_COLUMN_MAJOR ? (size_t)storage.width : 1;
+
+    const uint32_t u_mask = (uint32_t)texel_width - 1;
+    const uint32_t v_mask = (uint32_t)texel_height - 1;
+    uint32_t width_bits = 0;
+    while ((1u << width_bits) < (uint32_t)texel_width)
+        width_bits++;
+    uint32_t u_position = to_fixed(u), v_position = to_fixed(v);
+    const uint32_t u_delta = to_fixed(u_step), v_delta = to_fixed(v_step);
+
+    const uint8_t *colormap = fb->palette->colormaps[palette_light_level(light)];
+    uint8_t *pixel = storage_at(&storage, sx, sy);
+    for (int32_t x = x0; x < x1; x++, pixel += stride, u_position += u_delta, v_position += v_delta)
+        *pixel = colormap[texels[
+            ((v_position >> DNF_PIXELS_TEXEL_FRACTION) & v_mask) << width_bits
+            | ((u_position >> DNF_PIXELS_TEXEL_FRACTION) & u_mask)]];
+}
+
+void pixels_draw_column_masked(
+    const dnf_framebuffer *fb,
+    const int32_t x, int32_t y0, int32_t y1,
+    const Color *texels, const int32_t texel_count,
+    float32_t v, const float32_t v_step,
+    const float32_t light)
+{
+    if (x < 0 || x >= fb->width || texel_count <= 0)
+        return;
+    if (y0 < 0)
+    {
+        v += v_step * (float32_t)-y0;
+        y0 = 0;
+    }
+    if (y1 > fb->height) y1 = fb->height;
+    if (y0 >= y1)
+        return;
+
+    mark_rows(fb, y0, y1);
+    const dnf_pixel_storage storage = storage_of(fb);
+    int32_t sx = x, sy = y0;
+    to_storage(fb, &sx, &sy);
+    const size_t stride = fb->layout == DNF_FRAMEBUFFER_COLUMN_MAJOR ? 1 : (size_t)storage.width;
+
+    // coordinates only grow down the column, so clamping the end is enough
+    const uint32_t last = (uint32_t)texel_count - 1;
+    uint32_t position = (uint32_t)((v > 0.0f ? v : 0.0f) * (float32_t)(1 << DNF_PIXELS_TEXEL_FRACTION));
+    const uint32_t step = (uint32_t)((v_step > 0.0f ? v_step : 0.0f) * (float32_t)(1 << DNF_PIXELS_TEXEL_FRACTION));
+
+    if (fb->format == DNF_PIXEL_FORMAT_INDEXED8)
+    {
+        const uint32_t level = palette_light_level(light);
+        uint8_t *pixel = storage_at(&storage, sx, sy);
+        for (int32_t y = y0; y < y1; y++, pixel += stride, position += step)
+        {
+            const uint32_t t = position >> DNF_PIXELS_TEXEL_FRACTION;
+            const Color texel = texels[t < last ? t : last];
+            if (texel.a)
+                *pixel = palette_light(fb->palette, palette_find(fb->palette, texel), level);
+        }
+        return;
+    }
+
+    const uint32_t scale = light >= 1.0f ? 256 : light <= 0.0f ? 0 : (uint32_t)(light * 256.0f);
+    uint32_t *pixel = storage_at(&storage, sx, sy);
+    if (stride != 1)
+    {
+        for (int32_t y = y0; y < y1; y++, pixel += stride, position += step)
+        {
+            const uint32_t t = position >> DNF_PIXELS_TEXEL_FRACTION;
+            const uint32_t texel = color_to_pixel(texels[t < last ? t : last]);
+            if (texel & DNF_PIXELS_ALPHA_MASK)
+                *pixel = shade_pixel(texel, scale);
+        }
+        return;
+    }
+
+    // contiguous column: gather a run of shaded texels (shading keeps the
+    // alpha), then let the keyed copy kernel select them in vector registers
+    uint32_t run[DNF_PIXELS_MASKED_RUN];
+    for (int32_t y = y0; y < y1;)
+    {
+        const int32_t count = y1 - y < DNF_PIXELS_MASKED_RUN ? y1 - y : DNF_PIXELS_MASKED_RUN;
+        for (int32_t i = 0; i < count; i++, position += step)
+        {
+            const uint32_t t = position >> DNF_PIXELS_TEXEL_FRACTION;
+            run[i] = shade_pixel(color_to_pixel(texels[t < last ? t : last]), scale);
+        }
+        kernels->copy_keyed(pixel, run, (size_t)count);
+        pixel += count;
+        y += count;
+    }
+}
+
+void pixels_draw_column_masked_index(
+    const dnf_framebuffer *fb,
+    const int32_t x, int32_t y0, int32_t y1,
+    const uint8_t *texels, const int32_t texel_count,
+    float32_t v, const float32_t v_step,
+    const float32_t light, const uint8_t transparent_index)
+{
+    if (x < 0 || x >= fb->width || texel_count <= 0)
+        return;
+    if (y0 < 0)
+    {
+        v += v_step * (float32_t)-y0;
+        y0 = 0;
+    }
+    if (y1 > fb->height) y1 = fb->height;
+    if (y0 >= y1)
+        return;
+
+    mark_rows(fb, y0, y1);
+    const dnf_pixel_storage storage = storage_of(fb);
+    int32_t sx = x, sy = y0;
+    to_storage(fb, &sx, &sy);
+    const size_t stride = fb->layout == DNF_FRAMEBUFFER_COLUMN_MAJOR ? 1 : (size_t)storage.width;
+
+    const uint32_t last = (uint32_t)texel_count - 1;
+    uint32_t position = (uint32_t)((v > 0.0f ? v : 0.0f) * (float32_t)(1 << DNF_PIXELS_TEXEL_FRACTION));
+    const uint32_t step = (uint32_t)((v_step > 0.0f ? v_step : 0.0f) * (float32_t)(1 << DNF_PIXELS_TEXEL_FRACTION));
+
+    const uint8_t *colormap = fb->palette->colormaps[palette_light_level(light)];
+    uint8_t *pixel = storage_at(&storage, sx, sy);
+    for (int32_t y = y0; y < y1; y++, pixel += stride, position += step)
+    {
+        const uint32_t t = position >> DNF_PIXELS_TEXEL_FRACTION;
+        const uint8_t texel = texels[t < last ? t : last];
+        if (texel != transparent_index)
+            *pixel = colormap[texel];
+    }
+}
+
+/**
+ * @brief Clips a blit rectangle to both framebuffers.
+ *
+ * @return False if nothing is left.
+ */
+static bool8_t clip_blit(
+    const dnf_framebuffer *dst, int32_t *dst_x, int32_t *dst_y,
+    const dnf_framebuffer *src, int32_t *src_x, int32_t *src_y,
+    int32_t *width, int32_t *height)
+{
+    // shift both origins together so the pixels stay paired
+    int32_t shift_x = 0, shift_y = 0;
+    if (-*dst_x > shift_x) shift_x = -*dst_x;
+    if (-*src_x > shift_x) shift_x = -*src_x;
+    if (-*dst_y > shift_y) shift_y = -*dst_y;
+    if (-*src_y > shift_y) shift_y = -*src_y;
+
+    *dst_x += shift_x;
+    *src_x += shift_x;
+    *width -= shift_x;
+    *dst_y += shift_y;
+    *src_y += shift_y;
+    *height -= shift_y;
+
+    if (*width > dst->width - *dst_x) *width = dst->width - *dst_x;
+    if (*width > src->width - *src_x) *width = src->width - *src_x;
+    if (*height > dst->height - *dst_y) *height = dst->height - *dst_y;
+    if (*height > src->height - *src_y) *height = src->height - *src_y;
+    return *width > 0 && *height > 0;
+}
+
+/**
+ * @brief Reads a pixel as a Color value (indices go through the palette).
+ */
+static uint32_t load_pixel(const dnf_framebuffer *fb, const dnf_pixel_storage *storage, int32_t x, int32_t y)
+{
+    to_storage(fb, &x, &y);
+    if (fb->format == DNF_PIXEL_FORMAT_INDEXED8)
+        return color_to_pixel(fb->palette->colors[*(const uint8_t *)storage_at(storage, x, y)]);
+    return *(const uint32_t *)storage_at(storage, x, y);
+}
+
+/**
+ * @brief Writes a Color value to a pixel (indexed framebuffers get the
+ * closest palette index).
+ */
+static void store_pixel(const dnf_framebuffer *fb, const dnf_pixel_storage *storage, int32_t x, int32_t y, const uint32_t pixel)
+{
+    to_storage(fb, &x, &y);
+    if (fb->format == DNF_PIXEL_FORMAT_INDEXED8)
+    {
+        Color color;
+        memcpy(&color, &pixel, sizeof(color));
+        *(uint8_t *)storage_at(storage, x, y) = palette_find(fb->palette, color);
+    }
+    else
+        *(uint32_t *)storage_at(storage, x, y) = pixel;
+}
+
+/**
+ * @brief Blits pixel by pixel, converting between any formats and layouts.
+ */
+static void blit_generic(
+    const dnf_framebuffer *dst, const int32_t dst_x, const int32_t dst_y,
+    const dnf_framebuffer *src, const int32_t src_x, const int32_t src_y,
+    const int32_t width, const int32_t height,
+    const bool8_t keyed)
+{
+    const dnf_pixel_storage dst_storage = storage_of(dst);
+    const dnf_pixel_storage src_storage = storage_of(src);
+    for (int32_t y = 0; y < height; y++)
+    {
+        for (int32_t x = 0; x < width; x++)
+        {
+            const uint32_t pixel = load_pixel(src, &src_storage, src_x + x, src_y + y);
+            if (!keyed || (pixel & DNF_PIXELS_ALPHA_MASK))
+                store_pixel(dst, &dst_storage, dst_x + x, dst_y + y, pixel);
+        }
+    }
+}
+
+/**
+ * @brief Transposes 8-bit storage (already clipped, in source storage
+ * coordinates).
+ */
+static void transpose_indices(
+    uint8_t *dst, const size_t dst_stride,
+    const uint8_t *src, const size_t src_stride,
+    const int32_t rows, const int32_t cols)
+{
+    for (int32_t y = 0; y < rows; y += DNF_PIXELS_TRANSPOSE_TILE)
+    {
+        const int32_t tile_rows = rows - y < DNF_PIXELS_TRANSPOSE_TILE ? rows - y : DNF_PIXELS_TRANSPOSE_TILE;
+        for (int32_t x = 0; x < cols; x += DNF_PIXELS_TRANSPOSE_TILE)
+        {
+            const int32_t tile_cols = cols - x < DNF_PIXELS_TRANSPOSE_TILE ? cols - x : DNF_PIXELS_TRANSPOSE_TILE;
+            for (int32_t r = y; r < y + tile_rows; r++)
+                for (int32_t c = x; c < x + tile_cols; c++)
+                    dst[(size_t)c * dst_stride + r] = src[(size_t)r * src_stride + c];
+        }
+    }
+}
+
+void pixels_blit(
+    const dnf_framebuffer *dst, int32_t dst_x, int32_t dst_y,
+    const dnf_framebuffer *src, int32_t src_x, int32_t src_y,
+    int32_t width, int32_t height)
+{
+    if (!clip_blit(dst, &dst_x, &dst_y, src, &src_x, &src_y, &width, &height))
+        return;
+    mark_rows(dst, dst_y, dst_y + height);
+
+    // quantizing to a palette has no fast path (nothing needs one)
+    const bool8_t expand = src->format == DNF_PIXEL_FORMAT_INDEXED8 && dst->format == DNF_PIXEL_FORMAT_RGBA8;
+    if (src->format != dst->format && !expand)
+    {
+        blit_generic(dst, dst_x, dst_y, src, src_x, src_y, width, height, false);
+        return;
+    }
+
+    const dnf_pixel_storage dst_storage = storage_of(dst);
+    const dnf_pixel_storage src_storage = storage_of(src);
+    to_storage(dst, &dst_x, &dst_y);
+    to_storage(src, &src_x, &src_y);
+    to_storage(src, &width, &height);  // block size in source storage
+
+    if (dst->layout == src->layout)
+    {
+        // the C library's copy is already vectorized for every target
+        for (int32_t y = 0; y < height; y++)
+        {
+            void *dst_run = storage_at(&dst_storage, dst_x, dst_y + y);
+            const void *src_run = storage_at(&src_storage, src_x, src_y + y);
+            if (expand)
+                kernels->expand(dst_run, src_run, (size_t)width, (const uint32_t *)src->palette->colors);
+            else
+                memcpy(dst_run, src_run, (size_t)width * src_storage.pixel_size);
+        }
+        return;
+    }
+
+    // different layouts: the destination storage is the transpose of the source
+    if (src->format == DNF_PIXEL_FORMAT_INDEXED8 && !expand)
+    {
+        transpose_indices(
+            storage_at(&dst_storage, dst_x, dst_y), (size_t)dst_storage.width,
+            storage_at(&src_storage, src_x, src_y), (size_t)src_storage.width,
+            height, width);
+        return;
+    }
+
+    for (int32_t y = 0; y < height; y += DNF_PIXELS_TRANSPOSE_TILE)
+    {
+        const int32_t rows = height - y < DNF_PIXELS_TRANSPOSE_TILE ? height - y : DNF_PIXELS_TRANSPOSE_TILE;
+        for (int32_t x = 0; x < width; x += DNF_PIXELS_TRANSPOSE_TILE)
+        {
+            const int32_t cols = width - x < DNF_PIXELS_TRANSPOSE_TILE ? width - x : DNF_PIXELS_TRANSPOSE_TILE;
+            const uint32_t *tile = storage_at(&src_storage, src_x + x, src_y + y);
+            size_t tile_stride = (size_t)src_storage.width;
+
+            // expand the source tile first, then transpose it as usual
+            uint32_t expanded[DNF_PIXELS_TRANSPOSE_TILE * DNF_PIXELS_TRANSPOSE_TILE];
+            if (expand)
+            {
+                for (int32_t r = 0; r < rows; r++)
+                    kernels->expand(
+                        expanded + r * DNF_PIXELS_TRANSPOSE_TILE,
+                        storage_at(&src_storage, src_x + x, src_y + y + r),
+                        (size_t)cols, (const uint32_t *)src->palette->colors);
+                tile = expanded;
+                tile_stride = DNF_PIXELS_TRANSPOSE_TILE;
+            }
+
+            kernels->transpose(
+                storage_at(&dst_storage, dst_x + y, dst_y + x), (size_t)dst_storage.width,
+                tile, tile_stride, (size_t)rows, (size_t)cols);
+        }
+    }
+}
+
+void pixels_blit_keyed(
+    const dnf_framebuffer *dst, int32_t dst_x, int32_t dst_y,
+    const dnf_framebuffer *src, int32_t src_x, int32_t src_y,
+    int32_t width, int32_t height)
+{
+    if (!clip_blit(dst, &dst_x, &dst_y, src, &src_x, &src_y, &width, &height))
+        return;
+    mark_rows(dst, dst_y, dst_y + height);
+
+    // mixed layouts and palettes are rare here, go pixel by pixel
+    if (dst->layout != src->layout
+        || dst->format != DNF_PIXEL_FORMAT_RGBA8 || src->format != DNF_PIXEL_FORMAT_RGBA8)
+    {
+        blit_generic(dst, dst_x, dst_y, src, src_x, src_y, width, height, true);
+        return;
+    }
+
+    const dnf_pixel_storage dst_storage = storage_of(dst);
+    const dnf_pixel_storage src_storage = storage_of(src);
+    to_storage(dst, &dst_x, &dst_y);
+    to_storage(src, &src_x, &src_y);
+    to_storage(src, &width, &height);
+    for (int32_t y = 0; y < height; y++)
+        kernels->copy_keyed(
+            storage_at(&dst_storage, dst_x, dst_y + y),
+            storage_at(&src_storage, src_x, src_y + y),
+            (size_t)width);
+}
@@ -0,0 +1,976 @@
+// DNF (Doomed and Forgotten): a DOOM-style first-person shooter.
+// Copyright (C) 2025-2026  Alexandr Gorbatenko
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+
+#include "pvs.h"
+
+#include "dnf_memory.h"
+#include "job_system.h"
+#include "logger.h"
+
+#include <math.h>    // ceilf, cosf, sinf, floorf, sqrtf, fabsf, fminf, fmaxf
+#include <stdio.h>   // fopen, fwrite
+#include <string.h>  // memcpy, memcmp, memset
+
+// Spacing of the parallel lines sampled in every direction, in cells.
+#define DNF_PVS_LINE_SPACING 0.125f
+// Widest gap between two neighbouring line directions at the far end of the
+// map, in cells.
+#define DNF_PVS_LINE_GAP 0.25f
+// Half a turn in radians.
+#define DNF_PVS_HALF_TURN 3.14159265f
+// Depth a line must go into a wall cell to be stopped by it. Lines that only
+// clip a corner go on (unless the next cell is a wall too), which covers
+// the views between two sampled lines.
+#define DNF_PVS_WALL_MARGIN 0.05f
+// How far lines start inside the map bounds, and how far a leaf must reach
+// into a stretch of a line to be a part of it.
+#define DNF_PVS_LINE_STEP 0.001f
+// Margin around the level bounds (lines start and end in the void).
+#define DNF_PVS_LEVEL_MARGIN 1.0f
+// Hashes of the last marked stretches every job remembers (power of two).
+#define DNF_PVS_RECENT_STRETCHES 65536
+
+
+/**
+ * @brief Leaf along a sampled line.
+ */
+typedef struct dnf_pvs_leaf_span
+{
+    uint32_t leaf;
+    float32_t enter;  //!< Position along the line where it enters the leaf (0 to 1)
+    float32_t leave;  //!< Position along the line where it leaves the leaf (0 to 1)
+} dnf_pvs_leaf_span;
+
+/**
+ * @brief One-sided seg along a sampled line.
+ */
+typedef struct dnf_pvs_wall
+{
+    float32_t fraction;  //!< Position along the line where it crosses the seg (0 to 1)
+    uint32_t seg;
+} dnf_pvs_wall;
+
+/**
+ * @brief State of a build job.
+ */
+typedef struct dnf_pvs_job
+{
+    uint32_t *stretch;          //!< Clusters along an unblocked stretch of a line, in line order (no repeats in a row)
+    uint32_t stretch_count;     //!< Number of clusters in the stretch
+    uint64_t *recent;           //!< Hashes of marked stretches (DNF_PVS_RECENT_STRETCHES, direct-mapped)
+    uint64_t *row;              //!< Clusters of the stretch being marked (row_words, zero between stretches)
+
+    // BSP levels
+    dnf_pvs_leaf_span *leaves;  //!< Leaves the line crosses, in line order
+    uint32_t leaf_count;        //!< Number of leaves
+    dnf_pvs_wall *walls;        //!< One-sided segs the line crosses, nearest first
+    uint32_t wall_count;        //!< Number of walls
+} dnf_pvs_job;
+
+/**
+ * @brief Shared state of a PVS build.
+ */
+typedef struct dnf_pvs_builder
+{
+    uint32_t cluster_count;
+    uint32_t row_bytes;
+    uint32_t row_words;        //!< Row stride of the matrix
+    uint64_t *matrix;          //!< Uncompressed rows, cluster_count x row_words (little-endian, same bits as pvs.h rows)
+    uint32_t job_count;        //!< Jobs (every job fills the rows of every job_count-th cluster)
+
+    // sampled lines
+    float32_t min_x, min_y;    //!< Area the lines cross
+    float32_t max_x, max_y;
+    uint32_t angle_count;      //!< Line directions in half a turn
+    dnf_pvs_job *jobs;         //!< One per job
+
+    // grid maps
+    const dnf_grid_map *map;
+    int32_t cluster_size;
+    int32_t clusters_x;
+
+    // BSP levels
+    const dnf_bsp_level *level;
+} dnf_pvs_builder;
+
+
+/**
+ * @brief Marks a cluster in an uncompressed row.
+ */
+static void mark_cluster(uint64_t *row, const uint32_t cluster)
+{
+    row[cluster >> 6] |= 1ull << (cluster & 63);
+}
+
+/**
+ * @brief Gets the cluster of a grid cell.
+ */
+static uint32_t cell_cluster(const dnf_pvs_builder *builder, const int32_t x, const int32_t y)
+{
+    return (uint32_t)((y / builder->cluster_size) * builder->clusters_x + x / builder->cluster_size);
+}
+
+/**
+ * @brief Adds a cluster to a stretch.
+ */
+static void extend_stretch(dnf_pvs_job *job, const uint32_t cluster)
+{
+    if (job->stretch_count == 0 || job->stretch[job->stretch_count - 1] != cluster)
+        job->stretch[job->stretch_count++] = cluster;
+}
+
+/**
+ * @brief Marks the clusters of a stretch in the rows of each other (only
+ * the rows the job fills) and empties it.
+ */
+static void close_stretch(const dnf_pvs_builder *builder, dnf_pvs_job *job, const uint32_t job_index)
+{
+    const uint32_t *clusters = job->stretch;
+    const uint32_t count = job->stretch_count;
+    job->stretch_count = 0;
+
+    if (count < 2)
+        return;
+
+    // neighbouring lines mostly cross the same clusters, skip what was just marked
+    uint64_t hash = 0xcbf29ce484222325ull ^ count;
+    for (uint32_t i = 0; i < count; i++)
+        hash = (hash ^ clusters[i]) * 0x100000001b3ull;
+    uint64_t *recent = &job->recent[hash & (DNF_PVS_RECENT_STRETCHES - 1)];
+    if (*recent == hash)
+        return;
+    *recent = hash;
+
+    // clusters along a row of the map are a few words of a row apart, those
+    // are ORed in a word at a time; the rest is marked bit by bit
+    uint32_t first = UINT32_MAX, last = 0;
+    for (uint32_t i = 0; i < count; i++)
+    {
+        first = clusters[i] >> 6 < first ? clusters[i] >> 6 : first;
+        last = clusters[i] >> 6 > last ? clusters[i] >> 6 : last;
+    }
+    if (last - first >= count)
+    {
+        for (uint32_t i = 0; i < count; i++)
+        {
+            if (clusters[i] % builder->job_count != job_index)
+                continue;
+            uint64_t *row = builder->matrix + (size_t)clusters[i] * builder->row_words;
+            for (uint32_t j = 0; j < count; j++)
+                mark_cluster(row, clusters[j]);
+        }
+        return;
+    }
+
+    for (uint32_t i = 0; i < count; i++)
+        mark_cluster(job->row, clusters[i]);
+    for (uint32_t i = 0; i < count; i++)
+    {
+        if (clusters[i] % builder->job_count != job_index)
+            continue;
+        uint64_t *row = builder->matrix + (size_t)clusters[i] * builder->row_words;
+        for (uint32_t word = first; word <= last; word++)
+            row[word] |= job->row[word];
+    }
+    memset(job->row + first, 0, (last - first + 1) * sizeof(uint64_t));
+}
+
+/**
+ * @brief Clips a line to the area of a build.
+ *
+ * @param out_enter Position along the line where it enters the area.
+ * @param out_leave Position along the line where it leaves the area.
+ * @return False if the line misses the area.
+ */
+static bool8_t clip_line(
+    const dnf_pvs_builder *builder,
+    const float32_t x, const float32_t y, const float32_t dir_x, const float32_t dir_y,
+    float32_t *out_enter, float32_t *out_leave)
+{
+    float32_t enter = -INFINITY, leave = INFINITY;
+    const float32_t origins[2] = { x, y }, dirs[2] = { dir_x, dir_y };
+    const float32_t mins[2] = { builder->min_x, builder->min_y }, maxs[2] = { builder->max_x, builder->max_y };
+    for (uint32_t axis = 0; axis < 2; axis++)
+    {
+        if (dirs[axis] == 0.0f)
+        {
+            if (origins[axis] < mins[axis] || origins[axis] > maxs[axis])
+                return false;
+            continue;
+        }
+        const float32_t t0 = (mins[axis] - origins[axis]) / dirs[axis];
+        const float32_t t1 = (maxs[axis] - origins[axis]) / dirs[axis];
+        enter = fmaxf(enter, fminf(t0, t1));
+        leave = fminf(leave, fmaxf(t0, t1));
+    }
+    *out_enter = enter + DNF_PVS_LINE_STEP;
+    *out_leave = leave - DNF_PVS_LINE_STEP;
+    return *out_enter < *out_leave;
+}
+
+/**
+ * @brief Samples lines across the area of a build: angle_count directions,
+ * parallel lines DNF_PVS_LINE_SPACING apart in every direction.
+ *
+ * @param walk Called with the start and the end of every line.
+ */
+static void sample_lines(
+    const dnf_pvs_builder *builder, const uint32_t job_index,
+    void (*walk)(const dnf_pvs_builder *builder, uint32_t job_index,
+        float32_t x0, float32_t y0, float32_t x1, float32_t y1))
+{
+    const float32_t corners[4][2] = {
+        { builder->min_x, builder->min_y }, { builder->max_x, builder->min_y },
+        { builder->min_x, builder->max_y }, { builder->max_x, builder->max_y },
+    };
+    for (uint32_t a = 0; a < builder->angle_count; a++)
+    {
+        // half a step off the axes, lines never run along the cell borders
+        const float32_t angle = ((float32_t)a + 0.5f) * DNF_PVS_HALF_TURN / (float32_t)builder->angle_count;
+        const float32_t dir_x = cosf(angle), dir_y = sinf(angle);
+
+        // offsets of the lines along the normal that cover the area
+        float32_t low = INFINITY, high = -INFINITY;
+        for (uint32_t c = 0; c < 4; c++)
+        {
+            const float32_t offset = corners[c][0] * -dir_y + corners[c][1] * dir_x;
+            low = fminf(low, offset);
+            high = fmaxf(high, offset);
+        }
+
+        const uint32_t line_count = (uint32_t)ceilf((high - low) / DNF_PVS_LINE_SPACING);
+        for (uint32_t l = 0; l < line_count; l++)
+        {
+            const float32_t offset = low + ((float32_t)l + 0.5f) * DNF_PVS_LINE_SPACING;
+            const float32_t x = offset * -dir_y, y = offset * dir_x;
+            float32_t enter, leave;
+            if (clip_line(builder, x, y, dir_x, dir_y, &enter, &leave))
+                walk(builder, job_index, x + dir_x * enter, y + dir_y * enter, x + dir_x * leave, y + dir_y * leave);
+        }
+    }
+}
+
+/**
+ * @brief Traverses the grid along a line (DDA, like the raycaster) and
+ * splits it into stretches at the walls it goes deeper than
+ * DNF_PVS_WALL_MARGIN into or two walls in a row. A stretch includes the
+ * walls at both ends.
+ */
+static void walk_grid_line(
+    const dnf_pvs_builder *builder, const uint32_t job_index,
+    const float32_t x0, const float32_t y0, const float32_t x1, const float32_t y1)
+{
+    const dnf_grid_map *map = builder->map;
+    dnf_pvs_job *job = &builder->jobs[job_index];
+    const float32_t length = sqrtf((x1 - x0) * (x1 - x0) + (y1 - y0) * (y1 - y0));
+    const float32_t dir_x = (x1 - x0) / length, dir_y = (y1 - y0) / length;
+    int32_t cell_x = (int32_t)x0;
+    int32_t cell_y = (int32_t)y0;
+
+    const float32_t delta_x = dir_x != 0.0f ? fabsf(1.0f / dir_x) : INFINITY;
+    const float32_t delta_y = dir_y != 0.0f ? fabsf(1.0f / dir_y) : INFINITY;
+    const int32_t step_x = dir_x < 0.0f ? -1 : 1;
+    const int32_t step_y = dir_y < 0.0f ? -1 : 1;
+    float32_t side_x = dir_x < 0.0f ? (x0 - (float32_t)cell_x) * delta_x : ((float32_t)cell_x + 1.0f - x0) * delta_x;
+    float32_t side_y = dir_y < 0.0f ? (y0 - (float32_t)cell_y) * delta_y : ((float32_t)cell_y + 1.0f - y0) * delta_y;
+
+    // between stretches the line is inside walls, the last of them starts the next one
+    bool8_t open = false, grazed = false;
+    uint32_t last_wall = DNF_PVS_NO_CLUSTER;
+    float32_t enter = 0.0f;
+    while (cell_x >= 0 && cell_y >= 0 && cell_x < map->width && cell_y < map->height)
+    {
+        const float32_t leave = fminf(side_x, side_y);
+        const uint32_t cluster = cell_cluster(builder, cell_x, cell_y);
+        if (map->cells[cell_y * map->width + cell_x] == 0)
+        {
+            if (!open && last_wall != DNF_PVS_NO_CLUSTER)
+                extend_stretch(job, last_wall);
+            extend_stretch(job, cluster);
+            open = true;
+            grazed = false;
+        }
+        else if (!open)
+            last_wall = cluster;
+        else
+        {
+            extend_stretch(job, cluster);
+
+            // the middle of the chord through the cell is the deepest point
+            const float32_t middle = (enter + leave) * 0.5f;
+            const float32_t inside_x = x0 + dir_x * middle - (float32_t)cell_x;
+            const float32_t inside_y = y0 + dir_y * middle - (float32_t)cell_y;
+            const bool8_t deep = inside_x > DNF_PVS_WALL_MARGIN && inside_x < 1.0f - DNF_PVS_WALL_MARGIN
+                && inside_y > DNF_PVS_WALL_MARGIN && inside_y < 1.0f - DNF_PVS_WALL_MARGIN;
+            if (deep || grazed)
+            {
+                close_stretch(builder, job, job_index);
+                open = false;
+                last_wall = cluster;
+            }
+            grazed = !deep && !grazed;
+        }
+
+        enter = leave;
+        if (side_x < side_y)
+        {
+            side_x += delta_x;
+            cell_x += step_x;
+        }
+        else
+        {
+            side_y += delta_y;
+            cell_y += step_y;
+        }
+    }
+    close_stretch(builder, job, job_index);
+}
+
+/**
+ * @brief Fills the rows of every job_count-th grid cluster (job system).
+ *
+ * @param user_data Pointer to dnf_pvs_builder.
+ */
+static void build_grid_rows(const uint32_t job_index, void *user_data)
+{
+    const dnf_pvs_builder *builder = user_data;
+    for (uint32_t cluster = job_index; cluster < builder->cluster_count; cluster += builder->job_count)
+        mark_cluster(builder->matrix + (size_t)cluster * builder->row_words, cluster);
+    sample_lines(builder, job_index, walk_grid_line);
+}
+
+/**
+ * @brief Lists the leaves a part of a line crosses, walking the subtree with
+ * the pieces on either side of every partition (the near one first).
+ *
+ * @param enter Position along the line where the part starts.
+ * @param leave Position along the line where the part ends.
+ */
+static void collect_leaves(
+    const dnf_bsp_level *level, uint32_t child,
+    float32_t x0, float32_t y0, const float32_t x1, const float32_t y1,
+    float32_t enter, const float32_t leave,
+    dnf_pvs_job *job)
+{
+    // only the near pieces recurse, the far ones go on down in the loop
+    while (!(child & DNF_BSP_SUBSECTOR_BIT))
+    {
+        const dnf_bsp_node *node = &level->nodes[child];
+        const float32_t side0 = (x0 - node->x) * -node->dy + (y0 - node->y) * node->dx;
+        const float32_t side1 = (x1 - node->x) * -node->dy + (y1 - node->y) * node->dx;
+        if ((side0 >= 0.0f) == (side1 >= 0.0f))
+        {
+            child = node->children[side0 >= 0.0f ? 0 : 1];
+            continue;
+        }
+
+        const float32_t t = side0 / (side0 - side1);
+        const float32_t split_x = x0 + (x1 - x0) * t, split_y = y0 + (y1 - y0) * t;
+        const float32_t split = enter + (leave - enter) * t;
+        collect_leaves(level, node->children[side0 >= 0.0f ? 0 : 1], x0, y0, split_x, split_y, enter, split, job);
+        child = node->children[side1 >= 0.0f ? 0 : 1];
+        x0 = split_x;
+        y0 = split_y;
+        enter = split;
+    }
+
+    job->leaves[job->leaf_count++] = (dnf_pvs_leaf_span){
+        .leaf = child & ~DNF_BSP_SUBSECTOR_BIT,
+        .enter = enter,
+        .leave = leave
+    };
+}
+
+/**
+ * @brief Lists the one-sided segs of the leaves a line crosses that the line
+ * goes through (a seg lies on the border of its leaf, so these are all the
+ * walls along the line).
+ */
+static void collect_walls(
+    const dnf_bsp_level *level,
+    const float32_t x0, const float32_t y0, const float32_t x1, const float32_t y1,
+    dnf_pvs_job *job)
+{
+    const float32_t dx = x1 - x0, dy = y1 - y0;
+    job->wall_count = 0;
+    for (uint32_t i = 0; i < job->leaf_count; i++)
+    {
+        const dnf_subsector *subsector = &level->subsectors[job->leaves[i].leaf];
+        for (uint32_t s = subsector->first_seg; s < subsector->first_seg + subsector->seg_count; s++)
+        {
+            const dnf_seg *seg = &level->segs[s];
+            if (seg->back_sector != DNF_BSP_NO_SECTOR)
+                continue;
+
+            // the line goes across the whole level, it crosses every seg with ends on either side
+            const float32_t side1 = (seg->v1.x - x0) * dy - (seg->v1.y - y0) * dx;
+            const float32_t side2 = (seg->v2.x - x0) * dy - (seg->v2.y - y0) * dx;
+            if ((side1 < 0.0f) == (side2 < 0.0f))
+                continue;
+            const float32_t seg_dx = seg->v2.x - seg->v1.x, seg_dy = seg->v2.y - seg->v1.y;
+            const float32_t t = ((seg->v1.x - x0) * seg_dy - (seg->v1.y - y0) * seg_dx) / (dx * seg_dy - dy * seg_dx);
+
+            // leaves come in line order, so walls mostly do too
+            uint32_t slot = job->wall_count++;
+            for (; slot > 0 && job->walls[slot - 1].fraction > t; slot--)
+                job->walls[slot] = job->walls[slot - 1];
+            job->walls[slot] = (dnf_pvs_wall){ .fraction = t, .seg = s };
+        }
+    }
+}
+
+/**
+ * @brief Splits a line at the one-sided segs it crosses; the leaves along
+ * every stretch inside the level are visible from each other.
+ */
+static void walk_level_line(
+    const dnf_pvs_builder *builder, const uint32_t job_index,
+    const float32_t x0, const float32_t y0, const float32_t x1, const float32_t y1)
+{
+    const dnf_bsp_level *level = builder->level;
+    dnf_pvs_job *job = &builder->jobs[job_index];
+
+    job->leaf_count = 0;
+    collect_leaves(level, level->root, x0, y0, x1, y1, 0.0f, 1.0f, job);
+    collect_walls(level, x0, y0, x1, y1, job);
+
+    // leaves that only touch a stretch at a wall are behind it
+    const float32_t length = sqrtf((x1 - x0) * (x1 - x0) + (y1 - y0) * (y1 - y0));
+    const float32_t epsilon = DNF_PVS_LINE_STEP / length;
+    uint32_t first_leaf = 0;
+    float32_t start = 0.0f;
+    for (uint32_t w = 0; w < job->wall_count; w++)
+    {
+        // the line starts and ends in the void, a stretch that hits the back of a wall is outside
+        const float32_t end = job->walls[w].fraction;
+        const float32_t middle = (start + end) * 0.5f;
+        const float32_t middle_x = x0 + (x1 - x0) * middle, middle_y = y0 + (y1 - y0) * middle;
+        const dnf_seg *seg = &level->segs[job->walls[w].seg];
+        if ((middle_x - seg->v1.x) * -(seg->v2.y - seg->v1.y) + (middle_y - seg->v1.y) * (seg->v2.x - seg->v1.x) >= 0.0f)
+        {
+            for (uint32_t i = first_leaf; i < job->leaf_count && job->leaves[i].enter < end - epsilon; i++)
+                if (job->leaves[i].leave > start + epsilon)
+                    extend_stretch(job, job->leaves[i].leaf);
+            close_stretch(builder, job, job_index);
+        }
+
+        while (first_leaf < job->leaf_count && job->leaves[first_leaf].leave <= end + epsilon)
+            first_leaf++;
+        start = end;
+    }
+}
+
+/**
+ * @brief Fills the rows of every job_count-th BSP leaf (job system).
+ *
+ * @param user_data Pointer to dnf_pvs_builder.
+ */
+static void build_level_rows(const uint32_t job_index, void *user_data)
+{
+    const dnf_pvs_builder *builder = user_data;
+    for (uint32_t leaf = job_index; leaf < builder->cluster_count; leaf += builder->job_count)
+        mark_cluster(builder->matrix + (size_t)leaf * builder->row_words, leaf);
+    sample_lines(builder, job_index, walk_level_line);
+}
+
+/**
+ * @brief Counts the bytes of a run-length encoded row (see pvs.h).
+ */
+static uint32_t compressed_size(const uint8_t *row, const uint32_t row_bytes)
+{
+    uint32_t size = 0;
+    for (uint32_t i = 0; i < row_bytes; size++)
+    {
+        if (row[i] != 0)
+        {
+            i++;
+            continue;
+        }
+
+        uint32_t run = 0;
+        while (i < row_bytes && row[i] == 0 && run < 255)
+        {
+            i++;
+            run++;
+        }
+        size++;
+    }
+    return size;
+}
+
+/**
+ * @brief Run-length encodes a row (see pvs.h).
+ *
+ * @return Number of bytes written.
+ */
+static uint32_t compress_row(const uint8_t *row, const uint32_t row_bytes, uint8_t *out)
+{
+    uint32_t size = 0;
+    for (uint32_t i = 0; i < row_bytes;)
+    {
+        out[size++] = row[i];
+        if (row[i] != 0)
+        {
+            i++;
+            continue;
+        }
+
+        uint8_t run = 0;
+        while (i < row_bytes && row[i] == 0 && run < 255)
+        {
+            i++;
+            run++;
+        }
+        out[size++] = run;
+    }
+    return size;
+}
+
+/**
+ * @brief Adds a value to an FNV-1a hash, byte by byte.
+ */
+static uint32_t hash_u32(uint32_t hash, const uint32_t value)
+{
+    for (uint32_t i = 0; i < 4; i++)
+        hash = (hash ^ ((value >> (i * 8)) & 0xFF)) * 16777619u;
+    return hash;
+}
+
+/**
+ * @brief Adds the bits of a float to an FNV-1a hash.
+ */
+static uint32_t hash_f32(const uint32_t hash, const float32_t value)
+{
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    return hash_u32(hash, bits);
+}
+
+/**
+ * @brief Hashes what the PVS of a grid map depends on.
+ */
+static uint32_t grid_hash(const dnf_grid_map *map, const int32_t cluster_size)
+{
+    uint32_t hash = hash_u32(2166136261u, (uint32_t)map->width);
+    hash = hash_u32(hash, (uint32_t)map->height);
+    hash = hash_u32(hash, (uint32_t)cluster_size);
+    for (int32_t i = 0; i < map->width * map->height; i++)
+        hash = (hash ^ (map->cells[i] != 0)) * 16777619u;
+    return hash;
+}
+
+/**
+ * @brief Hashes what the PVS of a BSP level depends on.
+ */
+static uint32_t level_hash(const dnf_bsp_level *level)
+{
+    uint32_t hash = hash_u32(2166136261u, level->root);
+    for (uint32_t i = 0; i < level->node_count; i++)
+    {
+        const dnf_bsp_node *node = &level->nodes[i];
+        hash = hash_f32(hash, node->x);
+        hash = hash_f32(hash, node->y);
+        hash = hash_f32(hash, node->dx);
+        hash = hash_f32(hash, node->dy);
+        hash = hash_u32(hash, node->children[0]);
+        hash = hash_u32(hash, node->children[1]);
+    }
+    for (uint32_t i = 0; i < level->subsector_count; i++)
+    {
+        hash = hash_u32(hash, level->subsectors[i].first_seg);
+        hash = hash_u32(hash, level->subsectors[i].seg_count);
+    }
+    for (uint32_t i = 0; i < level->seg_count; i++)
+    {
+        const dnf_seg *seg = &level->segs[i];
+        hash = hash_f32(hash, seg->v1.x);
+        hash = hash_f32(hash, seg->v1.y);
+        hash = hash_f32(hash, seg->v2.x);
+        hash = hash_f32(hash, seg->v2.y);
+        hash = hash_u32(hash, seg->back_sector == DNF_BSP_NO_SECTOR);
+    }
+    return hash;
+}
+
+/**
+ * @brief Compresses the matrix into a lump.
+ *
+ * @param source_hash Hash of the map (see grid_hash(), level_hash()).
+ * @return False on allocation failure.
+ */
+static bool8_t finish_pvs(
+    dnf_pvs *pvs,
+    const dnf_pvs_builder *builder,
+    const int32_t cluster_size, const int32_t width, const int32_t height,
+    const uint32_t source_hash)
+{
+    const uint32_t count = builder->cluster_count;
+    const uint32_t row_bytes = builder->row_bytes;
+
+    size_t data_size = 0;
+    uint64_t visible = 0;
+    for (uint32_t from = 0; from < count; from++)
+    {
+        const uint8_t *row = (const uint8_t *)(builder->matrix + (size_t)from * builder->row_words);
+        data_size += compressed_size(row, row_bytes);
+        for (uint32_t byte = 0; byte < row_bytes; byte++)
+            for (uint8_t bits = row[byte]; bits != 0; bits &= (uint8_t)(bits - 1))
+                visible++;
+    }
+    if (data_size > UINT32_MAX)
+    {
+        DNF_ERROR("PVS of %u clusters doesn't fit a lump", count);
+        return false;
+    }
+
+    const size_t lump_size = sizeof(dnf_pvs_header) + count * sizeof(uint32_t) + data_size;
+    uint8_t *lump = dnf_alloc(lump_size, DNF_MEMORY_TAG_LEVEL);
+    if (!lump)
+    {
+        DNF_ERROR("Failed to allocate a PVS of %u clusters", count);
+        return false;
+    }
+
+    dnf_pvs_header header = {
+        .version = DNF_PVS_VERSION,
+        .cluster_count = count,
+        .cluster_size = cluster_size,
+        .width = width,
+        .height = height,
+        .data_size = (uint32_t)data_size,
+        .source_hash = source_hash
+    };
+    memcpy(header.magic, DNF_PVS_MAGIC, sizeof(header.magic));
+    memcpy(lump, &header, sizeof(header));
+
+    uint32_t *offsets = (uint32_t *)(lump + sizeof(header));
+    uint8_t *data = lump + sizeof(header) + count * sizeof(uint32_t);
+    uint32_t offset = 0;
+    for (uint32_t from = 0; from < count; from++)
+    {
+        offsets[from] = offset;
+        offset += compress_row((const uint8_t *)(builder->matrix + (size_t)from * builder->row_words), row_bytes, data + offset);
+    }
+
+    if (!pvs_load(pvs, lump, lump_size))
+    {
+        dnf_free(lump);
+        return false;
+    }
+    pvs->owned = true;
+
+    DNF_INFO(
+        "Built PVS: %u clusters, %.1f visible on average, %zu bytes of rows (%u uncompressed)",
+        count, (float64_t)visible / (float64_t)count, data_size, count * row_bytes);
+    return true;
+}
+
+/**
+ * @brief Allocates the uncompressed matrix and the jobs of a build.
+ *
+ * @param max_stretch Most clusters a line can cross.
+ * @return False on allocation failure (free the builder with free_builder()).
+ */
+static bool8_t init_builder(dnf_pvs_builder *builder, const uint32_t cluster_count, const uint32_t max_stretch)
+{
+    builder->cluster_count = cluster_count;
+    builder->row_bytes = (cluster_count + 7) / 8;
+    builder->row_words = (cluster_count + 63) / 64;
+    builder->job_count = job_system_thread_count();
+
+    // neighbouring directions drift apart by the angle step per cell travelled
+    const float32_t width = builder->max_x - builder->min_x, height = builder->max_y - builder->min_y;
+    builder->angle_count = (uint32_t)ceilf(DNF_PVS_HALF_TURN * sqrtf(width * width + height * height) / DNF_PVS_LINE_GAP);
+
+    const size_t matrix_size = (size_t)cluster_count * builder->row_words * sizeof(uint64_t);
+    builder->matrix = dnf_alloc(matrix_size, DNF_MEMORY_TAG_LEVEL);
+    if (!builder->matrix)
+    {
+        DNF_ERROR("Failed to allocate the visibility matrix of %u clusters", cluster_count);
+        return false;
+    }
+    memset(builder->matrix, 0, matrix_size);
+
+    builder->jobs = dnf_alloc(builder->job_count * sizeof(dnf_pvs_job), DNF_MEMORY_TAG_LEVEL);
+    if (!builder->jobs)
+    {
+        DNF_ERROR("Failed to allocate the PVS builder");
+        return false;
+    }
+    memset(builder->jobs, 0, builder->job_count * sizeof(dnf_pvs_job));
+
+    for (uint32_t i = 0; i < builder->job_count; i++)
+    {
+        dnf_pvs_job *job = &builder->jobs[i];
+        job->stretch = dnf_alloc(max_stretch * sizeof(uint32_t), DNF_MEMORY_TAG_LEVEL);
+        job->recent = dnf_alloc(DNF_PVS_RECENT_STRETCHES * sizeof(uint64_t), DNF_MEMORY_TAG_LEVEL);
+        job->row = dnf_alloc(builder->row_words * sizeof(uint64_t), DNF_MEMORY_TAG_LEVEL);
+        if (!job->stretch || !job->recent || !job->row)
+        {
+            DNF_ERROR("Failed to allocate the PVS builder");
+            return false;
+        }
+        memset(job->recent, 0, DNF_PVS_RECENT_STRETCHES * sizeof(uint64_t));
+        memset(job->row, 0, builder->row_words * sizeof(uint64_t));
+    }
+    return true;
+}
+
+/**
+ * @brief Frees what init_builder() allocated.
+ */
+static void free_builder(dnf_pvs_builder *builder)
+{
+    for (uint32_t i = 0; builder->jobs && i < builder->job_count; i++)
+    {
+        dnf_pvs_job *job = &builder->jobs[i];
+        dnf_free(job->stretch);
+        dnf_free(job->recent);
+        dnf_free(job->row);
+        dnf_free(job->leaves);
+        dnf_free(job->walls);
+    }
+    dnf_free(builder->jobs);
+    dnf_free(builder->matrix);
+}
+
+bool8_t pvs_build_grid(dnf_pvs *pvs, const dnf_grid_map *map, const int32_t cluster_size)
+{
+    *pvs = (dnf_pvs){0};
+    if (map->width <= 0 || map->height <= 0 || cluster_size <= 0)
+    {
+        DNF_ERROR("Can't build the PVS of a %dx%d grid map with %d-cell clusters", map->width, map->height, cluster_size);
+        return false;
+    }
+
+    dnf_pvs_builder builder = {
+        .max_x = (float32_t)map->width,
+        .max_y = (float32_t)map->height,
+        .map = map,
+        .cluster_size = cluster_size,
+        .clusters_x = (map->width + cluster_size - 1) / cluster_size,
+    };
+    const int32_t clusters_y = (map->height + cluster_size - 1) / cluster_size;
+    const uint32_t cluster_count = (uint32_t)(builder.clusters_x * clusters_y);
+
+    // a line crosses a cell per step, one cluster at most once
+    const uint32_t max_cells = (uint32_t)(map->width + map->height);
+    bool8_t success = init_builder(&builder, cluster_count, max_cells < cluster_count ? max_cells : cluster_count);
+    if (success)
+    {
+        job_system_dispatch(builder.job_count, build_grid_rows, &builder);
+        success = finish_pvs(pvs, &builder, cluster_size, map->width, map->height, grid_hash(map, cluster_size));
+    }
+    free_builder(&builder);
+    return success;
+}
+
+bool8_t pvs_build_level(dnf_pvs *pvs, const dnf_bsp_level *level)
+{
+    *pvs = (dnf_pvs){0};
+    if (level->subsector_count == 0 || level->vertex_count == 0)
+    {
+        DNF_ERROR("Can't build the PVS of a level without subsectors");
+        return false;
+    }
+
+    dnf_pvs_builder builder = {
+        .min_x = INFINITY, .min_y = INFINITY,
+        .max_x = -INFINITY, .max_y = -INFINITY,
+        .level = level,
+    };
+    for (uint32_t i = 0; i < level->vertex_count; i++)
+    {
+        builder.min_x = fminf(builder.min_x, level->vertices[i].x);
+        builder.min_y = fminf(builder.min_y, level->vertices[i].y);
+        builder.max_x = fmaxf(builder.max_x, level->vertices[i].x);
+        builder.max_y = fmaxf(builder.max_y, level->vertices[i].y);
+    }
+    builder.min_x -= DNF_PVS_LEVEL_MARGIN;
+    builder.min_y -= DNF_PVS_LEVEL_MARGIN;
+    builder.max_x += DNF_PVS_LEVEL_MARGIN;
+    builder.max_y += DNF_PVS_LEVEL_MARGIN;
+
+    // leaves are convex, a line crosses every one of them at most once
+    bool8_t success = init_builder(&builder, level->subsector_count, level->subsector_count);
+    for (uint32_t i = 0; success && i < builder.job_count; i++)
+    {
+        dnf_pvs_job *job = &builder.jobs[i];
+        job->leaves = dnf_alloc(level->subsector_count * sizeof(dnf_pvs_leaf_span), DNF_MEMORY_TAG_LEVEL);
+        job->walls = dnf_alloc(level->seg_count * sizeof(dnf_pvs_wall), DNF_MEMORY_TAG_LEVEL);
+        success = job->leaves && job->walls;
+        if (!success)
+            DNF_ERROR("Failed to allocate the PVS builder");
+    }
+
+    if (success)
+    {
+        job_system_dispatch(builder.job_count, build_level_rows, &builder);
+        success = finish_pvs(pvs, &builder, 0, 0, 0, level_hash(level));
+    }
+    free_builder(&builder);
+    return success;
+}
+
+bool8_t pvs_load(dnf_pvs *pvs, const void *lump, const size_t size)
+{
+    *pvs = (dnf_pvs){0};
+
+    dnf_pvs_header header;
+    if (size < sizeof(header) || ((uintptr_t)lump & 3) != 0)
+    {
+        DNF_ERROR("PVS lump is too small or misaligned");
+        return false;
+    }
+    memcpy(&header, lump, sizeof(header));
+    if (memcmp(header.magic, DNF_PVS_MAGIC, sizeof(header.magic)) != 0 || header.version != DNF_PVS_VERSION)
+    {
+        DNF_ERROR("Not a version %d PVS lump", DNF_PVS_VERSION);
+        return false;
+    }
+
+    const uint64_t expected = sizeof(header) + (uint64_t)header.cluster_count * sizeof(uint32_t) + header.data_size;
+    if (header.cluster_count == 0 || expected > size)
+    {
+        DNF_ERROR("PVS lump of %u clusters is truncated", header.cluster_count);
+        return false;
+    }
+
+    int32_t clusters_x = 0;
+    if (header.cluster_size > 0)
+    {
+        clusters_x = (header.width + header.cluster_size - 1) / header.cluster_size;
+        const int32_t clusters_y = (header.height + header.cluster_size - 1) / header.cluster_size;
+        if (header.width <= 0 || header.height <= 0 || (uint64_t)clusters_x * (uint64_t)clusters_y != header.cluster_count)
+        {
+            DNF_ERROR("PVS lump doesn't match its %dx%d grid map", header.width, header.height);
+            return false;
+        }
+    }
+
+    const uint32_t *offsets = (const uint32_t *)((const uint8_t *)lump + sizeof(header));
+    for (uint32_t i = 0; i < header.cluster_count; i++)
+    {
+        if (offsets[i] >= header.data_size)
+        {
+            DNF_ERROR("PVS lump has a row outside its data");
+            return false;
+        }
+    }
+
+    *pvs = (dnf_pvs){
+        .cluster_count = header.cluster_count,
+        .row_bytes = (header.cluster_count + 7) / 8,
+        .cluster_size = header.cluster_size,
+        .clusters_x = clusters_x,
+        .width = header.width,
+        .height = header.height,
+        .source_hash = header.source_hash,
+        .offsets = offsets,
+        .data = (const uint8_t *)(offsets + header.cluster_count),
+        .data_size = header.data_size,
+        .lump = lump,
+        .lump_size = (size_t)expected,
+        .owned = false
+    };
+    return true;
+}
+
+bool8_t pvs_matches_grid(const dnf_pvs *pvs, const dnf_grid_map *map, const int32_t cluster_size)
+{
+    return pvs->cluster_count > 0 && pvs->cluster_size == cluster_size
+        && pvs->width == map->width && pvs->height == map->height
+        && pvs->source_hash == grid_hash(map, cluster_size);
+}
+
+bool8_t pvs_matches_level(const dnf_pvs *pvs, const dnf_bsp_level *level)
+{
+    return pvs->cluster_count == level->subsector_count && pvs->cluster_size == 0
+        && pvs->source_hash == level_hash(level);
+}
+
+void pvs_free(dnf_pvs *pvs)
+{
+    if (pvs->owned)
+        dnf_free((void *)pvs->lump);
+    *pvs = (dnf_pvs){0};
+}
+
+bool8_t pvs_save(const dnf_pvs *pvs, const char *path)
+{
+    FILE *out = fopen(path, "wb");
+    if (!out)
+    {
+        DNF_ERROR("Failed to create %s", path);
+        return false;
+    }
+
+    bool8_t success = fwrite(pvs->lump, 1, pvs->lump_size, out) == pvs->lump_size;
+    success = fclose(out) == 0 && success;
+    if (!success)
+    {
+        DNF_ERROR("Failed to write %s", path);
+        remove(path);
+    }
+    return success;
+}
+
+void pvs_decompress(const dnf_pvs *pvs, const uint32_t cluster, uint8_t *out_visible)
+{
+    if (cluster >= pvs->cluster_count)
+    {
+        memset(out_visible, 0xFF, pvs->row_bytes);
+        return;
+    }
+
+    // rows are checked against the data end, lumps may come from disk
+    const uint8_t *in = pvs->data + pvs->offsets[cluster];
+    const uint8_t *end = pvs->data + pvs->data_size;
+    uint32_t written = 0;
+    while (written < pvs->row_bytes && in < end)
+    {
+        const uint8_t value = *in++;
+        if (value != 0)
+        {
+            out_visible[written++] = value;
+            continue;
+        }
+
+        uint32_t run = in < end ? *in++ : 0;
+        if (run > pvs->row_bytes - written)
+            run = pvs->row_bytes - written;
+        memset(out_visible + written, 0, run);
+        written += run;
+    }
+    memset(out_visible + written, 0, pvs->row_bytes - written);
+}
+
+bool8_t pvs_is_visible(const uint8_t *visible, const uint32_t cluster)
+{
+    return cluster != DNF_PVS_NO_CLUSTER && (visible[cluster >> 3] & (1u << (cluster & 7))) != 0;
+}
+
+uint32_t pvs_grid_cluster(const dnf_pvs *pvs, const float32_t x, const float32_t y)
+{
+    if (pvs->cluster_size <= 0)
+        return DNF_PVS_NO_CLUSTER;
+
+    const float32_t cell_x = floorf(x), cell_y = floorf(y);
+    if (cell_x < 0.0f || cell_y < 0.0f || cell_x >= (float32_t)pvs->width || cell_y >= (float32_t)pvs->height)
+        return DNF_PVS_NO_CLUSTER;
+    return (uint32_t)(((int32_t)cell_y / pvs->cluster_size) * pvs->clusters_x + (int32_t)cell_x / pvs->cluster_size);
+}
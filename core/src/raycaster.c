@@ -0,0 +1,410 @@
+// DNF (Doomed and Forgotten): a DOOM-style first-person shooter.
+// Copyright (C) 2025-2026  Alexandr Gorbatenko
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+
+#include "raycaster.h"
+
+#include "pixels.h"
+
+#include <math.h>
+
+// Light of the darker (Y-facing) wall sides.
+#define DNF_RAYCASTER_SIDE_LIGHT 0.75f
+// Height of the eye above the floor and below the ceiling (walls are one
+// unit tall and centered on the horizon).
+#define DNF_RAYCASTER_EYE_HEIGHT 0.5f
+// Most rows textured ceilings and floors are drawn for (span starts live on
+// the stack of every band); taller framebuffers get flat colors.
+#define DNF_RAYCASTER_MAX_SPAN_ROWS 4320
+
+
+/**
+ * @brief Per-frame raycaster parameters shared by all column bands.
+ */
+typedef struct dnf_raycast_frame
+{
+    const dnf_view_tables *view;  //!< Per-column view tables
+    const dnf_grid_map *map;      //!< Map to render
+    float32_t origin_x;           //!< Camera X position
+    float32_t origin_y;           //!< Camera Y position
+    float32_t forward_x;          //!< Camera forward vector (X)
+    float32_t forward_y;          //!< Camera forward vector (Y)
+    bool8_t indexed;              //!< True if the target is indexed (the index tables are set)
+    bool8_t texture_indices;      //!< True if the textures have indices of the target palette
+    uint8_t wall_indices[DNF_GRID_MAP_WALL_TYPES][2];  //!< Palette index of every wall type, per side
+    uint8_t ceiling_index;        //!< Palette index of the ceiling
+    uint8_t floor_index;          //!< Palette index of the floor
+    const dnf_texture *wall_textures[DNF_GRID_MAP_WALL_TYPES];  //!< Texture of every wall type (nullptr - flat color)
+    const dnf_texture *ceiling_texture;  //!< Texture of the ceiling (nullptr - flat color)
+    const dnf_texture *floor_texture;    //!< Texture of the floor (nullptr - flat color)
+} dnf_raycast_frame;
+
+/**
+ * @brief Open ceiling and floor spans of a band (the rows of a plane that
+ * are visible in the last column drawn, and where their runs started).
+ */
+typedef struct dnf_span_rows
+{
+    int32_t ceiling_end;  //!< Ceiling rows [0; ceiling_end) are open
+    int32_t floor_start;  //!< Floor rows [floor_start; height) are open
+    int16_t starts[DNF_RAYCASTER_MAX_SPAN_ROWS];  //!< First column of the open span of every row
+} dnf_span_rows;
+
+/**
+ * @brief Result of a single ray cast.
+ */
+typedef struct dnf_ray_hit
+{
+    float32_t distance;  //!< Distance along the (normalized) ray
+    uint8_t cell;        //!< Wall type of the hit cell
+    bool8_t y_side;      //!< True if a horizontal (Y-facing) wall side was hit
+} dnf_ray_hit;
+
+
+uint8_t grid_map_get_cell(const dnf_grid_map *map, const int32_t x, const int32_t y)
+{
+    if (x < 0 || y < 0 || x >= map->width || y >= map->height)
+        return 1;
+    return map->cells[y * map->width + x];
+}
+
+/**
+ * @brief Traverses the grid along a ray (DDA) until it hits a wall.
+ *
+ * @param map Grid map.
+ * @param origin_x Ray origin X.
+ * @param origin_y Ray origin Y.
+ * @param dir_x Normalized ray direction X.
+ * @param dir_y Normalized ray direction Y.
+ * @return Hit information.
+ */
+static dnf_ray_hit cast_ray(
+    const dnf_grid_map *map,
+    const float32_t origin_x, const float32_t origin_y,
+    const float32_t dir_x, const float32_t dir_y)
+{
+    int32_t cell_x = (int32_t)floorf(origin_x);
+    int32_t cell_y = (int32_t)floorf(origin_y);
+
+    // distance along the ray between two vertical/horizontal grid lines
+    const float32_t delta_x = dir_x == 0.0f ? INFINITY : fabsf(1.0f / dir_x);
+    const float32_t delta_y = dir_y == 0.0f ? INFINITY : fabsf(1.0f / dir_y);
+
+    int32_t step_x, step_y;
+    float32_t side_x, side_y;  // distance to the next vertical/horizontal grid line
+    if (dir_x < 0.0f)
+    {
+        step_x = -1;
+        side_x = (origin_x - (float32_t)cell_x) * delta_x;
+    }
+    else
+    {
+        step_x = 1;
+        side_x = ((float32_t)cell_x + 1.0f - origin_x) * delta_x;
+    }
+    if (dir_y < 0.0f)
+    {
+        step_y = -1;
+        side_y = (origin_y - (float32_t)cell_y) * delta_y;
+    }
+    else
+    {
+        step_y = 1;
+        side_y = ((float32_t)cell_y + 1.0f - origin_y) * delta_y;
+    }
+
+    // the map border is solid, so a ray can't take more steps than this
+    const int32_t max_steps = map->width + map->height + 2;
+    dnf_ray_hit hit = { .distance = 0.0f, .cell = 1, .y_side = false };
+    for (int32_t i = 0; i < max_steps; i++)
+    {
+        if (side_x < side_y)
+        {
+            hit.distance = side_x;
+            side_x += delta_x;
+            cell_x += step_x;
+            hit.y_side = false;
+        }
+        else
+        {
+            hit.distance = side_y;
+            side_y += delta_y;
+            cell_y += step_y;
+            hit.y_side = true;
+        }
+
+        hit.cell = grid_map_get_cell(map, cell_x, cell_y);
+        if (hit.cell != 0)
+            break;
+    }
+
+    return hit;
+}
+
+/**
+ * @brief Draws a span of a textured ceiling or floor row.
+ *
+ * Rows are at a fixed depth, so the texture is stepped linearly along the
+ * camera right vector with the per-row view tables.
+ */
+static void draw_plane_span(
+    const dnf_raycast_frame *frame,
+    const dnf_framebuffer *fb,
+    const dnf_texture *texture,
+    const int32_t y, const int32_t x0, const int32_t x1)
+{
+    const dnf_view_tables *view = frame->view;
+    const float32_t depth = DNF_RAYCASTER_EYE_HEIGHT * view->row_depth[y];
+    const float32_t step = DNF_RAYCASTER_EYE_HEIGHT * view->row_step[y];
+
+    // world position seen through the center of the first column
+    const float32_t offset = ((float32_t)x0 + 0.5f - (float32_t)fb->width * 0.5f) * step;
+    const float32_t world_x = frame->origin_x + frame->forward_x * depth - frame->forward_y * offset;
+    const float32_t world_y = frame->origin_y + frame->forward_y * depth + frame->forward_x * offset;
+
+    // one texture repeat per cell, the level with about a texel per pixel
+    const uint32_t mip = texture_select_mip(texture, step * (float32_t)texture->width);
+    const float32_t width = (float32_t)texture_mip_width(texture, mip);
+    const float32_t height = (float32_t)texture_mip_height(texture, mip);
+    if (frame->texture_indices)
+    {
+        pixels_draw_span_textured_index(fb, y, x0, x1,
+            frame->map->textures->indices + texture->mip_offsets[mip], (int32_t)width, (int32_t)height,
+            world_x * width, world_y * height,
+            -frame->forward_y * step * width, frame->forward_x * step * height,
+            1.0f);
+        return;
+    }
+    pixels_draw_span_textured(fb, y, x0, x1,
+        frame->map->textures->atlas + texture->mip_offsets[mip], (int32_t)width, (int32_t)height,
+        world_x * width, world_y * height,
+        -frame->forward_y * step * width, frame->forward_x * step * height,
+        1.0f);
+}
+
+/**
+ * @brief Moves the open spans of the textured planes to a column: spans of
+ * rows the planes no longer cover end there, newly covered rows start there.
+ *
+ * @param col Column (x_end closes every span of the band).
+ * @param ceiling_end Ceiling rows of the column end here.
+ * @param floor_start Floor rows of the column start here.
+ */
+static void update_spans(
+    const dnf_raycast_frame *frame,
+    const dnf_framebuffer *fb,
+    dnf_span_rows *spans,
+    const int32_t col,
+    const int32_t ceiling_end,
+    const int32_t floor_start)
+{
+    if (frame->ceiling_texture)
+    {
+        for (int32_t y = spans->ceiling_end; y < ceiling_end; y++)
+            spans->starts[y] = (int16_t)col;
+        for (int32_t y = ceiling_end; y < spans->ceiling_end; y++)
+            draw_plane_span(frame, fb, frame->ceiling_texture, y, spans->starts[y], col);
+    }
+    if (frame->floor_texture)
+    {
+        for (int32_t y = floor_start; y < spans->floor_start; y++)
+            spans->starts[y] = (int16_t)col;
+        for (int32_t y = spans->floor_start; y < floor_start; y++)
+            draw_plane_span(frame, fb, frame->floor_texture, y, spans->starts[y], col);
+    }
+    spans->ceiling_end = ceiling_end;
+    spans->floor_start = floor_start;
+}
+
+/**
+ * @brief Fills the ceiling and floor rows of a column with flat colors
+ * (planes without a texture).
+ */
+static void fill_planes(
+    const dnf_raycast_frame *frame,
+    const dnf_framebuffer *fb,
+    const int32_t col,
+    const int32_t ceiling_end,
+    const int32_t floor_start)
+{
+    if (!frame->ceiling_texture)
+    {
+        if (frame->indexed)
+            pixels_fill_column_index(fb, col, 0, ceiling_end, frame->ceiling_index);
+        else
+            pixels_fill_column(fb, col, 0, ceiling_end, frame->map->ceiling_color);
+    }
+    if (!frame->floor_texture)
+    {
+        if (frame->indexed)
+            pixels_fill_column_index(fb, col, floor_start, fb->height, frame->floor_index);
+        else
+            pixels_fill_column(fb, col, floor_start, fb->height, frame->map->floor_color);
+    }
+}
+
+/**
+ * @brief Renders a band of columns (see renderer_draw_bands()).
+ *
+ * @param user_data Pointer to dnf_raycast_frame.
+ */
+static void raycast_band(const dnf_framebuffer *fb, const int32_t x_begin, const int32_t x_end, void *user_data)
+{
+    const dnf_raycast_frame *frame = user_data;
+    const dnf_view_tables *view = frame->view;
+    const dnf_grid_map *map = frame->map;
+    const float32_t half_height = (float32_t)fb->height * 0.5f;
+
+    // spans of the textured planes, drawn as the columns go
+    const bool8_t textured_planes = frame->ceiling_texture || frame->floor_texture;
+    dnf_span_rows spans;
+    spans.ceiling_end = 0;
+    spans.floor_start = fb->height;
+
+    for (int32_t col = x_begin; col < x_end; col++)
+    {
+        // rotate the camera-space ray by the camera direction
+        const float32_t ray_forward = view->ray_dir_x[col];
+        const float32_t ray_right = view->ray_dir_y[col];
+        const float32_t dir_x = frame->forward_x * ray_forward - frame->forward_y * ray_right;
+        const float32_t dir_y = frame->forward_y * ray_forward + frame->forward_x * ray_right;
+
+        const dnf_ray_hit hit = cast_ray(map, frame->origin_x, frame->origin_y, dir_x, dir_y);
+
+        // perpendicular distance removes the fish-eye effect
+        const float32_t depth = fmaxf(hit.distance * view->fisheye[col], 1e-4f);
+        const float32_t wall_height = view->projection / depth;
+        view->depth[col] = depth;
+
+        const float32_t wall_start = half_height - wall_height * 0.5f;
+        int32_t wall_top = (int32_t)wall_start;
+        int32_t wall_bottom = (int32_t)(half_height + wall_height * 0.5f);
+
+        // the ceiling and the floor take the rest of the column
+        const int32_t ceiling_end = wall_top < 0 ? 0 : wall_top > fb->height ? fb->height : wall_top;
+        const int32_t floor_start = wall_bottom > fb->height ? fb->height : wall_bottom < 0 ? 0 : wall_bottom;
+        fill_planes(frame, fb, col, ceiling_end, floor_start);
+        if (textured_planes)
+            update_spans(frame, fb, &spans, col, ceiling_end, floor_start);
+
+        const dnf_texture *texture = frame->wall_textures[hit.cell % DNF_GRID_MAP_WALL_TYPES];
+        if (texture)
+        {
+            // where along the wall the ray hit, mirrored so every side reads left to right
+            const float32_t wall_x = hit.y_side
+                ? frame->origin_x + dir_x * hit.distance
+                : frame->origin_y + dir_y * hit.distance;
+            float32_t u = wall_x - floorf(wall_x);
+            if ((!hit.y_side && dir_x > 0.0f) || (hit.y_side && dir_y < 0.0f))
+                u = 1.0f - u;
+
+            // the level with about a texel per pixel
+            const uint32_t mip = texture_select_mip(texture, (float32_t)texture->height / wall_height);
+            const int32_t texels = texture_mip_height(texture, mip);
+            const int32_t texel_u = (int32_t)(u * (float32_t)texture_mip_width(texture, mip));
+
+            // texel coordinate at the center of the first row
+            const float32_t v_step = (float32_t)texels / wall_height;
+            const float32_t v = fmaxf(((float32_t)wall_top + 0.5f - wall_start) * v_step, 0.0f);
+            const float32_t light = hit.y_side ? DNF_RAYCASTER_SIDE_LIGHT : 1.0f;
+            if (frame->texture_indices)
+                pixels_draw_column_textured_index(fb, col, wall_top, wall_bottom,
+                    texture_column_indices(map->textures, texture, mip, texel_u), texels, v, v_step, light);
+            else
+                pixels_draw_column_textured(fb, col, wall_top, wall_bottom,
+                    texture_column(map->textures, texture, mip, texel_u), texels, v, v_step, light);
+            continue;
+        }
+
+        if (wall_top < 0)
+            wall_top = 0;
+        if (wall_bottom > fb->height)
+            wall_bottom = fb->height;
+
+        if (frame->indexed)
+        {
+            // the side darkening is already in the tables
+            pixels_fill_column_index(fb, col, wall_top, wall_bottom,
+                frame->wall_indices[hit.cell % DNF_GRID_MAP_WALL_TYPES][hit.y_side]);
+            continue;
+        }
+
+        Color wall_color = map->wall_colors[hit.cell % DNF_GRID_MAP_WALL_TYPES];
+        if (hit.y_side)
+        {
+            // darken one side of the walls to tell them apart
+            wall_color.r = (uint8_t)(wall_color.r * DNF_RAYCASTER_SIDE_LIGHT);
+            wall_color.g = (uint8_t)(wall_color.g * DNF_RAYCASTER_SIDE_LIGHT);
+            wall_color.b = (uint8_t)(wall_color.b * DNF_RAYCASTER_SIDE_LIGHT);
+        }
+
+        pixels_fill_column(fb, col, wall_top, wall_bottom, wall_color);
+    }
+
+    if (textured_planes)
+        update_spans(frame, fb, &spans, x_end, 0, fb->height);
+}
+
+void raycaster_render(
+    const renderer_context *ctx,
+    const dnf_grid_map *map,
+    const dnf_camera *camera)
+{
+    // bands may run after we return (pipelined contexts)
+    dnf_raycast_frame *frame = renderer_alloc_pass_data(ctx, sizeof(dnf_raycast_frame));
+    if (!frame)
+        return;
+
+    *frame = (dnf_raycast_frame){
+        .view = &ctx->view,
+        .map = map,
+        .origin_x = camera->x,
+        .origin_y = camera->y,
+        .forward_x = cosf(camera->angle),
+        .forward_y = sinf(camera->angle),
+        .indexed = ctx->palette != nullptr
+    };
+
+    if (map->textures)
+    {
+        // textures quantized for another palette (or none) are looked up per texel
+        frame->texture_indices = frame->indexed && map->textures->palette == ctx->palette;
+        for (uint32_t i = 0; i < DNF_GRID_MAP_WALL_TYPES; i++)
+            frame->wall_textures[i] = texture_cache_get(map->textures, map->wall_textures[i]);
+
+        if (ctx->framebuffers[ctx->back_buffer].height <= DNF_RAYCASTER_MAX_SPAN_ROWS)
+        {
+            frame->ceiling_texture = texture_cache_get(map->textures, map->ceiling_texture);
+            frame->floor_texture = texture_cache_get(map->textures, map->floor_texture);
+        }
+    }
+
+    // indexed targets: light the wall types once per frame (colormap lookups)
+    if (frame->indexed)
+    {
+        const uint32_t side_level = palette_light_level(DNF_RAYCASTER_SIDE_LIGHT);
+        for (uint32_t i = 0; i < DNF_GRID_MAP_WALL_TYPES; i++)
+        {
+            const uint8_t index = palette_find(ctx->palette, map->wall_colors[i]);
+            frame->wall_indices[i][0] = index;
+            frame->wall_indices[i][1] = palette_light(ctx->palette, index, side_level);
+        }
+        frame->ceiling_index = palette_find(ctx->palette, map->ceiling_color);
+        frame->floor_index = palette_find(ctx->palette, map->floor_color);
+    }
+
+    renderer_draw_bands(ctx, raycast_band, frame);
+}
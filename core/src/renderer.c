@@ -17,41 +17,434 @@
 
 #include "renderer.h"
 
+#include "dnf_clock.h"
+#include "dnf_memory.h"
+#include "job_system.h"
 #include "logger.h"
+#include "pixels.h"
 
 #include <raylib.h>
 #include <raymath.h>
 
-#include <stdlib.h>
+#include <string.h>
 
+// Default horizontal field of view (in degrees).
+#define DNF_RENDERER_DEFAULT_FOV 90.0f
+
+// Bands per job system thread (more bands - better load balancing).
+#define DNF_RENDERER_BANDS_PER_THREAD 4
+// Band width alignment in pixels (16 RGBA8 pixels = one 64-byte cache line).
+#define DNF_RENDERER_BAND_ALIGN 16
+// Rows (or columns of a column-major target) per render target resolve job.
+#define DNF_RENDERER_RESOLVE_BAND 64
+// Buffers with at least this share of rows changed (in percent) are
+// uploaded in one piece.
+#define DNF_RENDERER_FULL_UPLOAD_PERCENT 75
+// Max number of band drawing passes queued per frame.
+#define DNF_RENDERER_MAX_PASSES 8
+// Size of per-frame pass data storage in bytes.
+#define DNF_RENDERER_PASS_DATA_SIZE 16384
+
+/**
+ * @brief Parameters of a single renderer_draw_bands() call.
+ */
+typedef struct dnf_band_batch
+{
+    const dnf_framebuffer *fb;  //!< Framebuffer to draw into
+    dnf_band_draw_fn draw;      //!< Band drawing function
+    void *user_data;            //!< Band drawing function user data
+    int32_t band_width;         //!< Width of every band (except the last one)
+} dnf_band_batch;
+
+/**
+ * @brief Passes queued into the frame being drawn; they must outlive
+ * asynchronous passes, so they belong to the rendering context.
+ */
+typedef struct dnf_renderer_passes
+{
+    dnf_band_batch batches[DNF_RENDERER_MAX_PASSES];  //!< Band batches of the frame
+    uint32_t batch_count;   //!< Number of batches in use
+    _Alignas(16) uint8_t data[DNF_RENDERER_PASS_DATA_SIZE];  //!< Pass data storage (see renderer_alloc_pass_data())
+    size_t data_used;       //!< Bytes of the storage in use
+} dnf_renderer_passes;
+
+/**
+ * @brief Parameters of a render target resolve.
+ */
+typedef struct dnf_resolve_batch
+{
+    const dnf_framebuffer *src;    //!< Render target
+    const dnf_framebuffer *dst;    //!< Row-major framebuffer
+    const uint8_t *tiles;          //!< Row tiles to resolve
+    int32_t y_begin;               //!< First row to resolve
+    int32_t y_end;                 //!< Last row to resolve (exclusive)
+} dnf_resolve_batch;
+
+
+/**
+ * @brief Frees the per-column and per-row view tables of a given context.
+ *
+ * @param view View tables to free.
+ */
+static void free_view_tables(dnf_view_tables *view)
+{
+    dnf_free(view->ray_dir_x);
+    dnf_free(view->ray_dir_y);
+    dnf_free(view->fisheye);
+    dnf_free(view->depth);
+    dnf_free(view->row_depth);
+    dnf_free(view->row_step);
+    view->ray_dir_x = nullptr;
+    view->ray_dir_y = nullptr;
+    view->fisheye = nullptr;
+    view->depth = nullptr;
+    view->row_depth = nullptr;
+    view->row_step = nullptr;
+}
+
+/**
+ * @brief (Re)builds the per-column and per-row view tables for the current
+ * framebuffer size and field of view.
+ *
+ * @param ctx Rendering context.
+ * @return True if the tables were allocated successfully.
+ */
+static bool8_t build_view_tables(renderer_context *ctx)
+{
+    dnf_view_tables *view = &ctx->view;
+    const int32_t width = ctx->framebuffers[0].width;
+    const int32_t height = ctx->framebuffers[0].height;
+
+    free_view_tables(view);
+    view->ray_dir_x = dnf_alloc(width * sizeof(float32_t), DNF_MEMORY_TAG_RENDERER);
+    view->ray_dir_y = dnf_alloc(width * sizeof(float32_t), DNF_MEMORY_TAG_RENDERER);
+    view->fisheye = dnf_alloc(width * sizeof(float32_t), DNF_MEMORY_TAG_RENDERER);
+    view->depth = dnf_alloc(width * sizeof(float32_t), DNF_MEMORY_TAG_RENDERER);
+    view->row_depth = dnf_alloc(height * sizeof(float32_t), DNF_MEMORY_TAG_RENDERER);
+    view->row_step = dnf_alloc(height * sizeof(float32_t), DNF_MEMORY_TAG_RENDERER);
+    if (!view->ray_dir_x || !view->ray_dir_y || !view->fisheye || !view->depth
+        || !view->row_depth || !view->row_step)
+    {
+        DNF_ERROR("Failed to allocate view tables for %dx%d", width, height);
+        free_view_tables(view);
+        return false;
+    }
+
+    const float32_t half_plane = tanf(view->fov * 0.5f);
+    view->projection = (float32_t)width * 0.5f / half_plane;
+
+    for (int32_t col = 0; col < width; col++)
+    {
+        // position of the column center on the projection plane, [-1; 1]
+        const float32_t plane_x = (2.0f * ((float32_t)col + 0.5f) / (float32_t)width - 1.0f) * half_plane;
+        const float32_t angle = atanf(plane_x);
+
+        view->ray_dir_x[col] = cosf(angle);
+        view->ray_dir_y[col] = sinf(angle);
+        view->fisheye[col] = cosf(angle);
+        view->depth[col] = INFINITY;  // sprites are unclipped until a world pass runs
+    }
+
+    for (int32_t row = 0; row < height; row++)
+    {
+        // rows next to the horizon of an odd height stay half a row away from it
+        const float32_t rows_from_horizon = fmaxf(fabsf((float32_t)row + 0.5f - (float32_t)height * 0.5f), 0.5f);
+        view->row_depth[row] = view->projection / rows_from_horizon;
+        view->row_step[row] = 1.0f / rows_from_horizon;
+    }
+
+    return true;
+}
+
+/**
+ * @brief Allocates the framebuffers, the render target (if the format needs
+ * one), dirty row tracking and the target texture.
+ *
+ * Framebuffers take the layout of the target. The texture holds the
+ * framebuffer storage as it is, so the texture of a column-major layout is
+ * the transposed image (see renderer_begin_frame()).
+ *
+ * The palette must already exist for indexed targets.
+ *
+ * @param ctx Rendering context (buffer count and backend are set).
+ * @param width Target image width.
+ * @param height Target image height.
+ * @param layout Render target layout.
+ * @param format Render target format.
+ * @param initial Image of the target size to show until the first upload
+ * (nullptr - black).
+ * @return True if everything was allocated successfully.
+ */
+static bool8_t create_targets(
+    renderer_context *ctx,
+    const int32_t width,
+    const int32_t height,
+    const dnf_framebuffer_layout layout,
+    const dnf_pixel_format format,
+    const Image *initial)
+{
+    const bool8_t transposed = layout == DNF_FRAMEBUFFER_COLUMN_MAJOR;
+    const int32_t texture_width = transposed ? height : width;
+    const int32_t texture_height = transposed ? width : height;
+
+    for (uint32_t i = 0; i < ctx->buffer_count; i++)
+    {
+        ctx->framebuffers[i] = (dnf_framebuffer){
+            .pixels = GenImageColor(texture_width, texture_height, BLACK).data,
+            .width = width,
+            .height = height,
+            .layout = layout,
+            .format = DNF_PIXEL_FORMAT_RGBA8
+        };
+    }
+    ctx->back_buffer = 0;
+    ctx->front_buffer = 0;
+    ctx->front_uploaded = true;  // no frame is complete yet, the texture shows what it was created with
+
+    // one render target is enough, it is resolved before the next frame starts
+    // (the layout is kept without one, see renderer_resize_target())
+    ctx->render_target = (dnf_framebuffer){
+        .pixels = nullptr,
+        .width = width,
+        .height = height,
+        .layout = layout,
+        .format = format,
+        .palette = ctx->palette
+    };
+    if (format == DNF_PIXEL_FORMAT_INDEXED8)
+        ctx->render_target.pixels = MemAlloc((uint32_t)(width * height));
+    ctx->back_finished = false;
+
+    // every buffer (and the texture) starts black, as written by frame 0
+    const int32_t tile_count = (height + DNF_FRAMEBUFFER_DIRTY_TILE - 1) / DNF_FRAMEBUFFER_DIRTY_TILE;
+    ctx->dirty = (dnf_dirty_rows){
+        .tiles = dnf_alloc((size_t)tile_count * sizeof(atomic_uchar), DNF_MEMORY_TAG_RENDERER),
+        .tile_count = tile_count
+    };
+    for (uint32_t i = 0; i < ctx->buffer_count; i++)
+    {
+        ctx->tile_frames[i] = dnf_alloc((size_t)tile_count * sizeof(uint32_t), DNF_MEMORY_TAG_RENDERER);
+        ctx->framebuffers[i].dirty = ctx->render_target.pixels ? nullptr : &ctx->dirty;
+    }
+    ctx->render_target.dirty = &ctx->dirty;
+    ctx->target_tile_frames = dnf_alloc((size_t)tile_count * sizeof(uint32_t), DNF_MEMORY_TAG_RENDERER);
+    ctx->texture_tile_frames = dnf_alloc((size_t)tile_count * sizeof(uint32_t), DNF_MEMORY_TAG_RENDERER);
+    ctx->resolve_tiles = dnf_alloc((size_t)tile_count, DNF_MEMORY_TAG_RENDERER);
+    if (!ctx->dirty.tiles || !ctx->target_tile_frames || !ctx->texture_tile_frames || !ctx->resolve_tiles)
+    {
+        DNF_ERROR("Failed to allocate dirty row tracking");
+        return false;
+    }
+    for (uint32_t i = 0; i < ctx->buffer_count; i++)
+    {
+        if (!ctx->tile_frames[i])
+        {
+            DNF_ERROR("Failed to allocate dirty row tracking");
+            return false;
+        }
+    }
+    for (int32_t tile = 0; tile < tile_count; tile++)
+        atomic_init(&ctx->dirty.tiles[tile], 0);
+
+    if (ctx->backend == DNF_RENDERER_BACKEND_HEADLESS)
+    {
+        // no GPU texture, but keep the sizes for screen rect calculations
+        ctx->target = (Texture2D){
+            .id = 0,
+            .width = texture_width,
+            .height = texture_height,
+            .mipmaps = 1,
+            .format = PIXELFORMAT_UNCOMPRESSED_R8G8B8A8
+        };
+    }
+    else
+    {
+        // initialize target Texture2D
+        const Image target_image = {
+            .data = initial ? initial->data : ctx->framebuffers[0].pixels,
+            .width = texture_width,
+            .height = texture_height,
+            .mipmaps = 1,
+            .format = PIXELFORMAT_UNCOMPRESSED_R8G8B8A8
+        };
+        ctx->target = LoadTextureFromImage(target_image);
+        SetTextureFilter(ctx->target, TEXTURE_FILTER_POINT);  // no interpolation
+
+        // no buffer holds what the texture shows, the first upload is a full one
+        if (initial)
+        {
+            for (int32_t tile = 0; tile < tile_count; tile++)
+                ctx->texture_tile_frames[tile] = UINT32_MAX;
+        }
+    }
+
+    return true;
+}
+
+/**
+ * @brief Frees everything create_targets() allocated.
+ *
+ * Nothing may draw into the buffers anymore.
+ *
+ * @param ctx Rendering context.
+ */
+static void destroy_targets(renderer_context *ctx)
+{
+    if (ctx->backend == DNF_RENDERER_BACKEND_WINDOW)
+        UnloadTexture(ctx->target);
+    for (uint32_t i = 0; i < ctx->buffer_count; i++)
+    {
+        MemFree(ctx->framebuffers[i].pixels);
+        dnf_free(ctx->tile_frames[i]);
+        ctx->framebuffers[i].pixels = nullptr;
+        ctx->tile_frames[i] = nullptr;
+    }
+    MemFree(ctx->render_target.pixels);
+    dnf_free(ctx->dirty.tiles);
+    dnf_free(ctx->target_tile_frames);
+    dnf_free(ctx->texture_tile_frames);
+    dnf_free(ctx->resolve_tiles);
+    ctx->render_target.pixels = nullptr;
+    ctx->dirty.tiles = nullptr;
+    ctx->target_tile_frames = nullptr;
+    ctx->texture_tile_frames = nullptr;
+    ctx->resolve_tiles = nullptr;
+}
+
+/**
+ * @brief Frees everything a rendering context owns (see renderer_init()).
+ *
+ * Nothing may draw into the buffers anymore.
+ *
+ * @param ctx Rendering context.
+ */
+static void free_context(renderer_context *ctx)
+{
+    destroy_targets(ctx);
+    dnf_free(ctx->palette);
+    ctx->palette = nullptr;
+    free_view_tables(&ctx->view);
+    dnf_free(ctx->passes);
+    ctx->passes = nullptr;
+    if (ctx->bsp_scratch)
+    {
+        dnf_free(ctx->bsp_scratch->clips);
+        dnf_free(ctx->bsp_scratch->ranges);
+        dnf_free(ctx->bsp_scratch->visible_sets);
+        dnf_free(ctx->bsp_scratch);
+        ctx->bsp_scratch = nullptr;
+    }
+}
 
 bool8_t renderer_init(
     renderer_context *ctx,
     const int32_t out_width,
-    const int32_t out_height)
-{
-    // TODO: make the logic more robust and raise errors if something is wrong
-    ctx->framebuffer.width = out_width;
-    ctx->framebuffer.height = out_height;
-    ctx->framebuffer.pixels = GenImageColor(out_width, out_height, BLACK).data;
-
-    // initialize target Texture2D
-    const Image target_image = {
-        .data = ctx->framebuffer.pixels,
-        .width = out_width,
-        .height = out_height,
-        .mipmaps = 1,
-        .format = PIXELFORMAT_UNCOMPRESSED_R8G8B8A8
-    };
-    ctx->target = LoadTextureFromImage(target_image);
-    SetTextureFilter(ctx->target, TEXTURE_FILTER_POINT);  // no interpolation
+    const int32_t out_height,
+    uint32_t buffer_count,
+    const dnf_renderer_backend backend,
+    const bool8_t column_major,
+    const dnf_pixel_format format)
+{
+    if (buffer_count < 1)
+        buffer_count = 1;
+    if (buffer_count > DNF_RENDERER_MAX_BUFFERS)
+    {
+        DNF_WARN("Too many framebuffers requested (%u), using %d", buffer_count, DNF_RENDERER_MAX_BUFFERS);
+        buffer_count = DNF_RENDERER_MAX_BUFFERS;
+    }
+
+    // everything below is freed by free_context() if a step fails
+    *ctx = (renderer_context){0};
+    ctx->buffer_count = buffer_count;
+    ctx->backend = backend;
+    ctx->stats = (dnf_renderer_stats){0};
+    ctx->frame_stamp = 0;
+
+    ctx->passes = dnf_alloc(sizeof(dnf_renderer_passes), DNF_MEMORY_TAG_RENDERER);
+    if (!ctx->passes)
+    {
+        DNF_ERROR("Failed to allocate pass storage");
+        free_context(ctx);
+        return false;
+    }
+
+    ctx->bsp_scratch = dnf_alloc(sizeof(dnf_bsp_scratch), DNF_MEMORY_TAG_RENDERER);
+    if (!ctx->bsp_scratch)
+    {
+        DNF_ERROR("Failed to allocate BSP scratch buffers");
+        free_context(ctx);
+        return false;
+    }
+
+    if (format == DNF_PIXEL_FORMAT_INDEXED8)
+    {
+        ctx->palette = dnf_alloc(sizeof(dnf_palette), DNF_MEMORY_TAG_RENDERER);
+        if (!ctx->palette)
+        {
+            DNF_ERROR("Failed to allocate the palette");
+            free_context(ctx);
+            return false;
+        }
+        palette_init_default(ctx->palette);
+    }
+
+    // precompute per-column tables for world renderers
+    const dnf_framebuffer_layout layout = column_major ? DNF_FRAMEBUFFER_COLUMN_MAJOR : DNF_FRAMEBUFFER_ROW_MAJOR;
+    ctx->view = (dnf_view_tables){ .fov = DNF_RENDERER_DEFAULT_FOV * DEG2RAD };
+    if (!create_targets(ctx, out_width, out_height, layout, format, nullptr) || !build_view_tables(ctx))
+    {
+        free_context(ctx);
+        return false;
+    }
     DNF_DEBUG("Initialized rendering context");
 
     DNF_INFO(
         "Initialized a new rendering context: "
-        "target resolution %dx%d, ",
-        out_width, out_height);
+        "target resolution %dx%d, %u framebuffer(s)%s%s%s",
+        out_width, out_height, buffer_count,
+        column_major ? ", column-major target" : "",
+        format == DNF_PIXEL_FORMAT_INDEXED8 ? ", indexed target" : "",
+        backend == DNF_RENDERER_BACKEND_HEADLESS ? ", headless" : "");
+
+    return true;
+}
+
+bool8_t renderer_resize_target(
+    renderer_context *ctx,
+    const int32_t width,
+    const int32_t height)
+{
+    if (width == ctx->framebuffers[0].width && height == ctx->framebuffers[0].height)
+        return true;
+
+    // nothing may draw into the buffers anymore
+    job_system_wait();
+
+    // keep showing the latest frame (stretched) until a new one is uploaded,
+    // scaling the texture storage keeps a column-major frame transposed
+    const dnf_framebuffer_layout layout = ctx->render_target.layout;
+    const bool8_t transposed = layout == DNF_FRAMEBUFFER_COLUMN_MAJOR;
+    Image latest = {0};
+    if (ctx->backend == DNF_RENDERER_BACKEND_WINDOW)
+    {
+        latest = ImageCopy((Image){
+            .data = ctx->framebuffers[ctx->front_buffer].pixels,
+            .width = ctx->target.width,
+            .height = ctx->target.height,
+            .mipmaps = 1,
+            .format = PIXELFORMAT_UNCOMPRESSED_R8G8B8A8
+        });
+        ImageResizeNN(&latest, transposed ? height : width, transposed ? width : height);
+    }
 
+    const dnf_pixel_format format = ctx->render_target.format;
+    destroy_targets(ctx);
+    const bool8_t created = create_targets(ctx, width, height, layout, format, latest.data ? &latest : nullptr);
+    UnloadImage(latest);
+    if (!created || !build_view_tables(ctx))
+        return false;
+
+    DNF_DEBUG("Resized the render target to %dx%d", width, height);
     return true;
 }
 
@@ -61,13 +454,13 @@ void renderer_resize_window(
     const int32_t window_height)
 {
     // scale factor - get it from either of the ratios
-    const float32_t scale = fminf(
-        (float32_t)window_width / (float32_t)ctx->target.width,
-        (float32_t)window_height / (float32_t)ctx->target.height);
+    const float32_t width = (float32_t)ctx->framebuffers[0].width;
+    const float32_t height = (float32_t)ctx->framebuffers[0].height;
+    const float32_t scale = fminf((float32_t)window_width / width, (float32_t)window_height / height);
 
     // we could just do ctx->screen_rect.width = window_width
-    ctx->screen_rect.width = (float32_t)ctx->target.width * scale;
-    ctx->screen_rect.height = (float32_t)ctx->target.height * scale;
+    ctx->screen_rect.width = width * scale;
+    ctx->screen_rect.height = height * scale;
 
     // update screen rectangle top-left corner position
     ctx->screen_rect.x = ((float32_t)window_width - ctx->screen_rect.width) / 2;
@@ -81,9 +474,12 @@ void renderer_shutdown(renderer_context *ctx)
         DNF_INFO(
             "Shutting down a rendering context: "
             "target %dx%d, screen %dx%d",
-            ctx->target.width, ctx->target.height,
+            ctx->framebuffers[0].width, ctx->framebuffers[0].height,
             ctx->screen_rect.width, ctx->screen_rect.height);
-        UnloadTexture(ctx->target);
+        // nothing may draw into the buffers anymore
+        job_system_wait();
+
+        free_context(ctx);
         DNF_INFO("Renderer shut down successfully");
     }
 }
@@ -93,28 +489,326 @@ void renderer_shutdown(renderer_context *ctx)
  * @brief A wrapper for raylib's DrawText()
  */
 static void draw_text(
+    const renderer_context *ctx,
     const char *text,
     const int32_t x, const int32_t y,
     const int32_t size, const Color color)
-{ DrawText(text, x, y, size, color); }
+{
+    if (ctx->backend != DNF_RENDERER_BACKEND_HEADLESS)
+        DrawText(text, x, y, size, color);
+}
+
+/**
+ * @brief A wrapper for raylib's DrawFPS()
+ */
+static void draw_fps(const renderer_context *ctx, const int32_t x, const int32_t y)
+{
+    if (ctx->backend != DNF_RENDERER_BACKEND_HEADLESS)
+        DrawFPS(x, y);
+}
 
 
 dnf_renderer_api renderer_get_api(void)
 {
     return (dnf_renderer_api){
         .draw_text = draw_text,
-        .draw_fps = DrawFPS
+        .draw_fps = draw_fps
+    };
+}
+
+/**
+ * @brief Job function that draws a single band of a dnf_band_batch.
+ */
+static void draw_band_job(const uint32_t job_index, void *user_data)
+{
+    const dnf_band_batch *batch = user_data;
+
+    const int32_t x_begin = (int32_t)job_index * batch->band_width;
+    int32_t x_end = x_begin + batch->band_width;
+    if (x_end > batch->fb->width)
+        x_end = batch->fb->width;
+
+    if (x_begin < x_end)
+        batch->draw(batch->fb, x_begin, x_end, batch->user_data);
+}
+
+/**
+ * @brief Gets the buffer frames are drawn into.
+ */
+static const dnf_framebuffer *render_target(const renderer_context *ctx)
+{
+    if (ctx->render_target.pixels)
+        return &ctx->render_target;
+    return &ctx->framebuffers[ctx->back_buffer];
+}
+
+/**
+ * @brief Job function that resolves a band of a dnf_resolve_batch.
+ *
+ * Bands follow the target's contiguous runs: rows of a row-major target
+ * (skipped unless some of them are to be resolved), columns of a
+ * column-major one (only the rows range to be resolved).
+ */
+static void resolve_band_job(const uint32_t job_index, void *user_data)
+{
+    const dnf_resolve_batch *batch = user_data;
+    const dnf_framebuffer *src = batch->src;
+
+    const int32_t start = (int32_t)job_index * DNF_RENDERER_RESOLVE_BAND;
+    if (src->layout == DNF_FRAMEBUFFER_COLUMN_MAJOR)
+    {
+        pixels_blit(
+            batch->dst, start, batch->y_begin,
+            src, start, batch->y_begin,
+            DNF_RENDERER_RESOLVE_BAND, batch->y_end - batch->y_begin);
+        return;
+    }
+
+    bool8_t changed = false;
+    for (int32_t y = start; y < start + DNF_RENDERER_RESOLVE_BAND && y < src->height; y += DNF_FRAMEBUFFER_DIRTY_TILE)
+        changed |= batch->tiles[y / DNF_FRAMEBUFFER_DIRTY_TILE];
+    if (changed)
+        pixels_blit(batch->dst, 0, start, src, 0, start, src->width, DNF_RENDERER_RESOLVE_BAND);
+}
+
+/**
+ * @brief Completes the back buffer, unless it is already done: records the
+ * rows the frame wrote and converts the rows of the render target (if there
+ * is one) the back buffer doesn't hold yet into it (expands palette
+ * indices, both have the same layout).
+ *
+ * Band drawing must be finished.
+ *
+ * @param ctx Rendering context.
+ */
+static void finish_back_buffer(renderer_context *ctx)
+{
+    if (ctx->back_finished)
+        return;
+
+    const int32_t tile_count = ctx->dirty.tile_count;
+    const uint32_t frame = ++ctx->frame_stamp;
+    uint32_t *back_frames = ctx->tile_frames[ctx->back_buffer];
+    uint32_t *written_frames = ctx->render_target.pixels ? ctx->target_tile_frames : back_frames;
+    for (int32_t tile = 0; tile < tile_count; tile++)
+    {
+        if (atomic_load_explicit(&ctx->dirty.tiles[tile], memory_order_relaxed))
+        {
+            written_frames[tile] = frame;
+            atomic_store_explicit(&ctx->dirty.tiles[tile], 0, memory_order_relaxed);
+        }
+    }
+
+    if (ctx->render_target.pixels)
+    {
+        int32_t first = tile_count, last = -1;
+        for (int32_t tile = 0; tile < tile_count; tile++)
+        {
+            ctx->resolve_tiles[tile] = back_frames[tile] != ctx->target_tile_frames[tile];
+            if (ctx->resolve_tiles[tile])
+            {
+                if (first == tile_count)
+                    first = tile;
+                last = tile;
+            }
+        }
+
+        if (last >= 0)
+        {
+            dnf_resolve_batch batch = {
+                .src = &ctx->render_target,
+                .dst = &ctx->framebuffers[ctx->back_buffer],
+                .tiles = ctx->resolve_tiles,
+                .y_begin = first * DNF_FRAMEBUFFER_DIRTY_TILE,
+                .y_end = (last + 1) * DNF_FRAMEBUFFER_DIRTY_TILE
+            };
+            if (batch.y_end > ctx->render_target.height)
+                batch.y_end = ctx->render_target.height;
+
+            const int32_t length = ctx->render_target.layout == DNF_FRAMEBUFFER_COLUMN_MAJOR
+                ? ctx->render_target.width
+                : ctx->render_target.height;
+            const uint32_t job_count = (uint32_t)((length + DNF_RENDERER_RESOLVE_BAND - 1) / DNF_RENDERER_RESOLVE_BAND);
+            job_system_dispatch(job_count, resolve_band_job, &batch);
+            memcpy(back_frames, ctx->target_tile_frames, (size_t)tile_count * sizeof(uint32_t));
+        }
+    }
+    ctx->back_finished = true;
+}
+
+/**
+ * @brief Uploads the rows of a buffer the target texture doesn't hold yet.
+ *
+ * Rows go as full-width strips: a strip is contiguous in the buffer, a
+ * narrower rectangle would need a staging copy. Rows of a column-major
+ * buffer are texture columns, so it is uploaded whole.
+ *
+ * @param ctx Rendering context.
+ * @param index Index of a completed buffer.
+ */
+static void upload_buffer(renderer_context *ctx, const uint32_t index)
+{
+    const dnf_framebuffer *fb = &ctx->framebuffers[index];
+    const uint32_t *frames = ctx->tile_frames[index];
+    const uint32_t *texture_frames = ctx->texture_tile_frames;
+    const int32_t tile_count = ctx->dirty.tile_count;
+
+    int32_t changed_rows = 0;
+    for (int32_t tile = 0; tile < tile_count; tile++)
+    {
+        if (frames[tile] != texture_frames[tile])
+            changed_rows += fb->height - tile * DNF_FRAMEBUFFER_DIRTY_TILE < DNF_FRAMEBUFFER_DIRTY_TILE
+                ? fb->height - tile * DNF_FRAMEBUFFER_DIRTY_TILE
+                : DNF_FRAMEBUFFER_DIRTY_TILE;
+    }
+    if (changed_rows == 0)
+        return;
+
+    const uint64_t upload_start = dnf_clock_now_ns();
+    if (fb->layout == DNF_FRAMEBUFFER_COLUMN_MAJOR
+        || changed_rows * 100 >= fb->height * DNF_RENDERER_FULL_UPLOAD_PERCENT)
+        UpdateTexture(ctx->target, fb->pixels);
+    else
+    {
+        int32_t tile = 0;
+        while (tile < tile_count)
+        {
+            if (frames[tile] == texture_frames[tile])
+            {
+                tile++;
+                continue;
+            }
+
+            int32_t end = tile;
+            while (end < tile_count && frames[end] != texture_frames[end])
+                end++;
+
+            const int32_t y0 = tile * DNF_FRAMEBUFFER_DIRTY_TILE;
+            int32_t y1 = end * DNF_FRAMEBUFFER_DIRTY_TILE;
+            if (y1 > fb->height)
+                y1 = fb->height;
+            UpdateTextureRec(
+                ctx->target,
+                (Rectangle){0.0f, (float32_t)y0, (float32_t)fb->width, (float32_t)(y1 - y0)},
+                (const Color *)fb->pixels + (size_t)y0 * fb->width);
+            tile = end;
+        }
+    }
+    memcpy(ctx->texture_tile_frames, frames, (size_t)tile_count * sizeof(uint32_t));
+    ctx->stats.upload_ns += dnf_clock_now_ns() - upload_start;
+}
+
+const dnf_framebuffer *renderer_get_back_buffer(const renderer_context *ctx)
+{
+    job_system_wait();
+    return render_target(ctx);
+}
+
+void *renderer_alloc_pass_data(const renderer_context *ctx, size_t size)
+{
+    dnf_renderer_passes *passes = ctx->passes;
+    size = (size + 15) & ~(size_t)15;
+    if (size > DNF_RENDERER_PASS_DATA_SIZE)
+    {
+        DNF_ERROR("Pass data of %zu bytes doesn't fit into the pass storage", size);
+        return nullptr;
+    }
+
+    // out of storage - nothing is in flight after a wait, so start over
+    if (passes->data_used + size > DNF_RENDERER_PASS_DATA_SIZE)
+    {
+        job_system_wait();
+        passes->data_used = 0;
+    }
+
+    void *data = passes->data + passes->data_used;
+    passes->data_used += size;
+    memset(data, 0, size);
+    return data;
+}
+
+void renderer_draw_bands(
+    const renderer_context *ctx,
+    const dnf_band_draw_fn draw,
+    void *user_data)
+{
+    const dnf_framebuffer *fb = render_target(ctx);
+    dnf_renderer_passes *passes = ctx->passes;
+
+    // cache line aligned bands, so neighbouring bands never share a line
+    const int32_t band_count = (int32_t)(job_system_thread_count() * DNF_RENDERER_BANDS_PER_THREAD);
+    int32_t band_width = (fb->width + band_count - 1) / band_count;
+    band_width = (band_width + DNF_RENDERER_BAND_ALIGN - 1) / DNF_RENDERER_BAND_ALIGN * DNF_RENDERER_BAND_ALIGN;
+
+    // all batch slots may be in flight - wait for them to free up
+    if (passes->batch_count == DNF_RENDERER_MAX_PASSES)
+    {
+        job_system_wait();
+        passes->batch_count = 0;
+    }
+
+    dnf_band_batch *batch = &passes->batches[passes->batch_count++];
+    *batch = (dnf_band_batch){
+        .fb = fb,
+        .draw = draw,
+        .user_data = user_data,
+        .band_width = band_width
     };
+
+    const uint32_t job_count = (uint32_t)((fb->width + band_width - 1) / band_width);
+    if (ctx->buffer_count > 1)
+        job_system_dispatch_async(job_count, draw_band_job, batch);
+    else
+    {
+        job_system_dispatch(job_count, draw_band_job, batch);
+        passes->batch_count = 0;
+    }
 }
 
-void renderer_begin_frame(const renderer_context *ctx)
+void renderer_begin_frame(renderer_context *ctx)
 {
+    // nothing to upload to or present on
+    if (ctx->backend == DNF_RENDERER_BACKEND_HEADLESS)
+    {
+        ctx->front_uploaded = true;
+        return;
+    }
+
     // update texture with our framebuffer
-    UpdateTexture(ctx->target, ctx->framebuffer.pixels);
+    if (ctx->buffer_count == 1)
+    {
+        job_system_wait();
+        finish_back_buffer(ctx);
+        upload_buffer(ctx, 0);
+    }
+    else if (!ctx->front_uploaded)
+    {
+        // the back buffer is still being drawn by the workers meanwhile
+        upload_buffer(ctx, ctx->front_buffer);
+        ctx->front_uploaded = true;
+    }
 
     BeginDrawing();
     ClearBackground(BLACK);
 
+    if (ctx->framebuffers[0].layout == DNF_FRAMEBUFFER_COLUMN_MAJOR)
+    {
+        // the texture is the transposed frame: flip it vertically and turn
+        // it clockwise around the top-right corner of the screen rect
+        DrawTexturePro(
+            ctx->target,
+            (Rectangle){ 0.0f, 0.0f, (float32_t)ctx->target.width, -(float32_t)ctx->target.height },
+            (Rectangle){
+                ctx->screen_rect.x + ctx->screen_rect.width,
+                ctx->screen_rect.y,
+                ctx->screen_rect.height,
+                ctx->screen_rect.width},
+            (Vector2){0.0f, 0.0f},
+            90.0f,
+            WHITE);
+        return;
+    }
+
     // scale the render to the screen rect
     DrawTexturePro(
         // Texture to render
@@ -123,8 +817,8 @@ void renderer_begin_frame(const renderer_context *ctx)
         (Rectangle){
             0.0f,
             0.0f,
-            (float32_t)ctx->framebuffer.width,
-            (float32_t)ctx->framebuffer.height},
+            (float32_t)ctx->target.width,
+            (float32_t)ctx->target.height},
         // Destination rectangle (to scale to)
         ctx->screen_rect,
         // Origin of destination rectangle
@@ -135,8 +829,83 @@ void renderer_begin_frame(const renderer_context *ctx)
         WHITE);
 }
 
-void renderer_end_frame(const renderer_context *ctx)
+void renderer_end_frame(renderer_context *ctx)
 {
+    if (ctx->backend == DNF_RENDERER_BACKEND_HEADLESS)
+        return;
+
     // render the entire screen
+    const uint64_t present_start = dnf_clock_now_ns();
     EndDrawing();
+    ctx->stats.present_ns += dnf_clock_now_ns() - present_start;
+}
+
+void renderer_set_palette(renderer_context *ctx, const Color colors[DNF_PALETTE_SIZE])
+{
+    if (!ctx->palette)
+    {
+        DNF_WARN("Tried to set a palette of a context without an indexed target");
+        return;
+    }
+
+    // queued bands and the resolve still read the old one
+    job_system_wait();
+    palette_init(ctx->palette, colors);
+
+    // every pixel changes its color
+    for (int32_t tile = 0; tile < ctx->dirty.tile_count; tile++)
+        atomic_store_explicit(&ctx->dirty.tiles[tile], 1, memory_order_relaxed);
+}
+
+bool8_t renderer_dump_frame(const renderer_context *ctx, const char *filename)
+{
+    // single-buffered contexts complete frames in place
+    job_system_wait();
+    const dnf_framebuffer *fb = &ctx->framebuffers[ctx->front_buffer];
+
+    Image image = {
+        .data = fb->pixels,
+        .width = fb->width,
+        .height = fb->height,
+        .mipmaps = 1,
+        .format = PIXELFORMAT_UNCOMPRESSED_R8G8B8A8
+    };
+
+    // images are row-major, transpose column-major frames first
+    if (fb->layout == DNF_FRAMEBUFFER_COLUMN_MAJOR)
+    {
+        image.data = GenImageColor(fb->width, fb->height, BLACK).data;
+        const dnf_framebuffer rows = {
+            .pixels = image.data,
+            .width = fb->width,
+            .height = fb->height,
+            .layout = DNF_FRAMEBUFFER_ROW_MAJOR,
+            .format = DNF_PIXEL_FORMAT_RGBA8
+        };
+        pixels_blit(&rows, 0, 0, fb, 0, 0, fb->width, fb->height);
+    }
+
+    const bool8_t exported = ExportImage(image, filename);
+    if (image.data != fb->pixels)
+        UnloadImage(image);
+    if (!exported)
+    {
+        DNF_ERROR("Failed to dump frame to %s", filename);
+        return false;
+    }
+    return true;
+}
+
+void renderer_swap_buffers(renderer_context *ctx)
+{
+    // finish the back buffer
+    job_system_wait();
+    finish_back_buffer(ctx);
+    ctx->passes->batch_count = 0;
+    ctx->passes->data_used = 0;
+
+    ctx->front_buffer = ctx->back_buffer;
+    ctx->front_uploaded = false;
+    ctx->back_finished = false;
+    ctx->back_buffer = (ctx->back_buffer + 1) % ctx->buffer_count;
 }
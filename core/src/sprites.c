@@ -0,0 +1,338 @@
+// DNF (Doomed and Forgotten): a DOOM-style first-person shooter.
+// Copyright (C) 2025-2026  Alexandr Gorbatenko
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+
+#include "sprites.h"
+
+#include "logger.h"
+#include "palette.h"
+#include "pixels.h"
+
+#include <math.h>  // cosf, sinf, ceilf, fminf, fmaxf
+
+// Alignment of the per-frame arrays (a cache line).
+#define DNF_SPRITE_ARRAY_ALIGNMENT 64
+// Sprites closer than this to the camera plane are not drawn.
+#define DNF_SPRITE_NEAR_PLANE 0.05f
+// Radix sort digit size in bits (two passes over the 16-bit depth).
+#define DNF_SPRITE_RADIX_BITS 8
+#define DNF_SPRITE_RADIX_SIZE (1 << DNF_SPRITE_RADIX_BITS)
+
+
+/**
+ * @brief A sprite projected to the screen, ready to be drawn.
+ */
+typedef struct dnf_sprite_view
+{
+    const Color *texels;   //!< Texels of the mip level (nullptr - solid color)
+    const uint8_t *indices;  //!< Palette indices of the mip level (nullptr - look the texels up)
+    int32_t texel_width;   //!< Columns of the mip level
+    int32_t texel_height;  //!< Texels per column
+    float32_t depth;       //!< Camera-space depth (compared with the wall depth)
+    float32_t left;        //!< Fractional screen column of the left edge
+    float32_t u_step;      //!< Texel columns per screen column
+    float32_t v;           //!< Texel coordinate at the first row
+    float32_t v_step;      //!< Texels per screen row
+    int32_t x_begin;       //!< First covered column (clipped to the screen)
+    int32_t x_end;         //!< Last covered column (exclusive, clipped to the screen)
+    int32_t y_begin;       //!< First covered row (may be off-screen)
+    int32_t y_end;         //!< Last covered row (exclusive, may be off-screen)
+    float32_t light;       //!< Light factor of the texels
+    Color color;           //!< Lit color (untextured sprites)
+    uint8_t index;         //!< Lit palette index (untextured sprites, indexed targets)
+    uint8_t transparent;   //!< Palette index of the masked texels (with indices)
+} dnf_sprite_view;
+
+/**
+ * @brief Per-frame sprite pass parameters shared by all column bands.
+ */
+typedef struct dnf_sprite_frame
+{
+    const dnf_view_tables *view;   //!< View tables (with the wall depth)
+    const dnf_sprite_view *views;  //!< Projected sprites
+    const uint32_t *keys;          //!< Draw order (view index in the low half)
+    uint32_t count;                //!< Sprites to draw
+    bool8_t indexed;               //!< True if the target is indexed
+} dnf_sprite_frame;
+
+
+bool8_t sprite_batch_init(dnf_sprite_batch *batch, const uint32_t capacity)
+{
+    *batch = (dnf_sprite_batch){0};
+    if (capacity == 0 || capacity > DNF_SPRITE_MAX_COUNT)
+    {
+        DNF_ERROR("Invalid sprite batch capacity %u (1 to %u)", capacity, DNF_SPRITE_MAX_COUNT);
+        return false;
+    }
+
+    batch->sprites = dnf_alloc(capacity * sizeof(dnf_sprite), DNF_MEMORY_TAG_RENDERER);
+    if (!batch->sprites)
+    {
+        DNF_ERROR("Failed to allocate a sprite batch of %u sprites", capacity);
+        return false;
+    }
+
+    batch->capacity = capacity;
+    return true;
+}
+
+void sprite_batch_shutdown(dnf_sprite_batch *batch)
+{
+    dnf_free(batch->sprites);
+    *batch = (dnf_sprite_batch){0};
+}
+
+void sprite_batch_clear(dnf_sprite_batch *batch)
+{
+    batch->count = 0;
+}
+
+bool8_t sprite_batch_add(dnf_sprite_batch *batch, const dnf_sprite *sprite)
+{
+    if (batch->count == batch->capacity)
+        return false;
+    batch->sprites[batch->count++] = *sprite;
+    return true;
+}
+
+/**
+ * @brief Sorts keys by their high half (stable LSD radix sort, one pass per
+ * byte).
+ *
+ * @param keys Keys to sort (sorted in place).
+ * @param scratch Scratch of the same size.
+ * @param count Number of keys.
+ */
+static void radix_sort_keys(uint32_t *keys, uint32_t *scratch, const uint32_t count)
+{
+    // histograms of both digits in one read
+    uint32_t histograms[2][DNF_SPRITE_RADIX_SIZE] = {0};
+    for (uint32_t i = 0; i < count; i++)
+    {
+        histograms[0][(keys[i] >> 16) & (DNF_SPRITE_RADIX_SIZE - 1)]++;
+        histograms[1][keys[i] >> (16 + DNF_SPRITE_RADIX_BITS)]++;
+    }
+
+    uint32_t *src = keys, *dst = scratch;
+    for (uint32_t pass = 0; pass < 2; pass++)
+    {
+        // every key has the same digit - the pass wouldn't move anything
+        const uint32_t shift = 16 + pass * DNF_SPRITE_RADIX_BITS;
+        if (histograms[pass][(src[0] >> shift) & (DNF_SPRITE_RADIX_SIZE - 1)] == count)
+            continue;
+
+        uint32_t offset = 0;
+        for (uint32_t digit = 0; digit < DNF_SPRITE_RADIX_SIZE; digit++)
+        {
+            const uint32_t digit_count = histograms[pass][digit];
+            histograms[pass][digit] = offset;
+            offset += digit_count;
+        }
+        for (uint32_t i = 0; i < count; i++)
+            dst[histograms[pass][(src[i] >> shift) & (DNF_SPRITE_RADIX_SIZE - 1)]++] = src[i];
+
+        uint32_t *swap = src;
+        src = dst;
+        dst = swap;
+    }
+
+    // an odd number of passes leaves the result in the scratch
+    if (src != keys)
+        for (uint32_t i = 0; i < count; i++)
+            keys[i] = src[i];
+}
+
+/**
+ * @brief Draws a band of columns (see renderer_draw_bands()).
+ *
+ * @param user_data Pointer to dnf_sprite_frame.
+ */
+static void sprite_band(const dnf_framebuffer *fb, const int32_t x_begin, const int32_t x_end, void *user_data)
+{
+    const dnf_sprite_frame *frame = user_data;
+    const float32_t *wall_depth = frame->view->depth;
+
+    for (uint32_t i = 0; i < frame->count; i++)
+    {
+        const dnf_sprite_view *sv = &frame->views[frame->keys[i] & 0xFFFF];
+        const int32_t first = sv->x_begin > x_begin ? sv->x_begin : x_begin;
+        const int32_t end = sv->x_end < x_end ? sv->x_end : x_end;
+
+        for (int32_t col = first; col < end; col++)
+        {
+            // behind the wall of this column
+            if (wall_depth[col] <= sv->depth)
+                continue;
+
+            if (!sv->texels)
+            {
+                if (frame->indexed)
+                    pixels_fill_column_index(fb, col, sv->y_begin, sv->y_end, sv->index);
+                else
+                    pixels_fill_column(fb, col, sv->y_begin, sv->y_end, sv->color);
+                continue;
+            }
+
+            int32_t u = (int32_t)(((float32_t)col + 0.5f - sv->left) * sv->u_step);
+            if (u < 0) u = 0;
+            if (u >= sv->texel_width) u = sv->texel_width - 1;
+            if (sv->indices)
+            {
+                pixels_draw_column_masked_index(fb, col, sv->y_begin, sv->y_end,
+                    sv->indices + (size_t)u * sv->texel_height, sv->texel_height, sv->v, sv->v_step, sv->light,
+                    sv->transparent);
+                continue;
+            }
+            pixels_draw_column_masked(fb, col, sv->y_begin, sv->y_end,
+                sv->texels + (size_t)u * sv->texel_height, sv->texel_height, sv->v, sv->v_step, sv->light);
+        }
+    }
+}
+
+uint32_t sprite_batch_render(
+    const renderer_context *ctx,
+    dnf_sprite_batch *batch,
+    const dnf_texture_cache *textures,
+    const dnf_camera *camera,
+    dnf_arena *frame_arena)
+{
+    batch->visible = 0;
+    if (batch->count == 0)
+        return 0;
+
+    // bands read the views and the keys until the buffer swap
+    dnf_sprite_view *views = arena_alloc(frame_arena, batch->count * sizeof(dnf_sprite_view), DNF_SPRITE_ARRAY_ALIGNMENT);
+    uint32_t *keys = arena_alloc(frame_arena, batch->count * sizeof(uint32_t), DNF_SPRITE_ARRAY_ALIGNMENT);
+    uint32_t *sort_buffer = arena_alloc(frame_arena, batch->count * sizeof(uint32_t), DNF_SPRITE_ARRAY_ALIGNMENT);
+    if (!views || !keys || !sort_buffer)
+    {
+        DNF_WARN("Frame arena is full, %u sprites not drawn", batch->count);
+        return 0;
+    }
+
+    const dnf_framebuffer *fb = &ctx->framebuffers[ctx->back_buffer];
+    const float32_t half_width = (float32_t)fb->width * 0.5f;
+    const float32_t half_height = (float32_t)fb->height * 0.5f;
+    const float32_t projection = ctx->view.projection;
+    const float32_t forward_x = cosf(camera->angle);
+    const float32_t forward_y = sinf(camera->angle);
+
+    // project and cull, keeping the depth range for the quantization
+    uint32_t visible = 0;
+    float32_t max_depth = 0.0f;
+    for (uint32_t i = 0; i < batch->count; i++)
+    {
+        const dnf_sprite *sprite = &batch->sprites[i];
+        const float32_t rel_x = sprite->x - camera->x;
+        const float32_t rel_y = sprite->y - camera->y;
+        const float32_t depth = rel_x * forward_x + rel_y * forward_y;
+        if (depth < DNF_SPRITE_NEAR_PLANE)
+            continue;
+
+        const float32_t right = -rel_x * forward_y + rel_y * forward_x;
+        const float32_t scale = projection / depth;
+        const float32_t pixel_width = sprite->width * scale;
+        const float32_t pixel_height = sprite->height * scale;
+
+        // columns and rows whose centers lie within the sprite (far-off-screen
+        // edges are kept in a sane integer range)
+        const float32_t left = half_width + right * scale - pixel_width * 0.5f;
+        const float32_t top = half_height - (sprite->z + sprite->height - camera->z) * scale;
+        const int32_t x_begin = (int32_t)ceilf(fmaxf(left, -1.0f) - 0.5f);
+        const int32_t x_end = (int32_t)ceilf(fminf(left + pixel_width, (float32_t)fb->width + 1.0f) - 0.5f);
+        const int32_t y_begin = (int32_t)ceilf(fmaxf(top, -1e6f) - 0.5f);
+        const int32_t y_end = (int32_t)ceilf(fminf(top + pixel_height, 1e6f) - 0.5f);
+        if (x_begin >= x_end || x_end <= 0 || x_begin >= fb->width
+            || y_begin >= y_end || y_end <= 0 || y_begin >= fb->height)
+            continue;
+
+        dnf_sprite_view *sv = &views[visible];
+        *sv = (dnf_sprite_view){
+            .depth = depth,
+            .left = left,
+            .x_begin = x_begin > 0 ? x_begin : 0,
+            .x_end = x_end < fb->width ? x_end : fb->width,
+            .y_begin = y_begin,
+            .y_end = y_end,
+            .light = sprite->light,
+        };
+
+        const dnf_texture *texture = textures ? texture_cache_get(textures, sprite->texture) : nullptr;
+        if (texture)
+        {
+            // the level with about a texel per pixel
+            const uint32_t mip = texture_select_mip(texture, (float32_t)texture->height / pixel_height);
+            sv->texels = textures->atlas + texture->mip_offsets[mip];
+            if (ctx->palette && textures->palette == ctx->palette)
+            {
+                sv->indices = textures->indices + texture->mip_offsets[mip];
+                sv->transparent = texture->transparent_index;
+            }
+            sv->texel_width = texture_mip_width(texture, mip);
+            sv->texel_height = texture_mip_height(texture, mip);
+            sv->u_step = (float32_t)sv->texel_width / pixel_width;
+            sv->v_step = (float32_t)sv->texel_height / pixel_height;
+            sv->v = ((float32_t)y_begin + 0.5f - top) * sv->v_step;
+        }
+        else if (ctx->palette)
+        {
+            sv->index = palette_light(ctx->palette, palette_find(ctx->palette, sprite->color),
+                palette_light_level(sprite->light));
+        }
+        else
+        {
+            const float32_t light = fmaxf(0.0f, fminf(sprite->light, 1.0f));
+            sv->color = (Color){
+                (uint8_t)((float32_t)sprite->color.r * light),
+                (uint8_t)((float32_t)sprite->color.g * light),
+                (uint8_t)((float32_t)sprite->color.b * light),
+                sprite->color.a
+            };
+        }
+
+        max_depth = fmaxf(max_depth, depth);
+        visible++;
+    }
+
+    // farther sprites get smaller keys, so an ascending sort is back to front
+    const float32_t quantize = 65535.0f / fmaxf(max_depth, DNF_SPRITE_NEAR_PLANE);
+    for (uint32_t i = 0; i < visible; i++)
+    {
+        const uint32_t quantized = (uint32_t)(views[i].depth * quantize);
+        keys[i] = (65535 - (quantized < 65535 ? quantized : 65535)) << 16 | i;
+    }
+    if (visible > 1)
+        radix_sort_keys(keys, sort_buffer, visible);
+
+    batch->visible = visible;
+    if (visible == 0)
+        return 0;
+
+    // bands may run after we return (pipelined contexts)
+    dnf_sprite_frame *frame = renderer_alloc_pass_data(ctx, sizeof(dnf_sprite_frame));
+    if (!frame)
+        return 0;
+
+    *frame = (dnf_sprite_frame){
+        .view = &ctx->view,
+        .views = views,
+        .keys = keys,
+        .count = visible,
+        .indexed = ctx->palette != nullptr
+    };
+    renderer_draw_bands(ctx, sprite_band, frame);
+    return visible;
+}
@@ -0,0 +1,415 @@
+// DNF (Doomed and Forgotten): a DOOM-style first-person shooter.
+// Copyright (C) 2025-2026  Alexandr Gorbatenko
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+#include "texture_cache.h"
+
+#include "dnf_memory.h"
+#include "logger.h"
+
+#include <string.h>  // strncmp, strncpy
+
+
+/**
+ * @brief Rounds a texture side up to a power of two (at most the level 0
+ * size of DNF_TEXTURE_MAX_MIPS levels).
+ */
+static int32_t next_power_of_two(const int32_t size)
+{
+    int32_t power = 1;
+    while (power < size && power < (1 << (DNF_TEXTURE_MAX_MIPS - 1)))
+        power <<= 1;
+    return power;
+}
+
+/**
+ * @brief Gets the size of the next mip level side.
+ */
+static int32_t mip_side(const int32_t side)
+{
+    return side > 1 ? (side + 1) / 2 : 1;
+}
+
+/**
+ * @brief Gets the index of a texel of a level in its storage order.
+ */
+static size_t texel_index(const dnf_texture_kind kind, const int32_t width, const int32_t height, const int32_t x, const int32_t y)
+{
+    if (kind == DNF_TEXTURE_FLAT)
+        return (size_t)y * width + x;
+    return (size_t)x * height + y;
+}
+
+/**
+ * @brief Averages a 2x2 block of a level into a texel of the next one.
+ *
+ * Sprite alpha is a mask: the texel is opaque if most of the block is, and
+ * only opaque texels count towards its color, so transparent (usually
+ * black) texels don't bleed into the edges.
+ */
+static Color filter_block(
+    const dnf_texture_kind kind,
+    const Color *src, const int32_t width, const int32_t height,
+    const int32_t x, const int32_t y)
+{
+    // odd sides: the last texel pairs with itself
+    const int32_t xs[2] = { 2 * x, 2 * x + 1 < width ? 2 * x + 1 : 2 * x };
+    const int32_t ys[2] = { 2 * y, 2 * y + 1 < height ? 2 * y + 1 : 2 * y };
+
+    uint32_t r = 0, g = 0, b = 0, a = 0, count = 0;
+    for (int32_t j = 0; j < 2; j++)
+    {
+        for (int32_t i = 0; i < 2; i++)
+        {
+            const Color texel = src[texel_index(kind, width, height, xs[i], ys[j])];
+            if (kind == DNF_TEXTURE_SPRITE && texel.a == 0)
+                continue;
+            r += texel.r;
+            g += texel.g;
+            b += texel.b;
+            a += texel.a;
+            count++;
+        }
+    }
+
+    if (kind == DNF_TEXTURE_SPRITE && count < 2)
+        return (Color){ 0, 0, 0, 0 };
+    return (Color){
+        (uint8_t)((r + count / 2) / count),
+        (uint8_t)((g + count / 2) / count),
+        (uint8_t)((b + count / 2) / count),
+        kind == DNF_TEXTURE_SPRITE ? 255 : (uint8_t)((a + count / 2) / count)
+    };
+}
+
+/**
+ * @brief Converts the texels of every level of a texture to indices of the
+ * cache palette.
+ */
+static void quantize_texture(const dnf_texture_cache *cache, dnf_texture *texture)
+{
+    // levels are laid out in order, the last one ends the texture
+    const uint32_t last = texture->mip_count - 1;
+    const size_t begin = texture->mip_offsets[0];
+    const size_t end = texture->mip_offsets[last]
+        + (size_t)texture_mip_width(texture, last) * texture_mip_height(texture, last);
+
+    if (texture->kind != DNF_TEXTURE_SPRITE)
+    {
+        for (size_t i = begin; i < end; i++)
+            cache->indices[i] = palette_find(cache->palette, cache->atlas[i]);
+        return;
+    }
+
+    // masked texels take the index the opaque ones use least (none, unless
+    // the sprite has every color of the palette)
+    uint32_t uses[DNF_PALETTE_SIZE] = {0};
+    for (size_t i = begin; i < end; i++)
+    {
+        if (!cache->atlas[i].a)
+            continue;
+        cache->indices[i] = palette_find(cache->palette, cache->atlas[i]);
+        uses[cache->indices[i]]++;
+    }
+    uint32_t transparent = 0;
+    for (uint32_t index = 1; index < DNF_PALETTE_SIZE && uses[transparent] > 0; index++)
+        if (uses[index] < uses[transparent])
+            transparent = index;
+    if (uses[transparent] > 0)
+        DNF_WARN("Sprite '%s' uses every palette color, %u texels become transparent", texture->name, uses[transparent]);
+
+    texture->transparent_index = (uint8_t)transparent;
+    for (size_t i = begin; i < end; i++)
+        if (!cache->atlas[i].a)
+            cache->indices[i] = texture->transparent_index;
+}
+
+bool8_t texture_cache_init(dnf_texture_cache *cache, const size_t atlas_texels, const uint32_t max_textures)
+{
+    *cache = (dnf_texture_cache){0};
+
+    cache->atlas = dnf_alloc(atlas_texels * sizeof(Color), DNF_MEMORY_TAG_TEXTURES);
+    cache->textures = dnf_alloc(max_textures * sizeof(dnf_texture), DNF_MEMORY_TAG_TEXTURES);
+    if (!cache->atlas || !cache->textures)
+    {
+        DNF_ERROR("Failed to allocate a texture atlas of %zu texels", atlas_texels);
+        texture_cache_shutdown(cache);
+        return false;
+    }
+
+    cache->atlas_capacity = atlas_texels;
+    cache->texture_capacity = max_textures;
+    return true;
+}
+
+void texture_cache_shutdown(dnf_texture_cache *cache)
+{
+    dnf_free(cache->atlas);
+    dnf_free(cache->textures);
+    dnf_free(cache->indices);
+    *cache = (dnf_texture_cache){0};
+}
+
+bool8_t texture_cache_set_palette(dnf_texture_cache *cache, const dnf_palette *palette)
+{
+    if (!palette)
+    {
+        dnf_free(cache->indices);
+        cache->indices = nullptr;
+        cache->palette = nullptr;
+        return true;
+    }
+
+    // laid out like the atlas, so the level offsets work for both
+    if (!cache->indices)
+    {
+        cache->indices = dnf_alloc(cache->atlas_capacity, DNF_MEMORY_TAG_TEXTURES);
+        if (!cache->indices)
+        {
+            DNF_ERROR("Failed to allocate the palette indices of a texture atlas of %zu texels", cache->atlas_capacity);
+            cache->palette = nullptr;
+            return false;
+        }
+    }
+
+    cache->palette = palette;
+    for (uint32_t i = 0; i < cache->texture_count; i++)
+        quantize_texture(cache, &cache->textures[i]);
+    return true;
+}
+
+dnf_texture_handle texture_cache_add(
+    dnf_texture_cache *cache,
+    const char *name,
+    const Image image,
+    const dnf_texture_kind kind)
+{
+    const dnf_texture_handle existing = texture_cache_find(cache, name);
+    if (existing != DNF_TEXTURE_INVALID)
+        return existing;
+
+    if (!image.data || image.width <= 0 || image.height <= 0)
+    {
+        DNF_ERROR("Texture '%s' has no pixels", name);
+        return DNF_TEXTURE_INVALID;
+    }
+    if (cache->texture_count == cache->texture_capacity)
+    {
+        DNF_ERROR("Texture cache is full (%u textures), '%s' not added", cache->texture_capacity, name);
+        return DNF_TEXTURE_INVALID;
+    }
+
+    // the caller's image stays as it is
+    Image source = ImageCopy(image);
+    if (source.format != PIXELFORMAT_UNCOMPRESSED_R8G8B8A8)
+        ImageFormat(&source, PIXELFORMAT_UNCOMPRESSED_R8G8B8A8);
+    if (kind != DNF_TEXTURE_SPRITE)
+    {
+        // wrapping and mips need power-of-two sides
+        const int32_t width = next_power_of_two(source.width);
+        const int32_t height = next_power_of_two(source.height);
+        if (width != source.width || height != source.height)
+        {
+            DNF_WARN("Texture '%s' is %dx%d, resized to %dx%d", name, source.width, source.height, width, height);
+            ImageResize(&source, width, height);
+        }
+    }
+
+    dnf_texture texture = {
+        .kind = kind,
+        .width = source.width,
+        .height = source.height
+    };
+    strncpy(texture.name, name, DNF_TEXTURE_NAME_LENGTH - 1);
+
+    // lay out the levels, each on an aligned offset
+    size_t offset = cache->atlas_used;
+    for (int32_t width = texture.width, height = texture.height; texture.mip_count < DNF_TEXTURE_MAX_MIPS;
+        width = mip_side(width), height = mip_side(height))
+    {
+        texture.mip_offsets[texture.mip_count++] = offset;
+        offset += ((size_t)width * height + DNF_TEXTURE_ALIGNMENT - 1) / DNF_TEXTURE_ALIGNMENT * DNF_TEXTURE_ALIGNMENT;
+        if (width == 1 && height == 1)
+            break;
+    }
+    if (offset > cache->atlas_capacity)
+    {
+        DNF_ERROR("Texture atlas is full (%zu of %zu texels used), '%s' needs %zu more",
+            cache->atlas_used, cache->atlas_capacity, name, offset - cache->atlas_used);
+        UnloadImage(source);
+        return DNF_TEXTURE_INVALID;
+    }
+
+    // level 0 in storage order (walls and sprites are transposed)
+    const Color *pixels = source.data;
+    Color *level = cache->atlas + texture.mip_offsets[0];
+    for (int32_t y = 0; y < texture.height; y++)
+        for (int32_t x = 0; x < texture.width; x++)
+            level[texel_index(kind, texture.width, texture.height, x, y)] = pixels[(size_t)y * texture.width + x];
+    UnloadImage(source);
+
+    if (kind == DNF_TEXTURE_SPRITE)
+    {
+        // keep alpha a mask from the start, the mips rely on it
+        for (size_t i = 0; i < (size_t)texture.width * texture.height; i++)
+            level[i].a = level[i].a >= 128 ? 255 : 0;
+    }
+
+    // every level is filtered from the previous one
+    int32_t width = texture.width, height = texture.height;
+    for (uint32_t mip = 1; mip < texture.mip_count; mip++)
+    {
+        const Color *src = cache->atlas + texture.mip_offsets[mip - 1];
+        Color *dst = cache->atlas + texture.mip_offsets[mip];
+        const int32_t mip_width = mip_side(width), mip_height = mip_side(height);
+        for (int32_t y = 0; y < mip_height; y++)
+            for (int32_t x = 0; x < mip_width; x++)
+                dst[texel_index(kind, mip_width, mip_height, x, y)] = filter_block(kind, src, width, height, x, y);
+        width = mip_width;
+        height = mip_height;
+    }
+
+    if (cache->palette)
+        quantize_texture(cache, &texture);
+
+    cache->atlas_used = offset;
+    cache->textures[cache->texture_count++] = texture;
+    DNF_DEBUG("Texture '%s' added: %dx%d, %u mips", texture.name, texture.width, texture.height, texture.mip_count);
+    return cache->texture_count;
+}
+
+dnf_texture_handle texture_cache_load(
+    dnf_texture_cache *cache,
+    const char *name,
+    const char *path,
+    const dnf_texture_kind kind)
+{
+    // loaded textures aren't read again
+    const dnf_texture_handle existing = texture_cache_find(cache, name);
+    if (existing != DNF_TEXTURE_INVALID)
+        return existing;
+
+    const Image image = LoadImage(path);
+    if (!image.data)
+    {
+        DNF_ERROR("Failed to load texture '%s' from %s", name, path);
+        return DNF_TEXTURE_INVALID;
+    }
+
+    const dnf_texture_handle handle = texture_cache_add(cache, name, image, kind);
+    UnloadImage(image);
+    return handle;
+}
+
+dnf_texture_handle texture_cache_load_memory(
+    dnf_texture_cache *cache,
+    const char *name,
+    const char *file_type,
+    const void *data,
+    const size_t size,
+    const dnf_texture_kind kind)
+{
+    const dnf_texture_handle existing = texture_cache_find(cache, name);
+    if (existing != DNF_TEXTURE_INVALID)
+        return existing;
+
+    const Image image = LoadImageFromMemory(file_type, data, (int)size);
+    if (!image.data)
+    {
+        DNF_ERROR("Failed to decode texture '%s' (%zu bytes of %s)", name, size, file_type);
+        return DNF_TEXTURE_INVALID;
+    }
+
+    const dnf_texture_handle handle = texture_cache_add(cache, name, image, kind);
+    UnloadImage(image);
+    return handle;
+}
+
+dnf_texture_handle texture_cache_find(const dnf_texture_cache *cache, const char *name)
+{
+    for (uint32_t i = 0; i < cache->texture_count; i++)
+    {
+        if (strncmp(cache->textures[i].name, name, DNF_TEXTURE_NAME_LENGTH - 1) == 0)
+            return i + 1;
+    }
+    return DNF_TEXTURE_INVALID;
+}
+
+const dnf_texture *texture_cache_get(const dnf_texture_cache *cache, const dnf_texture_handle handle)
+{
+    if (handle == DNF_TEXTURE_INVALID || handle > cache->texture_count)
+        return nullptr;
+    return &cache->textures[handle - 1];
+}
+
+uint32_t texture_select_mip(const dnf_texture *texture, float32_t texels_per_pixel)
+{
+    uint32_t mip = 0;
+    while (texels_per_pixel >= 2.0f && mip + 1 < texture->mip_count)
+    {
+        texels_per_pixel *= 0.5f;
+        mip++;
+    }
+    return mip;
+}
+
+int32_t texture_mip_width(const dnf_texture *texture, const uint32_t mip)
+{
+    int32_t width = texture->width;
+    for (uint32_t i = 0; i < mip; i++)
+        width = mip_side(width);
+    return width;
+}
+
+int32_t texture_mip_height(const dnf_texture *texture, const uint32_t mip)
+{
+    int32_t height = texture->height;
+    for (uint32_t i = 0; i < mip; i++)
+        height = mip_side(height);
+    return height;
+}
+
+/**
+ * @brief Wraps a texel coordinate to [0; size).
+ */
+static int32_t wrap(const int32_t coordinate, const int32_t size)
+{
+    const int32_t wrapped = coordinate % size;
+    return wrapped < 0 ? wrapped + size : wrapped;
+}
+
+const Color *texture_column(const dnf_texture_cache *cache, const dnf_texture *texture, const uint32_t mip, const int32_t u)
+{
+    const int32_t width = texture_mip_width(texture, mip);
+    const int32_t height = texture_mip_height(texture, mip);
+    return cache->atlas + texture->mip_offsets[mip] + (size_t)wrap(u, width) * height;
+}
+
+const uint8_t *texture_column_indices(
+    const dnf_texture_cache *cache,
+    const dnf_texture *texture,
+    const uint32_t mip,
+    const int32_t u)
+{
+    const int32_t width = texture_mip_width(texture, mip);
+    const int32_t height = texture_mip_height(texture, mip);
+    return cache->indices + texture->mip_offsets[mip] + (size_t)wrap(u, width) * height;
+}
+
+const Color *texture_row(const dnf_texture_cache *cache, const dnf_texture *texture, const uint32_t mip, const int32_t v)
+{
+    const int32_t width = texture_mip_width(texture, mip);
+    const int32_t height = texture_mip_height(texture, mip);
+    return cache->atlas + texture->mip_offsets[mip] + (size_t)wrap(v, height) * width;
+}
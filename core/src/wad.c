@@ -0,0 +1,245 @@
+// DNF (Doomed and Forgotten): a DOOM-style first-person shooter.
+// Copyright (C) 2025-2026  Alexandr Gorbatenko
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+#include "wad.h"
+
+#include "logger.h"
+
+#include <string.h>  // memcmp, memchr, strcmp
+
+#if defined(_WIN32)
+    #define WIN32_LEAN_AND_MEAN
+    #include <windows.h>   // CreateFileMapping, MapViewOfFile (no raylib in this file)
+#else
+    #include <fcntl.h>     // open
+    #include <sys/mman.h>  // mmap, madvise
+    #include <sys/stat.h>  // fstat
+    #include <unistd.h>    // close, sysconf
+#endif
+
+
+/**
+ * @brief Maps a whole file read-only.
+ *
+ * @return False if the file can't be opened or is empty.
+ */
+static bool8_t map_file(dnf_wad *wad, const char *path)
+{
+#if defined(_WIN32)
+    HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+        return false;
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size) || size.QuadPart == 0)
+    {
+        CloseHandle(file);
+        return false;
+    }
+
+    // the mapping keeps the file open
+    HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    CloseHandle(file);
+    if (!mapping)
+        return false;
+
+    const void *data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (!data)
+    {
+        CloseHandle(mapping);
+        return false;
+    }
+
+    wad->data = data;
+    wad->size = (size_t)size.QuadPart;
+    wad->mapping = mapping;
+    return true;
+#else
+    const int fd = open(path, O_RDONLY);
+    if (fd < 0)
+        return false;
+
+    struct stat info;
+    if (fstat(fd, &info) != 0 || info.st_size == 0)
+    {
+        close(fd);
+        return false;
+    }
+
+    // the mapping keeps the file open
+    void *data = mmap(nullptr, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED)
+        return false;
+
+    // lumps are read in no particular order, don't read ahead of every fault
+    madvise(data, (size_t)info.st_size, MADV_RANDOM);
+
+    wad->data = data;
+    wad->size = (size_t)info.st_size;
+    return true;
+#endif
+}
+
+/**
+ * @brief Unmaps the file of an archive.
+ */
+static void unmap_file(const dnf_wad *wad)
+{
+#if defined(_WIN32)
+    UnmapViewOfFile(wad->data);
+    CloseHandle(wad->mapping);
+#else
+    munmap((void *)wad->data, wad->size);
+#endif
+}
+
+/**
+ * @brief Validates the header and the directory of a mapped archive.
+ */
+static bool8_t check_directory(const dnf_wad *wad, const char *path)
+{
+    if (wad->size < sizeof(dnf_wad_header))
+    {
+        DNF_ERROR("Archive %s is too small (%zu bytes)", path, wad->size);
+        return false;
+    }
+
+    dnf_wad_header header;
+    memcpy(&header, wad->data, sizeof(header));
+    if (memcmp(header.magic, DNF_WAD_MAGIC, sizeof(header.magic)) != 0)
+    {
+        DNF_ERROR("%s is not an archive", path);
+        return false;
+    }
+    if (header.version != DNF_WAD_VERSION)
+    {
+        DNF_ERROR("Archive %s has unsupported version %u", path, header.version);
+        return false;
+    }
+
+    // entries are used in place, so the directory must be aligned
+    const uint64_t directory_size = (uint64_t)header.lump_count * sizeof(dnf_wad_entry);
+    if (header.directory_offset % _Alignof(dnf_wad_entry) != 0
+        || header.directory_offset > wad->size
+        || directory_size > wad->size - header.directory_offset)
+    {
+        DNF_ERROR("Archive %s has a broken directory", path);
+        return false;
+    }
+
+    const dnf_wad_entry *directory = (const dnf_wad_entry *)(wad->data + header.directory_offset);
+    for (uint32_t i = 0; i < header.lump_count; i++)
+    {
+        const dnf_wad_entry *entry = &directory[i];
+        if (!memchr(entry->name, '\0', DNF_WAD_NAME_LENGTH)
+            || entry->offset > wad->size || entry->size > wad->size - entry->offset)
+        {
+            DNF_ERROR("Archive %s has a broken lump %u", path, i);
+            return false;
+        }
+        if (i > 0 && strcmp(directory[i - 1].name, entry->name) >= 0)
+        {
+            DNF_ERROR("Archive %s directory isn't sorted (at '%s')", path, entry->name);
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool8_t wad_open(dnf_wad *wad, const char *path)
+{
+    *wad = (dnf_wad){0};
+
+    if (!map_file(wad, path))
+    {
+        DNF_ERROR("Failed to map archive %s", path);
+        return false;
+    }
+
+    if (!check_directory(wad, path))
+    {
+        unmap_file(wad);
+        *wad = (dnf_wad){0};
+        return false;
+    }
+
+    const dnf_wad_header *header = (const dnf_wad_header *)wad->data;
+    wad->directory = (const dnf_wad_entry *)(wad->data + header->directory_offset);
+    wad->lump_count = header->lump_count;
+
+    DNF_INFO("Opened archive %s: %u lumps, %zu bytes", path, wad->lump_count, wad->size);
+    return true;
+}
+
+void wad_close(dnf_wad *wad)
+{
+    if (wad->data)
+        unmap_file(wad);
+    *wad = (dnf_wad){0};
+}
+
+uint32_t wad_find(const dnf_wad *wad, const char *name)
+{
+    uint32_t low = 0, high = wad->lump_count;
+    while (low < high)
+    {
+        const uint32_t middle = low + (high - low) / 2;
+        const int32_t order = strcmp(wad->directory[middle].name, name);
+        if (order == 0)
+            return middle;
+        if (order < 0)
+            low = middle + 1;
+        else
+            high = middle;
+    }
+    return DNF_WAD_NO_LUMP;
+}
+
+const void *wad_lump(const dnf_wad *wad, const uint32_t lump, size_t *out_size)
+{
+    if (lump >= wad->lump_count)
+        return nullptr;
+
+    if (out_size)
+        *out_size = (size_t)wad->directory[lump].size;
+    return wad->data + wad->directory[lump].offset;
+}
+
+const char *wad_lump_name(const dnf_wad *wad, const uint32_t lump)
+{
+    return lump < wad->lump_count ? wad->directory[lump].name : nullptr;
+}
+
+void wad_prefetch(const dnf_wad *wad, const uint32_t lump)
+{
+    if (lump >= wad->lump_count || wad->directory[lump].size == 0)
+        return;
+
+#if defined(_WIN32)
+    WIN32_MEMORY_RANGE_ENTRY range = {
+        .VirtualAddress = (void *)(wad->data + wad->directory[lump].offset),
+        .NumberOfBytes = (SIZE_T)wad->directory[lump].size
+    };
+    PrefetchVirtualMemory(GetCurrentProcess(), 1, &range, 0);
+#else
+    // madvise wants a page-aligned start
+    const uintptr_t page = (uintptr_t)sysconf(_SC_PAGESIZE);
+    const uintptr_t start = (uintptr_t)(wad->data + wad->directory[lump].offset);
+    const uintptr_t aligned = start & ~(page - 1);
+    madvise((void *)aligned, (size_t)(start - aligned + wad->directory[lump].size), MADV_WILLNEED);
+#endif
+}
@@ -0,0 +1,121 @@
+# DNF (Doomed and Forgotten): a DOOM-style first-person shooter.
+# Copyright (C) 2025-2026  Alexandr Gorbatenko
+#
+# This program is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+# Turns the built-in text maps (the dnf_pvs formats) into the C arrays of
+# game.c, so the game and its precomputed PVS come from the same files:
+#
+#   cmake -DMAP=test_map.txt -DLEVEL=test_level.txt -DCLUSTER_SIZE=2
+#         -DOUTPUT=test_maps.h -P embed_maps.cmake
+#
+# Level elements may carry what dnf_pvs skips:
+#
+#   sector FLOOR_HEIGHT CEILING_HEIGHT LIGHT FLOOR_COLOR CEILING_COLOR
+#   line V1 V2 FRONT_SECTOR [BACK_SECTOR] COLOR
+#
+# where the colors are raylib color names.
+
+foreach(variable MAP LEVEL CLUSTER_SIZE OUTPUT)
+    if(NOT DEFINED ${variable})
+        message(FATAL_ERROR "embed_maps.cmake: ${variable} is not set")
+    endif()
+endforeach()
+
+# grid map: one line per row, '.', ' ' or '0' for an empty cell, a hex digit
+# for a wall type, short lines padded with walls
+file(STRINGS ${MAP} rows)
+set(width 0)
+list(TRANSFORM rows REPLACE "\r$" "")
+foreach(row IN LISTS rows)
+    string(LENGTH "${row}" length)
+    if(length GREATER width)
+        set(width ${length})
+    endif()
+endforeach()
+list(LENGTH rows height)
+if(width EQUAL 0 OR height EQUAL 0)
+    message(FATAL_ERROR "${MAP} is empty")
+endif()
+
+set(cells "")
+foreach(row IN LISTS rows)
+    string(LENGTH "${row}" length)
+    set(line "   ")
+    foreach(x RANGE 1 ${width})
+        if(x GREATER length)
+            set(cell 1)
+        else()
+            math(EXPR index "${x} - 1")
+            string(SUBSTRING "${row}" ${index} 1 c)
+            if(c STREQUAL "." OR c STREQUAL " " OR c STREQUAL "0")
+                set(cell 0)
+            elseif(c MATCHES "^[1-9a-fA-F]$")
+                math(EXPR cell "0x${c}")
+            else()
+                message(FATAL_ERROR "${MAP}: unknown cell '${c}'")
+            endif()
+        endif()
+        string(APPEND line " ${cell},")
+    endforeach()
+    string(APPEND cells "${line}\n")
+endforeach()
+
+# BSP level: one element per line, '#' comments
+file(STRINGS ${LEVEL} elements)
+set(vertices "")
+set(sectors "")
+set(linedefs "")
+set(number "[-+0-9.eE]+")
+foreach(element IN LISTS elements)
+    string(STRIP "${element}" element)
+    if(element STREQUAL "" OR element MATCHES "^#")
+        continue()
+    elseif(element MATCHES "^vertex[ \t]+(${number})[ \t]+(${number})$")
+        string(APPEND vertices "    { ${CMAKE_MATCH_1}, ${CMAKE_MATCH_2} },\n")
+    elseif(element MATCHES "^sector[ \t]+(${number})[ \t]+(${number})[ \t]+([0-9]+)[ \t]+([A-Z]+)[ \t]+([A-Z]+)$")
+        string(APPEND sectors
+            "    { .floor_height = ${CMAKE_MATCH_1}, .ceiling_height = ${CMAKE_MATCH_2}, .light = ${CMAKE_MATCH_3}, "
+            ".floor_color = ${CMAKE_MATCH_4}, .ceiling_color = ${CMAKE_MATCH_5} },\n")
+    elseif(element MATCHES "^line[ \t]+([0-9]+)[ \t]+([0-9]+)[ \t]+([0-9]+)[ \t]+([0-9]+)[ \t]+([A-Z]+)$")
+        string(APPEND linedefs "    { ${CMAKE_MATCH_1}, ${CMAKE_MATCH_2}, ${CMAKE_MATCH_3}, ${CMAKE_MATCH_4}, ${CMAKE_MATCH_5} },\n")
+    elseif(element MATCHES "^line[ \t]+([0-9]+)[ \t]+([0-9]+)[ \t]+([0-9]+)[ \t]+([A-Z]+)$")
+        string(APPEND linedefs "    { ${CMAKE_MATCH_1}, ${CMAKE_MATCH_2}, ${CMAKE_MATCH_3}, DNF_BSP_NO_SECTOR, ${CMAKE_MATCH_4} },\n")
+    else()
+        message(FATAL_ERROR "${LEVEL}: can't embed '${element}'")
+    endif()
+endforeach()
+
+file(WRITE ${OUTPUT}
+"// Generated by game/cmake/embed_maps.cmake from ${MAP} and ${LEVEL}, edit those instead.
+
+#pragma once
+
+#define TEST_MAP_WIDTH ${width}
+#define TEST_MAP_HEIGHT ${height}
+// grid map PVS cluster side in cells
+#define TEST_PVS_CLUSTER_SIZE ${CLUSTER_SIZE}
+
+static const uint8_t test_map_cells[TEST_MAP_WIDTH * TEST_MAP_HEIGHT] = {
+${cells}};
+
+static const dnf_vertex test_level_vertices[] = {
+${vertices}};
+
+static const dnf_linedef test_level_linedefs[] = {
+${linedefs}};
+
+static const dnf_sector test_level_sectors[] = {
+${sectors}};
+")
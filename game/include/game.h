@@ -18,15 +18,41 @@
 #pragma once
 
 #include "defines.h"
+#include "blockmap.h"
 #include "dnf_gametypes.h"
+#include "entity.h"
+#include "pvs.h"
+#include "sprites.h"
+
+/**
+ * @brief A projectile fired by the player (a block of game::projectile_pool).
+ */
+typedef struct dnf_projectile
+{
+    float32_t x;       //!< World X position
+    float32_t y;       //!< World Y position
+    float32_t prev_x;  //!< X position at the previous tick (for interpolation)
+    float32_t prev_y;  //!< Y position at the previous tick
+    float32_t vel_x;   //!< X velocity in units per second
+    float32_t vel_y;   //!< Y velocity in units per second
+    struct dnf_projectile *next;  //!< Next live projectile
+} dnf_projectile;
 
 typedef struct dnf_game_state
 {
-    int8_t number;
+    dnf_entity_store monsters;  //!< Monsters of the grid test view
+    dnf_blockmap monster_blockmap;  //!< Spatial index of the monsters
+    int32_t player_health;      //!< Health of the player (grid test view)
+    dnf_sprite_batch sprites;   //!< Sprites of the frame being rendered
+    dnf_pvs map_pvs;            //!< PVS of the grid test map
+    uint8_t *visible_clusters;  //!< Grid map clusters potentially visible from the player
+    dnf_projectile *projectiles;  //!< Live projectiles of the grid test view
 } dnf_game_state;
 
 DNF_API bool8_t dnf_game_init(game *game_instance);
 
 DNF_API bool8_t dnf_game_update(game *game_instance, float32_t dt);
 
-DNF_API bool8_t dnf_game_render(game *game_instance, float32_t dt);
+DNF_API bool8_t dnf_game_render(game *game_instance, float32_t alpha);
+
+DNF_API void dnf_game_shutdown(game *game_instance);
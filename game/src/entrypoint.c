@@ -18,7 +18,10 @@
 #include "entrypoint.h"
 #include "game.h"
 
+#include "dnf_memory.h"
+
 #include <stdlib.h>
+#include <string.h>
 
 
 bool8_t game_create(game *out_game_instance)
@@ -27,30 +30,151 @@ bool8_t game_create(game *out_game_instance)
     out_game_instance->engine_config->start_width = 960;
     out_game_instance->engine_config->start_height = 540;
     out_game_instance->engine_config->title = "DNF 0.1.0 | TEST";
+    out_game_instance->engine_config->worker_threads = 0;  // one per core
+    out_game_instance->engine_config->framebuffers = 2;    // render while presenting
+    out_game_instance->engine_config->target_fps = 0;      // render as fast as possible
+    out_game_instance->engine_config->tick_rate = DNF_ENGINE_DEFAULT_TICK_RATE;
+    out_game_instance->engine_config->max_ticks = DNF_ENGINE_DEFAULT_MAX_TICKS;
+    out_game_instance->engine_config->asset_budget_ms = DNF_ENGINE_DEFAULT_ASSET_BUDGET_MS;
+    out_game_instance->engine_config->frame_arena_size = DNF_ENGINE_DEFAULT_FRAME_ARENA_SIZE;
+    out_game_instance->engine_config->projectile_size = sizeof(dnf_projectile);
+    out_game_instance->engine_config->max_projectiles = DNF_ENGINE_DEFAULT_MAX_PROJECTILES;
+    out_game_instance->engine_config->backend = DNF_RENDERER_BACKEND_WINDOW;
+    out_game_instance->engine_config->pixel_isa = DNF_PIXEL_ISA_AUTO;
+    out_game_instance->engine_config->column_major = false;  // render straight into the framebuffers
+    out_game_instance->engine_config->render_format = DNF_PIXEL_FORMAT_RGBA8;
+    out_game_instance->engine_config->render_scale = 1.0f;  // render at the window size
+    out_game_instance->engine_config->dynamic_resolution_ms = 0.0f;  // keep the render scale
+    out_game_instance->engine_config->frame_limit = 0;     // run until closed
+    out_game_instance->engine_config->fixed_dt = 0.0f;     // measure frame time (ticks stay fixed)
+    out_game_instance->engine_config->dump_interval = 0;   // don't save frames
+    out_game_instance->engine_config->dump_dir = "./frames";
+    out_game_instance->engine_config->async_logging = true;  // keep logging off the main thread
+    out_game_instance->engine_config->log_format = DNF_LOG_FORMAT_TEXT;
+    out_game_instance->engine_config->log_levels = nullptr;  // default levels
 
     // configure the game instance
     out_game_instance->init = dnf_game_init;
     out_game_instance->update = dnf_game_update;
     out_game_instance->render = dnf_game_render;
+    out_game_instance->shutdown = dnf_game_shutdown;
 
     // configure the game state
-    out_game_instance->game_state = malloc(sizeof(dnf_game_state));
+    out_game_instance->game_state = dnf_alloc(sizeof(dnf_game_state), DNF_MEMORY_TAG_GAME);
+
+    return out_game_instance->game_state != nullptr;
+}
+
+/**
+ * @brief Applies command line options to the engine config.
+ *
+ * Supported options:
+ * --headless (no window), --column-major (column-major render target),
+ * --indexed (8-bit palette render target),
+ * --render-scale S (render at S times the window size),
+ * --dynamic-resolution MS (adapt the render scale to hold MS of render time),
+ * --frames N (exit after N frames),
+ * --dt SECONDS (fixed frame time), --fps N (frame rate cap, 0 - uncapped),
+ * --tick-rate N (simulation ticks per second),
+ * --dump-every N (save every N-th frame), --dump-dir PATH (where to save frames),
+ * --binary-log (write logs/dnf_game.dnflog, decode it with dnf_logdump),
+ * --log-levels SPEC (runtime log levels, e.g. "info,renderer=trace").
+ *
+ * @param argc Argument count.
+ * @param argv Arguments.
+ * @param config Engine config to modify.
+ * @return True if all options were recognized.
+ */
+static bool8_t parse_arguments(const int argc, char **argv, dnf_engine_config *config)
+{
+    for (int i = 1; i < argc; i++)
+    {
+        const char *arg = argv[i];
+        const char *value = i + 1 < argc ? argv[i + 1] : nullptr;
+
+        if (strcmp(arg, "--headless") == 0)
+            config->backend = DNF_RENDERER_BACKEND_HEADLESS;
+        else if (strcmp(arg, "--column-major") == 0)
+            config->column_major = true;
+        else if (strcmp(arg, "--indexed") == 0)
+            config->render_format = DNF_PIXEL_FORMAT_INDEXED8;
+        else if (strcmp(arg, "--binary-log") == 0)
+            config->log_format = DNF_LOG_FORMAT_BINARY;
+        else if (strcmp(arg, "--frames") == 0 && value)
+        {
+            config->frame_limit = (uint32_t)strtoul(value, nullptr, 10);
+            i++;
+        }
+        else if (strcmp(arg, "--render-scale") == 0 && value)
+        {
+            config->render_scale = strtof(value, nullptr);
+            i++;
+        }
+        else if (strcmp(arg, "--dynamic-resolution") == 0 && value)
+        {
+            config->dynamic_resolution_ms = strtof(value, nullptr);
+            i++;
+        }
+        else if (strcmp(arg, "--dt") == 0 && value)
+        {
+            config->fixed_dt = strtof(value, nullptr);
+            i++;
+        }
+        else if (strcmp(arg, "--fps") == 0 && value)
+        {
+            config->target_fps = (uint32_t)strtoul(value, nullptr, 10);
+            i++;
+        }
+        else if (strcmp(arg, "--tick-rate") == 0 && value)
+        {
+            config->tick_rate = (uint32_t)strtoul(value, nullptr, 10);
+            i++;
+        }
+        else if (strcmp(arg, "--dump-every") == 0 && value)
+        {
+            config->dump_interval = (uint32_t)strtoul(value, nullptr, 10);
+            i++;
+        }
+        else if (strcmp(arg, "--dump-dir") == 0 && value)
+        {
+            config->dump_dir = value;
+            i++;
+        }
+        else if (strcmp(arg, "--log-levels") == 0 && value)
+        {
+            config->log_levels = value;
+            i++;
+        }
+        else
+        {
+            DNF_ERROR("Unknown or incomplete command line option: %s", arg);
+            return false;
+        }
+    }
+
+    // a headless run has no window to close
+    if (config->backend == DNF_RENDERER_BACKEND_HEADLESS && config->frame_limit == 0)
+    {
+        DNF_WARN("Headless run without --frames, limiting to 600 frames");
+        config->frame_limit = 600;
+    }
 
-    // TODO: do sturdier logic
     return true;
 }
 
 /**
  * @brief The game's main entry point (for the simplest .exe)
  *
+ * @param argc Argument count.
+ * @param argv Arguments (see parse_arguments()).
  * @return Exit code.
  */
-int main(void)
+int main(int argc, char **argv)
 {
     dnf_engine_config engine_config;
     dnf_input_system_handler input_handler;
     renderer_context render_ctx;
-    game game_instance;
+    game game_instance = {0};
 
     game_instance.engine_config = &engine_config;
     game_instance.input_handler = &input_handler;
@@ -64,15 +188,25 @@ int main(void)
         return -1;
     }
 
+    if (!parse_arguments(argc, argv, &engine_config))
+    {
+        dnf_free(game_instance.game_state);
+        return -1;
+    }
+
     // Initialize engine
     if (!engine_init(&game_instance))
     {
         DNF_FATAL("Could not initialize engine!");
+        dnf_free(game_instance.game_state);
         return 1;
     }
 
     // Run and shutdown
-    if (!engine_run())
+    const bool8_t ran = engine_run();
+    dnf_free(game_instance.game_state);
+    game_instance.game_state = nullptr;
+    if (!ran)
     {
         DNF_ERROR("Encountered an error while shutting down the engine.");
         return 2;
@@ -17,69 +17,608 @@
 
 #include "game.h"
 
+#include "asset_loader.h"
+#include "blockmap.h"
+#include "bsp.h"
+#include "entity.h"
 #include "logger.h"
+#include "pvs.h"
+#include "raycaster.h"
 #include "renderer.h"
+#include "sprites.h"
+#include "texture_cache.h"
+#include "wad.h"
 
-#include <string.h>
+#include <math.h>
+#include <stdio.h>
+
+// the built-in grid map and BSP level (test_map_cells and test_level_*),
+// generated from game/maps by embed_maps.cmake
+#include "test_maps.h"
+
+// room for the test textures and their mips
+#define TEST_TEXTURE_ATLAS_TEXELS (256 * 1024)
+#define TEST_TEXTURE_MAX_COUNT 32
+#define TEST_TEXTURE_SIZE 64
+
+// monsters roaming the grid test view
+#define TEST_MONSTER_COUNT 24
+#define TEST_PLAYER_HEALTH 100
+// monster billboard size in world units and texels
+#define TEST_MONSTER_WIDTH 0.6f
+#define TEST_MONSTER_HEIGHT 0.75f
+#define TEST_MONSTER_SPRITE_WIDTH 48
+#define TEST_MONSTER_SPRITE_HEIGHT 60
+// player projectiles (DNF_GAME_ACTION_ATTACK1 in the grid test view)
+#define TEST_PROJECTILE_SPEED 8.0f
+#define TEST_PROJECTILE_DAMAGE 10
+#define TEST_PROJECTILE_SIZE 0.15f
+
+// blockmap block side in world units
+#define TEST_BLOCK_SIZE 2.0f
+// precomputed PVS lumps of the built-in maps, next to the executable (dnf_pvs
+// and dnf_pack, see game/CMakeLists.txt)
+#define TEST_MAPS_WAD "maps.wad"
+#define TEST_MAP_PVS_LUMP "test_map.pvs"
+#define TEST_LEVEL_PVS_LUMP "test_level.pvs"
 
 static const dnf_input_system_handler *input;
 
-static float32_t x = 90, y = 90;
-static float32_t speed = 200;
+static dnf_grid_map test_map = {
+    .width = TEST_MAP_WIDTH,
+    .height = TEST_MAP_HEIGHT,
+    .cells = test_map_cells,
+    .wall_colors = {
+        [1] = GRAY,
+        [2] = MAROON,
+        [3] = DARKBROWN,
+        [4] = BLUE,
+    },
+    .ceiling_color = DARKGRAY,
+    .floor_color = BROWN,
+};
+
+static dnf_bsp_level test_level;
+static dnf_blockmap test_level_blockmap;
+static dnf_pvs test_level_pvs;
+
+static dnf_wad maps_wad;
+
+static dnf_texture_cache textures;
+
+/**
+ * @brief A procedural wall or flat texture, generated on the asset loader
+ * thread.
+ */
+typedef struct test_texture
+{
+    const char *name;            //!< Texture name
+    const Color *color;          //!< Grid map color it replaces
+    dnf_texture_handle *handle;  //!< Grid map texture it is used for
+    dnf_texture_kind kind;       //!< Wall or flat
+    int32_t checks;              //!< Checkers per side
+    Image image;                 //!< Generated image (until added to the cache)
+} test_texture;
+
+static test_texture test_textures[] = {
+    { .name = "gray_blocks", .color = &test_map.wall_colors[1], .handle = &test_map.wall_textures[1], .kind = DNF_TEXTURE_WALL, .checks = 4 },
+    { .name = "maroon_tiles", .color = &test_map.wall_colors[2], .handle = &test_map.wall_textures[2], .kind = DNF_TEXTURE_WALL, .checks = 8 },
+    { .name = "brown_planks", .color = &test_map.wall_colors[3], .handle = &test_map.wall_textures[3], .kind = DNF_TEXTURE_WALL, .checks = 2 },
+    { .name = "blue_grid", .color = &test_map.wall_colors[4], .handle = &test_map.wall_textures[4], .kind = DNF_TEXTURE_WALL, .checks = 16 },
+    { .name = "floor_tiles", .color = &test_map.floor_color, .handle = &test_map.floor_texture, .kind = DNF_TEXTURE_FLAT, .checks = 8 },
+    { .name = "ceiling_panels", .color = &test_map.ceiling_color, .handle = &test_map.ceiling_texture, .kind = DNF_TEXTURE_FLAT, .checks = 2 },
+};
 
-static const renderer_context *render_ctx;
+// monster sprite (entity sprite 0), drawn as a flat color until it is generated
+static Image monster_image;
+static dnf_texture_handle monster_texture = DNF_TEXTURE_INVALID;
+
+// test views (switched with DNF_GAME_ACTION_DEBUG_NEXT_VIEW)
+typedef enum dnf_test_view
+{
+    DNF_TEST_VIEW_BSP,
+    DNF_TEST_VIEW_GRID,
+
+    DNF_TEST_VIEW_COUNT
+} dnf_test_view;
+
+static dnf_test_view current_view = DNF_TEST_VIEW_BSP;
+static dnf_camera cameras[DNF_TEST_VIEW_COUNT] = {
+    [DNF_TEST_VIEW_BSP] = { .x = 2.0f, .y = 2.0f, .z = 0.5f, .angle = 0.5f },
+    [DNF_TEST_VIEW_GRID] = { .x = 2.5f, .y = 2.5f, .z = 0.5f, .angle = 0.0f },
+};
+// camera state at the previous tick, for interpolated rendering
+static dnf_camera previous_cameras[DNF_TEST_VIEW_COUNT];
+static const float32_t eye_height = 0.5f;
+static const float32_t player_radius = 0.25f;
+static const float32_t player_height = 0.6f;
+static const float32_t player_max_step = 0.3f;
+static float32_t speed = 3.0f;       // world units per second
+static float32_t turn_speed = 2.0f;  // radians per second
+
+static renderer_context *render_ctx;
 static dnf_renderer_api renderer;
+static dnf_pool *projectile_pool;
+
+static const dnf_entity_ai_params monster_ai = {
+    .sight_range = 6.0f,
+    .attack_range = 1.0f,
+    .attack_cooldown = 1.0f,
+};
+
+/**
+ * @brief Spawns the test monsters on empty cells of the test grid map.
+ *
+ * @param monsters Store to spawn into.
+ */
+static void spawn_test_monsters(dnf_entity_store *monsters)
+{
+    uint32_t seed = 12345;
+    uint32_t spawned = 0;
+    while (spawned < TEST_MONSTER_COUNT)
+    {
+        // xorshift, the layout is the same every run
+        seed ^= seed << 13;
+        seed ^= seed >> 17;
+        seed ^= seed << 5;
+        const int32_t x = (int32_t)(seed % TEST_MAP_WIDTH);
+        const int32_t y = (int32_t)((seed >> 8) % TEST_MAP_HEIGHT);
+        if (grid_map_get_cell(&test_map, x, y) != 0)
+            continue;
+
+        const dnf_entity_desc desc = {
+            .x = (float32_t)x + 0.5f,
+            .y = (float32_t)y + 0.5f,
+            .radius = 0.25f,
+            .speed = 1.0f + (float32_t)(seed % 100) * 0.01f,
+            .health = 20,
+            .sprite = 0,
+            .ai_state = DNF_ENTITY_AI_IDLE,
+        };
+        entity_spawn(monsters, &desc);
+        spawned++;
+    }
+}
+
+/**
+ * @brief Fires a projectile from the camera (nothing if the pool is full).
+ *
+ * @param state Game state.
+ * @param camera Camera of the player.
+ */
+static void fire_projectile(dnf_game_state *state, const dnf_camera *camera)
+{
+    dnf_projectile *projectile = projectile_pool ? pool_alloc(projectile_pool) : nullptr;
+    if (!projectile)
+        return;
+
+    *projectile = (dnf_projectile){
+        .x = camera->x,
+        .y = camera->y,
+        .prev_x = camera->x,
+        .prev_y = camera->y,
+        .vel_x = cosf(camera->angle) * TEST_PROJECTILE_SPEED,
+        .vel_y = sinf(camera->angle) * TEST_PROJECTILE_SPEED,
+        .next = state->projectiles,
+    };
+    state->projectiles = projectile;
+}
+
+/**
+ * @brief Moves the projectiles. The ones that hit a monster (and damage
+ * it) or a wall go back to the pool.
+ *
+ * @param state Game state (monsters linked into their blockmap).
+ * @param dt Tick duration in seconds.
+ */
+static void update_projectiles(dnf_game_state *state, const float32_t dt)
+{
+    dnf_projectile **link = &state->projectiles;
+    while (*link)
+    {
+        dnf_projectile *projectile = *link;
+        const float32_t x = projectile->x + projectile->vel_x * dt;
+        const float32_t y = projectile->y + projectile->vel_y * dt;
+        const dnf_blockmap_hit hit = blockmap_trace(
+            &state->monster_blockmap, projectile->x, projectile->y, x, y, DNF_ENTITY_NONE, true);
+        projectile->prev_x = projectile->x;
+        projectile->prev_y = projectile->y;
+        projectile->x = x;
+        projectile->y = y;
+
+        if (hit.entity != DNF_ENTITY_NONE)
+        {
+            const uint32_t monster = entity_index(&state->monsters, hit.entity);
+            if (monster != DNF_ENTITY_NO_INDEX)
+                state->monsters.health[monster] -= TEST_PROJECTILE_DAMAGE;
+        }
+        if (hit.entity != DNF_ENTITY_NONE || grid_map_get_cell(&test_map, (int32_t)floorf(x), (int32_t)floorf(y)) != 0)
+        {
+            *link = projectile->next;
+            pool_free(projectile_pool, projectile);
+            continue;
+        }
+        link = &projectile->next;
+    }
+}
+
+/**
+ * @brief Generates a test texture: checkers of the grid map color and a
+ * darker shade (asset loader thread).
+ *
+ * @param user_data Pointer to test_texture.
+ */
+static bool8_t generate_test_texture(void *user_data)
+{
+    test_texture *texture = user_data;
+    const Color color = *texture->color;
+    const Color shade = { color.r / 2, color.g / 2, color.b / 2, 255 };
+    const int32_t check_size = TEST_TEXTURE_SIZE / texture->checks;
+    texture->image = GenImageChecked(TEST_TEXTURE_SIZE, TEST_TEXTURE_SIZE, check_size, check_size, color, shade);
+    return texture->image.data != nullptr;
+}
+
+/**
+ * @brief Adds a generated test texture to the cache and the grid map (main
+ * thread). The walls, the floor and the ceiling are drawn with flat colors
+ * until then.
+ *
+ * @param user_data Pointer to test_texture.
+ * @param loaded True if the image was generated.
+ */
+static void add_test_texture(void *user_data, const bool8_t loaded)
+{
+    test_texture *texture = user_data;
+    if (!loaded)
+        return;
+
+    *texture->handle = texture_cache_add(&textures, texture->name, texture->image, texture->kind);
+    UnloadImage(texture->image);
+    texture->image = (Image){0};
+}
+
+/**
+ * @brief Generates the monster sprite: a red blob with two eyes on a
+ * transparent background (asset loader thread).
+ *
+ * @param user_data Unused.
+ */
+static bool8_t generate_monster_sprite(void *user_data)
+{
+    (void)user_data;
+    monster_image = GenImageColor(TEST_MONSTER_SPRITE_WIDTH, TEST_MONSTER_SPRITE_HEIGHT, BLANK);
+    if (!monster_image.data)
+        return false;
 
-void clear_framebuffer(const dnf_framebuffer *fb, Color color)
+    Color *texels = monster_image.data;
+    for (int32_t y = 0; y < TEST_MONSTER_SPRITE_HEIGHT; y++)
+    {
+        for (int32_t x = 0; x < TEST_MONSTER_SPRITE_WIDTH; x++)
+        {
+            // ellipse filling the image, eyes in the upper third
+            const float32_t dx = ((float32_t)x + 0.5f) / TEST_MONSTER_SPRITE_WIDTH * 2.0f - 1.0f;
+            const float32_t dy = ((float32_t)y + 0.5f) / TEST_MONSTER_SPRITE_HEIGHT * 2.0f - 1.0f;
+            if (dx * dx + dy * dy > 1.0f)
+                continue;
+
+            const float32_t eye_x = fabsf(dx) - 0.35f;
+            const float32_t eye_y = dy + 0.35f;
+            const bool8_t eye = eye_x * eye_x + eye_y * eye_y < 0.02f;
+            const uint8_t shade = (uint8_t)(160.0f + 40.0f * (1.0f - dy));
+            texels[y * TEST_MONSTER_SPRITE_WIDTH + x] = eye ? (Color){ 255, 240, 64, 255 } : (Color){ shade, 24, 24, 255 };
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Adds the generated monster sprite to the cache (main thread).
+ *
+ * @param user_data Unused.
+ * @param loaded True if the image was generated.
+ */
+static void add_monster_sprite(void *user_data, const bool8_t loaded)
+{
+    (void)user_data;
+    if (!loaded)
+        return;
+
+    monster_texture = texture_cache_add(&textures, "monster", monster_image, DNF_TEXTURE_SPRITE);
+    UnloadImage(monster_image);
+    monster_image = (Image){0};
+}
+
+/**
+ * @brief Uses a precomputed PVS lump of the maps WAD in place.
+ *
+ * @param name Lump name.
+ * @param out_pvs Resulting PVS.
+ * @return False if the lump is missing or malformed.
+ */
+static bool8_t load_test_pvs(const char *name, dnf_pvs *out_pvs)
 {
-    memset(fb->pixels, 0x000f, fb->width * fb->height * sizeof(Color));
+    *out_pvs = (dnf_pvs){0};
+    size_t size;
+    const void *lump = wad_lump(&maps_wad, wad_find(&maps_wad, name), &size);
+    return lump && pvs_load(out_pvs, lump, size);
 }
 
 bool8_t dnf_game_init(game *game_instance)
 {
     input = game_instance->input_handler;
+    dnf_game_state *state = game_instance->game_state;
 
     render_ctx = game_instance->renderer_context;
     renderer = game_instance->renderer_api;
+    projectile_pool = game_instance->projectile_pool;
+
+    const dnf_level_map test_level_map = {
+        .vertices = test_level_vertices,
+        .vertex_count = sizeof(test_level_vertices) / sizeof(test_level_vertices[0]),
+        .linedefs = test_level_linedefs,
+        .linedef_count = sizeof(test_level_linedefs) / sizeof(test_level_linedefs[0]),
+        .sectors = test_level_sectors,
+        .sector_count = sizeof(test_level_sectors) / sizeof(test_level_sectors[0]),
+    };
+    if (!bsp_level_build(&test_level_map, &test_level))
+        return false;
+    if (!blockmap_init_level(&test_level_blockmap, &test_level, TEST_BLOCK_SIZE, 0))
+        return false;
+
+    // visibility is precomputed at build time, it's only built here if the
+    // lumps are missing or older than the maps
+    char maps_path[512];
+    snprintf(maps_path, sizeof(maps_path), "%s%s", GetApplicationDirectory(), TEST_MAPS_WAD);
+    if (FileExists(maps_path))
+        wad_open(&maps_wad, maps_path);
+    if (!load_test_pvs(TEST_LEVEL_PVS_LUMP, &test_level_pvs) || !pvs_matches_level(&test_level_pvs, &test_level))
+    {
+        DNF_WARN("No up-to-date %s in %s, building the level PVS", TEST_LEVEL_PVS_LUMP, maps_path);
+        pvs_free(&test_level_pvs);
+        if (!pvs_build_level(&test_level_pvs, &test_level))
+            return false;
+    }
+    test_level.pvs = &test_level_pvs;
+    if (!load_test_pvs(TEST_MAP_PVS_LUMP, &state->map_pvs)
+        || !pvs_matches_grid(&state->map_pvs, &test_map, TEST_PVS_CLUSTER_SIZE))
+    {
+        DNF_WARN("No up-to-date %s in %s, building the map PVS", TEST_MAP_PVS_LUMP, maps_path);
+        pvs_free(&state->map_pvs);
+        if (!pvs_build_grid(&state->map_pvs, &test_map, TEST_PVS_CLUSTER_SIZE))
+            return false;
+    }
+    state->visible_clusters = dnf_alloc(state->map_pvs.row_bytes, DNF_MEMORY_TAG_GAME);
+    if (!state->visible_clusters)
+        return false;
+
+    // wall textures stream in while the game runs
+    if (!texture_cache_init(&textures, TEST_TEXTURE_ATLAS_TEXELS, TEST_TEXTURE_MAX_COUNT))
+        return false;
+    if (render_ctx->palette && !texture_cache_set_palette(&textures, render_ctx->palette))
+        return false;
+    test_map.textures = &textures;
+    for (uint32_t i = 0; i < sizeof(test_textures) / sizeof(test_textures[0]); i++)
+        asset_loader_request(DNF_ASSET_PRIORITY_NEARBY, generate_test_texture, add_test_texture, &test_textures[i]);
+    asset_loader_request(DNF_ASSET_PRIORITY_NEARBY, generate_monster_sprite, add_monster_sprite, nullptr);
+
+    if (!entity_store_init(&state->monsters, TEST_MONSTER_COUNT))
+        return false;
+    if (!blockmap_init(
+        &state->monster_blockmap,
+        0.0f, 0.0f, (float32_t)TEST_MAP_WIDTH, (float32_t)TEST_MAP_HEIGHT,
+        TEST_BLOCK_SIZE, TEST_MONSTER_COUNT))
+        return false;
+    spawn_test_monsters(&state->monsters);
+    state->player_health = TEST_PLAYER_HEALTH;
+    if (!sprite_batch_init(&state->sprites, TEST_MONSTER_COUNT + (projectile_pool ? projectile_pool->capacity : 0)))
+        return false;
+
+    for (uint32_t i = 0; i < DNF_TEST_VIEW_COUNT; i++)
+        previous_cameras[i] = cameras[i];
 
     return true;
 }
 
 bool8_t dnf_game_update(game *game_instance, float32_t dt)
 {
+    dnf_game_state *state = game_instance->game_state;
+
+    if (input->is_pressed(DNF_GAME_ACTION_DEBUG_NEXT_VIEW))
+        current_view = (current_view + 1) % DNF_TEST_VIEW_COUNT;
+
+    dnf_camera *camera = &cameras[current_view];
+    previous_cameras[current_view] = *camera;
+
+    if (input->is_held(DNF_GAME_ACTION_TURN_LEFT))
+        camera->angle -= turn_speed * dt;
+    if (input->is_held(DNF_GAME_ACTION_TURN_RIGHT))
+        camera->angle += turn_speed * dt;
+
+    const float32_t forward_x = cosf(camera->angle);
+    const float32_t forward_y = sinf(camera->angle);
+
+    // right vector is forward rotated clockwise: (-forward_y, forward_x)
+    float32_t move_forward = 0.0f, move_right = 0.0f;
     if (input->is_held(DNF_GAME_ACTION_MOVE_FORWARD))
-        y = y - speed * dt;
+        move_forward += speed * dt;
     if (input->is_held(DNF_GAME_ACTION_MOVE_BACKWARD))
-        y = y + speed * dt;
+        move_forward -= speed * dt;
     if (input->is_held(DNF_GAME_ACTION_MOVE_LEFT))
-        x = x - speed * dt;
+        move_right -= speed * dt;
     if (input->is_held(DNF_GAME_ACTION_MOVE_RIGHT))
-        x = x + speed * dt;
+        move_right += speed * dt;
+
+    camera->x += forward_x * move_forward - forward_y * move_right;
+    camera->y += forward_y * move_forward + forward_x * move_right;
+
+    // stand on the floor of the current sector
+    if (current_view == DNF_TEST_VIEW_BSP)
+    {
+        blockmap_collide_circle(
+            &test_level_blockmap, &camera->x, &camera->y, player_radius,
+            camera->z - eye_height, player_height, player_max_step);
+        const uint32_t subsector = bsp_point_subsector(&test_level, camera->x, camera->y);
+        camera->z = test_level.sectors[test_level.subsectors[subsector].sector].floor_height + eye_height;
+    }
+    else
+    {
+        if (input->is_pressed(DNF_GAME_ACTION_ATTACK1))
+            fire_projectile(state, camera);
+
+        // monsters chase the player without crowding, then move and slide along the walls
+        // only monsters in the player's PVS wake up
+        pvs_decompress(&state->map_pvs, pvs_grid_cluster(&state->map_pvs, camera->x, camera->y), state->visible_clusters);
+        dnf_entity_ai_params ai = monster_ai;
+        ai.target_x = camera->x;
+        ai.target_y = camera->y;
+        ai.pvs = &state->map_pvs;
+        ai.visible = state->visible_clusters;
+        entity_pass_link(&state->monsters, &state->monster_blockmap);
+        const uint32_t attacks = entity_pass_ai(&state->monsters, &ai, dt);
+        entity_pass_separate(&state->monsters, &state->monster_blockmap, dt);
+        entity_pass_move(&state->monsters, dt);
+        entity_pass_collide_grid(&state->monsters, &test_map);
+        update_projectiles(state, dt);
+
+        if (attacks > 0 && state->player_health > 0)
+        {
+            state->player_health -= (int32_t)attacks;
+            DNF_DEBUG("Player hit by %u monster(s), health %d", attacks, state->player_health);
+        }
+    }
 
     return true;
 }
 
-bool8_t dnf_game_render(game *game_instance, float32_t dt)
+/**
+ * @brief Interpolates between the previous and the current tick camera.
+ *
+ * @param from Previous tick camera.
+ * @param to Current tick camera.
+ * @param alpha Interpolation factor (0 - previous, 1 - current).
+ * @return Interpolated camera.
+ */
+static dnf_camera lerp_camera(const dnf_camera *from, const dnf_camera *to, const float32_t alpha)
+{
+    return (dnf_camera){
+        .x = from->x + (to->x - from->x) * alpha,
+        .y = from->y + (to->y - from->y) * alpha,
+        .z = from->z + (to->z - from->z) * alpha,
+        .angle = from->angle + (to->angle - from->angle) * alpha,
+    };
+}
+
+/**
+ * @brief Adds the monsters and the projectiles in the camera's PVS to the
+ * sprite batch, interpolated between ticks.
+ *
+ * @param state Game state.
+ * @param camera Camera the sprites are rendered from.
+ * @param alpha Interpolation factor (0 - previous tick, 1 - current tick).
+ */
+static void batch_sprites(dnf_game_state *state, const dnf_camera *camera, const float32_t alpha)
+{
+    const dnf_entity_store *monsters = &state->monsters;
+    const dnf_pvs *pvs = &state->map_pvs;
+    pvs_decompress(pvs, pvs_grid_cluster(pvs, camera->x, camera->y), state->visible_clusters);
+
+    sprite_batch_clear(&state->sprites);
+    for (uint32_t i = 0; i < monsters->count; i++)
+    {
+        const float32_t x = monsters->prev_x[i] + (monsters->x[i] - monsters->prev_x[i]) * alpha;
+        const float32_t y = monsters->prev_y[i] + (monsters->y[i] - monsters->prev_y[i]) * alpha;
+        if (!pvs_is_visible(state->visible_clusters, pvs_grid_cluster(pvs, x, y)))
+            continue;
+
+        const dnf_sprite sprite = {
+            .x = x,
+            .y = y,
+            .z = 0.0f,
+            .width = TEST_MONSTER_WIDTH,
+            .height = TEST_MONSTER_HEIGHT,
+            .light = monsters->ai_state[i] == DNF_ENTITY_AI_DEAD ? 0.4f : 1.0f,
+            .texture = monsters->sprite[i] == 0 ? monster_texture : DNF_TEXTURE_INVALID,
+            .color = MAROON,
+        };
+        sprite_batch_add(&state->sprites, &sprite);
+    }
+
+    for (const dnf_projectile *projectile = state->projectiles; projectile; projectile = projectile->next)
+    {
+        const float32_t x = projectile->prev_x + (projectile->x - projectile->prev_x) * alpha;
+        const float32_t y = projectile->prev_y + (projectile->y - projectile->prev_y) * alpha;
+        if (!pvs_is_visible(state->visible_clusters, pvs_grid_cluster(pvs, x, y)))
+            continue;
+
+        const dnf_sprite sprite = {
+            .x = x,
+            .y = y,
+            .z = eye_height - TEST_PROJECTILE_SIZE * 0.5f,
+            .width = TEST_PROJECTILE_SIZE,
+            .height = TEST_PROJECTILE_SIZE,
+            .light = 1.0f,
+            .texture = DNF_TEXTURE_INVALID,
+            .color = ORANGE,
+        };
+        sprite_batch_add(&state->sprites, &sprite);
+    }
+}
+
+bool8_t dnf_game_render(game *game_instance, float32_t alpha)
 {
-    // we will draw directly to the framebuffer
-    const dnf_framebuffer *fb = &(render_ctx->framebuffer);
-    clear_framebuffer(fb, BLACK);
+    dnf_game_state *state = game_instance->game_state;
+    const dnf_camera camera = lerp_camera(&previous_cameras[current_view], &cameras[current_view], alpha);
+
+    // world passes run on the workers while the previous frame is presented
+    if (current_view == DNF_TEST_VIEW_BSP)
+        bsp_render(render_ctx, &test_level, &camera);
+    else
+    {
+        raycaster_render(render_ctx, &test_map, &camera);
 
-    const int32_t ix = x;
-    // game drawing logic
-    const int32_t iy = y;
-    const int32_t i = ix < 0 ? 0 : ix > fb->width ? fb->width : ix;
-    const int32_t j = iy < 0 ? 0 : iy > fb->height ? fb->height : iy;
-    fb->pixels[j * fb->width + i] = RED;
+        // sprites are clipped against the walls drawn by the pass before
+        batch_sprites(state, &camera, alpha);
+        sprite_batch_render(render_ctx, &state->sprites, &textures, &camera, game_instance->frame_arena);
+    }
 
     renderer_begin_frame(render_ctx);
 
     // UI Logic
-    renderer.draw_text("DNF TEST", 10, 10, 24, GREEN);
-    renderer.draw_fps(10, 40);
+    renderer.draw_text(render_ctx, "DNF TEST", 10, 10, 24, GREEN);
+    renderer.draw_fps(render_ctx, 10, 40);
 
     renderer_end_frame(render_ctx);
+    renderer_swap_buffers(render_ctx);
 
 
     return true;
 }
+
+void dnf_game_shutdown(game *game_instance)
+{
+    dnf_game_state *state = game_instance->game_state;
+    while (state->projectiles)
+    {
+        dnf_projectile *projectile = state->projectiles;
+        state->projectiles = projectile->next;
+        pool_free(projectile_pool, projectile);
+    }
+    sprite_batch_shutdown(&state->sprites);
+    dnf_free(state->visible_clusters);
+    state->visible_clusters = nullptr;
+    pvs_free(&state->map_pvs);
+    blockmap_shutdown(&state->monster_blockmap);
+    entity_store_shutdown(&state->monsters);
+
+    texture_cache_shutdown(&textures);
+    test_map.textures = nullptr;
+    for (uint32_t i = 0; i < sizeof(test_map.wall_textures) / sizeof(test_map.wall_textures[0]); i++)
+        test_map.wall_textures[i] = DNF_TEXTURE_INVALID;
+    test_map.floor_texture = DNF_TEXTURE_INVALID;
+    test_map.ceiling_texture = DNF_TEXTURE_INVALID;
+    monster_texture = DNF_TEXTURE_INVALID;
+    pvs_free(&test_level_pvs);
+    wad_close(&maps_wad);
+    blockmap_shutdown(&test_level_blockmap);
+    bsp_level_free(&test_level);
+}
@@ -0,0 +1,317 @@
+// DNF (Doomed and Forgotten): a DOOM-style first-person shooter.
+// Copyright (C) 2025-2026  Alexandr Gorbatenko
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+#include "log_binary.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Longest decoded message.
+#define LOGDUMP_MAX_MSG_LENGTH 8192
+
+
+/**
+ * @brief A call site read from a SITE record.
+ */
+typedef struct logdump_site
+{
+    uint32_t level;
+    uint32_t line;
+    char *file;
+    char *format;
+} logdump_site;
+
+/**
+ * @brief Decoding state of one log file.
+ */
+typedef struct logdump_state
+{
+    const uint8_t *cursor;  //!< Next unread byte
+    const uint8_t *end;     //!< End of the file data
+    int64_t wall_origin;    //!< Wall clock seconds at clock_origin
+    uint64_t clock_origin;  //!< Monotonic nanoseconds of the session start
+    bool8_t has_header;     //!< A header has been read
+
+    logdump_site *sites;    //!< Sites by id (index 0 unused)
+    uint32_t site_capacity;
+} logdump_state;
+
+
+/**
+ * @brief Reads bytes from the file data.
+ *
+ * @return False if the data ends early.
+ */
+static bool8_t read_bytes(logdump_state *state, void *out, const size_t size)
+{
+    if ((size_t)(state->end - state->cursor) < size)
+        return false;
+    memcpy(out, state->cursor, size);
+    state->cursor += size;
+    return true;
+}
+
+/**
+ * @brief Reads a length-prefixed (u16) string into a new allocation.
+ *
+ * @return String or nullptr if the data ends early.
+ */
+static char *read_string16(logdump_state *state)
+{
+    uint16_t length;
+    if (!read_bytes(state, &length, sizeof(length)) || (size_t)(state->end - state->cursor) < length)
+        return nullptr;
+
+    char *string = malloc((size_t)length + 1);
+    if (!string)
+        return nullptr;
+    memcpy(string, state->cursor, length);
+    string[length] = '\0';
+    state->cursor += length;
+    return string;
+}
+
+/**
+ * @brief Forgets all sites (a new session or rotated file starts over).
+ */
+static void clear_sites(logdump_state *state)
+{
+    for (uint32_t i = 0; i < state->site_capacity; i++)
+    {
+        free(state->sites[i].file);
+        free(state->sites[i].format);
+    }
+    free(state->sites);
+    state->sites = nullptr;
+    state->site_capacity = 0;
+}
+
+/**
+ * @brief Reads a file header (the magic is already consumed).
+ */
+static bool8_t read_header(logdump_state *state)
+{
+    uint32_t version;
+    uint8_t long_size, pointer_size;
+    uint16_t reserved;
+    if (!read_bytes(state, &version, 4) || !read_bytes(state, &long_size, 1)
+        || !read_bytes(state, &pointer_size, 1) || !read_bytes(state, &reserved, 2)
+        || !read_bytes(state, &state->wall_origin, 8) || !read_bytes(state, &state->clock_origin, 8))
+        return false;
+
+    if (version != DNF_LOG_BINARY_VERSION)
+    {
+        fprintf(stderr, "Unsupported binary log version %u\n", version);
+        return false;
+    }
+    // packed arguments are stored with the writer's type sizes
+    if (long_size != sizeof(long) || pointer_size != sizeof(void *))
+    {
+        fprintf(stderr, "Log was written on a platform with different type sizes\n");
+        return false;
+    }
+
+    clear_sites(state);
+    state->has_header = true;
+    return true;
+}
+
+/**
+ * @brief Converts a record timestamp to wall clock seconds.
+ */
+static int64_t wall_time(const logdump_state *state, const uint64_t timestamp)
+{
+    return state->wall_origin + ((int64_t)(timestamp - state->clock_origin)) / 1000000000;
+}
+
+/**
+ * @brief Prints a decoded log line.
+ */
+static void print_line(
+    const logdump_state *state, const uint64_t timestamp,
+    const uint32_t level, const char *file, const uint32_t line, const char *message)
+{
+    char out[LOGDUMP_MAX_MSG_LENGTH + 256];
+    const size_t length = dnf_log_format_line(
+        out, sizeof(out), wall_time(state, timestamp), level, file, line, message);
+    fwrite(out, 1, length, stdout);
+}
+
+/**
+ * @brief Decodes one binary log file to stdout.
+ *
+ * @param path File path.
+ * @return True if the whole file was decoded.
+ */
+static bool8_t dump_file(const char *path)
+{
+    FILE *file = fopen(path, "rb");
+    if (!file)
+    {
+        fprintf(stderr, "Could not open %s\n", path);
+        return false;
+    }
+
+    fseek(file, 0, SEEK_END);
+    const long size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    uint8_t *data = size > 0 ? malloc((size_t)size) : nullptr;
+    const bool8_t read_ok = data && fread(data, 1, (size_t)size, file) == (size_t)size;
+    fclose(file);
+    if (!read_ok)
+    {
+        fprintf(stderr, "Could not read %s\n", path);
+        free(data);
+        return false;
+    }
+
+    logdump_state state = {
+        .cursor = data,
+        .end = data + size,
+    };
+    static char message[LOGDUMP_MAX_MSG_LENGTH];
+    bool8_t ok = true;
+
+    while (ok && state.cursor < state.end)
+    {
+        // a header starts every session and every rotated file
+        if ((size_t)(state.end - state.cursor) >= 8 && memcmp(state.cursor, DNF_LOG_BINARY_MAGIC, 8) == 0)
+        {
+            state.cursor += 8;
+            ok = read_header(&state);
+            continue;
+        }
+        if (!state.has_header)
+        {
+            fprintf(stderr, "%s is not a binary log\n", path);
+            ok = false;
+            break;
+        }
+
+        uint8_t type;
+        read_bytes(&state, &type, 1);
+        switch (type)
+        {
+            case DNF_LOG_RECORD_SITE:
+            {
+                uint32_t id, line;
+                uint8_t level;
+                ok = read_bytes(&state, &id, 4) && read_bytes(&state, &level, 1) && read_bytes(&state, &line, 4);
+                char *site_file = ok ? read_string16(&state) : nullptr;
+                char *format = site_file ? read_string16(&state) : nullptr;
+                ok = ok && format && id > 0;
+                if (ok && id >= state.site_capacity)
+                {
+                    const uint32_t capacity = id * 2;
+                    logdump_site *sites = realloc(state.sites, capacity * sizeof(logdump_site));
+                    ok = sites != nullptr;
+                    if (ok)
+                    {
+                        memset(sites + state.site_capacity, 0,
+                            (capacity - state.site_capacity) * sizeof(logdump_site));
+                        state.sites = sites;
+                        state.site_capacity = capacity;
+                    }
+                }
+                if (!ok)
+                {
+                    free(site_file);
+                    free(format);
+                    break;
+                }
+
+                logdump_site *site = &state.sites[id];
+                free(site->file);
+                free(site->format);
+                *site = (logdump_site){ level, line, site_file, format };
+                break;
+            }
+            case DNF_LOG_RECORD_MESSAGE:
+            {
+                uint32_t id, args_size;
+                uint64_t timestamp;
+                ok = read_bytes(&state, &id, 4) && read_bytes(&state, &timestamp, 8)
+                    && read_bytes(&state, &args_size, 4)
+                    && (size_t)(state.end - state.cursor) >= args_size
+                    && id < state.site_capacity && state.sites[id].format;
+                if (!ok)
+                    break;
+
+                const logdump_site *site = &state.sites[id];
+                dnf_log_format_packed(site->format, state.cursor, args_size, message, sizeof(message));
+                state.cursor += args_size;
+                print_line(&state, timestamp, site->level, site->file, site->line, message);
+                break;
+            }
+            case DNF_LOG_RECORD_TEXT:
+            {
+                uint8_t level;
+                uint64_t timestamp;
+                uint32_t line, length;
+                ok = read_bytes(&state, &level, 1) && read_bytes(&state, &timestamp, 8)
+                    && read_bytes(&state, &line, 4);
+                char *text_file = ok ? read_string16(&state) : nullptr;
+                ok = text_file && read_bytes(&state, &length, 4)
+                    && (size_t)(state.end - state.cursor) >= length;
+                if (ok)
+                {
+                    const size_t copy = length < sizeof(message) ? length : sizeof(message) - 1;
+                    memcpy(message, state.cursor, copy);
+                    message[copy] = '\0';
+                    state.cursor += length;
+                    print_line(&state, timestamp, level, text_file, line, message);
+                }
+                free(text_file);
+                break;
+            }
+            default:
+                ok = false;
+                break;
+        }
+    }
+
+    if (!ok)
+        fprintf(stderr, "%s: corrupted or truncated at byte %zu\n", path, (size_t)(state.cursor - data));
+
+    clear_sites(&state);
+    free(data);
+    return ok;
+}
+
+/**
+ * @brief Binary log decoder entry point.
+ *
+ * Decodes the given binary logs (oldest first, e.g. dnf_game.dnflog.1
+ * before dnf_game.dnflog) to stdout in the text log format.
+ *
+ * @param argc Argument count.
+ * @param argv Binary log files.
+ * @return 0 if all files were decoded, 1 otherwise.
+ */
+int main(int argc, char **argv)
+{
+    if (argc < 2)
+    {
+        fprintf(stderr, "Usage: %s FILE.dnflog [FILE.dnflog...]\n", argv[0]);
+        return 1;
+    }
+
+    bool8_t ok = true;
+    for (int i = 1; i < argc; i++)
+        ok = dump_file(argv[i]) && ok;
+
+    return ok ? 0 : 1;
+}
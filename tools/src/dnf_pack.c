@@ -0,0 +1,212 @@
+// DNF (Doomed and Forgotten): a DOOM-style first-person shooter.
+// Copyright (C) 2025-2026  Alexandr Gorbatenko
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+#include "wad.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+/**
+ * @brief A file to pack.
+ */
+typedef struct pack_lump
+{
+    const char *path;                //!< Source file
+    char name[DNF_WAD_NAME_LENGTH];  //!< Lump name
+} pack_lump;
+
+
+/**
+ * @brief Orders lumps by name (the directory must be sorted).
+ */
+static int compare_lumps(const void *a, const void *b)
+{
+    return strcmp(((const pack_lump *)a)->name, ((const pack_lump *)b)->name);
+}
+
+/**
+ * @brief Parses a NAME=FILE or FILE argument (the name defaults to the
+ * file name without directories).
+ *
+ * @return False if the name is empty or too long.
+ */
+static bool8_t parse_lump(const char *arg, pack_lump *out_lump)
+{
+    const char *separator = strchr(arg, '=');
+    const char *name;
+    size_t length;
+    if (separator)
+    {
+        name = arg;
+        length = (size_t)(separator - arg);
+        out_lump->path = separator + 1;
+    }
+    else
+    {
+        const char *slash = strrchr(arg, '/');
+        const char *backslash = strrchr(arg, '\\');
+        if (backslash > slash)
+            slash = backslash;
+        name = slash ? slash + 1 : arg;
+        length = strlen(name);
+        out_lump->path = arg;
+    }
+
+    if (length == 0 || length >= DNF_WAD_NAME_LENGTH)
+    {
+        fprintf(stderr, "Lump name of '%s' must be 1 to %d characters\n", arg, DNF_WAD_NAME_LENGTH - 1);
+        return false;
+    }
+    memset(out_lump->name, 0, sizeof(out_lump->name));
+    memcpy(out_lump->name, name, length);
+    return true;
+}
+
+/**
+ * @brief Pads the output with zeros up to a multiple of the lump alignment.
+ *
+ * @return Padded offset.
+ */
+static uint64_t pad_to_alignment(FILE *out, uint64_t offset)
+{
+    static const uint8_t zeros[DNF_WAD_LUMP_ALIGNMENT] = {0};
+    const uint64_t padding = (DNF_WAD_LUMP_ALIGNMENT - offset % DNF_WAD_LUMP_ALIGNMENT) % DNF_WAD_LUMP_ALIGNMENT;
+    fwrite(zeros, 1, (size_t)padding, out);
+    return offset + padding;
+}
+
+/**
+ * @brief Copies a file into the output.
+ *
+ * @return Number of bytes copied, or -1 if the file can't be read.
+ */
+static int64_t copy_file(FILE *out, const char *path)
+{
+    FILE *in = fopen(path, "rb");
+    if (!in)
+    {
+        fprintf(stderr, "Failed to open %s\n", path);
+        return -1;
+    }
+
+    uint8_t buffer[64 * 1024];
+    int64_t total = 0;
+    size_t count;
+    while ((count = fread(buffer, 1, sizeof(buffer), in)) > 0)
+    {
+        fwrite(buffer, 1, count, out);
+        total += (int64_t)count;
+    }
+
+    const bool8_t failed = ferror(in) != 0;
+    fclose(in);
+    if (failed)
+    {
+        fprintf(stderr, "Failed to read %s\n", path);
+        return -1;
+    }
+    return total;
+}
+
+/**
+ * @brief Writes an archive of the given lumps.
+ *
+ * @return True on success.
+ */
+static bool8_t write_archive(const char *path, pack_lump *lumps, const uint32_t lump_count)
+{
+    qsort(lumps, lump_count, sizeof(pack_lump), compare_lumps);
+    for (uint32_t i = 1; i < lump_count; i++)
+    {
+        if (strcmp(lumps[i - 1].name, lumps[i].name) == 0)
+        {
+            fprintf(stderr, "Duplicate lump name '%s'\n", lumps[i].name);
+            return false;
+        }
+    }
+
+    dnf_wad_entry *directory = calloc(lump_count ? lump_count : 1, sizeof(dnf_wad_entry));
+    FILE *out = fopen(path, "wb");
+    if (!directory || !out)
+    {
+        fprintf(stderr, "Failed to create %s\n", path);
+        free(directory);
+        if (out)
+            fclose(out);
+        return false;
+    }
+
+    // the header is rewritten once the directory offset is known
+    dnf_wad_header header = { .version = DNF_WAD_VERSION, .lump_count = lump_count };
+    memcpy(header.magic, DNF_WAD_MAGIC, sizeof(header.magic));
+    fwrite(&header, sizeof(header), 1, out);
+    uint64_t offset = sizeof(header);
+
+    bool8_t ok = true;
+    for (uint32_t i = 0; i < lump_count && ok; i++)
+    {
+        offset = pad_to_alignment(out, offset);
+        const int64_t size = copy_file(out, lumps[i].path);
+        ok = size >= 0;
+        directory[i] = (dnf_wad_entry){ .offset = offset, .size = (uint64_t)(ok ? size : 0) };
+        memcpy(directory[i].name, lumps[i].name, DNF_WAD_NAME_LENGTH);
+        offset += directory[i].size;
+    }
+
+    if (ok)
+    {
+        header.directory_offset = pad_to_alignment(out, offset);
+        fwrite(directory, sizeof(dnf_wad_entry), lump_count, out);
+        fseek(out, 0, SEEK_SET);
+        fwrite(&header, sizeof(header), 1, out);
+        ok = ferror(out) == 0;
+        if (!ok)
+            fprintf(stderr, "Failed to write %s\n", path);
+    }
+
+    ok = fclose(out) == 0 && ok;
+    free(directory);
+    if (!ok)
+        remove(path);
+    return ok;
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 2)
+    {
+        fprintf(stderr, "Usage: %s OUTPUT.wad [NAME=]FILE [[NAME=]FILE...]\n", argv[0]);
+        return 1;
+    }
+
+    const uint32_t lump_count = (uint32_t)(argc - 2);
+    pack_lump *lumps = calloc(lump_count ? lump_count : 1, sizeof(pack_lump));
+    if (!lumps)
+        return 1;
+
+    bool8_t ok = true;
+    for (uint32_t i = 0; i < lump_count && ok; i++)
+        ok = parse_lump(argv[2 + i], &lumps[i]);
+
+    if (ok)
+        ok = write_archive(argv[1], lumps, lump_count);
+    if (ok)
+        printf("Packed %u lumps into %s\n", lump_count, argv[1]);
+
+    free(lumps);
+    return ok ? 0 : 1;
+}
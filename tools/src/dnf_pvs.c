@@ -0,0 +1,285 @@
+// DNF (Doomed and Forgotten): a DOOM-style first-person shooter.
+// Copyright (C) 2025-2026  Alexandr Gorbatenko
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+#include "pvs.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Widest and tallest map the tool reads, in cells.
+#define PVS_TOOL_MAX_MAP_SIZE 4096
+// Longest line of a text level, in characters.
+#define PVS_TOOL_MAX_LEVEL_LINE 256
+
+
+/**
+ * @brief Reads a text grid map: one line per row, '.', ' ' or '0' for an
+ * empty cell, a hex digit 1-F for a wall type. Short lines are padded with
+ * walls.
+ *
+ * @return True on success (free out_map->cells).
+ */
+static bool8_t read_grid_map(const char *path, dnf_grid_map *out_map)
+{
+    FILE *in = fopen(path, "rb");
+    if (!in)
+    {
+        fprintf(stderr, "Failed to open %s\n", path);
+        return false;
+    }
+
+    // first pass - map size
+    char line[PVS_TOOL_MAX_MAP_SIZE + 3];
+    int32_t width = 0, height = 0;
+    while (fgets(line, sizeof(line), in))
+    {
+        const int32_t length = (int32_t)strcspn(line, "\r\n");
+        if (length > PVS_TOOL_MAX_MAP_SIZE || height == PVS_TOOL_MAX_MAP_SIZE)
+        {
+            fprintf(stderr, "%s is bigger than %dx%d cells\n", path, PVS_TOOL_MAX_MAP_SIZE, PVS_TOOL_MAX_MAP_SIZE);
+            fclose(in);
+            return false;
+        }
+        width = length > width ? length : width;
+        height++;
+    }
+    if (width == 0 || height == 0)
+    {
+        fprintf(stderr, "%s is empty\n", path);
+        fclose(in);
+        return false;
+    }
+
+    uint8_t *cells = malloc((size_t)width * (size_t)height);
+    if (!cells)
+    {
+        fclose(in);
+        return false;
+    }
+    memset(cells, 1, (size_t)width * (size_t)height);
+
+    // second pass - cells
+    rewind(in);
+    for (int32_t y = 0; y < height && fgets(line, sizeof(line), in); y++)
+    {
+        const int32_t length = (int32_t)strcspn(line, "\r\n");
+        for (int32_t x = 0; x < length; x++)
+        {
+            const char c = line[x];
+            uint8_t cell;
+            if (c == '.' || c == ' ' || c == '0')
+                cell = 0;
+            else if (c >= '1' && c <= '9')
+                cell = (uint8_t)(c - '0');
+            else if (c >= 'A' && c <= 'F')
+                cell = (uint8_t)(c - 'A' + 10);
+            else if (c >= 'a' && c <= 'f')
+                cell = (uint8_t)(c - 'a' + 10);
+            else
+            {
+                fprintf(stderr, "%s:%d: unknown cell '%c'\n", path, y + 1, c);
+                free(cells);
+                fclose(in);
+                return false;
+            }
+            cells[y * width + x] = cell;
+        }
+    }
+    fclose(in);
+
+    *out_map = (dnf_grid_map){ .width = width, .height = height, .cells = cells };
+    return true;
+}
+
+/**
+ * @brief Reads a text BSP level: one element per line, referring to the
+ * vertices and sectors before it by index (from 0):
+ *
+ *     vertex X Y
+ *     sector FLOOR_HEIGHT CEILING_HEIGHT
+ *     line V1 V2 FRONT_SECTOR [BACK_SECTOR]
+ *
+ * Lines without a back sector are one-sided. Whatever follows these fields
+ * (light and colors, see game/cmake/embed_maps.cmake) doesn't affect
+ * visibility and is skipped, as are empty lines and lines starting with '#'.
+ *
+ * @return True on success (free the arrays of out_map either way).
+ */
+static bool8_t read_level_map(const char *path, dnf_level_map *out_map)
+{
+    *out_map = (dnf_level_map){0};
+    FILE *in = fopen(path, "rb");
+    if (!in)
+    {
+        fprintf(stderr, "Failed to open %s\n", path);
+        return false;
+    }
+
+    // first pass - element counts
+    char line[PVS_TOOL_MAX_LEVEL_LINE];
+    char keyword[16];
+    uint32_t vertex_count = 0, sector_count = 0, linedef_count = 0;
+    while (fgets(line, sizeof(line), in))
+    {
+        if (sscanf(line, "%15s", keyword) != 1)
+            continue;
+        vertex_count += strcmp(keyword, "vertex") == 0;
+        sector_count += strcmp(keyword, "sector") == 0;
+        linedef_count += strcmp(keyword, "line") == 0;
+    }
+    if (linedef_count == 0 || sector_count == 0)
+    {
+        fprintf(stderr, "%s has no lines or sectors\n", path);
+        fclose(in);
+        return false;
+    }
+
+    dnf_vertex *vertices = calloc(vertex_count, sizeof(dnf_vertex));
+    dnf_sector *sectors = calloc(sector_count, sizeof(dnf_sector));
+    dnf_linedef *linedefs = calloc(linedef_count, sizeof(dnf_linedef));
+    *out_map = (dnf_level_map){
+        .vertices = vertices,
+        .linedefs = linedefs,
+        .sectors = sectors,
+    };
+    if (!vertices || !sectors || !linedefs)
+    {
+        fclose(in);
+        return false;
+    }
+
+    // second pass - elements
+    rewind(in);
+    for (int32_t number = 1; fgets(line, sizeof(line), in); number++)
+    {
+        if (sscanf(line, "%15s", keyword) != 1 || keyword[0] == '#')
+            continue;
+
+        bool8_t valid = false;
+        if (strcmp(keyword, "vertex") == 0)
+        {
+            dnf_vertex *vertex = &vertices[out_map->vertex_count++];
+            valid = sscanf(line, "%*s %f %f", &vertex->x, &vertex->y) == 2;
+        }
+        else if (strcmp(keyword, "sector") == 0)
+        {
+            dnf_sector *sector = &sectors[out_map->sector_count++];
+            sector->light = 255;
+            valid = sscanf(line, "%*s %f %f", &sector->floor_height, &sector->ceiling_height) == 2;
+        }
+        else if (strcmp(keyword, "line") == 0)
+        {
+            dnf_linedef *linedef = &linedefs[out_map->linedef_count++];
+            linedef->back_sector = DNF_BSP_NO_SECTOR;
+            const int read = sscanf(
+                line, "%*s %u %u %d %d",
+                &linedef->v1, &linedef->v2, &linedef->front_sector, &linedef->back_sector);
+            valid = read >= 3
+                && linedef->v1 < out_map->vertex_count && linedef->v2 < out_map->vertex_count
+                && linedef->front_sector >= 0 && (uint32_t)linedef->front_sector < out_map->sector_count
+                && linedef->back_sector >= DNF_BSP_NO_SECTOR && linedef->back_sector < (int32_t)out_map->sector_count;
+        }
+
+        if (!valid)
+        {
+            fprintf(stderr, "%s:%d: can't read '%s'\n", path, number, keyword);
+            fclose(in);
+            return false;
+        }
+    }
+    fclose(in);
+    return true;
+}
+
+/**
+ * @brief Frees what read_level_map() allocated.
+ */
+static void free_level_map(dnf_level_map *map)
+{
+    free((void *)map->vertices);
+    free((void *)map->sectors);
+    free((void *)map->linedefs);
+}
+
+/**
+ * @brief Builds the PVS of a text BSP level (see read_level_map()).
+ *
+ * @return True on success.
+ */
+static bool8_t build_level_pvs(const char *path, dnf_pvs *out_pvs)
+{
+    dnf_level_map map;
+    bool8_t ok = read_level_map(path, &map);
+    dnf_bsp_level level;
+    ok = ok && bsp_level_build(&map, &level);
+    free_level_map(&map);
+    if (!ok)
+        return false;
+
+    ok = pvs_build_level(out_pvs, &level);
+    bsp_level_free(&level);
+    return ok;
+}
+
+int main(int argc, char **argv)
+{
+    if (argc == 4 && strcmp(argv[1], "--level") == 0)
+    {
+        dnf_pvs pvs;
+        if (!build_level_pvs(argv[2], &pvs))
+            return 1;
+
+        const bool8_t ok = pvs_save(&pvs, argv[3]);
+        if (ok)
+            printf("Wrote the PVS of a level (%u subsectors, %zu bytes) to %s\n", pvs.cluster_count, pvs.lump_size, argv[3]);
+        pvs_free(&pvs);
+        return ok ? 0 : 1;
+    }
+
+    if (argc < 3 || argc > 4)
+    {
+        fprintf(stderr, "Usage: %s MAP.txt OUTPUT.pvs [CLUSTER_SIZE]\n", argv[0]);
+        fprintf(stderr, "       %s --level LEVEL.txt OUTPUT.pvs\n", argv[0]);
+        fprintf(stderr, "Pack the output into the level WAD with dnf_pack.\n");
+        return 1;
+    }
+
+    const int32_t cluster_size = argc == 4 ? atoi(argv[3]) : 1;
+    if (cluster_size <= 0)
+    {
+        fprintf(stderr, "Cluster size must be a positive number of cells\n");
+        return 1;
+    }
+
+    dnf_grid_map map;
+    if (!read_grid_map(argv[1], &map))
+        return 1;
+
+    dnf_pvs pvs;
+    bool8_t ok = pvs_build_grid(&pvs, &map, cluster_size);
+    if (ok)
+    {
+        ok = pvs_save(&pvs, argv[2]);
+        if (ok)
+            printf(
+                "Wrote the PVS of a %dx%d map (%u clusters, %zu bytes) to %s\n",
+                map.width, map.height, pvs.cluster_count, pvs.lump_size, argv[2]);
+        pvs_free(&pvs);
+    }
+
+    free((void *)map.cells);
+    return ok ? 0 : 1;
+}